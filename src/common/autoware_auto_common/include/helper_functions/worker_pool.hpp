@@ -0,0 +1,193 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+/// \file
+/// \brief This file defines a fork-join pool of persistent worker threads
+
+#ifndef HELPER_FUNCTIONS__WORKER_POOL_HPP_
+#define HELPER_FUNCTIONS__WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace autoware
+{
+namespace common
+{
+namespace helper_functions
+{
+/// \brief A fixed set of threads which are started once and then repeatedly used to run a batch
+///        of independent tasks, blocking until all tasks are done. The calling thread also
+///        executes tasks, so a pool of size 1 runs everything inline with no threads.
+///
+/// Running a batch does not allocate memory. run() must not be called concurrently from multiple
+/// threads, or from within a task.
+class WorkerPool
+{
+public:
+  /// \brief Constructor, starts the worker threads
+  /// \param[in] num_threads The total number of threads working on a batch, including the calling
+  ///                        thread
+  /// \throw std::domain_error If num_threads is zero
+  explicit WorkerPool(const std::size_t num_threads)
+  : m_generation{0U},
+    m_active{0U},
+    m_stop{false},
+    m_num_tasks{0U},
+    m_next_task{0U},
+    m_context{nullptr},
+    m_invoke{nullptr},
+    m_error{nullptr}
+  {
+    if (0U == num_threads) {
+      throw std::domain_error{"WorkerPool: Need at least one thread"};
+    }
+    m_workers.reserve(num_threads - 1U);
+    for (std::size_t idx = 1U; idx < num_threads; ++idx) {
+      m_workers.emplace_back([this] {work();});
+    }
+  }
+
+  /// \brief Destructor, stops and joins the worker threads
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_stop = true;
+    }
+    m_start_cv.notify_all();
+    for (auto & worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool & operator=(const WorkerPool &) = delete;
+
+  /// \brief Get the number of threads working on a batch, including the calling thread
+  /// \return The number of threads
+  std::size_t size() const
+  {
+    return m_workers.size() + 1U;
+  }
+
+  /// \brief Run fn(idx) for each idx in [0, num_tasks), distributed over all threads, and block
+  ///        until all calls have returned. Tasks are handed out dynamically in increasing order.
+  /// \param[in] num_tasks The number of tasks in this batch
+  /// \param[in] fn The task functor, called with the task index
+  /// \tparam FnT The type of the task functor
+  /// \throw Rethrows the first exception thrown by a task, after all threads are done
+  template<typename FnT>
+  void run(const std::size_t num_tasks, const FnT & fn)
+  {
+    if (m_workers.empty() || (num_tasks <= 1U)) {
+      for (std::size_t idx = 0U; idx < num_tasks; ++idx) {
+        fn(idx);
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_num_tasks = num_tasks;
+      m_next_task.store(0U);
+      m_context = &fn;
+      m_invoke = [](const void * context, const std::size_t idx) {
+          (*static_cast<const FnT *>(context))(idx);
+        };
+      m_error = nullptr;
+      m_active = m_workers.size();
+      ++m_generation;
+    }
+    m_start_cv.notify_all();
+    execute();
+    std::exception_ptr error{nullptr};
+    {
+      std::unique_lock<std::mutex> lock{m_mutex};
+      m_done_cv.wait(lock, [this] {return 0U == m_active;});
+      error = m_error;
+      m_error = nullptr;
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  /// \brief Worker thread loop: wait for a new batch, help execute it, report completion
+  void work()
+  {
+    uint64_t generation = 0U;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_start_cv.wait(lock, [this, generation] {return m_stop || (m_generation != generation);});
+        if (m_stop) {
+          return;
+        }
+        generation = m_generation;
+      }
+      execute();
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_active;
+        if (0U == m_active) {
+          m_done_cv.notify_one();
+        }
+      }
+    }
+  }
+
+  /// \brief Grab and run tasks of the current batch until none are left
+  void execute()
+  {
+    for (std::size_t idx = m_next_task.fetch_add(1U); idx < m_num_tasks;
+      idx = m_next_task.fetch_add(1U))
+    {
+      try {
+        m_invoke(m_context, idx);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (!m_error) {
+          m_error = std::current_exception();
+        }
+      }
+    }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_start_cv;
+  std::condition_variable m_done_cv;
+  uint64_t m_generation;
+  std::size_t m_active;
+  bool m_stop;
+  // Current batch, written under the mutex before the workers are woken up
+  std::size_t m_num_tasks;
+  std::atomic<std::size_t> m_next_task;
+  const void * m_context;
+  void (* m_invoke)(const void *, std::size_t);
+  std::exception_ptr m_error;
+};  // class WorkerPool
+}  // namespace helper_functions
+}  // namespace common
+}  // namespace autoware
+
+#endif  // HELPER_FUNCTIONS__WORKER_POOL_HPP_
@@ -0,0 +1,68 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "helper_functions/worker_pool.hpp"
+
+using autoware::common::helper_functions::WorkerPool;
+
+TEST(worker_pool, bad_size)
+{
+  EXPECT_THROW(WorkerPool{0U}, std::domain_error);
+}
+
+TEST(worker_pool, all_tasks_run_once)
+{
+  for (std::size_t num_threads = 1U; num_threads <= 4U; ++num_threads) {
+    WorkerPool pool{num_threads};
+    EXPECT_EQ(pool.size(), num_threads);
+    std::vector<std::atomic<uint32_t>> counts(1000U);
+    for (auto & count : counts) {
+      count.store(0U);
+    }
+    // Repeated batches reuse the same threads
+    for (uint32_t run = 0U; run < 10U; ++run) {
+      pool.run(counts.size(), [&counts](const std::size_t idx) {++counts[idx];});
+    }
+    for (const auto & count : counts) {
+      EXPECT_EQ(count.load(), 10U);
+    }
+    // Empty batch is fine
+    pool.run(0U, [](const std::size_t) {FAIL();});
+  }
+}
+
+TEST(worker_pool, exception)
+{
+  WorkerPool pool{3U};
+  std::atomic<uint32_t> count{0U};
+  const auto fn = [&count](const std::size_t idx) {
+      ++count;
+      if (5U == idx) {
+        throw std::runtime_error{"task failed"};
+      }
+    };
+  EXPECT_THROW(pool.run(100U, fn), std::runtime_error);
+  // Other tasks still ran, and the pool is still usable
+  EXPECT_EQ(count.load(), 100U);
+  count.store(0U);
+  pool.run(100U, [&count](const std::size_t) {++count;});
+  EXPECT_EQ(count.load(), 100U);
+}
@@ -22,9 +22,9 @@
 
 #include <common/types.hpp>
 #include <geometry/spatial_hash_config.hpp>
+#include <geometry/spatial_hash_storage.hpp>
 #include <geometry/visibility_control.hpp>
 #include <vector>
-#include <unordered_map>
 #include <utility>
 
 using autoware::common::types::float32_t;
@@ -43,11 +43,13 @@ namespace spatial_hash
 /// \brief An implementation of the spatial hash or integer lattice data structure for efficient
 ///        (O(1)) near neighbor queries.
 /// \tparam PointT The point type stored in this data structure. Must have float members x, y, and z
+/// \tparam ConfigT Config2d or Config3d
+/// \tparam StorageT The storage policy, MultimapStorage or FlatStorage
 ///
 /// This implementation can support both 2D and 3D queries
 /// (though only one type per data structure), and can support queries of varying radius. This data
 /// structure cannot do near neighbor lookups for euclidean distance in arbitrary dimensions.
-template<typename PointT, typename ConfigT>
+template<typename PointT, typename ConfigT, typename StorageT = MultimapStorage<PointT>>
 class GEOMETRY_PUBLIC SpatialHashBase
 {
   using Index3 = details::Index3;
@@ -56,8 +58,9 @@ class GEOMETRY_PUBLIC SpatialHashBase
     "SpatialHash only works with Config2d or Config3d");
 
 public:
-  using Hash = std::unordered_multimap<Index, PointT>;
-  using IT = typename Hash::const_iterator;
+  using Storage = StorageT;
+  using IT = typename Storage::IT;
+  using BinVector = typename Storage::BinVector;
   /// \brief Wrapper around an iterator and a distance (from some query point)
   class Output
   {
@@ -111,7 +114,7 @@ private:
   /// \param[in] cfg The configuration object for this class
   explicit SpatialHashBase(const ConfigT & cfg)
   : m_config{cfg},
-    m_hash(),
+    m_hash(cfg.get_capacity()),
     m_neighbors{},  // TODO(c.ho) reserve, but there's no default constructor for output
     m_bins_hit{},  // zero initialization (and below)
     m_neighbors_found{}
@@ -138,14 +141,29 @@ private:
   ///                          capacity
   template<typename IteratorT>
   void insert(IteratorT begin, IteratorT end)
+  {
+    insert(begin, end, [](const PointT & pt) -> const PointT & {return pt;});
+  }
+
+  /// \brief Inserts a range of elements, converting each to a point. With FlatStorage, this is a
+  ///        bulk build: the points are copied, then all bin indices are computed in one pass
+  /// \param[in] begin The start of the range of elements to insert
+  /// \param[in] end The end of the range of elements to insert
+  /// \param[in] convert Functor making a PointT from an element, called once per element in order
+  /// \tparam IteratorT The iterator type
+  /// \tparam ConvertT The type of the conversion functor
+  /// \throw std::length_error If the range of points to insert exceeds the data structure's
+  ///                          capacity
+  template<typename IteratorT, typename ConvertT>
+  void insert(IteratorT begin, IteratorT end, const ConvertT & convert)
   {
     // This check is here for strong exception safety
-    if ((size() + std::distance(begin, end)) > capacity()) {
+    if ((size() + static_cast<Index>(std::distance(begin, end))) > capacity()) {
       throw std::length_error{"SpatialHash: Cannot multi-insert past capacity"};
     }
-    for (IteratorT it = begin; it != end; ++it) {
-      (void)insert_impl(*it);
-    }
+    m_hash.insert(begin, end, convert, [this](const PointT & pt) {
+        return m_config.bin(point_adapter::x_(pt), point_adapter::y_(pt), point_adapter::z_(pt));
+      });
   }
 
   /// \brief Reset the state of the data structure
@@ -196,6 +214,21 @@ private:
     return end();
   }
 
+  /// \brief Prepare the data structure for const queries. With FlatStorage, this sorts the points
+  ///        by bin if there were modifications, and must be called before const queries
+  void finalize()
+  {
+    m_hash.finalize();
+  }
+
+  /// \brief Get the occupied bins, each as the range of points it contains. With FlatStorage, each
+  ///        range is contiguous in memory, and the points are sorted by bin if needed
+  /// \return A reference to a vector of iterator pairs delimiting the points in each bin
+  const BinVector & bins()
+  {
+    return m_hash.bins();
+  }
+
   /// \brief Get the number of bins touched during the lifetime of this object, for debugging and
   ///        size tuning
   /// \return The total number of bins touched during near() queries
@@ -225,8 +258,31 @@ protected:
     const float32_t y,
     const float32_t z)
   {
+    m_hash.finalize();
+    // update book-keeping
+    m_bins_hit += near_impl(x, y, z, m_neighbors);
+    m_neighbors_found += m_neighbors.size();
+    return m_neighbors;
+  }
+
+  /// \brief Finds all points within a fixed radius of a reference point, without modifying the
+  ///        data structure. Requires finalize() to have been called after the last modification.
+  /// \param[in] x The x component of the reference point
+  /// \param[in] y The y component of the reference point
+  /// \param[in] z The z component of the reference point, respected only if the spatial hash is not
+  ///              2D.
+  /// \param[out] neighbors Overwritten with iterators pointing to all points within the radius,
+  ///                       and the actual distance to the reference point
+  /// \return The number of bins touched
+  Index near_impl(
+    const float32_t x,
+    const float32_t y,
+    const float32_t z,
+    OutputVector & neighbors) const
+  {
+    Index bins_hit = 0U;
     // reset output
-    m_neighbors.clear();
+    neighbors.clear();
     // Compute bin, bin range
     const Index3 ref_idx = m_config.index3(x, y, z);
     const details::BinRange idx_range = m_config.bin_range(ref_idx);
@@ -234,7 +290,7 @@ protected:
     // For bins in radius
     do {  // guaranteed to have at least the bin ref_idx is in
       // update book-keeping
-      ++m_bins_hit;
+      ++bins_hit;
       // Iterating in a square/cube pattern is easier than constructing sphere pattern
       if (m_config.is_candidate_bin(ref_idx, idx)) {
         // For point in bin
@@ -245,14 +301,12 @@ protected:
           const float32_t dist2 = m_config.distance_squared(x, y, z, pt);
           if (dist2 <= m_config.radius2()) {
             // Only compute true distance if necessary
-            m_neighbors.emplace_back(it, sqrtf(dist2));
+            neighbors.emplace_back(it, sqrtf(dist2));
           }
         }
       }
     } while (m_config.next_bin(idx_range, idx));
-    // update book-keeping
-    m_neighbors_found += m_neighbors.size();
-    return m_neighbors;
+    return bins_hit;
   }
 
 private:
@@ -264,11 +318,11 @@ private:
     const Index idx =
       m_config.bin(point_adapter::x_(pt), point_adapter::y_(pt), point_adapter::z_(pt));
     // Insert into bin
-    return m_hash.insert(std::make_pair(idx, pt));
+    return m_hash.insert(idx, pt);
   }
 
   const ConfigT m_config;
-  Hash m_hash;
+  Storage m_hash;
   OutputVector m_neighbors;
   Index m_bins_hit;
   Index m_neighbors_found;
@@ -278,19 +332,21 @@ private:
 /// apex_app::common::geometry::spatial_hash::SpatialHashBase to provide different function
 /// signatures on 2D and 3D configurations
 /// \tparam PointT The point type stored in this data structure. Must have float members x, y and z
-template<typename PointT, typename ConfigT>
+/// \tparam StorageT The storage policy, MultimapStorage or FlatStorage
+template<typename PointT, typename ConfigT, typename StorageT = MultimapStorage<PointT>>
 class GEOMETRY_PUBLIC SpatialHash;
 
 /// \brief Explicit specialization of SpatialHash for 2D configuration
 /// \tparam PointT The point type stored in this data structure.
-template<typename PointT>
-class GEOMETRY_PUBLIC SpatialHash<PointT, Config2d>: public SpatialHashBase<PointT, Config2d>
+template<typename PointT, typename StorageT>
+class GEOMETRY_PUBLIC SpatialHash<PointT, Config2d, StorageT>
+  : public SpatialHashBase<PointT, Config2d, StorageT>
 {
 public:
-  using OutputVector = typename SpatialHashBase<PointT, Config2d>::OutputVector;
+  using OutputVector = typename SpatialHashBase<PointT, Config2d, StorageT>::OutputVector;
 
   explicit SpatialHash(const Config2d & cfg)
-  : SpatialHashBase<PointT, Config2d>(cfg) {}
+  : SpatialHashBase<PointT, Config2d, StorageT>(cfg) {}
 
   /// \brief Finds all points within a fixed radius of a reference point
   /// \param[in] x The x component of the reference point
@@ -303,6 +359,18 @@ public:
     return this->near_impl(x, y, 0.0F);
   }
 
+  /// \brief Finds all points within a fixed radius of a reference point. This is safe to call
+  ///        concurrently, but requires finalize() to have been called after the last modification,
+  ///        and does not update the bins_hit() and neighbors_found() statistics.
+  /// \param[in] x The x component of the reference point
+  /// \param[in] y The y component of the reference point
+  /// \param[out] neighbors Overwritten with iterators pointing to all points within the
+  ///                       configured radius, and the actual distance to the reference point
+  void near(const float32_t x, const float32_t y, OutputVector & neighbors) const
+  {
+    (void)this->near_impl(x, y, 0.0F, neighbors);
+  }
+
   /// \brief Finds all points within a fixed radius of a reference point
   /// \param[in] pt The reference point. Only the x and y members are respected.
   /// \return A const reference to a vector containing iterators pointing to
@@ -316,14 +384,15 @@ public:
 
 /// \brief Explicit specialization of SpatialHash for 3D configuration
 /// \tparam PointT The point type stored in this data structure. Must have float members x, y and z
-template<typename PointT>
-class GEOMETRY_PUBLIC SpatialHash<PointT, Config3d>: public SpatialHashBase<PointT, Config3d>
+template<typename PointT, typename StorageT>
+class GEOMETRY_PUBLIC SpatialHash<PointT, Config3d, StorageT>
+  : public SpatialHashBase<PointT, Config3d, StorageT>
 {
 public:
-  using OutputVector = typename SpatialHashBase<PointT, Config3d>::OutputVector;
+  using OutputVector = typename SpatialHashBase<PointT, Config3d, StorageT>::OutputVector;
 
   explicit SpatialHash(const Config3d & cfg)
-  : SpatialHashBase<PointT, Config3d>(cfg) {}
+  : SpatialHashBase<PointT, Config3d, StorageT>(cfg) {}
 
   /// \brief Finds all points within a fixed radius of a reference point
   /// \param[in] x The x component of the reference point
@@ -338,6 +407,23 @@ public:
     return this->near_impl(x, y, z);
   }
 
+  /// \brief Finds all points within a fixed radius of a reference point. This is safe to call
+  ///        concurrently, but requires finalize() to have been called after the last modification,
+  ///        and does not update the bins_hit() and neighbors_found() statistics.
+  /// \param[in] x The x component of the reference point
+  /// \param[in] y The y component of the reference point
+  /// \param[in] z The z component of the reference point
+  /// \param[out] neighbors Overwritten with iterators pointing to all points within the
+  ///                       configured radius, and the actual distance to the reference point
+  void near(
+    const float32_t x,
+    const float32_t y,
+    const float32_t z,
+    OutputVector & neighbors) const
+  {
+    (void)this->near_impl(x, y, z, neighbors);
+  }
+
   /// \brief Finds all points within a fixed radius of a reference point
   /// \param[in] pt The reference point.
   /// \return A const reference to a vector containing iterators pointing to
@@ -353,6 +439,12 @@ template<typename T>
 using SpatialHash2d = SpatialHash<T, Config2d>;
 template<typename T>
 using SpatialHash3d = SpatialHash<T, Config3d>;
+/// \brief 2D spatial hash with contiguous storage and no allocation after construction
+template<typename T>
+using FlatSpatialHash2d = SpatialHash<T, Config2d, FlatStorage<T>>;
+/// \brief 3D spatial hash with contiguous storage and no allocation after construction
+template<typename T>
+using FlatSpatialHash3d = SpatialHash<T, Config3d, FlatStorage<T>>;
 }  // namespace spatial_hash
 }  // namespace geometry
 }  // namespace common
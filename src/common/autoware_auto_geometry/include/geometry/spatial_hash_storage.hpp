@@ -0,0 +1,356 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+/// \file
+/// \brief This file defines the storage policies which can back the spatial hash
+
+#ifndef GEOMETRY__SPATIAL_HASH_STORAGE_HPP_
+#define GEOMETRY__SPATIAL_HASH_STORAGE_HPP_
+
+#include <common/types.hpp>
+#include <geometry/spatial_hash_config.hpp>
+#include <geometry/visibility_control.hpp>
+
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+
+namespace autoware
+{
+namespace common
+{
+namespace geometry
+{
+namespace spatial_hash
+{
+/// \brief Node based storage for the spatial hash. Each point is a separately allocated node in an
+///        std::unordered_multimap, keyed on the bin index.
+/// \tparam PointT The point type stored in this data structure
+template<typename PointT>
+class GEOMETRY_PUBLIC MultimapStorage
+{
+public:
+  using Container = std::unordered_multimap<Index, PointT>;
+  using IT = typename Container::const_iterator;
+  using BinVector = std::vector<std::pair<IT, IT>>;
+
+  /// \brief Constructor
+  /// \param[in] capacity The maximum number of points that will be stored, unused
+  explicit MultimapStorage(const Index capacity)
+  {
+    (void)capacity;
+  }
+  /// \brief Store a point in the given bin
+  /// \param[in] bin The composed index of the bin the point falls into
+  /// \param[in] pt The point to store
+  /// \return Iterator pointing to the stored point
+  IT insert(const Index bin, const PointT & pt)
+  {
+    return m_hash.insert(std::make_pair(bin, pt));
+  }
+  /// \brief Store a range of points
+  /// \param[in] begin The start of the range of points to insert
+  /// \param[in] end The end of the range of points to insert
+  /// \param[in] convert Functor making a PointT from an element of the range
+  /// \param[in] bin_fn Functor computing the bin index of a PointT
+  template<typename IteratorT, typename ConvertT, typename BinFnT>
+  void insert(IteratorT begin, IteratorT end, const ConvertT & convert, const BinFnT & bin_fn)
+  {
+    for (IteratorT it = begin; it != end; ++it) {
+      const PointT pt = convert(*it);
+      (void)insert(bin_fn(pt), pt);
+    }
+  }
+  /// \brief Prepare for queries, nothing to be done for this storage
+  void finalize()
+  {
+  }
+  /// \brief Get all points stored in a given bin
+  /// \param[in] bin The composed index of the bin
+  /// \return A pair of iterators delimiting the points in the bin
+  std::pair<IT, IT> equal_range(const Index bin) const
+  {
+    return m_hash.equal_range(bin);
+  }
+  /// \brief Get the occupied bins, each as the range of points it contains. Equal keys are
+  ///        adjacent in an unordered_multimap, so this is a single pass over all nodes
+  /// \return A reference to the bins, valid until the next call to this function
+  const BinVector & bins()
+  {
+    m_bins.clear();
+    for (IT it = m_hash.begin(); it != m_hash.end(); ) {
+      const IT first = it;
+      while ((it != m_hash.end()) && (it->first == first->first)) {
+        ++it;
+      }
+      m_bins.emplace_back(first, it);
+    }
+    return m_bins;
+  }
+  /// \brief Remove all stored points
+  void clear()
+  {
+    m_hash.clear();
+  }
+  /// \brief Get number of stored points
+  Index size() const
+  {
+    return m_hash.size();
+  }
+  /// \brief Whether no points are stored
+  bool8_t empty() const
+  {
+    return m_hash.empty();
+  }
+  /// \brief Get iterator to the first stored point
+  IT begin() const
+  {
+    return m_hash.begin();
+  }
+  /// \brief Get iterator to one past the last stored point
+  IT end() const
+  {
+    return m_hash.end();
+  }
+
+private:
+  Container m_hash;
+  BinVector m_bins;
+};  // class MultimapStorage
+
+/// \brief Contiguous storage for the spatial hash with no memory allocation after construction.
+///        Points are appended to a flat array on insertion. Before the first query after any
+///        modification, the points are counting-sorted by bin into a second flat array, so that
+///        all points of a bin are adjacent in memory (CSR layout). The bin -> range lookup is an
+///        open addressing hash table with linear probing, sized to twice the capacity.
+/// \tparam PointT The point type stored in this data structure
+template<typename PointT>
+class GEOMETRY_PUBLIC FlatStorage
+{
+public:
+  using Entry = std::pair<Index, PointT>;
+  using Container = std::vector<Entry>;
+  using IT = typename Container::const_iterator;
+  using BinVector = std::vector<std::pair<IT, IT>>;
+
+  /// \brief Constructor, all memory is allocated here
+  /// \param[in] capacity The maximum number of points that will be stored
+  explicit FlatStorage(const Index capacity)
+  : m_mask{table_size(capacity) - 1U},
+    m_entries{},
+    m_sorted{},
+    m_slots(m_mask + 1U),
+    m_entry_slots{},
+    m_used_slots{},
+    m_bins{},
+    m_dirty{false}
+  {
+    m_entries.reserve(capacity);
+    m_sorted.reserve(capacity);
+    m_entry_slots.reserve(capacity);
+    m_used_slots.reserve(capacity);
+    m_bins.reserve(capacity);
+  }
+  /// \brief Store a point in the given bin, it is not visible to equal_range() until the next
+  ///        call to finalize()
+  /// \param[in] bin The composed index of the bin the point falls into
+  /// \param[in] pt The point to store
+  /// \return Iterator pointing to the stored point in insertion order
+  IT insert(const Index bin, const PointT & pt)
+  {
+    m_entries.emplace_back(bin, pt);
+    m_dirty = true;
+    return m_entries.cend() - 1;
+  }
+  /// \brief Store a range of points. The points are first copied, then all bin indices are
+  ///        computed in a separate tight loop over contiguous memory, which the compiler can
+  ///        vectorize
+  /// \param[in] begin The start of the range of points to insert
+  /// \param[in] end The end of the range of points to insert
+  /// \param[in] convert Functor making a PointT from an element of the range, called once per
+  ///                    element in order
+  /// \param[in] bin_fn Functor computing the bin index of a PointT
+  template<typename IteratorT, typename ConvertT, typename BinFnT>
+  void insert(IteratorT begin, IteratorT end, const ConvertT & convert, const BinFnT & bin_fn)
+  {
+    const Index first = m_entries.size();
+    for (IteratorT it = begin; it != end; ++it) {
+      m_entries.emplace_back(Index{}, convert(*it));
+    }
+    Entry * const entries = m_entries.data();
+    const Index last = m_entries.size();
+    for (Index idx = first; idx < last; ++idx) {
+      entries[idx].first = bin_fn(entries[idx].second);
+    }
+    m_dirty = true;
+  }
+  /// \brief Prepare for queries by sorting the points by bin, if there were any modifications
+  void finalize()
+  {
+    if (m_dirty) {
+      build();
+    }
+  }
+  /// \brief Get all points stored in a given bin
+  /// \param[in] bin The composed index of the bin
+  /// \return A pair of iterators delimiting the points in the bin
+  /// \throw std::logic_error If points were inserted since the last call to finalize()
+  std::pair<IT, IT> equal_range(const Index bin) const
+  {
+    if (m_dirty) {
+      throw std::logic_error{"FlatStorage: Query before finalize()"};
+    }
+    const Slot & slot = m_slots[find_slot(bin)];
+    if (EMPTY == slot.bin) {
+      return std::make_pair(m_sorted.cend(), m_sorted.cend());
+    }
+    const IT first = m_sorted.cbegin() + static_cast<std::ptrdiff_t>(slot.offset);
+    return std::make_pair(first, first + static_cast<std::ptrdiff_t>(slot.count));
+  }
+  /// \brief Get the occupied bins, each as the contiguous range of points it contains, sorting the
+  ///        points by bin if needed
+  /// \return A reference to the bins, valid until the next modification
+  const BinVector & bins()
+  {
+    finalize();
+    return m_bins;
+  }
+  /// \brief Remove all stored points, only touching the occupied parts of the lookup table
+  void clear()
+  {
+    for (const Index sdx : m_used_slots) {
+      m_slots[sdx] = Slot{};
+    }
+    m_used_slots.clear();
+    m_entry_slots.clear();
+    m_bins.clear();
+    m_entries.clear();
+    m_sorted.clear();
+    m_dirty = false;
+  }
+  /// \brief Get number of stored points
+  Index size() const
+  {
+    return m_entries.size();
+  }
+  /// \brief Whether no points are stored
+  bool8_t empty() const
+  {
+    return m_entries.empty();
+  }
+  /// \brief Get iterator to the first stored point, in insertion order
+  IT begin() const
+  {
+    return m_entries.cbegin();
+  }
+  /// \brief Get iterator to one past the last stored point, in insertion order
+  IT end() const
+  {
+    return m_entries.cend();
+  }
+
+private:
+  /// \brief Marker for an unoccupied slot in the lookup table
+  static constexpr Index EMPTY = std::numeric_limits<Index>::max();
+  /// \brief An entry in the open addressing table, describing where the points of a bin live
+  struct Slot
+  {
+    Index bin{EMPTY};
+    Index offset{};
+    Index count{};
+  };  // struct Slot
+
+  /// \brief Smallest power of two that is at least twice the capacity, for a load factor <= 0.5
+  static Index table_size(const Index capacity)
+  {
+    Index ret = 1U;
+    while (ret < (capacity * 2U)) {
+      ret <<= 1U;
+    }
+    return ret;
+  }
+  /// \brief Find the slot occupied by a bin, or the empty slot where it would go
+  Index find_slot(const Index bin) const
+  {
+    // Fibonacci hashing to spread out the (mostly sequential) bin indices
+    constexpr Index MULTIPLIER = static_cast<Index>(11400714819323198485ULL);
+    Index sdx = (bin * MULTIPLIER) & m_mask;
+    while ((EMPTY != m_slots[sdx].bin) && (bin != m_slots[sdx].bin)) {
+      sdx = (sdx + 1U) & m_mask;
+    }
+    return sdx;
+  }
+  /// \brief Counting sort of the points by bin into the CSR array
+  void build()
+  {
+    // Reset ranges of bins which were seen in a previous build
+    for (const Index sdx : m_used_slots) {
+      m_slots[sdx].count = 0U;
+    }
+    // Histogram
+    m_entry_slots.clear();
+    for (const auto & entry : m_entries) {
+      const Index sdx = find_slot(entry.first);
+      Slot & slot = m_slots[sdx];
+      if (EMPTY == slot.bin) {
+        slot.bin = entry.first;
+        m_used_slots.push_back(sdx);
+      }
+      ++slot.count;
+      m_entry_slots.push_back(sdx);
+    }
+    // Exclusive prefix sum; count is reused as the fill cursor for the scatter
+    m_sorted.resize(m_entries.size());
+    m_bins.clear();
+    Index offset = 0U;
+    for (const Index sdx : m_used_slots) {
+      Slot & slot = m_slots[sdx];
+      slot.offset = offset;
+      offset += slot.count;
+      const IT first = m_sorted.cbegin() + static_cast<std::ptrdiff_t>(slot.offset);
+      m_bins.emplace_back(first, first + static_cast<std::ptrdiff_t>(slot.count));
+      slot.count = 0U;
+    }
+    // Scatter
+    for (Index idx = 0U; idx < m_entries.size(); ++idx) {
+      Slot & slot = m_slots[m_entry_slots[idx]];
+      m_sorted[slot.offset + slot.count] = m_entries[idx];
+      ++slot.count;
+    }
+    m_dirty = false;
+  }
+
+  const Index m_mask;
+  Container m_entries;
+  Container m_sorted;
+  std::vector<Slot> m_slots;
+  std::vector<Index> m_entry_slots;
+  std::vector<Index> m_used_slots;
+  BinVector m_bins;
+  bool8_t m_dirty;
+};  // class FlatStorage
+
+template<typename PointT>
+constexpr Index FlatStorage<PointT>::EMPTY;
+}  // namespace spatial_hash
+}  // namespace geometry
+}  // namespace common
+}  // namespace autoware
+
+#endif  // GEOMETRY__SPATIAL_HASH_STORAGE_HPP_
@@ -106,6 +106,10 @@ Index Config3d::index_(const details::Index3 & idx) const
 ////////////////////////////////////////////////////////////////////////////////
 template class SpatialHash<geometry_msgs::msg::Point32, Config2d>;
 template class SpatialHash<geometry_msgs::msg::Point32, Config3d>;
+template class SpatialHash<geometry_msgs::msg::Point32, Config2d,
+    FlatStorage<geometry_msgs::msg::Point32>>;
+template class SpatialHash<geometry_msgs::msg::Point32, Config3d,
+    FlatStorage<geometry_msgs::msg::Point32>>;
 }  // namespace spatial_hash
 }  // namespace geometry
 }  // namespace common
@@ -18,6 +18,11 @@
 #define TEST_SPATIAL_HASH_HPP_
 
 #include <geometry_msgs/msg/point32.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tuple>
 #include <vector>
 #include <limits>
 #include "geometry/spatial_hash.hpp"
@@ -30,6 +35,8 @@ using autoware::common::geometry::spatial_hash::Config3d;
 using autoware::common::geometry::spatial_hash::SpatialHash;
 using autoware::common::geometry::spatial_hash::SpatialHash2d;
 using autoware::common::geometry::spatial_hash::SpatialHash3d;
+using autoware::common::geometry::spatial_hash::FlatSpatialHash2d;
+using autoware::common::geometry::spatial_hash::FlatSpatialHash3d;
 
 template<typename PointT>
 class TypedSpatialHashTest : public ::testing::Test
@@ -252,4 +259,160 @@ TEST(SpatialHashConfig, bad_cases)
   //   std::domain_error);
   // TODO(c.ho) re-enable test when we can actually check unsigned integer multiplication overflow
 }
+
+/// Near neighbors of a query, as sorted coordinates so that backends can be compared
+template<typename OutputVector>
+std::vector<std::tuple<float32_t, float32_t, float32_t>> sorted_neighbors(const OutputVector & nbrs)
+{
+  std::vector<std::tuple<float32_t, float32_t, float32_t>> ret{};
+  for (const auto & itd : nbrs) {
+    const geometry_msgs::msg::Point32 & pt = itd;
+    ret.emplace_back(pt.x, pt.y, pt.z);
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+std::vector<geometry_msgs::msg::Point32> random_points(const std::size_t count, const float32_t lim)
+{
+  std::mt19937 gen(1338U);
+  std::uniform_real_distribution<float32_t> distr{-lim, lim};
+  std::vector<geometry_msgs::msg::Point32> ret{count};
+  for (auto & pt : ret) {
+    pt.x = distr(gen);
+    pt.y = distr(gen);
+    pt.z = distr(gen) * 0.1F;
+  }
+  return ret;
+}
+
+/// The flat backend should give the same results as the multimap backend
+TEST(FlatSpatialHash, matches_multimap)
+{
+  using PointT = geometry_msgs::msg::Point32;
+  const auto pts = random_points(2048U, 20.0F);
+  const auto half = pts.begin() + 1024;
+  {
+    const Config2d cfg{-20.0F, 20.0F, -20.0F, 20.0F, 1.5F, pts.size()};
+    SpatialHash2d<PointT> ref_hash{cfg};
+    FlatSpatialHash2d<PointT> hash{cfg};
+    // Query in between insertions to exercise rebuilding
+    ref_hash.insert(pts.begin(), half);
+    hash.insert(pts.begin(), half);
+    EXPECT_EQ(
+      sorted_neighbors(ref_hash.near(pts.front())),
+      sorted_neighbors(hash.near(pts.front())));
+    ref_hash.insert(half, pts.end());
+    hash.insert(half, pts.end());
+    EXPECT_EQ(hash.size(), pts.size());
+    EXPECT_EQ(std::distance(hash.cbegin(), hash.cend()), static_cast<std::ptrdiff_t>(pts.size()));
+    for (const auto & pt : pts) {
+      ASSERT_EQ(sorted_neighbors(ref_hash.near(pt)), sorted_neighbors(hash.near(pt)));
+    }
+    EXPECT_EQ(ref_hash.bins_hit(), hash.bins_hit());
+    EXPECT_EQ(ref_hash.neighbors_found(), hash.neighbors_found());
+    EXPECT_THROW(hash.insert(pts.front()), std::length_error);
+    // Reuse after clear
+    hash.clear();
+    EXPECT_TRUE(hash.empty());
+    EXPECT_TRUE(hash.near(pts.front()).empty());
+    hash.insert(pts.begin(), pts.end());
+    EXPECT_EQ(
+      sorted_neighbors(ref_hash.near(pts.back())),
+      sorted_neighbors(hash.near(pts.back())));
+  }
+  {
+    const Config3d cfg{-20.0F, 20.0F, -20.0F, 20.0F, -2.0F, 2.0F, 1.5F, pts.size()};
+    SpatialHash3d<PointT> ref_hash{cfg};
+    FlatSpatialHash3d<PointT> hash{cfg};
+    ref_hash.insert(pts.begin(), pts.end());
+    hash.insert(pts.begin(), pts.end());
+    for (const auto & pt : pts) {
+      ASSERT_EQ(sorted_neighbors(ref_hash.near(pt)), sorted_neighbors(hash.near(pt)));
+    }
+  }
+}
+
+/// Bins should partition the points, with each bin holding a single contiguous bin index
+template<typename HashT>
+void check_bins(HashT & hash)
+{
+  std::size_t count = 0U;
+  std::vector<std::size_t> keys{};
+  for (const auto & bin : hash.bins()) {
+    ASSERT_NE(bin.first, bin.second);
+    for (auto it = bin.first; it != bin.second; ++it) {
+      ASSERT_EQ(it->first, bin.first->first);
+      ++count;
+    }
+    keys.push_back(bin.first->first);
+  }
+  EXPECT_EQ(count, hash.size());
+  std::sort(keys.begin(), keys.end());
+  EXPECT_EQ(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+TEST(FlatSpatialHash, bulk_insert_and_bins)
+{
+  using PointT = geometry_msgs::msg::Point32;
+  const auto pts = random_points(1024U, 20.0F);
+  const Config2d cfg{-20.0F, 20.0F, -20.0F, 20.0F, 1.5F, 2U * pts.size()};
+  SpatialHash2d<PointT> ref_hash{cfg};
+  FlatSpatialHash2d<PointT> hash{cfg};
+  // Conversion is applied in order
+  float32_t offset = 0.0F;
+  const auto convert = [&offset](const PointT & pt) {
+      PointT ret{pt};
+      ret.z = offset;
+      offset += 1.0F;
+      return ret;
+    };
+  ref_hash.insert(pts.begin(), pts.end(), convert);
+  offset = 0.0F;
+  hash.insert(pts.begin(), pts.end(), convert);
+  float32_t expected_z = 0.0F;
+  for (const auto & kv : hash) {
+    ASSERT_FLOAT_EQ(kv.second.z, expected_z);
+    expected_z += 1.0F;
+  }
+  check_bins(ref_hash);
+  check_bins(hash);
+  EXPECT_EQ(ref_hash.bins().size(), hash.bins().size());
+  // Mixed single and bulk insertion
+  hash.insert(pts.front());
+  hash.insert(pts.begin() + 1, pts.end());
+  check_bins(hash);
+  EXPECT_EQ(hash.size(), 2U * pts.size());
+  EXPECT_THROW(hash.insert(pts.begin(), pts.begin() + 1), std::length_error);
+}
+
+/// Figure out the runtime of filling and querying each backend, locally
+template<typename HashT>
+void benchmark_backend(const char * name, const std::vector<geometry_msgs::msg::Point32> & pts)
+{
+  const Config2d cfg{-50.0F, 50.0F, -50.0F, 50.0F, 0.5F, pts.size()};
+  HashT hash{cfg};
+  const uint32_t num_runs = 5U;
+  std::size_t num_neighbors = 0U;
+  auto time_begin = std::chrono::steady_clock::now();
+  for (uint32_t idx = 0U; idx < num_runs; ++idx) {
+    hash.clear();
+    hash.insert(pts.begin(), pts.end());
+    for (const auto & pt : pts) {
+      num_neighbors += hash.near(pt).size();
+    }
+  }
+  auto time_end = std::chrono::steady_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(time_end - time_begin);
+  std::cerr << name << " insert + near() average runtime: " << duration.count() / num_runs <<
+    " µs (" << num_neighbors / num_runs << " neighbors)\n";
+}
+
+TEST(FlatSpatialHash, benchmark)
+{
+  using PointT = geometry_msgs::msg::Point32;
+  const auto pts = random_points(100000U, 50.0F);
+  benchmark_backend<SpatialHash2d<PointT>>("MultimapStorage", pts);
+  benchmark_backend<FlatSpatialHash2d<PointT>>("FlatStorage", pts);
+}
 #endif  // TEST_SPATIAL_HASH_HPP_
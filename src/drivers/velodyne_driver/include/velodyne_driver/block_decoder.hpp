@@ -0,0 +1,95 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \copyright Copyright 2020 Apex.AI, Inc.
+/// \file
+/// \brief This file defines the vectorized conversion of Velodyne data blocks into points
+
+#ifndef VELODYNE_DRIVER__BLOCK_DECODER_HPP_
+#define VELODYNE_DRIVER__BLOCK_DECODER_HPP_
+
+#include <velodyne_driver/visibility_control.hpp>
+#include <velodyne_driver/common.hpp>
+#include <array>
+
+namespace autoware
+{
+namespace drivers
+{
+namespace velodyne_driver
+{
+
+/// \brief Instruction sets the block decoding can dispatch to
+enum class SimdLevel : uint8_t
+{
+  SCALAR = 0U,
+  SSE2 = 1U,
+  AVX2 = 2U
+};
+
+/// \brief Get the most capable instruction set supported by the executing CPU. Detection happens
+///        once, on the first call
+/// \return The SimdLevel, SCALAR on non-x86 platforms
+VELODYNE_DRIVER_PUBLIC SimdLevel detect_simd_level();
+
+/// \brief Lookup tables of a translator used to decode its blocks
+struct VELODYNE_DRIVER_PUBLIC DecodeTables
+{
+  /// cosine of each azimuth index, AZIMUTH_ROTATION_RESOLUTION entries
+  const float32_t * cos_table;
+  /// sine of each azimuth index, AZIMUTH_ROTATION_RESOLUTION entries
+  const float32_t * sin_table;
+  /// intensity of each intensity byte, NUM_INTENSITY_VALUES entries
+  const float32_t * intensity_table;
+  /// meters per distance unit
+  float32_t distance_resolution;
+};
+
+/// \brief Points of a data block, one array per field so they can be processed in SIMD lanes.
+///        No alignment is required, so it can be a member of heap allocated objects
+struct VELODYNE_DRIVER_PUBLIC BlockPoints
+{
+  std::array<float32_t, NUM_POINTS_PER_BLOCK> x;
+  std::array<float32_t, NUM_POINTS_PER_BLOCK> y;
+  std::array<float32_t, NUM_POINTS_PER_BLOCK> z;
+  std::array<float32_t, NUM_POINTS_PER_BLOCK> intensity;
+};
+
+/// \brief Convert all channels of a data block into cartesian points. Each point is computed
+///        bit-for-bit as in VelodyneTranslator::convert(), whatever the instruction set.
+/// \param[in] channels The raw channels of the block, 3 bytes each: distance LSB, distance MSB and
+///                     intensity
+/// \param[in] azimuth_base Azimuth index of the block
+/// \param[in] azimuth_offsets Azimuth offset index of each channel, below
+///                            AZIMUTH_ROTATION_RESOLUTION
+/// \param[in] altitudes Altitude angle index of each channel
+/// \param[in] tables Lookup tables of the translator
+/// \param[out] out Gets filled with the points of all channels
+/// \param[in] level The instruction set to use, must be supported by the executing CPU
+VELODYNE_DRIVER_PUBLIC void decode_block(
+  const uint8_t * channels,
+  uint32_t azimuth_base,
+  const uint32_t * azimuth_offsets,
+  const uint32_t * altitudes,
+  const DecodeTables & tables,
+  BlockPoints & out,
+  SimdLevel level);
+
+}  // namespace velodyne_driver
+}  // namespace drivers
+}  // namespace autoware
+
+#endif  // VELODYNE_DRIVER__BLOCK_DECODER_HPP_
@@ -0,0 +1,81 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \copyright Copyright 2020 Apex.AI, Inc.
+/// \file
+/// \brief This file defines the motion compensation (deskewing) of points within a sweep
+
+#ifndef VELODYNE_DRIVER__MOTION_COMPENSATION_HPP_
+#define VELODYNE_DRIVER__MOTION_COMPENSATION_HPP_
+
+#include <velodyne_driver/visibility_control.hpp>
+#include <velodyne_driver/common.hpp>
+
+namespace autoware
+{
+namespace drivers
+{
+namespace velodyne_driver
+{
+
+/// \brief Velocity of the sensor, expressed in the sensor frame
+struct VELODYNE_DRIVER_PUBLIC SensorTwist
+{
+  /// linear velocity in m/s
+  float32_t vx;
+  float32_t vy;
+  float32_t vz;
+  /// angular velocity in rad/s
+  float32_t wx;
+  float32_t wy;
+  float32_t wz;
+};
+
+/// \brief Moves a point measured some time before a reference time into the sensor frame at the
+///        reference time, assuming that the sensor moves with a constant twist in between. The
+///        point is transformed as p_ref = R(-w * dt) * (p - v * dt). The rotation is expanded to
+///        second order, which is accurate to about a millimeter at 50 m for 0.5 rad/s over a
+///        100 ms sweep, and avoids any trigonometry per point.
+/// \param[in] twist Velocity of the sensor
+/// \param[in] dt_s Time from the measurement of the point to the reference time in seconds
+/// \param[in,out] x x coordinate of the point
+/// \param[in,out] y y coordinate of the point
+/// \param[in,out] z z coordinate of the point
+inline void compensate_motion(
+  const SensorTwist & twist, const float32_t dt_s,
+  float32_t & x, float32_t & y, float32_t & z) noexcept
+{
+  // Undo the translation
+  const float32_t qx = x - (twist.vx * dt_s);
+  const float32_t qy = y - (twist.vy * dt_s);
+  const float32_t qz = z - (twist.vz * dt_s);
+  // Undo the rotation: q + a x q + a x (a x q) / 2 with a = -w * dt
+  const float32_t ax = -twist.wx * dt_s;
+  const float32_t ay = -twist.wy * dt_s;
+  const float32_t az = -twist.wz * dt_s;
+  const float32_t cx = (ay * qz) - (az * qy);
+  const float32_t cy = (az * qx) - (ax * qz);
+  const float32_t cz = (ax * qy) - (ay * qx);
+  x = qx + cx + (0.5F * ((ay * cz) - (az * cy)));
+  y = qy + cy + (0.5F * ((az * cx) - (ax * cz)));
+  z = qz + cz + (0.5F * ((ax * cy) - (ay * cx)));
+}
+
+}  // namespace velodyne_driver
+}  // namespace drivers
+}  // namespace autoware
+
+#endif  // VELODYNE_DRIVER__MOTION_COMPENSATION_HPP_
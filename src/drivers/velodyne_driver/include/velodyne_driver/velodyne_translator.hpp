@@ -23,6 +23,7 @@
 
 #include <velodyne_driver/visibility_control.hpp>
 #include <geometry_msgs/msg/point32.hpp>
+#include <velodyne_driver/block_decoder.hpp>
 #include <velodyne_driver/common.hpp>
 #include <velodyne_driver/vlp16_data.hpp>
 #include <velodyne_driver/vlp32c_data.hpp>
@@ -50,6 +51,10 @@ class VELODYNE_DRIVER_PUBLIC VelodyneTranslator
 public:
   /// \brief Stores basic configuration information, does some simple validity checking
   static constexpr uint16_t POINT_BLOCK_CAPACITY = 512U;
+  /// \brief Most points a single packet converts into: all channels and an end of scan marker
+  ///        after each block
+  static constexpr uint32_t MAX_POINTS_PER_PACKET =
+    NUM_BLOCKS_PER_PACKET * (NUM_POINTS_PER_BLOCK + 1U);
 
   class Config
   {
@@ -108,8 +113,132 @@ private:
   /// \param[in] pkt A packet from a VLP16 HiRes sensor for conversion
   /// \param[out] output Gets filled with cartesian points and any additional flags
   void convert(const Packet & pkt, std::vector<autoware::common::types::PointXYZIF> & output)
+  {
+    convert_packet(pkt, output, nullptr);
+  }
+
+  /// \brief Convert a packet into a block of cartesian points and the firing time of each point
+  /// \param[in] pkt A packet from the sensor for conversion
+  /// \param[out] output Gets filled with cartesian points and any additional flags
+  /// \param[out] time_offsets_us Gets filled with the firing time of each element of output, in
+  ///                             microseconds after the packet timestamp. An end of scan marker
+  ///                             gets the time of the point before it
+  void convert(
+    const Packet & pkt, std::vector<autoware::common::types::PointXYZIF> & output,
+    std::vector<float32_t> & time_offsets_us)
+  {
+    time_offsets_us.clear();
+    convert_packet(pkt, output, &time_offsets_us);
+  }
+
+  /// \brief Convert a packet into cartesian points written directly into preallocated memory. A
+  ///        whole data block is decoded at once with the given instruction set, the points are
+  ///        bit-for-bit the same as the ones of the other overloads.
+  /// \param[in] pkt A packet from the sensor for conversion
+  /// \param[out] output Gets the cartesian points and any additional flags written to it, must
+  ///                    have space for MAX_POINTS_PER_PACKET points
+  /// \param[in] level The instruction set to decode with, must be supported by the executing CPU
+  /// \return The number of points written to output
+  std::size_t convert(
+    const Packet & pkt, autoware::common::types::PointXYZIF * const output,
+    const SimdLevel level)
+  {
+    PointSpanWriter writer{output};
+    convert_blocks(pkt, writer, false, level);
+    return writer.size();
+  }
+
+  /// \brief Convert a packet into cartesian points written directly into preallocated memory,
+  ///        with the best instruction set of the executing CPU
+  /// \param[in] pkt A packet from the sensor for conversion
+  /// \param[out] output Gets the cartesian points and any additional flags written to it, must
+  ///                    have space for MAX_POINTS_PER_PACKET points
+  /// \return The number of points written to output
+  std::size_t convert(const Packet & pkt, autoware::common::types::PointXYZIF * const output)
+  {
+    return convert(pkt, output, detect_simd_level());
+  }
+
+  /// \brief Convert a packet block by block into a writer, e.g. straight into the memory of a
+  ///        message, without an intermediate point block. The points, ids and firing times are
+  ///        bit-for-bit the same as the ones of the other overloads.
+  /// \tparam WriterT Type with the member functions
+  ///                 `write_block(const BlockPoints & points, const uint16_t * ids,
+  ///                 const float32_t * time_offsets_us)`, which gets the NUM_POINTS_PER_BLOCK
+  ///                 points of each valid block with their ids and firing times, and
+  ///                 `end_of_scan()`, which is called where the other overloads add an end of
+  ///                 scan marker
+  /// \param[in] pkt A packet from the sensor for conversion
+  /// \param[in,out] writer Gets the blocks of the packet
+  /// \param[in] with_time_offsets Whether to compute the firing times, the writer gets nullptr
+  ///                              otherwise
+  /// \param[in] level The instruction set to decode with, must be supported by the executing CPU
+  template<typename WriterT>
+  void convert_blocks(
+    const Packet & pkt, WriterT & writer, const bool8_t with_time_offsets,
+    const SimdLevel level)
+  {
+    const DecodeTables tables{m_cos_table.data(), m_sin_table.data(), m_intensity_table.data(),
+      m_sensor_data.distance_resolution()};
+
+    for (uint32_t block_id = 0U; block_id < NUM_BLOCKS_PER_PACKET; ++block_id, ++m_block_counter) {
+      const DataBlock & block = pkt.blocks[block_id];
+      const auto flag_check_result = m_sensor_data.check_flag(block.flag);
+      // Ignore block with invalid flag.
+      if (!flag_check_result.first) {
+        continue;
+      }
+      const auto num_banked_pts = flag_check_result.second;
+      const uint32_t azimuth_base = to_uint32(block.azimuth_bytes[1U], block.azimuth_bytes[0U]);
+      decode_block(&block.channels[0U].data[0U], azimuth_base,
+        m_sensor_data.azimuth_offsets(num_banked_pts, block_id),
+        m_sensor_data.altitudes(num_banked_pts, block_id), tables, m_block_points, level);
+      for (uint16_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+        m_block_ids[pt_id] = m_sensor_data.seq_id(m_block_counter, pt_id);
+      }
+      if (with_time_offsets) {
+        for (uint16_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+          m_block_times_us[pt_id] = m_sensor_data.time_offset_us(num_banked_pts, block_id, pt_id);
+        }
+      }
+      writer.write_block(m_block_points, m_block_ids.data(),
+        with_time_offsets ? m_block_times_us.data() : nullptr);
+
+      if (static_cast<float32_t>(m_block_counter) > m_sensor_data.num_blocks_per_revolution()) {
+        // full revolution reached.
+        writer.end_of_scan();
+        m_block_counter = uint16_t{0U};
+      }
+    }
+  }
+
+  /// \brief Get the timestamp of a packet, which is the time of the first firing in it
+  /// \param[in] pkt A packet from the sensor
+  /// \return Microseconds since the top of the hour, see packet_time_diff_us()
+  static uint32_t packet_timestamp_us(const Packet & pkt) noexcept
+  {
+    // little endian
+    return (to_uint32(pkt.timestamp_bytes[3U], pkt.timestamp_bytes[2U]) << 16U) +
+           to_uint32(pkt.timestamp_bytes[1U], pkt.timestamp_bytes[0U]);
+  }
+
+  /// \brief Get the time between two packet timestamps, which wrap around at the top of the hour
+  /// \param[in] from_us Timestamp of the earlier packet
+  /// \param[in] to_us Timestamp of the later packet
+  /// \return Microseconds from from_us to to_us, assuming they are less than an hour apart
+  static uint32_t packet_time_diff_us(const uint32_t from_us, const uint32_t to_us) noexcept
+  {
+    return (to_us >= from_us) ? (to_us - from_us) : ((US_PER_HOUR - from_us) + to_us);
+  }
+
+private:
+  /// \brief Implementation of convert(), time offsets are only computed if requested
+  void convert_packet(
+    const Packet & pkt, std::vector<autoware::common::types::PointXYZIF> & output,
+    std::vector<float32_t> * const time_offsets_us)
   {
     output.clear();
+    float32_t last_time_offset_us = 0.0F;
 
     for (uint32_t block_id = 0U; block_id < NUM_BLOCKS_PER_PACKET; ++block_id, ++m_block_counter) {
       const DataBlock & block = pkt.blocks[block_id];
@@ -136,6 +265,10 @@ private:
         pt.id = m_sensor_data.seq_id(m_block_counter, pt_id);
 
         output.push_back(pt);
+        if (time_offsets_us != nullptr) {
+          last_time_offset_us = m_sensor_data.time_offset_us(num_banked_pts, block_id, pt_id);
+          time_offsets_us->push_back(last_time_offset_us);
+        }
       }
 
       if (static_cast<float32_t>(m_block_counter) > m_sensor_data.num_blocks_per_revolution()) {
@@ -144,16 +277,62 @@ private:
         pt.id =
           static_cast<uint16_t>(PointXYZIF::END_OF_SCAN_ID);
         output.push_back(pt);
+        if (time_offsets_us != nullptr) {
+          time_offsets_us->push_back(last_time_offset_us);
+        }
         m_block_counter = uint16_t{0U};
       }
     }
   }
 
+  /// \brief Writer of convert() into preallocated memory
+  class PointSpanWriter
+  {
+public:
+    explicit PointSpanWriter(autoware::common::types::PointXYZIF * const output)
+    : m_output(output), m_size(0U)
+    {
+    }
+
+    void write_block(
+      const BlockPoints & points, const uint16_t * const ids, const float32_t * const)
+    {
+      for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+        autoware::common::types::PointXYZIF & pt = m_output[m_size];
+        pt.x = points.x[pt_id];
+        pt.y = points.y[pt_id];
+        pt.z = points.z[pt_id];
+        pt.intensity = points.intensity[pt_id];
+        pt.id = ids[pt_id];
+        ++m_size;
+      }
+    }
+
+    void end_of_scan()
+    {
+      m_output[m_size] = autoware::common::types::PointXYZIF{};
+      m_output[m_size].id = static_cast<uint16_t>(PointXYZIF::END_OF_SCAN_ID);
+      ++m_size;
+    }
+
+    /// number of points written
+    std::size_t size() const noexcept
+    {
+      return m_size;
+    }
+
 private:
+    autoware::common::types::PointXYZIF * m_output;
+    std::size_t m_size;
+  };
+
   // make sure packet sizes are correct
   static_assert(sizeof(DataChannel) == 3U, "Error velodyne data channel size is incorrect");
   static_assert(sizeof(DataBlock) == 100U, "Error velodyne data block size is incorrect");
   static_assert(sizeof(Packet) == 1206U, "Error velodyne packet size is incorrect");
+  // decode_block() reads the channels of a block as one contiguous byte array
+  static_assert(sizeof(DataChannel[NUM_POINTS_PER_BLOCK]) == (3U * NUM_POINTS_PER_BLOCK),
+    "Error velodyne data channels are not contiguous");
   // Ensure that a full packet will fit into a point block
   static_assert(static_cast<uint32_t>(POINT_BLOCK_CAPACITY) >=
     ((NUM_POINTS_PER_BLOCK * NUM_BLOCKS_PER_PACKET) + 1U),
@@ -213,6 +392,8 @@ private:
     }
   }
 
+  /// packet timestamps count the microseconds since the top of the hour
+  static constexpr uint32_t US_PER_HOUR = 3600000000U;
   /// tau = 2 pi
   static constexpr float32_t TAU = 6.283185307179586476925286766559F;
 
@@ -227,6 +408,10 @@ private:
   /// mask to avoid modulo: packet id can go up to 3617: 0000 1111 1111 1111 = 4096
   uint16_t m_block_counter{0U};
   SensorData m_sensor_data;
+  /// workspace for the points of the data block being decoded, their ids and firing times
+  BlockPoints m_block_points;
+  std::array<uint16_t, NUM_POINTS_PER_BLOCK> m_block_ids;
+  std::array<float32_t, NUM_POINTS_PER_BLOCK> m_block_times_us;
 };  // class Driver
 using Vlp16Translator = VelodyneTranslator<VLP16Data>;
 using Vlp32CTranslator = VelodyneTranslator<VLP32CData>;
@@ -75,6 +75,28 @@ public:
   /// \return Altitude angle for the given laser.
   uint32_t altitude(uint16_t num_banked_pts, uint32_t block_id, uint32_t pt_id) const;
 
+  /// Get the azimuth offsets of all points in the given block.
+  /// \param num_banked_pts Number of points from the sequence that were
+  /// transferred on previous blocks.
+  /// \param block_id Block ID within the packet.
+  /// \return Pointer to NUM_POINTS_PER_BLOCK consecutive azimuth offsets, indexed by point ID.
+  const uint32_t * azimuth_offsets(uint16_t num_banked_pts, uint32_t block_id) const noexcept;
+
+  /// Get the altitude angles of all points in the given block.
+  /// \param num_banked_pts Number of points from the sequence that were
+  /// transferred on previous blocks.
+  /// \param block_id Block ID within the packet.
+  /// \return Pointer to NUM_POINTS_PER_BLOCK consecutive altitude angles, indexed by point ID.
+  const uint32_t * altitudes(uint16_t num_banked_pts, uint32_t block_id) const noexcept;
+
+  /// Get the firing time of a given point in the given block.
+  /// \param num_banked_pts Number of points from the sequence that were
+  /// transferred on previous blocks.
+  /// \param block_id Block ID within the packet.
+  /// \param pt_id Point ID within the block.
+  /// \return Time in microseconds from the first firing in the packet to the firing of the point.
+  float32_t time_offset_us(uint16_t num_banked_pts, uint32_t block_id, uint32_t pt_id) const;
+
   /// Get total number of firing sequences in the number of blocks + number of points.
   /// \param num_blocks Total number of blocks.
   /// \param pt_id Residue number of points
@@ -108,10 +130,17 @@ private:
   /// \return none
   VELODYNE_DRIVER_LOCAL void init_altitude_table();
 
+  /// \brief initializes the firing times relative to the first firing in a packet. This only needs
+  ///        to run once and happens in the constructor
+  /// \return none
+  VELODYNE_DRIVER_LOCAL void init_time_table();
+
   /// lookup table for azimuth offset for each point index in a block
   std::array<uint32_t, NUM_LASERS> m_azimuth_ind;
   /// lookup table for altitude angle for each firing in a fire sequence (2 per block)
   std::array<uint32_t, NUM_LASERS> m_altitude_ind;
+  /// lookup table for the firing time of each laser in a fire sequence
+  std::array<float32_t, NUM_LASERS> m_time_offset_us;
 
   uint16_t m_num_blocks_per_revolution;
 };
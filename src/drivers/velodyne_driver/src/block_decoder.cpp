@@ -0,0 +1,232 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <velodyne_driver/block_decoder.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace autoware
+{
+namespace drivers
+{
+namespace velodyne_driver
+{
+namespace
+{
+// The kernels only use multiplications and sign flips of the same operands as the scalar
+// translator, which are exact in IEEE arithmetic, so all of them give the same bits. No kernel
+// may use fused multiply-adds.
+
+/// Per channel conversion, same operations as VelodyneTranslator::convert()
+void decode_block_scalar(
+  const uint8_t * const channels,
+  const uint32_t azimuth_base,
+  const uint32_t * const azimuth_offsets,
+  const uint32_t * const altitudes,
+  const DecodeTables & tables,
+  BlockPoints & out)
+{
+  for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+    const uint8_t * const channel = &channels[3U * pt_id];
+    const uint32_t th = (azimuth_base + azimuth_offsets[pt_id]) % AZIMUTH_ROTATION_RESOLUTION;
+    const float32_t r =
+      static_cast<float32_t>(to_uint32(channel[1U], channel[0U])) * tables.distance_resolution;
+    const uint32_t phi = altitudes[pt_id];
+    const float32_t r_xy = r * tables.cos_table[phi];
+    out.x[pt_id] = r_xy * tables.cos_table[th];
+    out.y[pt_id] = -r_xy * tables.sin_table[th];
+    out.z[pt_id] = r * tables.sin_table[phi];
+    out.intensity[pt_id] = tables.intensity_table[channel[2U]];
+  }
+}
+
+/// Split the interleaved channel bytes into distances and intensity indices
+inline void split_channels(
+  const uint8_t * const channels,
+  int32_t * const distances,
+  int32_t * const intensities)
+{
+  for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+    const uint8_t * const channel = &channels[3U * pt_id];
+    distances[pt_id] = static_cast<int32_t>(to_uint32(channel[1U], channel[0U]));
+    intensities[pt_id] = static_cast<int32_t>(channel[2U]);
+  }
+}
+
+#if defined(__SSE2__)
+/// Azimuth index modulo AZIMUTH_ROTATION_RESOLUTION. The sum of a 16 bit azimuth and an offset
+/// below the resolution is less than three resolutions, so two conditional subtractions suffice
+inline __m128i wrap_azimuth_sse2(__m128i th)
+{
+  const __m128i res = _mm_set1_epi32(static_cast<int32_t>(AZIMUTH_ROTATION_RESOLUTION));
+  const __m128i last = _mm_set1_epi32(static_cast<int32_t>(AZIMUTH_ROTATION_RESOLUTION - 1U));
+  th = _mm_sub_epi32(th, _mm_and_si128(_mm_cmpgt_epi32(th, last), res));
+  return _mm_sub_epi32(th, _mm_and_si128(_mm_cmpgt_epi32(th, last), res));
+}
+
+/// 4 channels at a time, the table lookups stay scalar as SSE2 has no gather
+void decode_block_sse2(
+  const uint8_t * const channels,
+  const uint32_t azimuth_base,
+  const uint32_t * const azimuth_offsets,
+  const uint32_t * const altitudes,
+  const DecodeTables & tables,
+  BlockPoints & out)
+{
+  alignas(16) int32_t distances[NUM_POINTS_PER_BLOCK];
+  alignas(16) int32_t intensities[NUM_POINTS_PER_BLOCK];
+  split_channels(channels, distances, intensities);
+  const __m128i base = _mm_set1_epi32(static_cast<int32_t>(azimuth_base));
+  const __m128 resolution = _mm_set1_ps(tables.distance_resolution);
+  const __m128 sign = _mm_set1_ps(-0.0F);
+  const float32_t * const cos_table = tables.cos_table;
+  const float32_t * const sin_table = tables.sin_table;
+  alignas(16) uint32_t th[4U];
+  for (uint32_t idx = 0U; idx < NUM_POINTS_PER_BLOCK; idx += 4U) {
+    //lint -e{9176} NOLINT unaligned load of integer lanes
+    const __m128i offsets =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(&azimuth_offsets[idx]));
+    //lint -e{9176} NOLINT aligned store of integer lanes
+    _mm_store_si128(
+      reinterpret_cast<__m128i *>(th), wrap_azimuth_sse2(_mm_add_epi32(offsets, base)));
+    const uint32_t * const phi = &altitudes[idx];
+    const __m128 cos_phi = _mm_setr_ps(
+      cos_table[phi[0U]], cos_table[phi[1U]], cos_table[phi[2U]], cos_table[phi[3U]]);
+    const __m128 sin_phi = _mm_setr_ps(
+      sin_table[phi[0U]], sin_table[phi[1U]], sin_table[phi[2U]], sin_table[phi[3U]]);
+    const __m128 cos_th = _mm_setr_ps(
+      cos_table[th[0U]], cos_table[th[1U]], cos_table[th[2U]], cos_table[th[3U]]);
+    const __m128 sin_th = _mm_setr_ps(
+      sin_table[th[0U]], sin_table[th[1U]], sin_table[th[2U]], sin_table[th[3U]]);
+    //lint -e{9176} NOLINT aligned load of integer lanes
+    const __m128 r = _mm_mul_ps(
+      _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i *>(&distances[idx]))),
+      resolution);
+    const __m128 r_xy = _mm_mul_ps(r, cos_phi);
+    _mm_storeu_ps(&out.x[idx], _mm_mul_ps(r_xy, cos_th));
+    _mm_storeu_ps(&out.y[idx], _mm_mul_ps(_mm_xor_ps(r_xy, sign), sin_th));
+    _mm_storeu_ps(&out.z[idx], _mm_mul_ps(r, sin_phi));
+    const int32_t * const intensity = &intensities[idx];
+    _mm_storeu_ps(&out.intensity[idx], _mm_setr_ps(
+        tables.intensity_table[intensity[0U]], tables.intensity_table[intensity[1U]],
+        tables.intensity_table[intensity[2U]], tables.intensity_table[intensity[3U]]));
+  }
+}
+#endif  // __SSE2__
+
+#if defined(__x86_64__) || defined(__i386__)
+/// 8 channels at a time with gathered table lookups. Compiled for AVX2 regardless of the baseline
+/// flags, only called after runtime detection
+__attribute__((target("avx2")))
+void decode_block_avx2(
+  const uint8_t * const channels,
+  const uint32_t azimuth_base,
+  const uint32_t * const azimuth_offsets,
+  const uint32_t * const altitudes,
+  const DecodeTables & tables,
+  BlockPoints & out)
+{
+  alignas(32) int32_t distances[NUM_POINTS_PER_BLOCK];
+  alignas(32) int32_t intensities[NUM_POINTS_PER_BLOCK];
+  split_channels(channels, distances, intensities);
+  const __m256i base = _mm256_set1_epi32(static_cast<int32_t>(azimuth_base));
+  const __m256i res = _mm256_set1_epi32(static_cast<int32_t>(AZIMUTH_ROTATION_RESOLUTION));
+  const __m256i last = _mm256_set1_epi32(static_cast<int32_t>(AZIMUTH_ROTATION_RESOLUTION - 1U));
+  const __m256 resolution = _mm256_set1_ps(tables.distance_resolution);
+  const __m256 sign = _mm256_set1_ps(-0.0F);
+  for (uint32_t idx = 0U; idx < NUM_POINTS_PER_BLOCK; idx += 8U) {
+    //lint -e{9176} NOLINT unaligned load of integer lanes
+    __m256i th = _mm256_add_epi32(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&azimuth_offsets[idx])), base);
+    // Same wrap around as in wrap_azimuth_sse2()
+    th = _mm256_sub_epi32(th, _mm256_and_si256(_mm256_cmpgt_epi32(th, last), res));
+    th = _mm256_sub_epi32(th, _mm256_and_si256(_mm256_cmpgt_epi32(th, last), res));
+    //lint -e{9176} NOLINT unaligned load of integer lanes
+    const __m256i phi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&altitudes[idx]));
+    const __m256 cos_phi = _mm256_i32gather_ps(tables.cos_table, phi, 4);
+    const __m256 sin_phi = _mm256_i32gather_ps(tables.sin_table, phi, 4);
+    const __m256 cos_th = _mm256_i32gather_ps(tables.cos_table, th, 4);
+    const __m256 sin_th = _mm256_i32gather_ps(tables.sin_table, th, 4);
+    //lint -e{9176} NOLINT aligned load of integer lanes
+    const __m256 r = _mm256_mul_ps(
+      _mm256_cvtepi32_ps(_mm256_load_si256(reinterpret_cast<const __m256i *>(&distances[idx]))),
+      resolution);
+    const __m256 r_xy = _mm256_mul_ps(r, cos_phi);
+    _mm256_storeu_ps(&out.x[idx], _mm256_mul_ps(r_xy, cos_th));
+    _mm256_storeu_ps(&out.y[idx], _mm256_mul_ps(_mm256_xor_ps(r_xy, sign), sin_th));
+    _mm256_storeu_ps(&out.z[idx], _mm256_mul_ps(r, sin_phi));
+    //lint -e{9176} NOLINT aligned load of integer lanes
+    const __m256i intensity =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(&intensities[idx]));
+    _mm256_storeu_ps(&out.intensity[idx],
+      _mm256_i32gather_ps(tables.intensity_table, intensity, 4));
+  }
+}
+#endif  // x86
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+SimdLevel detect_simd_level()
+{
+  static const SimdLevel level = []() {
+      SimdLevel ret = SimdLevel::SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+        ret = SimdLevel::AVX2;
+      } else if (__builtin_cpu_supports("sse2")) {
+#if defined(__SSE2__)
+        ret = SimdLevel::SSE2;
+#endif
+      }
+#endif
+      return ret;
+    } ();
+  return level;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void decode_block(
+  const uint8_t * const channels,
+  const uint32_t azimuth_base,
+  const uint32_t * const azimuth_offsets,
+  const uint32_t * const altitudes,
+  const DecodeTables & tables,
+  BlockPoints & out,
+  const SimdLevel level)
+{
+  switch (level) {
+#if defined(__x86_64__) || defined(__i386__)
+    case SimdLevel::AVX2:
+      decode_block_avx2(channels, azimuth_base, azimuth_offsets, altitudes, tables, out);
+      break;
+#endif
+#if defined(__SSE2__)
+    case SimdLevel::SSE2:
+      decode_block_sse2(channels, azimuth_base, azimuth_offsets, altitudes, tables, out);
+      break;
+#endif
+    default:
+      decode_block_scalar(channels, azimuth_base, azimuth_offsets, altitudes, tables, out);
+      break;
+  }
+}
+
+}  // namespace velodyne_driver
+}  // namespace drivers
+}  // namespace autoware
@@ -29,6 +29,7 @@ VLS128Data::VLS128Data(const float32_t rpm)
 {
   init_azimuth_table(rpm);
   init_altitude_table();
+  init_time_table();
   // (60E6 us/min * x min/rev = us/rev) * (seq/us * block/seq) = block / rev
   m_num_blocks_per_revolution =
     static_cast<uint16_t>(std::roundf(60.0E6F /
@@ -45,6 +46,25 @@ uint32_t VLS128Data::altitude(uint16_t num_banked_pts, uint32_t, uint32_t pt_id)
   return m_altitude_ind[num_banked_pts + pt_id];
 }
 
+const uint32_t * VLS128Data::azimuth_offsets(uint16_t num_banked_pts, uint32_t) const noexcept
+{
+  return &m_azimuth_ind[num_banked_pts];
+}
+
+const uint32_t * VLS128Data::altitudes(uint16_t num_banked_pts, uint32_t) const noexcept
+{
+  return &m_altitude_ind[num_banked_pts];
+}
+
+float32_t VLS128Data::time_offset_us(
+  uint16_t num_banked_pts, uint32_t block_id, uint32_t pt_id) const
+{
+  // A fire sequence is spread over 4 blocks, a packet holds 3 complete sequences
+  constexpr uint32_t num_blocks_per_seq = NUM_LASERS / NUM_POINTS_PER_BLOCK;
+  return (static_cast<float32_t>(block_id / num_blocks_per_seq) * FIRE_SEQ_OFFSET_US) +
+         m_time_offset_us[num_banked_pts + pt_id];
+}
+
 uint16_t VLS128Data::seq_id(uint16_t num_blocks, uint32_t) const noexcept
 {
   return static_cast<uint16_t>(std::floor(NUM_SEQUENCES_PER_BLOCK * num_blocks));
@@ -81,6 +101,18 @@ void VLS128Data::init_azimuth_table(const float32_t rpm)
   }
 }
 
+void VLS128Data::init_time_table()
+{
+  // Same firing schedule as in init_azimuth_table(): all 8 lasers of a group fire at once, with
+  // a maintenance period after the first 8 groups
+  for (uint32_t pt_id = 0U; pt_id < NUM_LASERS; ++pt_id) {
+    const uint32_t num_groups_fired = pt_id / GROUP_SIZE;
+    const auto maintenance_offset_us = num_groups_fired < 8U ? 0.0F : MAINTENANCE_DURATION1_US;
+    m_time_offset_us[pt_id] =
+      (static_cast<float32_t>(num_groups_fired) * FIRE_DURATION_US) + maintenance_offset_us;
+  }
+}
+
 uint16_t VLS128Data::num_blocks_per_revolution() const noexcept
 {
   return m_num_blocks_per_revolution;
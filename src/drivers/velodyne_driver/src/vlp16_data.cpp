@@ -27,6 +27,7 @@ VLP16Data::VLP16Data(const float32_t rpm)
 {
   init_azimuth_table(rpm);
   init_altitude_table();
+  init_time_table();
   // (60E6 us/min * x min/rev = us/rev) * (seq/us * block/seq) = block / rev
   m_num_blocks_per_revolution =
     static_cast<uint16_t>(std::ceil(60.0E6F / (rpm * FIRE_SEQ_OFFSET_US * 2.0F)));
@@ -39,7 +40,22 @@ uint32_t VLP16Data::azimuth_offset(uint16_t, uint32_t, uint32_t pt_id) const
 
 uint32_t VLP16Data::altitude(uint16_t, uint32_t, uint32_t pt_id) const
 {
-  return m_altitude_ind[pt_id % NUM_LASERS];
+  return m_altitude_ind[pt_id];
+}
+
+const uint32_t * VLP16Data::azimuth_offsets(uint16_t, uint32_t) const noexcept
+{
+  return m_azimuth_ind.data();
+}
+
+const uint32_t * VLP16Data::altitudes(uint16_t, uint32_t) const noexcept
+{
+  return m_altitude_ind.data();
+}
+
+float32_t VLP16Data::time_offset_us(uint16_t, uint32_t block_id, uint32_t pt_id) const
+{
+  return m_time_offset_us[(block_id * NUM_POINTS_PER_BLOCK) + pt_id];
 }
 
 uint16_t VLP16Data::seq_id(uint16_t num_blocks, uint32_t pt_id) const noexcept
@@ -65,6 +81,20 @@ void VLP16Data::init_azimuth_table(const float32_t rpm)
   }
 }
 
+void VLP16Data::init_time_table()
+{
+  // Each block holds two full fire sequences, one laser fires after the other:
+  // us = 55.296 * fire_seq + 2.304 * (point idx % 16)
+  for (uint32_t block_id = 0U; block_id < NUM_BLOCKS_PER_PACKET; ++block_id) {
+    for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+      const auto fire_seq = (block_id * 2U) + (pt_id / NUM_LASERS);
+      m_time_offset_us[(block_id * NUM_POINTS_PER_BLOCK) + pt_id] =
+        (static_cast<float32_t>(fire_seq) * FIRE_SEQ_OFFSET_US) +
+        (static_cast<float32_t>(pt_id % NUM_LASERS) * FIRE_DURATION_US);
+    }
+  }
+}
+
 std::pair<bool8_t, uint16_t> VLP16Data::check_flag(const BlockFlag & flag)
 {
   const auto valid = (flag[0U] == static_cast<uint8_t>(0xFF)) &&
@@ -109,6 +139,8 @@ void VLP16Data::init_altitude_table()
       deg_idx += static_cast<int32_t>(AZIMUTH_ROTATION_RESOLUTION);
     }
     m_altitude_ind[idx] = static_cast<uint32_t>(deg_idx);
+    // A block holds two fire sequences
+    m_altitude_ind[idx + NUM_LASERS] = static_cast<uint32_t>(deg_idx);
   }
 }
 
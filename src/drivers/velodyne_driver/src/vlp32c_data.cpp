@@ -29,6 +29,7 @@ VLP32CData::VLP32CData(const float32_t rpm)
 {
   init_azimuth_table(rpm);
   init_altitude_table();
+  init_time_table();
   // (60E6 us/min * x min/rev = us/rev) * (seq/us * block/seq) = block / rev
   m_num_blocks_per_revolution =
     static_cast<uint16_t>(std::floor(60.0E6F /
@@ -45,6 +46,21 @@ uint32_t VLP32CData::altitude(uint16_t, uint32_t, uint32_t pt_id) const
   return m_altitude_ind[pt_id];
 }
 
+const uint32_t * VLP32CData::azimuth_offsets(uint16_t, uint32_t) const noexcept
+{
+  return m_azimuth_ind.data();
+}
+
+const uint32_t * VLP32CData::altitudes(uint16_t, uint32_t) const noexcept
+{
+  return m_altitude_ind.data();
+}
+
+float32_t VLP32CData::time_offset_us(uint16_t, uint32_t block_id, uint32_t pt_id) const
+{
+  return m_time_offset_us[(block_id * NUM_POINTS_PER_BLOCK) + pt_id];
+}
+
 uint16_t VLP32CData::seq_id(uint16_t num_blocks, uint32_t) const noexcept
 {
   return num_blocks;
@@ -78,6 +94,19 @@ uint16_t VLP32CData::num_blocks_per_revolution() const noexcept
   return m_num_blocks_per_revolution;
 }
 
+void VLP32CData::init_time_table()
+{
+  // Each block holds one full fire sequence, the lasers fire in groups of 2
+  for (uint32_t block_id = 0U; block_id < NUM_BLOCKS_PER_PACKET; ++block_id) {
+    for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+      const uint32_t group_id = pt_id / GROUP_SIZE;
+      m_time_offset_us[(block_id * NUM_POINTS_PER_BLOCK) + pt_id] =
+        (static_cast<float32_t>(block_id) * FIRE_SEQ_OFFSET_US) +
+        (static_cast<float32_t>(group_id) * FIRE_DURATION_US);
+    }
+  }
+}
+
 std::pair<bool8_t, uint16_t> VLP32CData::check_flag(const BlockFlag & flag)
 {
   const auto valid = (flag[0U] == static_cast<uint8_t>(0xFF)) &&
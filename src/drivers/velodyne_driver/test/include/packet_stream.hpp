@@ -0,0 +1,73 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef PACKET_STREAM_HPP_
+#define PACKET_STREAM_HPP_
+
+#include <velodyne_driver/velodyne_translator.hpp>
+#include <cmath>
+#include <vector>
+
+// Fills packets of a sensor spinning at the given rate with points at varying distances
+template<typename SensorData>
+std::vector<typename autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>::Packet>
+make_packet_stream(const autoware::common::types::float32_t rpm, const uint32_t num_packets)
+{
+  using autoware::common::types::float32_t;
+  using autoware::drivers::velodyne_driver::AZIMUTH_ROTATION_RESOLUTION;
+  using autoware::drivers::velodyne_driver::NUM_BLOCKS_PER_PACKET;
+  using autoware::drivers::velodyne_driver::NUM_POINTS_PER_BLOCK;
+  using Packet =
+    typename autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>::Packet;
+  constexpr uint32_t num_blocks_per_seq =
+    (SensorData::NUM_LASERS + NUM_POINTS_PER_BLOCK - 1U) / NUM_POINTS_PER_BLOCK;
+  constexpr uint8_t flags[4U] = {0xEE, 0xDD, 0xCC, 0xBB};
+  // Azimuth moved by the sensor per fire sequence
+  const float32_t seq_azimuth =
+    (rpm / 60.0E6F) * SensorData::FIRE_SEQ_OFFSET_US * AZIMUTH_ROTATION_RESOLUTION;
+  std::vector<Packet> packets(num_packets);
+  uint32_t seq = 0U;
+  uint32_t timestamp_us = 0U;
+  for (auto & pkt : packets) {
+    for (uint32_t block_id = 0U; block_id < NUM_BLOCKS_PER_PACKET; ++block_id) {
+      auto & block = pkt.blocks[block_id];
+      block.flag[0U] = 0xFF;
+      block.flag[1U] = (num_blocks_per_seq > 1U) ? flags[block_id % num_blocks_per_seq] : 0xEE;
+      const auto azimuth = static_cast<uint32_t>(static_cast<float32_t>(seq) * seq_azimuth) %
+        AZIMUTH_ROTATION_RESOLUTION;
+      block.azimuth_bytes[0U] = static_cast<uint8_t>(azimuth & 0xFFU);
+      block.azimuth_bytes[1U] = static_cast<uint8_t>(azimuth >> 8U);
+      for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+        const uint32_t dist = 1000U + ((seq * 37U + pt_id * 101U) % 20000U);
+        block.channels[pt_id].data[0U] = static_cast<uint8_t>(dist & 0xFFU);
+        block.channels[pt_id].data[1U] = static_cast<uint8_t>(dist >> 8U);
+        block.channels[pt_id].data[2U] = static_cast<uint8_t>(pt_id * 7U);
+      }
+      if ((block_id % num_blocks_per_seq) == (num_blocks_per_seq - 1U)) {
+        ++seq;
+      }
+    }
+    for (uint32_t idx = 0U; idx < 4U; ++idx) {
+      pkt.timestamp_bytes[idx] = static_cast<uint8_t>(timestamp_us >> (8U * idx));
+    }
+    timestamp_us += static_cast<uint32_t>(std::lround(
+        static_cast<float32_t>(NUM_BLOCKS_PER_PACKET / num_blocks_per_seq) *
+        SensorData::FIRE_SEQ_OFFSET_US));
+  }
+  return packets;
+}
+
+#endif  // PACKET_STREAM_HPP_
@@ -256,6 +256,41 @@ TEST_F(velodyne_driver, basic)
   EXPECT_LE(phi_diff, (20.0F * 3.14159F / 180.0F) + 0.001F);
 }
 
+TEST_F(velodyne_driver, time_offsets)
+{
+  using autoware::drivers::velodyne_driver::VLP16Data;
+  const Vlp16Translator::Config cfg{300.0F};
+  Vlp16Translator driver(cfg);
+  std::vector<float32_t> time_offsets_us;
+  driver.convert(pkt, out, time_offsets_us);
+  ASSERT_EQ(out.size(), time_offsets_us.size());
+  const float32_t seq_us = VLP16Data::FIRE_SEQ_OFFSET_US;
+  const float32_t fire_us = VLP16Data::FIRE_DURATION_US;
+  // Timestamp bytes 0xac, 0x1a, 0x32, 0x20 are little endian
+  EXPECT_EQ(Vlp16Translator::packet_timestamp_us(pkt), 0x20321AACU);
+  // Each block holds two fire sequences of 16 lasers firing one after the other
+  EXPECT_FLOAT_EQ(time_offsets_us[0U], 0.0F);
+  EXPECT_FLOAT_EQ(time_offsets_us[1U], fire_us);
+  EXPECT_FLOAT_EQ(time_offsets_us[16U], seq_us);
+  EXPECT_FLOAT_EQ(time_offsets_us[32U], 2.0F * seq_us);
+  for (uint32_t idx = 1U; idx < time_offsets_us.size(); ++idx) {
+    EXPECT_GT(time_offsets_us[idx], time_offsets_us[idx - 1U]);
+  }
+  EXPECT_LT(time_offsets_us.back(), 24.0F * seq_us);
+  // The points are the same as without time offsets
+  Vlp16Translator driver_no_times(cfg);
+  std::vector<autoware::common::types::PointXYZIF> out_no_times;
+  driver_no_times.convert(pkt, out_no_times);
+  ASSERT_EQ(out.size(), out_no_times.size());
+  for (uint32_t idx = 0U; idx < out.size(); ++idx) {
+    EXPECT_EQ(out[idx].x, out_no_times[idx].x);
+    EXPECT_EQ(out[idx].id, out_no_times[idx].id);
+  }
+  // Timestamps wrap around at the top of the hour
+  EXPECT_EQ(Vlp16Translator::packet_time_diff_us(100U, 1427U), 1327U);
+  EXPECT_EQ(Vlp16Translator::packet_time_diff_us(3599999000U, 500U), 1500U);
+}
+
 // figure out what the runtime of convert() is, locally
 TEST_F(velodyne_driver, benchmark)
 {
@@ -0,0 +1,253 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <velodyne_driver/block_decoder.hpp>
+#include <velodyne_driver/velodyne_translator.hpp>
+#include <gtest/gtest.h>
+#include <packet_stream.hpp>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using autoware::common::types::float32_t;
+using autoware::common::types::PointXYZIF;
+using autoware::drivers::velodyne_driver::SimdLevel;
+using autoware::drivers::velodyne_driver::detect_simd_level;
+using autoware::drivers::velodyne_driver::NUM_BLOCKS_PER_PACKET;
+
+namespace
+{
+uint32_t bits(const float32_t value)
+{
+  uint32_t ret;
+  std::memcpy(&ret, &value, sizeof(ret));
+  return ret;
+}
+
+// Packets of random bytes, with a valid flag on most blocks
+template<typename Packet>
+std::vector<Packet> make_random_packets(const uint32_t num_packets)
+{
+  constexpr uint8_t flags[5U] = {0xEE, 0xDD, 0xCC, 0xBB, 0x00};
+  std::mt19937 gen{42U};
+  std::uniform_int_distribution<uint32_t> byte{0U, 255U};
+  std::vector<Packet> packets(num_packets);
+  for (auto & pkt : packets) {
+    auto * const raw = reinterpret_cast<uint8_t *>(&pkt);
+    for (std::size_t idx = 0U; idx < sizeof(Packet); ++idx) {
+      raw[idx] = static_cast<uint8_t>(byte(gen));
+    }
+    for (auto & block : pkt.blocks) {
+      block.flag[0U] = (byte(gen) < 224U) ? 0xFF : 0x00;
+      block.flag[1U] = flags[byte(gen) % 5U];
+    }
+  }
+  return packets;
+}
+
+// Converts the packets with the scalar translator and with the block decoder at every level the
+// CPU supports, the outputs must have the same bits
+template<typename SensorData>
+void check_bit_exact(
+  const std::vector<typename autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>::
+  Packet> & packets)
+{
+  using Translator = autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>;
+  constexpr float32_t rpm = 600.0F;
+  const auto max_points = Translator::MAX_POINTS_PER_PACKET;
+  for (uint8_t level = 0U; level <= static_cast<uint8_t>(detect_simd_level()); ++level) {
+    Translator reference{typename Translator::Config{rpm}};
+    Translator decoder{typename Translator::Config{rpm}};
+    std::vector<PointXYZIF> expected;
+    std::vector<PointXYZIF> output(max_points);
+    std::size_t num_checked = 0U;
+    for (const auto & pkt : packets) {
+      reference.convert(pkt, expected);
+      const auto num_points = decoder.convert(pkt, output.data(), static_cast<SimdLevel>(level));
+      ASSERT_EQ(num_points, expected.size());
+      for (std::size_t idx = 0U; idx < num_points; ++idx) {
+        ASSERT_EQ(bits(output[idx].x), bits(expected[idx].x)) << "level " << int(level);
+        ASSERT_EQ(bits(output[idx].y), bits(expected[idx].y)) << "level " << int(level);
+        ASSERT_EQ(bits(output[idx].z), bits(expected[idx].z)) << "level " << int(level);
+        ASSERT_EQ(bits(output[idx].intensity), bits(expected[idx].intensity));
+        ASSERT_EQ(output[idx].id, expected[idx].id);
+      }
+      num_checked += num_points;
+    }
+    EXPECT_GT(num_checked, 0U);
+  }
+}
+
+// Collects the blocks of convert_blocks() the way the vector convert() lays them out
+struct VectorWriter
+{
+  void write_block(
+    const autoware::drivers::velodyne_driver::BlockPoints & points, const uint16_t * const ids,
+    const float32_t * const block_times_us)
+  {
+    for (uint32_t pt_id = 0U; pt_id < autoware::drivers::velodyne_driver::NUM_POINTS_PER_BLOCK;
+      ++pt_id)
+    {
+      PointXYZIF pt;
+      pt.x = points.x[pt_id];
+      pt.y = points.y[pt_id];
+      pt.z = points.z[pt_id];
+      pt.intensity = points.intensity[pt_id];
+      pt.id = ids[pt_id];
+      output.push_back(pt);
+      last_time_us = block_times_us[pt_id];
+      time_offsets_us.push_back(last_time_us);
+    }
+  }
+  void end_of_scan()
+  {
+    PointXYZIF pt;
+    pt.id = static_cast<uint16_t>(PointXYZIF::END_OF_SCAN_ID);
+    output.push_back(pt);
+    time_offsets_us.push_back(last_time_us);
+  }
+  std::vector<PointXYZIF> output;
+  std::vector<float32_t> time_offsets_us;
+  float32_t last_time_us{0.0F};
+};
+
+// The blocks of convert_blocks() must match the timed convert() bit for bit
+template<typename SensorData>
+void check_writer(
+  const std::vector<typename autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>::
+  Packet> & packets)
+{
+  using Translator = autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>;
+  constexpr float32_t rpm = 600.0F;
+  Translator reference{typename Translator::Config{rpm}};
+  Translator decoder{typename Translator::Config{rpm}};
+  std::vector<PointXYZIF> expected;
+  std::vector<float32_t> expected_times_us;
+  VectorWriter writer;
+  for (const auto & pkt : packets) {
+    reference.convert(pkt, expected, expected_times_us);
+    writer.output.clear();
+    writer.time_offsets_us.clear();
+    decoder.convert_blocks(pkt, writer, true, detect_simd_level());
+    ASSERT_EQ(writer.output.size(), expected.size());
+    for (std::size_t idx = 0U; idx < expected.size(); ++idx) {
+      ASSERT_EQ(bits(writer.output[idx].x), bits(expected[idx].x));
+      ASSERT_EQ(bits(writer.output[idx].y), bits(expected[idx].y));
+      ASSERT_EQ(bits(writer.output[idx].z), bits(expected[idx].z));
+      ASSERT_EQ(bits(writer.output[idx].intensity), bits(expected[idx].intensity));
+      ASSERT_EQ(writer.output[idx].id, expected[idx].id);
+      ASSERT_EQ(bits(writer.time_offsets_us[idx]), bits(expected_times_us[idx]));
+    }
+  }
+}
+
+template<typename SensorData>
+void check_bit_exact()
+{
+  using Packet =
+    typename autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>::Packet;
+  check_bit_exact<SensorData>(make_packet_stream<SensorData>(600.0F, 200U));
+  check_bit_exact<SensorData>(make_random_packets<Packet>(200U));
+  check_writer<SensorData>(make_packet_stream<SensorData>(600.0F, 200U));
+  check_writer<SensorData>(make_random_packets<Packet>(200U));
+}
+
+// Decodes one sweep of packets with the scalar translator and with the block decoder at every
+// level the CPU supports, and reports the runtime per sweep
+template<typename SensorData>
+void benchmark_decode(const std::string & model)
+{
+  using Translator = autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>;
+  constexpr float32_t rpm = 600.0F;
+  const auto blocks_per_sweep = SensorData{rpm}.num_blocks_per_revolution();
+  const auto num_packets = (blocks_per_sweep / NUM_BLOCKS_PER_PACKET) + 1U;
+  const auto packets = make_packet_stream<SensorData>(rpm, num_packets);
+  const uint32_t num_runs = 20U;
+  const auto max_points = Translator::MAX_POINTS_PER_PACKET;
+  const auto to_us = [num_runs](const std::chrono::nanoseconds duration) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / num_runs;
+    };
+
+  Translator reference{typename Translator::Config{rpm}};
+  std::vector<PointXYZIF> out;
+  out.reserve(Translator::POINT_BLOCK_CAPACITY);
+  std::size_t num_points = 0U;
+  const auto reference_begin = std::chrono::steady_clock::now();
+  for (uint32_t run = 0U; run < num_runs; ++run) {
+    num_points = 0U;
+    for (const auto & pkt : packets) {
+      reference.convert(pkt, out);
+      num_points += out.size();
+    }
+  }
+  const auto reference_end = std::chrono::steady_clock::now();
+  std::cerr << model << " sweep of " << num_points << " points (" << num_packets << " packets)\n";
+  std::cerr << "convert() average runtime per sweep: " <<
+    to_us(reference_end - reference_begin) << " µs\n";
+
+  const char * const level_names[3U] = {"scalar", "SSE2", "AVX2"};
+  // Points are written to one buffer for the whole sweep, like a node filling its output cloud
+  std::vector<PointXYZIF> sweep(num_packets * max_points);
+  for (uint8_t level = 0U; level <= static_cast<uint8_t>(detect_simd_level()); ++level) {
+    Translator decoder{typename Translator::Config{rpm}};
+    std::size_t num_decoded = 0U;
+    const auto begin = std::chrono::steady_clock::now();
+    for (uint32_t run = 0U; run < num_runs; ++run) {
+      num_decoded = 0U;
+      for (const auto & pkt : packets) {
+        num_decoded += decoder.convert(pkt, &sweep[num_decoded], static_cast<SimdLevel>(level));
+      }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(num_decoded, num_points);
+    std::cerr << "convert() into a span, " << level_names[level] <<
+      " block decoding, average runtime per sweep: " << to_us(end - begin) << " µs\n";
+  }
+}
+}  // namespace
+
+TEST(BlockDecoderTest, bit_exact_vlp16)
+{
+  check_bit_exact<autoware::drivers::velodyne_driver::VLP16Data>();
+}
+
+TEST(BlockDecoderTest, bit_exact_vlp32c)
+{
+  check_bit_exact<autoware::drivers::velodyne_driver::VLP32CData>();
+}
+
+TEST(BlockDecoderTest, bit_exact_vls128)
+{
+  check_bit_exact<autoware::drivers::velodyne_driver::VLS128Data>();
+}
+
+TEST(BlockDecoderTest, benchmark_vlp16)
+{
+  benchmark_decode<autoware::drivers::velodyne_driver::VLP16Data>("VLP-16");
+}
+
+TEST(BlockDecoderTest, benchmark_vlp32c)
+{
+  benchmark_decode<autoware::drivers::velodyne_driver::VLP32CData>("VLP-32C");
+}
+
+TEST(BlockDecoderTest, benchmark_vls128)
+{
+  benchmark_decode<autoware::drivers::velodyne_driver::VLS128Data>("VLS-128");
+}
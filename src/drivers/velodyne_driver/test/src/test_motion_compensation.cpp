@@ -0,0 +1,156 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <velodyne_driver/motion_compensation.hpp>
+#include <velodyne_driver/velodyne_translator.hpp>
+#include <gtest/gtest.h>
+#include <packet_stream.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using autoware::common::types::float32_t;
+using autoware::common::types::PointXYZIF;
+using autoware::drivers::velodyne_driver::SensorTwist;
+using autoware::drivers::velodyne_driver::compensate_motion;
+using autoware::drivers::velodyne_driver::NUM_BLOCKS_PER_PACKET;
+
+TEST(MotionCompensationTest, translation)
+{
+  // Driving forward, a point ahead gets closer by the distance driven
+  const SensorTwist twist{20.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F};
+  float32_t x = 10.0F;
+  float32_t y = 3.0F;
+  float32_t z = -1.0F;
+  compensate_motion(twist, 0.1F, x, y, z);
+  EXPECT_FLOAT_EQ(x, 8.0F);
+  EXPECT_FLOAT_EQ(y, 3.0F);
+  EXPECT_FLOAT_EQ(z, -1.0F);
+  // Points measured at the reference time stay where they are
+  compensate_motion(twist, 0.0F, x, y, z);
+  EXPECT_FLOAT_EQ(x, 8.0F);
+}
+
+TEST(MotionCompensationTest, rotation)
+{
+  // Turning left, a point ahead moves to the right, compare against the exact rotation
+  const float32_t yaw_rate = 0.5F;
+  const float32_t dt = 0.1F;
+  const SensorTwist twist{0.0F, 0.0F, 0.0F, 0.0F, 0.0F, yaw_rate};
+  float32_t x = 50.0F;
+  float32_t y = 0.0F;
+  float32_t z = 2.0F;
+  compensate_motion(twist, dt, x, y, z);
+  const float32_t angle = -yaw_rate * dt;
+  // The second order expansion is accurate to about a millimeter here
+  EXPECT_NEAR(x, 50.0F * std::cos(angle), 2.0E-3F);
+  EXPECT_NEAR(y, 50.0F * std::sin(angle), 2.0E-3F);
+  EXPECT_FLOAT_EQ(z, 2.0F);
+  EXPECT_LT(y, 0.0F);
+}
+
+// Decodes one sweep of packets with and without time offsets and deskewing, and reports the
+// runtime per sweep
+template<typename SensorData>
+void benchmark_sweep(const std::string & model)
+{
+  using Translator = autoware::drivers::velodyne_driver::VelodyneTranslator<SensorData>;
+  constexpr float32_t rpm = 600.0F;
+  const auto blocks_per_sweep = SensorData{rpm}.num_blocks_per_revolution();
+  const auto num_packets = (blocks_per_sweep / NUM_BLOCKS_PER_PACKET) + 1U;
+  const auto packets = make_packet_stream<SensorData>(rpm, num_packets);
+  const SensorTwist twist{25.0F, 0.5F, 0.0F, 0.0F, 0.0F, 0.3F};
+  const uint32_t num_runs = 20U;
+
+  std::vector<PointXYZIF> out;
+  std::vector<float32_t> time_offsets_us;
+  out.reserve(Translator::POINT_BLOCK_CAPACITY);
+  time_offsets_us.reserve(Translator::POINT_BLOCK_CAPACITY);
+  std::vector<PointXYZIF> sweep;
+  std::vector<float32_t> sweep_times_us;
+  sweep.reserve(num_packets * Translator::POINT_BLOCK_CAPACITY);
+  sweep_times_us.reserve(num_packets * Translator::POINT_BLOCK_CAPACITY);
+
+  Translator plain{typename Translator::Config{rpm}};
+  const auto plain_begin = std::chrono::steady_clock::now();
+  for (uint32_t run = 0U; run < num_runs; ++run) {
+    sweep.clear();
+    for (const auto & pkt : packets) {
+      plain.convert(pkt, out);
+      sweep.insert(sweep.end(), out.begin(), out.end());
+    }
+  }
+  const auto plain_end = std::chrono::steady_clock::now();
+  const auto num_points = sweep.size();
+
+  Translator timed{typename Translator::Config{rpm}};
+  std::chrono::nanoseconds timed_duration{0};
+  std::chrono::nanoseconds deskew_duration{0};
+  float32_t checksum = 0.0F;
+  for (uint32_t run = 0U; run < num_runs; ++run) {
+    const auto timed_begin = std::chrono::steady_clock::now();
+    sweep.clear();
+    sweep_times_us.clear();
+    const auto start_us = Translator::packet_timestamp_us(packets.front());
+    for (const auto & pkt : packets) {
+      timed.convert(pkt, out, time_offsets_us);
+      const auto packet_time_us = static_cast<float32_t>(
+        Translator::packet_time_diff_us(start_us, Translator::packet_timestamp_us(pkt)));
+      sweep.insert(sweep.end(), out.begin(), out.end());
+      for (const auto time_us : time_offsets_us) {
+        sweep_times_us.push_back(packet_time_us + time_us);
+      }
+    }
+    const auto deskew_begin = std::chrono::steady_clock::now();
+    const float32_t end_us = sweep_times_us.back();
+    for (std::size_t idx = 0U; idx < sweep.size(); ++idx) {
+      auto & pt = sweep[idx];
+      compensate_motion(twist, (end_us - sweep_times_us[idx]) * 1.0E-6F, pt.x, pt.y, pt.z);
+    }
+    const auto deskew_end = std::chrono::steady_clock::now();
+    timed_duration += deskew_begin - timed_begin;
+    deskew_duration += deskew_end - deskew_begin;
+    checksum += sweep.back().x;
+  }
+  ASSERT_EQ(sweep.size(), num_points);
+  ASSERT_EQ(sweep_times_us.size(), num_points);
+  // A sweep at 600 rpm takes 100 ms
+  EXPECT_NEAR(sweep_times_us.back(), 100.0E3F, 1.0E3F);
+  EXPECT_TRUE(std::isfinite(checksum));
+
+  const auto to_us = [num_runs](const std::chrono::nanoseconds duration) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / num_runs;
+    };
+  std::cerr << model << " sweep of " << num_points << " points (" << num_packets << " packets)\n";
+  std::cerr << "convert() average runtime per sweep: " << to_us(plain_end - plain_begin) <<
+    " µs\n";
+  std::cerr << "convert() with time offsets average runtime per sweep: " <<
+    to_us(timed_duration) << " µs\n";
+  std::cerr << "compensate_motion() average runtime per sweep: " << to_us(deskew_duration) <<
+    " µs\n";
+}
+
+TEST(MotionCompensationTest, benchmark_vlp32c)
+{
+  benchmark_sweep<autoware::drivers::velodyne_driver::VLP32CData>("VLP-32C");
+}
+
+TEST(MotionCompensationTest, benchmark_vls128)
+{
+  benchmark_sweep<autoware::drivers::velodyne_driver::VLS128Data>("VLS-128");
+}
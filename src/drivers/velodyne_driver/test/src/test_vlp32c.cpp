@@ -88,3 +88,20 @@ TEST(VLP32CDataTest, flag_test) {
   check_flag({static_cast<uint8_t>(0xFF), static_cast<uint8_t>(0xAA)}, false, 0U, false);
   check_flag({static_cast<uint8_t>(0x00), static_cast<uint8_t>(0xDD)}, false, 0U, false);
 }
+
+TEST(VLP32CDataTest, time_offset_test) {
+  constexpr auto rpm{300U};
+  VLP32CData vlp32c_data{rpm};
+  const float32_t seq_us = VLP32CData::FIRE_SEQ_OFFSET_US;
+  const float32_t fire_us = VLP32CData::FIRE_DURATION_US;
+  // Each block is a full fire sequence, the lasers fire in pairs
+  for (auto block_id = 0U; block_id < 12U; ++block_id) {
+    for (auto pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+      const auto expected = (static_cast<float32_t>(block_id) * seq_us) +
+        (static_cast<float32_t>(pt_id / 2U) * fire_us);
+      EXPECT_FLOAT_EQ(vlp32c_data.time_offset_us(0U, block_id, pt_id), expected);
+    }
+  }
+  // The last pair fires before the next sequence starts
+  EXPECT_LT(vlp32c_data.time_offset_us(0U, 0U, 31U), seq_us);
+}
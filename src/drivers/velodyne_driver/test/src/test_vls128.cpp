@@ -118,3 +118,35 @@ TEST(VLS128DataTest, flag_test) {
   check_flag({static_cast<uint8_t>(0xFF), static_cast<uint8_t>(0xAA)}, false, 0U, false);
   check_flag({static_cast<uint8_t>(0x00), static_cast<uint8_t>(0xDD)}, false, 0U, false);
 }
+
+TEST(VLS128DataTest, time_offset_test) {
+  constexpr auto rpm{300U};
+  VLS128Data vls128_data{rpm};
+  const float32_t seq_us = VLS128Data::FIRE_SEQ_OFFSET_US;
+  const float32_t fire_us = VLS128Data::FIRE_DURATION_US;
+  const float32_t maintenance_us = VLS128Data::MAINTENANCE_DURATION1_US;
+  // First laser of the first group
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(0U, 0U, 0U), 0.0F);
+  // All lasers of a group fire at the same time
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(0U, 0U, 7U), 0.0F);
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(0U, 0U, 8U), fire_us);
+  // Last group before the maintenance period
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(32U, 1U, 31U), 7.0F * fire_us);
+  // First group after the maintenance period
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(64U, 2U, 0U), (8.0F * fire_us) + maintenance_us);
+  // The second fire sequence of the packet starts in the fifth block
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(0U, 4U, 0U), seq_us);
+  EXPECT_FLOAT_EQ(vls128_data.time_offset_us(96U, 11U, 31U),
+    (2.0F * seq_us) + (15.0F * fire_us) + maintenance_us);
+  // Firing times only grow within a packet and stay within it
+  float32_t last_time = 0.0F;
+  for (auto block_id = 0U; block_id < 12U; ++block_id) {
+    const auto num_banked_pts = static_cast<uint16_t>((block_id % 4U) * NUM_POINTS_PER_BLOCK);
+    for (auto pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+      const auto time = vls128_data.time_offset_us(num_banked_pts, block_id, pt_id);
+      EXPECT_GE(time, last_time);
+      last_time = time;
+    }
+  }
+  EXPECT_LT(last_time, 3.0F * seq_us);
+}
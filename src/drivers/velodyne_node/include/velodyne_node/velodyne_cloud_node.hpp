@@ -23,16 +23,21 @@
 #ifndef VELODYNE_NODE__VELODYNE_CLOUD_NODE_HPP_
 #define VELODYNE_NODE__VELODYNE_CLOUD_NODE_HPP_
 
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/types.hpp"
 #include "lidar_utils/point_cloud_utils.hpp"
+#include "nav_msgs/msg/odometry.hpp"
 #include "udp_driver/udp_driver_node.hpp"
+#include "velodyne_driver/motion_compensation.hpp"
 #include "velodyne_driver/velodyne_translator.hpp"
 #include "velodyne_node/visibility_control.hpp"
 #include "sensor_msgs/msg/point_cloud2.hpp"
 
 using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
 
 namespace autoware
 {
@@ -44,6 +49,11 @@ namespace velodyne_node
 
 /// Template class for the velodyne driver node that receives veldyne `packet`s via
 /// UDP, converts the packet into a PointCloud2 message and publishes this cloud.
+/// The packets are decoded straight into the data of the cloud. Points that belong to the next
+/// cloud go to a back buffer, which is swapped in once the complete cloud has been published.
+/// Optionally, the firing time of each point after the header stamp is published in a
+/// "time_offset" field, and the points are motion compensated (deskewed) to the time of the last
+/// point of the cloud using the latest received odometry.
 /// \tparam SensorData SensorData implementation for the specific velodyne sensor model.
 template<typename SensorData>
 class VELODYNE_NODE_PUBLIC VelodyneCloudNode
@@ -65,6 +75,10 @@ public:
   /// \param[in] cloud_size Preallocated capacity (in number of points) for the point cloud messages
   ///                       must be greater than PointBlock::CAPACITY
   /// \param[in] config Config struct with rpm params
+  /// \param[in] publish_time_offsets Whether to add the firing time of each point, see the
+  ///                                 `publish_time_offsets` parameter of the other constructor
+  /// \param[in] deskew Whether to deskew the clouds with the odometry on the "odom" topic, see the
+  ///                   `deskew.*` parameters of the other constructor
   /// \throw std::runtime_error If cloud_size is not sufficiently large
   VelodyneCloudNode(
     const std::string & node_name,
@@ -72,9 +86,16 @@ public:
     const uint16_t port,
     const std::string & frame_id,
     const std::size_t cloud_size,
-    const Config & config);
+    const Config & config,
+    const bool8_t publish_time_offsets = false,
+    const bool8_t deskew = false);
 
-  /// \brief Parameter file constructor
+  /// \brief Parameter file constructor. Besides the parameters of the other constructor, the
+  ///        optional parameters are `publish_time_offsets` (default false), to add the firing time
+  ///        of each point in seconds after the header stamp, and `deskew.enabled` (default
+  ///        false), `deskew.odom_topic` (default "odom") and `deskew.odom_timeout_ms` (default
+  ///        200) for the motion compensation. The twist of the odometry is assumed to be the one
+  ///        of the sensor frame.
   /// \param[in] node_name Name of this node
   /// \param[in] node_namespace Namespace for this node
   VelodyneCloudNode(
@@ -87,23 +108,99 @@ protected:
     const Packet & pkt,
     sensor_msgs::msg::PointCloud2 & output) override;
   bool8_t get_output_remainder(sensor_msgs::msg::PointCloud2 & output) override;
+  /// Keep the twist of the latest odometry for the motion compensation
+  void on_odometry(const nav_msgs::msg::Odometry & msg);
 
 private:
+  /// Hands the decoded blocks of the translator to the node
+  class CloudWriter
+  {
+public:
+    CloudWriter(VelodyneCloudNode & node, sensor_msgs::msg::PointCloud2 & output)
+    : m_node(node), m_output(output)
+    {
+    }
+    void write_block(
+      const velodyne_driver::BlockPoints & points, const uint16_t *,
+      const float32_t * const time_offsets_us)
+    {
+      m_node.write_block(m_output, points, time_offsets_us);
+    }
+    void end_of_scan()
+    {
+      if (m_node.m_published_cloud) {
+        // The cloud was already completed by reaching its size, the scan ends in the back buffer
+        m_node.m_back_buffer_scan_ended = true;
+        m_node.m_back_buffer_scan_idx = m_node.m_back_buffer_idx;
+      } else {
+        m_node.m_published_cloud = true;
+      }
+    }
+
+private:
+    VelodyneCloudNode & m_node;
+    sensor_msgs::msg::PointCloud2 & m_output;
+  };
+
+  /// Write the points of a block and their times to the cloud, or to the back buffer if the
+  /// cloud is complete
+  void write_block(
+    sensor_msgs::msg::PointCloud2 & output, const velodyne_driver::BlockPoints & points,
+    const float32_t * time_offsets_us);
+  /// Size, deskew and stamp a complete cloud
+  void finish_cloud(sensor_msgs::msg::PointCloud2 & output);
+  /// Subscribe to the odometry for deskewing
+  void init_deskew(const std::string & odom_topic, const std::chrono::nanoseconds odom_timeout);
+  /// Deskew the points of a complete cloud if there is a recent twist
+  /// \return The time of the cloud after the timestamp of its first packet that the points refer
+  ///         to, i.e. the time of the last point if the cloud was deskewed and 0 otherwise
+  float32_t deskew_cloud(sensor_msgs::msg::PointCloud2 & output);
+
   VelodyneTranslatorT m_translator;
-  std::vector<autoware::common::types::PointXYZIF> m_point_block;
+  const velodyne_driver::SimdLevel m_simd_level;
 
-  // These next two variables are a minor hack to maintain stateful information across convert()
-  // calls. Specifically, it signals to reset any stateful information on the data vector at the top
-  // of the convert function
+  // Signals that the constructed point cloud is complete. The points decoded after it go to the
+  // back buffer, which replaces the data of the cloud at the top of the next convert() call
   bool8_t m_published_cloud;
-  // Keeps track of where you left off on the converted point block in case you needed to publish
-  // a point cloud in the middle of processing it
-  uint32_t m_remainder_start_idx;
   // keeps track of the constructed point cloud to continue growing it with new data
   uint32_t m_point_cloud_idx;
-  autoware::common::lidar_utils::PointCloudIts m_point_cloud_its;
+  // Data of the next point cloud and its number of points. The data of both buffers is kept at
+  // the size of a full cloud while it is written to, and only shrunk to publish it
+  std::vector<uint8_t> m_back_buffer;
+  uint32_t m_back_buffer_idx;
+  // Signals that a scan ended in the back buffer, its points up to m_back_buffer_scan_idx are
+  // published on their own by get_output_remainder()
+  bool8_t m_back_buffer_scan_ended;
+  uint32_t m_back_buffer_scan_idx;
+  // Bytes per point, the fields are x, y, z, intensity and optionally time_offset, float32 each
+  uint32_t m_point_step;
   const std::string m_frame_id;
   const std::size_t m_cloud_size;
+
+  // The firing times are only computed if they are published or used for deskewing
+  const bool8_t m_publish_time_offsets;
+  const bool8_t m_deskew;
+  // Timestamp of the packet being converted
+  uint32_t m_block_stamp_us;
+  // Timestamp of the first packet of the constructed point cloud
+  uint32_t m_cloud_stamp_us;
+  // Time of the packet being converted after m_cloud_stamp_us
+  float32_t m_block_time_us;
+  // Time of each point of the constructed point cloud after m_cloud_stamp_us, and of each point
+  // in the back buffer after m_block_stamp_us, only kept for deskewing
+  std::vector<float32_t> m_cloud_times_us;
+  std::vector<float32_t> m_back_buffer_times_us;
+  // Time of the last point of the packet being converted after m_block_stamp_us
+  float32_t m_packet_end_us;
+
+  // Odometry for the motion compensation, it is received on the executor thread
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr m_odometry_sub;
+  std::chrono::nanoseconds m_odometry_timeout;
+  std::mutex m_twist_mutex;
+  velodyne_driver::SensorTwist m_twist;
+  rclcpp::Time m_twist_time;
+  bool8_t m_has_twist;
+  bool8_t m_warned_no_twist;
 };  // class VelodyneCloudNode
 
 using VLP16DriverNode = VelodyneCloudNode<velodyne_driver::VLP16Data>;
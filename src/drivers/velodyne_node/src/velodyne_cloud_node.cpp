@@ -15,12 +15,15 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include <string>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include "common/types.hpp"
 #include "lidar_utils/point_cloud_utils.hpp"
-#include "sensor_msgs/point_cloud2_iterator.hpp"
 #include "velodyne_node/velodyne_cloud_node.hpp"
 
 using autoware::common::types::bool8_t;
@@ -39,23 +42,41 @@ VelodyneCloudNode<T>::VelodyneCloudNode(
   const uint16_t port,
   const std::string & frame_id,
   const std::size_t cloud_size,
-  const Config & config)
+  const Config & config,
+  const bool8_t publish_time_offsets,
+  const bool8_t deskew)
 : UdpDriverNode(
     node_name,
     "points_raw",
     typename UdpDriverNode::UdpConfig{ip, port}),
   m_translator(config),
+  m_simd_level(velodyne_driver::detect_simd_level()),
   m_published_cloud(false),
-  m_remainder_start_idx(0U),
   m_point_cloud_idx(0),
+  m_back_buffer_idx(0U),
+  m_back_buffer_scan_ended(false),
+  m_back_buffer_scan_idx(0U),
+  m_point_step(0U),
   m_frame_id(frame_id),
-  m_cloud_size(cloud_size)
+  m_cloud_size(cloud_size),
+  m_publish_time_offsets(publish_time_offsets),
+  m_deskew(deskew),
+  m_block_stamp_us(0U),
+  m_cloud_stamp_us(0U),
+  m_block_time_us(0.0F),
+  m_packet_end_us(0.0F),
+  m_odometry_timeout(std::chrono::nanoseconds::zero()),
+  m_twist{},
+  m_has_twist(false),
+  m_warned_no_twist(false)
 {
-  m_point_block.reserve(VelodyneTranslatorT::POINT_BLOCK_CAPACITY);
   // If your preallocated cloud size is too small, the node really won't operate well at all
-  if (static_cast<uint32_t>(m_point_block.capacity()) >= cloud_size) {
+  if (static_cast<uint32_t>(VelodyneTranslatorT::POINT_BLOCK_CAPACITY) >= cloud_size) {
     throw std::runtime_error("VelodyneCloudNode: cloud_size must be > PointBlock::CAPACITY");
   }
+  if (m_deskew) {
+    init_deskew("odom", std::chrono::milliseconds(200));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,25 +88,71 @@ VelodyneCloudNode<T>::VelodyneCloudNode(
   m_translator(
     Config{
         static_cast<float32_t>(this->declare_parameter("rpm").template get<int>())}),
+  m_simd_level(velodyne_driver::detect_simd_level()),
   m_published_cloud(false),
-  m_remainder_start_idx(0U),
   m_point_cloud_idx(0),
+  m_back_buffer_idx(0U),
+  m_back_buffer_scan_ended(false),
+  m_back_buffer_scan_idx(0U),
+  m_point_step(0U),
   m_frame_id(this->declare_parameter("frame_id").template get<std::string>().c_str()),
   m_cloud_size(static_cast<std::size_t>(
-      this->declare_parameter("cloud_size").template get<std::size_t>()))
+      this->declare_parameter("cloud_size").template get<std::size_t>())),
+  m_publish_time_offsets(this->declare_parameter("publish_time_offsets", false)),
+  m_deskew(this->declare_parameter("deskew.enabled", false)),
+  m_block_stamp_us(0U),
+  m_cloud_stamp_us(0U),
+  m_block_time_us(0.0F),
+  m_packet_end_us(0.0F),
+  m_odometry_timeout(std::chrono::nanoseconds::zero()),
+  m_twist{},
+  m_has_twist(false),
+  m_warned_no_twist(false)
 {
-  m_point_block.reserve(autoware::drivers::velodyne_driver::Vlp16Translator::POINT_BLOCK_CAPACITY);
   // If your preallocated cloud size is too small, the node really won't operate well at all
-  if (static_cast<uint32_t>(m_point_block.capacity()) >= m_cloud_size) {
+  if (static_cast<uint32_t>(VelodyneTranslatorT::POINT_BLOCK_CAPACITY) >= m_cloud_size) {
     throw std::runtime_error("VelodyneCloudNode: cloud_size must be > PointBlock::CAPACITY");
   }
+  if (m_deskew) {
+    const auto timeout_ms = this->declare_parameter("deskew.odom_timeout_ms", 200);
+    if (timeout_ms <= 0) {
+      throw std::domain_error("VelodyneCloudNode: deskew.odom_timeout_ms must be positive");
+    }
+    init_deskew(this->declare_parameter("deskew.odom_topic", std::string{"odom"}),
+      std::chrono::milliseconds(timeout_ms));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+void VelodyneCloudNode<T>::init_deskew(
+  const std::string & odom_topic,
+  const std::chrono::nanoseconds odom_timeout)
+{
+  m_cloud_times_us.reserve(m_cloud_size);
+  m_back_buffer_times_us.reserve(m_cloud_size);
+  m_odometry_timeout = odom_timeout;
+  m_odometry_sub = this->template create_subscription<nav_msgs::msg::Odometry>(odom_topic,
+      rclcpp::QoS{10},
+      [this](const nav_msgs::msg::Odometry::SharedPtr msg) {on_odometry(*msg);});
 }
 ////////////////////////////////////////////////////////////////////////////////
 template<typename T>
 void VelodyneCloudNode<T>::init_output(sensor_msgs::msg::PointCloud2 & output)
 {
-  autoware::common::lidar_utils::init_pcl_msg(output, m_frame_id.c_str(), m_cloud_size);
-  m_point_cloud_its.reset(output, m_point_cloud_idx);
+  if (m_publish_time_offsets) {
+    autoware::common::lidar_utils::init_pcl_msg(output, m_frame_id.c_str(), m_cloud_size, 5U,
+      "x", 1U, sensor_msgs::msg::PointField::FLOAT32,
+      "y", 1U, sensor_msgs::msg::PointField::FLOAT32,
+      "z", 1U, sensor_msgs::msg::PointField::FLOAT32,
+      "intensity", 1U, sensor_msgs::msg::PointField::FLOAT32,
+      "time_offset", 1U, sensor_msgs::msg::PointField::FLOAT32);
+  } else {
+    autoware::common::lidar_utils::init_pcl_msg(output, m_frame_id.c_str(), m_cloud_size);
+  }
+  // Both buffers are written to at the size of a full cloud, see write_block()
+  m_point_step = output.point_step;
+  m_back_buffer.resize(output.data.size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -94,43 +161,36 @@ bool8_t VelodyneCloudNode<T>::convert(
   const Packet & pkt,
   sensor_msgs::msg::PointCloud2 & output)
 {
-  // This handles the case when the below loop exited due to containing extra points
+  // The previous cloud was published, continue with the points of the back buffer
   if (m_published_cloud) {
-    // reset the pointcloud
-    autoware::common::lidar_utils::reset_pcl_msg(output, m_cloud_size, m_point_cloud_idx);
-    m_point_cloud_its.reset(output, m_point_cloud_idx);
-
-    // deserialize remainder into pointcloud
+    // Swapping keeps the memory of both buffers, the new cloud starts with the packet of the
+    // back buffer. Growing the published data back to a full cloud only zero fills the bytes
+    // that were not used by the published cloud.
+    std::swap(output.data, m_back_buffer);
+    m_back_buffer.resize(m_cloud_size * m_point_step);
+    m_point_cloud_idx = m_back_buffer_idx;
+    m_back_buffer_idx = 0U;
+    // Without get_output_remainder() the scan that ended in the back buffer continues
+    m_back_buffer_scan_ended = false;
+    std::swap(m_cloud_times_us, m_back_buffer_times_us);
+    m_back_buffer_times_us.clear();
     m_published_cloud = false;
-    for (uint32_t idx = m_remainder_start_idx; idx < m_point_block.size(); ++idx) {
-      const autoware::common::types::PointXYZIF & pt = m_point_block[idx];
-      (void)add_point_to_cloud(m_point_cloud_its, pt, m_point_cloud_idx);
-      // Here I am ignoring the return value, because this operation should never fail.
-      // In the constructor I ensure that cloud_size > PointBlock::CAPACITY. This means
-      // I am guaranteed to fit at least one whole PointBlock into my PointCloud2.
-      // Because just above this for loop, I reset the capacity of the pcl message,
-      // I am guaranteed to have capacity for the remainder of a point block.
-    }
+    m_cloud_stamp_us = m_block_stamp_us;
   }
-  m_translator.convert(pkt, m_point_block);
-  for (uint32_t idx = 0U; idx < m_point_block.size(); ++idx) {
-    const autoware::common::types::PointXYZIF & pt = m_point_block[idx];
-    if (static_cast<uint16_t>(autoware::common::types::PointXYZIF::END_OF_SCAN_ID) != pt.id) {
-      if (!add_point_to_cloud(m_point_cloud_its, pt, m_point_cloud_idx)) {
-        m_published_cloud = true;
-        m_remainder_start_idx = idx;
-      }
-    } else {
-      m_published_cloud = true;
-      m_remainder_start_idx = idx;
-      break;
+  const bool8_t with_time_offsets = m_publish_time_offsets || m_deskew;
+  if (with_time_offsets) {
+    m_block_stamp_us = VelodyneTranslatorT::packet_timestamp_us(pkt);
+    m_packet_end_us = 0.0F;
+    if (0U == m_point_cloud_idx) {
+      m_cloud_stamp_us = m_block_stamp_us;
     }
+    m_block_time_us = static_cast<float32_t>(
+      VelodyneTranslatorT::packet_time_diff_us(m_cloud_stamp_us, m_block_stamp_us));
   }
+  CloudWriter writer{*this, output};
+  m_translator.convert_blocks(pkt, writer, with_time_offsets, m_simd_level);
   if (m_published_cloud) {
-    // resize pointcloud down to its actual size
-    autoware::common::lidar_utils::resize_pcl_msg(output, m_point_cloud_idx);
-    output.header.stamp = this->now();
-    m_point_cloud_its.reset(output, m_point_cloud_idx);
+    finish_cloud(output);
   }
 
   return m_published_cloud;
@@ -141,10 +201,160 @@ template<typename T>
 bool8_t VelodyneCloudNode<T>::get_output_remainder(sensor_msgs::msg::PointCloud2 & output)
 {
   // The assumption checked in the constructor is that the PointCloud size is bigger than
-  // the PointBlocks, which can fully contain a packet. The use case of this method is in case
-  // PacketT > OutputT, which is not the case here.
-  (void)output;
-  return false;
+  // the PointBlocks, which can fully contain a packet. So a packet completes at most two clouds,
+  // when the cloud reaches its size and the scan ends later in the same packet. The points up
+  // to the end of the scan are the remainder, the rest stays in the back buffer.
+  if (!m_back_buffer_scan_ended) {
+    return false;
+  }
+  m_back_buffer_scan_ended = false;
+  const std::size_t scan_bytes = static_cast<std::size_t>(m_back_buffer_scan_idx) * m_point_step;
+  const std::size_t next_bytes =
+    (static_cast<std::size_t>(m_back_buffer_idx) * m_point_step) - scan_bytes;
+  std::swap(output.data, m_back_buffer);
+  m_back_buffer.resize(m_cloud_size * m_point_step);
+  if (next_bytes > 0U) {
+    std::memcpy(m_back_buffer.data(), &output.data[scan_bytes], next_bytes);
+  }
+  m_point_cloud_idx = m_back_buffer_scan_idx;
+  m_back_buffer_idx -= m_back_buffer_scan_idx;
+  if (m_deskew) {
+    std::swap(m_cloud_times_us, m_back_buffer_times_us);
+    m_back_buffer_times_us.assign(
+      m_cloud_times_us.begin() + m_back_buffer_scan_idx, m_cloud_times_us.end());
+    m_cloud_times_us.resize(m_back_buffer_scan_idx);
+  }
+  // The times of the back buffer are counted from the packet being converted
+  m_cloud_stamp_us = m_block_stamp_us;
+  m_block_time_us = 0.0F;
+  finish_cloud(output);
+  // m_published_cloud stays set, the next convert() continues with the rest of the back buffer
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+void VelodyneCloudNode<T>::finish_cloud(sensor_msgs::msg::PointCloud2 & output)
+{
+  // Shrink the data to the points of the cloud and set the size fields
+  autoware::common::lidar_utils::resize_pcl_msg(output, m_point_cloud_idx);
+  // Time of the cloud after the timestamp of its first packet that the points refer to
+  const float32_t reference_us = m_deskew ? deskew_cloud(output) : 0.0F;
+  // The packet just arrived, i.e. its last point was fired about now. The cloud is stamped at the
+  // reference time, so that stamp + time_offset is the firing time of each point.
+  const auto packet_end_ns =
+    static_cast<int64_t>((m_block_time_us + m_packet_end_us) - reference_us) * 1000;
+  output.header.stamp = this->now() - rclcpp::Duration(std::chrono::nanoseconds(packet_end_ns));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+void VelodyneCloudNode<T>::write_block(
+  sensor_msgs::msg::PointCloud2 & output,
+  const velodyne_driver::BlockPoints & points,
+  const float32_t * const time_offsets_us)
+{
+  if (time_offsets_us != nullptr) {
+    // The blocks come in firing order
+    m_packet_end_us = time_offsets_us[velodyne_driver::NUM_POINTS_PER_BLOCK - 1U];
+  }
+  uint32_t pt_id = 0U;
+  while (pt_id < velodyne_driver::NUM_POINTS_PER_BLOCK) {
+    if (m_point_cloud_idx >= m_cloud_size) {
+      // A full cloud gets published like a complete scan
+      m_published_cloud = true;
+    }
+    // Once the cloud is complete, the back buffer gets the points. It starts with this packet.
+    std::vector<uint8_t> & data = m_published_cloud ? m_back_buffer : output.data;
+    uint32_t & cloud_idx = m_published_cloud ? m_back_buffer_idx : m_point_cloud_idx;
+    std::vector<float32_t> & times_us =
+      m_published_cloud ? m_back_buffer_times_us : m_cloud_times_us;
+    const float32_t block_time_us = m_published_cloud ? 0.0F : m_block_time_us;
+    const auto num_points = std::min(velodyne_driver::NUM_POINTS_PER_BLOCK - pt_id,
+        static_cast<uint32_t>(m_cloud_size) - cloud_idx);
+    if (0U == num_points) {
+      // Can't happen, the back buffer holds at least a whole packet
+      break;
+    }
+
+    // The data has the size of a full cloud, so the points are written without growing it
+    uint8_t * dst = &data[static_cast<std::size_t>(cloud_idx) * m_point_step];
+    for (uint32_t idx = pt_id; idx < (pt_id + num_points); ++idx, dst += m_point_step) {
+      std::memcpy(&dst[0U], &points.x[idx], sizeof(float32_t));
+      std::memcpy(&dst[4U], &points.y[idx], sizeof(float32_t));
+      std::memcpy(&dst[8U], &points.z[idx], sizeof(float32_t));
+      std::memcpy(&dst[12U], &points.intensity[idx], sizeof(float32_t));
+      if (time_offsets_us != nullptr) {
+        const float32_t time_us = block_time_us + time_offsets_us[idx];
+        if (m_publish_time_offsets) {
+          const float32_t time_s = time_us * 1.0E-6F;
+          std::memcpy(&dst[16U], &time_s, sizeof(float32_t));
+        }
+        if (m_deskew) {
+          times_us.push_back(time_us);
+        }
+      }
+    }
+    cloud_idx += num_points;
+    pt_id += num_points;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+float32_t VelodyneCloudNode<T>::deskew_cloud(sensor_msgs::msg::PointCloud2 & output)
+{
+  const uint32_t num_points = m_point_cloud_idx;
+  if (0U == num_points) {
+    return 0.0F;
+  }
+  velodyne_driver::SensorTwist twist;
+  bool8_t has_recent_twist;
+  {
+    std::lock_guard<std::mutex> lock{m_twist_mutex};
+    twist = m_twist;
+    has_recent_twist = m_has_twist &&
+      ((this->now() - m_twist_time).nanoseconds() <= m_odometry_timeout.count());
+  }
+  if (!has_recent_twist) {
+    if (!m_warned_no_twist) {
+      RCLCPP_WARN(this->get_logger(), "No recent odometry, publishing clouds without deskewing");
+      m_warned_no_twist = true;
+    }
+    return 0.0F;
+  }
+  // Move every point to the sensor pose at the time of the last point, which becomes the stamp
+  // of the cloud. The time offsets are rewritten relative to it in the same pass.
+  const float32_t end_us = m_cloud_times_us[num_points - 1U];
+  uint8_t * pt = output.data.data();
+  for (uint32_t idx = 0U; idx < num_points; ++idx, pt += m_point_step) {
+    const float32_t dt_s = (end_us - m_cloud_times_us[idx]) * 1.0E-6F;
+    float32_t xyz[3U];
+    std::memcpy(&xyz[0U], pt, sizeof(xyz));
+    velodyne_driver::compensate_motion(twist, dt_s, xyz[0U], xyz[1U], xyz[2U]);
+    std::memcpy(pt, &xyz[0U], sizeof(xyz));
+    if (m_publish_time_offsets) {
+      const float32_t time_s = -dt_s;
+      std::memcpy(&pt[16U], &time_s, sizeof(float32_t));
+    }
+  }
+  m_warned_no_twist = false;
+  return end_us;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+void VelodyneCloudNode<T>::on_odometry(const nav_msgs::msg::Odometry & msg)
+{
+  const auto & linear = msg.twist.twist.linear;
+  const auto & angular = msg.twist.twist.angular;
+  std::lock_guard<std::mutex> lock{m_twist_mutex};
+  m_twist = velodyne_driver::SensorTwist{
+    static_cast<float32_t>(linear.x), static_cast<float32_t>(linear.y),
+    static_cast<float32_t>(linear.z), static_cast<float32_t>(angular.x),
+    static_cast<float32_t>(angular.y), static_cast<float32_t>(angular.z)};
+  m_twist_time = this->now();
+  m_has_twist = true;
 }
 
 template class VelodyneCloudNode<velodyne_driver::VLP16Data>;
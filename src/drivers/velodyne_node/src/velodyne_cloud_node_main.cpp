@@ -21,6 +21,7 @@
 #include <string>
 //lint -e537 NOLINT  // cpplint vs pclint
 #include <memory>
+#include <thread>
 #include <vector>
 #include <cstdio>
 #include <algorithm>
@@ -34,7 +35,20 @@ int32_t main(const int32_t argc, char ** const argv)
   try {
     rclcpp::init(argc, argv);
 
-    const auto run = [](const auto & nd_ptr) {nd_ptr->run();};
+    const auto run = [](const auto & nd_ptr) {
+        // The driver loop blocks on the socket, subscriptions such as the odometry for deskewing
+        // are serviced by a separate executor thread
+        std::thread spin_thread{[nd_ptr] {rclcpp::spin(nd_ptr->get_node_base_interface());}};
+        try {
+          nd_ptr->run();
+        } catch (...) {
+          (void)rclcpp::shutdown();
+          spin_thread.join();
+          throw;
+        }
+        (void)rclcpp::shutdown();
+        spin_thread.join();
+      };
 
     const auto * arg = rcutils_cli_get_option(argv, &argv[argc], "--model");
     if (arg != nullptr) {
@@ -19,12 +19,180 @@
 #include <velodyne_node/velodyne_cloud_node.hpp>
 #include <lidar_integration/lidar_integration.hpp>
 #include <lidar_integration/udp_sender.hpp>
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <thread>
 #include <string>
+#include <vector>
 
 using autoware::common::types::bool8_t;
 using autoware::common::types::float32_t;
+using autoware::common::types::PointXYZIF;
+using autoware::drivers::velodyne_driver::VLP16Data;
+using VLP16Translator = autoware::drivers::velodyne_driver::VelodyneTranslator<VLP16Data>;
+
+namespace
+{
+constexpr float32_t RPM = 600.0F;
+
+// Packets of a VLP16 spinning at RPM with points at varying distances, one firing sequence per
+// block
+std::vector<VLP16Translator::Packet> make_packets(const uint32_t num_packets)
+{
+  using autoware::drivers::velodyne_driver::AZIMUTH_ROTATION_RESOLUTION;
+  using autoware::drivers::velodyne_driver::NUM_BLOCKS_PER_PACKET;
+  using autoware::drivers::velodyne_driver::NUM_POINTS_PER_BLOCK;
+  const float32_t block_azimuth =
+    (RPM / 60.0E6F) * VLP16Data::FIRE_SEQ_OFFSET_US * AZIMUTH_ROTATION_RESOLUTION;
+  std::vector<VLP16Translator::Packet> packets(num_packets);
+  uint32_t seq = 0U;
+  uint32_t timestamp_us = 0U;
+  for (auto & pkt : packets) {
+    for (auto & block : pkt.blocks) {
+      block.flag[0U] = 0xFF;
+      block.flag[1U] = 0xEE;
+      const auto azimuth = static_cast<uint32_t>(static_cast<float32_t>(seq) * block_azimuth) %
+        AZIMUTH_ROTATION_RESOLUTION;
+      block.azimuth_bytes[0U] = static_cast<uint8_t>(azimuth & 0xFFU);
+      block.azimuth_bytes[1U] = static_cast<uint8_t>(azimuth >> 8U);
+      for (uint32_t pt_id = 0U; pt_id < NUM_POINTS_PER_BLOCK; ++pt_id) {
+        const uint32_t dist = 1000U + ((seq * 37U + pt_id * 101U) % 20000U);
+        block.channels[pt_id].data[0U] = static_cast<uint8_t>(dist & 0xFFU);
+        block.channels[pt_id].data[1U] = static_cast<uint8_t>(dist >> 8U);
+        block.channels[pt_id].data[2U] = static_cast<uint8_t>(pt_id * 7U);
+      }
+      ++seq;
+    }
+    for (uint32_t idx = 0U; idx < 4U; ++idx) {
+      pkt.timestamp_bytes[idx] = static_cast<uint8_t>(timestamp_us >> (8U * idx));
+    }
+    timestamp_us += static_cast<uint32_t>(std::lround(
+        static_cast<float32_t>(NUM_BLOCKS_PER_PACKET) * VLP16Data::FIRE_SEQ_OFFSET_US));
+  }
+  return packets;
+}
+
+// Feeds the packets straight to the conversion of the node, without a socket
+class TestNode : public autoware::drivers::velodyne_node::VLP16DriverNode
+{
+public:
+  using Base = autoware::drivers::velodyne_node::VLP16DriverNode;
+  explicit TestNode(const std::size_t cloud_size, const bool8_t deskew = false)
+  : Base("test_node", "127.0.0.1", 9999U, "base_link", cloud_size, Config{RPM}, true, deskew)
+  {
+  }
+  using Base::init_output;
+  using Base::convert;
+  using Base::get_output_remainder;
+  using Base::on_odometry;
+};
+
+// x, y, z, intensity and firing time in microseconds after the first packet of each point of a
+// cloud
+using Cloud = std::vector<float32_t>;
+
+// Number of clouds that were completed by the end of a scan, by reaching the cloud size, and by
+// reaching the cloud size in the packet in which the scan ended
+struct CloudEnds
+{
+  uint32_t end_of_scan{0U};
+  uint32_t cloud_size{0U};
+  uint32_t both{0U};
+};
+
+// Splits the output of the translator into clouds at the end of each scan and at the cloud size.
+// Optionally also returns the time of the last point of the packet in which each cloud was
+// completed, after the first packet of the cloud.
+std::vector<Cloud> make_expected_clouds(
+  const std::vector<VLP16Translator::Packet> & packets, const std::size_t cloud_size,
+  CloudEnds & ends, std::vector<float32_t> * const packet_ends_us = nullptr)
+{
+  VLP16Translator translator{VLP16Translator::Config{RPM}};
+  std::vector<Cloud> clouds{Cloud{}};
+  std::vector<PointXYZIF> points;
+  std::vector<float32_t> times_us;
+  uint32_t cloud_stamp_us = 0U;
+  for (const auto & pkt : packets) {
+    translator.convert(pkt, points, times_us);
+    const auto stamp_us = VLP16Translator::packet_timestamp_us(pkt);
+    // An end of scan has the time of the point before it, so this is the time of the last point
+    const float32_t packet_end_us = times_us.back();
+    const auto complete_cloud = [&]() {
+        if (packet_ends_us != nullptr) {
+          packet_ends_us->push_back(static_cast<float32_t>(
+              VLP16Translator::packet_time_diff_us(cloud_stamp_us, stamp_us)) + packet_end_us);
+        }
+        clouds.emplace_back();
+      };
+    bool8_t reached_size = false;
+    for (std::size_t idx = 0U; idx < points.size(); ++idx) {
+      const auto & pt = points[idx];
+      if (static_cast<uint16_t>(PointXYZIF::END_OF_SCAN_ID) == pt.id) {
+        ++ends.end_of_scan;
+        ends.both += reached_size ? 1U : 0U;
+        complete_cloud();
+        continue;
+      }
+      if (clouds.back().size() == (cloud_size * 5U)) {
+        ++ends.cloud_size;
+        reached_size = true;
+        complete_cloud();
+      }
+      if (clouds.back().empty()) {
+        cloud_stamp_us = stamp_us;
+      }
+      const float32_t time_us = static_cast<float32_t>(
+        VLP16Translator::packet_time_diff_us(cloud_stamp_us, stamp_us)) + times_us[idx];
+      clouds.back().insert(clouds.back().end(),
+        {pt.x, pt.y, pt.z, pt.intensity, time_us});
+    }
+  }
+  return clouds;
+}
+
+// Converts the packets with the node like UdpDriverNode does, and compares the published clouds
+// with the output of the translator
+void check_clouds(const uint32_t num_packets, const std::size_t cloud_size, CloudEnds & ends)
+{
+  const auto packets = make_packets(num_packets);
+  const auto expected = make_expected_clouds(packets, cloud_size, ends);
+
+  TestNode node{cloud_size};
+  sensor_msgs::msg::PointCloud2 output;
+  node.init_output(output);
+  std::vector<sensor_msgs::msg::PointCloud2> clouds;
+  for (const auto & pkt : packets) {
+    if (node.convert(pkt, output)) {
+      clouds.push_back(output);
+      while (node.get_output_remainder(output)) {
+        clouds.push_back(output);
+      }
+    }
+  }
+
+  // The last cloud is not complete yet
+  ASSERT_EQ(clouds.size() + 1U, expected.size());
+  for (std::size_t cloud_idx = 0U; cloud_idx < clouds.size(); ++cloud_idx) {
+    const auto & cloud = clouds[cloud_idx];
+    const auto & expected_cloud = expected[cloud_idx];
+    ASSERT_EQ(cloud.point_step, 5U * sizeof(float32_t));
+    ASSERT_EQ(cloud.width * 5U, expected_cloud.size()) << "cloud " << cloud_idx;
+    ASSERT_EQ(cloud.data.size(), cloud.width * cloud.point_step);
+    for (uint32_t pt_idx = 0U; pt_idx < cloud.width; ++pt_idx) {
+      float32_t pt[5U];
+      std::memcpy(&pt[0U], &cloud.data[pt_idx * cloud.point_step], sizeof(pt));
+      const float32_t * const expected_pt = &expected_cloud[pt_idx * 5U];
+      ASSERT_EQ(pt[0U], expected_pt[0U]) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_EQ(pt[1U], expected_pt[1U]) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_EQ(pt[2U], expected_pt[2U]) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_EQ(pt[3U], expected_pt[3U]) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_FLOAT_EQ(pt[4U], expected_pt[4U] * 1.0E-6F) <<
+        "cloud " << cloud_idx << " point " << pt_idx;
+    }
+  }
+}
+}  // namespace
 
 // This test is just to make sure the alternative constructor doesn't die
 TEST(velodyne_node, constructor)
@@ -65,6 +233,104 @@ TEST(velodyne_node, constructor)
   rclcpp::shutdown();
 }
 
+// The scans of 600 rpm end in the middle of a packet, every cloud ends with its scan
+TEST(velodyne_node, convert_end_of_scan)
+{
+  rclcpp::init(0, nullptr);
+  CloudEnds ends;
+  check_clouds(200U, 60000U, ends);
+  EXPECT_GE(ends.end_of_scan, 2U);
+  EXPECT_EQ(ends.cloud_size, 0U);
+  rclcpp::shutdown();
+}
+
+// Less than a scan, the clouds are completed by their size in the middle of a packet
+TEST(velodyne_node, convert_cloud_size)
+{
+  rclcpp::init(0, nullptr);
+  CloudEnds ends;
+  check_clouds(50U, 1000U, ends);
+  EXPECT_EQ(ends.end_of_scan, 0U);
+  EXPECT_GE(ends.cloud_size, 10U);
+  rclcpp::shutdown();
+}
+
+// The cloud is completed by its size a few points before the end of the scan in the same packet,
+// those points are published as a cloud of their own
+TEST(velodyne_node, convert_cloud_size_and_end_of_scan)
+{
+  rclcpp::init(0, nullptr);
+  // Number of points of the first scan
+  CloudEnds scan_ends;
+  const auto scans = make_expected_clouds(make_packets(100U), 60000U, scan_ends);
+  ASSERT_EQ(scan_ends.end_of_scan, 1U);
+  const std::size_t scan_size = scans[0U].size() / 5U;
+
+  CloudEnds ends;
+  check_clouds(200U, scan_size - 10U, ends);
+  EXPECT_GE(ends.both, 1U);
+  rclcpp::shutdown();
+}
+
+// A deskewed cloud is stamped at the time of its last point, which the points are moved to
+TEST(velodyne_node, deskew_stamp)
+{
+  rclcpp::init(0, nullptr);
+  const auto packets = make_packets(200U);
+  CloudEnds ends;
+  std::vector<float32_t> packet_ends_us;
+  const auto expected = make_expected_clouds(packets, 60000U, ends, &packet_ends_us);
+  ASSERT_GE(ends.end_of_scan, 2U);
+
+  TestNode node{60000U, true};
+  nav_msgs::msg::Odometry odometry;
+  odometry.twist.twist.linear.x = 20.0;
+  odometry.twist.twist.angular.z = 0.5;
+  node.on_odometry(odometry);
+  const autoware::drivers::velodyne_driver::SensorTwist twist{20.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.5F};
+
+  sensor_msgs::msg::PointCloud2 output;
+  node.init_output(output);
+  std::size_t cloud_idx = 0U;
+  for (const auto & pkt : packets) {
+    const int64_t before_ns = node.now().nanoseconds();
+    if (!node.convert(pkt, output)) {
+      continue;
+    }
+    const int64_t after_ns = node.now().nanoseconds();
+    ASSERT_LT(cloud_idx + 1U, expected.size());
+    const auto & expected_cloud = expected[cloud_idx];
+    ASSERT_EQ(output.width * 5U, expected_cloud.size()) << "cloud " << cloud_idx;
+    const float32_t end_us = expected_cloud[expected_cloud.size() - 1U];
+
+    // The packet was received at now(), the stamp is the time of the last point before that
+    const auto reference_ns =
+      static_cast<int64_t>(packet_ends_us[cloud_idx] - end_us) * 1000;
+    const int64_t stamp_ns = rclcpp::Time(output.header.stamp).nanoseconds();
+    EXPECT_GE(stamp_ns, before_ns - reference_ns - 1000) << "cloud " << cloud_idx;
+    EXPECT_LE(stamp_ns, after_ns - reference_ns + 1000) << "cloud " << cloud_idx;
+
+    for (uint32_t pt_idx = 0U; pt_idx < output.width; ++pt_idx) {
+      float32_t pt[5U];
+      std::memcpy(&pt[0U], &output.data[pt_idx * output.point_step], sizeof(pt));
+      const float32_t * const expected_pt = &expected_cloud[pt_idx * 5U];
+      const float32_t dt_s = (end_us - expected_pt[4U]) * 1.0E-6F;
+      float32_t x = expected_pt[0U];
+      float32_t y = expected_pt[1U];
+      float32_t z = expected_pt[2U];
+      autoware::drivers::velodyne_driver::compensate_motion(twist, dt_s, x, y, z);
+      ASSERT_FLOAT_EQ(pt[0U], x) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_FLOAT_EQ(pt[1U], y) << "cloud " << cloud_idx << " point " << pt_idx;
+      ASSERT_FLOAT_EQ(pt[2U], z) << "cloud " << cloud_idx << " point " << pt_idx;
+      // The time offsets count from the stamp
+      ASSERT_FLOAT_EQ(pt[4U], -dt_s) << "cloud " << cloud_idx << " point " << pt_idx;
+    }
+    ++cloud_idx;
+  }
+  EXPECT_EQ(cloud_idx, ends.end_of_scan);
+  rclcpp::shutdown();
+}
+
 struct VelodyneNodeTestParam
 {
   uint32_t reserved_size;
@@ -1,6 +1,11 @@
 # Generates ACADO MPC solver code from a given code generator
 # Generated files are compiled into a library with target GENERATED_LIB
 # :option ENABLE_WARNINGS: If active, enable warnings on autogenerated and external code
+# :option PER_INSTANCE_STATE: If active, the generated code accesses its variables and workspace
+#                             through the thread-local pointers acado_variables and
+#                             acado_workspace instead of the globals, which the user defines and
+#                             points to the state of the solver instance in use, see
+#                             ament_acado_per_instance_state.cmake. Only for QP_SOLVER QPOASES
 # :param GENERATOR: Source file for an ACADO code generator
 # :type GENERATOR: A string/path to a c++ file
 # :param OUTPUT_PATH: The directory the code generator writes to, which is set via the
@@ -19,7 +24,7 @@
 macro(ament_acado_generate GENERATED_PATH)
   # Input handling
   set(_ARG_NAMES "GENERATOR;OUTPUT_PATH;NAME;LIB_NAME;QP_SOLVER")
-  set(_ARG_OPTIONS "ENABLE_WARNINGS")
+  set(_ARG_OPTIONS "ENABLE_WARNINGS;PER_INSTANCE_STATE")
   set(_ARG_ARGN "SNIPPET_PATHS")
 
   cmake_parse_arguments(ARG
@@ -50,6 +55,9 @@ macro(ament_acado_generate GENERATED_PATH)
     message("Argument QP_SOLVER not set, using default of ${ARG_QP_SOLVER}")
   endif()
   string(TOUPPER ${ARG_QP_SOLVER} QP_SOLVER)
+  if(ARG_PER_INSTANCE_STATE AND NOT (${QP_SOLVER} STREQUAL "QPOASES"))
+    message(FATAL_ERROR "PER_INSTANCE_STATE is only supported for QP_SOLVER QPOASES!")
+  endif()
 
   if(NOT ARG_NAME)
     set(ARG_NAME "code_generator")
@@ -68,9 +76,17 @@ macro(ament_acado_generate GENERATED_PATH)
   set(_GENERATED_PATH "${CMAKE_BINARY_DIR}/${ARG_OUTPUT_PATH}")
   # Run code generator
   set(GENERATED_DIRECTORY single_track_dynamics)
+  set(_POST_GENERATE_COMMAND "")
+  if(ARG_PER_INSTANCE_STATE)
+    set(_POST_GENERATE_COMMAND
+      COMMAND ${CMAKE_COMMAND}
+        -D_GENERATED_PATH=${_GENERATED_PATH}
+        -P ${ament_acado_DIR}/ament_acado_per_instance_state.cmake)
+  endif()
   add_custom_command(
     DEPENDS ${ARG_NAME}
     COMMAND ${ARG_NAME}
+    ${_POST_GENERATE_COMMAND}
     OUTPUT
       # Common
       ${_GENERATED_PATH}/acado_common.h
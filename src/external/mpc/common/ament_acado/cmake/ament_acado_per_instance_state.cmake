@@ -0,0 +1,32 @@
+# Makes the state of generated qpOASES solver code per instance
+# This is a separate file so it can be run AFTER the code generator has been built (and run)
+# The globals acadoVariables and acadoWorkspace become thread-local pointers acado_variables and
+# acado_workspace, which the user points to the state of the instance to solve before calling into
+# the generated code. The number of working set recalculations of the qpOASES interface becomes
+# thread-local as well, so that instances can be solved concurrently on different threads.
+set(_HEADER ${_GENERATED_PATH}/acado_common.h)
+set(_QP_INTERFACE ${_GENERATED_PATH}/acado_qpoases_interface.cpp)
+
+file(READ ${_HEADER} _CONTENT)
+foreach(_TYPE_VAR "ACADOvariables;acadoVariables;acado_variables"
+    "ACADOworkspace;acadoWorkspace;acado_workspace")
+  list(GET _TYPE_VAR 0 _TYPE)
+  list(GET _TYPE_VAR 1 _GLOBAL)
+  list(GET _TYPE_VAR 2 _POINTER)
+  set(_DECLARATION "extern[ \t]+${_TYPE}[ \t]+${_GLOBAL}[ \t]*;")
+  if(NOT _CONTENT MATCHES "${_DECLARATION}")
+    message(FATAL_ERROR "${_HEADER} does not declare ${_GLOBAL}!")
+  endif()
+  string(REGEX REPLACE "${_DECLARATION}"
+    "extern __thread ${_TYPE} * ${_POINTER};\n#define ${_GLOBAL} (*${_POINTER})"
+    _CONTENT "${_CONTENT}")
+endforeach()
+file(WRITE ${_HEADER} "${_CONTENT}")
+
+file(READ ${_QP_INTERFACE} _CONTENT)
+set(_DECLARATION "static[ \t]+int[ \t]+acado_nWSR[ \t]*;")
+if(NOT _CONTENT MATCHES "${_DECLARATION}")
+  message(FATAL_ERROR "${_QP_INTERFACE} does not declare acado_nWSR!")
+endif()
+string(REGEX REPLACE "${_DECLARATION}" "static __thread int acado_nWSR;" _CONTENT "${_CONTENT}")
+file(WRITE ${_QP_INTERFACE} "${_CONTENT}")
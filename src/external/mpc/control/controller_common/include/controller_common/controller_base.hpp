@@ -95,6 +95,10 @@ public:
   /// \throw std::domain_error If state is not in the same frame as reference trajectory
   Command compute_command(const State & state);
 
+  /// Do work for the next compute_command() call which does not depend on the next state, e.g.
+  /// after the last command was sent. Does nothing by default
+  virtual void prepare_next();
+
   /// Computes stopping control command
   Command compute_stop_command(const State & state) const noexcept;
 
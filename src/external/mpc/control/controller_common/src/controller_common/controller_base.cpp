@@ -122,6 +122,12 @@ Command ControllerBase::compute_command(const State & state)
   return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void ControllerBase::prepare_next()
+{
+  // noop
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 bool ControllerBase::check_new_trajectory(const Trajectory & trajectory) const
 {
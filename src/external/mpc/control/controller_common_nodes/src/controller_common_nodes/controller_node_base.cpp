@@ -235,6 +235,13 @@ bool ControllerBaseNode::try_compute(const State & state)
   } catch (...) {
     diagnostic_fn();
     on_bad_compute(std::current_exception());
+    return true;
+  }
+  // The command is out, now there is time for work towards the next one
+  try {
+    m_controller->prepare_next();
+  } catch (...) {
+    on_bad_compute(std::current_exception());
   }
   return true;
 }
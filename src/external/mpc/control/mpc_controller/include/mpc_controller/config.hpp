@@ -52,6 +52,16 @@ enum class Interpolation : uint8_t
   NO = 1U
 };
 
+/// How the solver steps are distributed over a control cycle
+enum class SolverMode : uint8_t
+{
+  /// Preparation and feedback step when the command is computed
+  FULL = 0U,
+  /// Real-time iteration: the preparation step for the next cycle runs in prepare_next(), after
+  /// the command was sent, so that only the feedback step is left when the command is computed
+  REAL_TIME_ITERATION = 1U
+};
+
 /// \brief A configuration class for the MpcController
 class MPC_CONTROLLER_PUBLIC Config
 {
@@ -63,7 +73,9 @@ public:
     const OptimizationConfig & optimization_param,
     std::chrono::nanoseconds sample_period_tolerance,
     std::chrono::nanoseconds control_lookahead_duration,
-    Interpolation interpolation_option);
+    Interpolation interpolation_option,
+    SolverMode solver_mode = SolverMode::FULL,
+    std::chrono::nanoseconds solver_deadline = std::chrono::nanoseconds::zero());
   MPC_CONTROLLER_COPY_MOVE_ASSIGNABLE(Config)
 
   const LimitsConfig & limits() const noexcept;
@@ -73,6 +85,10 @@ public:
   std::chrono::nanoseconds sample_period_tolerance() const noexcept;
   std::chrono::nanoseconds control_lookahead_duration() const noexcept;
   bool do_interpolate() const noexcept;
+  SolverMode solver_mode() const noexcept;
+  /// Time after the start of a command computation after which the solver is abandoned and the
+  /// previous solution is used. Zero if the solver always runs to completion
+  std::chrono::nanoseconds solver_deadline() const noexcept;
 
 private:
   LimitsConfig m_limits;
@@ -82,6 +98,8 @@ private:
   std::chrono::nanoseconds m_sample_period_tolerance;
   std::chrono::nanoseconds m_control_lookahead_duration;
   bool m_do_interpolate;
+  SolverMode m_solver_mode;
+  std::chrono::nanoseconds m_solver_deadline;
 };  // class Config
 
 struct MPC_CONTROLLER_PUBLIC ControlDerivatives
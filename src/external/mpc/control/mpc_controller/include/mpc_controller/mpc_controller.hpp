@@ -21,7 +21,10 @@
 
 #include <controller_common/controller_base.hpp>
 #include <mpc_controller/config.hpp>
+#include <mpc_controller/solver_timings.hpp>
 
+#include <chrono>
+#include <memory>
 #include <ostream>
 #include <string>
 
@@ -31,13 +34,29 @@ namespace control
 {
 namespace mpc_controller
 {
+/// Variables and workspace of the autogenerated solver, defined next to the generated code
+struct SolverState;
+/// Thread to solve with a deadline, defined next to the generated code
+class SolverThread;
+
 /// \brief A wrapper around an autogenerated mpc solver for vehicle dynamics control
+///
+/// Each instance owns its solver variables and workspace, so several controllers, e.g. for
+/// candidate trajectories or weight sets, can exist in one process and be used from different
+/// threads. An instance itself is not thread-safe. The autogenerated solver accesses the state
+/// through thread-local pointers, which each solve points to the state of its instance, so the
+/// instances solve in parallel without copying their state.
+///
+/// In SolverMode::REAL_TIME_ITERATION, prepare_next() shifts the problem to the reference point
+/// predicted for the next cycle and runs the preparation step, so that the next command only needs
+/// the feedback step. With a solver deadline, the solver runs on a separate thread; if it does not
+/// finish in time, the command is taken from the previous solution, shifted to the current
+/// reference point.
 class MPC_CONTROLLER_PUBLIC MpcController : public controller_common::ControllerBase
 {
 public:
   constexpr static std::chrono::nanoseconds solver_time_step{std::chrono::milliseconds{100LL}};
-  // Disable other constructors, assignment operators: autogenerated code has annoying static
-  // variables
+  // Disable other constructors, assignment operators: the solver state is large
   MpcController(const MpcController &) = delete;
   MpcController(MpcController &&) noexcept = delete;
   MpcController & operator=(const MpcController &) = delete;
@@ -49,7 +68,7 @@ public:
 
   /// \brief Constructor
   explicit MpcController(const Config & config);
-  ~MpcController() override = default;
+  ~MpcController() override;
 
   /// Getter for config class
   const Config & get_config() const;
@@ -62,6 +81,19 @@ public:
   const Trajectory & get_computed_trajectory() const noexcept;
   /// Get derivatives computed from the control problem
   ControlDerivatives get_computed_control_derivatives() const noexcept;
+  /// Get the objective value of the last solution, e.g. to choose between the results of several
+  /// controllers
+  Real get_objective_value() const;
+  /// Durations of the solver steps so far
+  const SolverTimings & get_solver_timings() const noexcept;
+  /// Reset the durations of the solver steps
+  void reset_solver_timings() noexcept;
+
+  /// In SolverMode::REAL_TIME_ITERATION, prepare the problem for the next command computation, for
+  /// a state one behavior time step after the last one. To be called after the last command was
+  /// sent. Does nothing in other modes or if there is no solution to start from
+  /// \throw std::runtime_error If the preparation step fails
+  void prepare_next() override;
 
   /// Debug printing
   void debug_print(std::ostream & out) const;
@@ -81,12 +113,14 @@ protected:
   Command compute_command_impl(const State & state) override;
 
 private:
-  /// Run the solver subroutine
-  MPC_CONTROLLER_LOCAL void solve();
+  /// Run the solver subroutine, keep the previous solution if the deadline is missed
+  MPC_CONTROLLER_LOCAL void solve(std::chrono::steady_clock::time_point deadline);
   /// Roll references forward and update weights appropriately, return true if cold start
   MPC_CONTROLLER_LOCAL bool update_references(Index current_idx);
   /// Set initial conditions for problem
   MPC_CONTROLLER_LOCAL void initial_conditions(const Point & state);
+  /// Start the solution at x0; a prepared problem keeps the first node it was linearized at
+  MPC_CONTROLLER_LOCAL void reset_first_node() noexcept;
   /// Compute delta to roll state forward or back to match first reference
   MPC_CONTROLLER_LOCAL std::chrono::nanoseconds x0_time_offset(const State & state, Index idx);
   /// Compute interpolated command
@@ -119,13 +153,20 @@ private:
   MPC_CONTROLLER_LOCAL void set_terminal_reference(const Point & pt) noexcept;
   /// Roll solution and reference forward
   MPC_CONTROLLER_LOCAL void advance_problem(Index count);
-  /// Fills the last N trajectory reference points with points from the reference trajectory
-  MPC_CONTROLLER_LOCAL void backfill_reference(Index count);
+  /// Fills the last N trajectory reference points with points from the reference trajectory,
+  /// the first reference point being current_idx
+  MPC_CONTROLLER_LOCAL void backfill_reference(Index current_idx, Index count);
 
   Config m_config;
+  std::unique_ptr<SolverState> m_solver;
+  std::unique_ptr<SolverThread> m_solver_thread;
+  SolverTimings m_timings;
   Trajectory::UniquePtr m_interpolated_trajectory{nullptr};
   mutable Trajectory m_computed_trajectory;
   Index m_last_reference_index;
+  Index m_unshifted_reference_index;
+  std::chrono::system_clock::time_point m_last_state_time;
+  bool m_is_solved;
 };  // class MpcController
 }  // namespace mpc_controller
 }  // namespace control
@@ -0,0 +1,77 @@
+// Copyright 2020 Christopher Ho
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MPC_CONTROLLER__SOLVER_TIMINGS_HPP_
+#define MPC_CONTROLLER__SOLVER_TIMINGS_HPP_
+
+#include <mpc_controller/visibility_control.hpp>
+#include <mpc_controller/config.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace motion
+{
+namespace control
+{
+namespace mpc_controller
+{
+/// Histogram of durations with bins of equal width, starting at zero
+class MPC_CONTROLLER_PUBLIC TimingHistogram
+{
+public:
+  /// \param bin_width Duration covered by each bin
+  /// \param num_bins Number of bins, the last one also counts all longer durations
+  /// \throw std::domain_error If the bin width is not positive or there are no bins
+  TimingHistogram(std::chrono::nanoseconds bin_width, std::size_t num_bins);
+  MPC_CONTROLLER_COPY_MOVE_ASSIGNABLE(TimingHistogram)
+
+  /// Count a duration
+  void add(std::chrono::nanoseconds duration) noexcept;
+  /// Reset all counts
+  void clear() noexcept;
+
+  /// Counts per bin, bin i covers [i * bin_width, (i + 1) * bin_width)
+  const std::vector<std::uint64_t> & bins() const noexcept;
+  std::chrono::nanoseconds bin_width() const noexcept;
+  /// Total number of durations
+  std::uint64_t count() const noexcept;
+  /// Longest duration, zero if there are none
+  std::chrono::nanoseconds max() const noexcept;
+  /// Upper edge of the bin below which the given fraction of durations lies, e.g. 0.99 for the
+  /// 99th percentile. The result is at most the longest duration
+  std::chrono::nanoseconds percentile(Real fraction) const noexcept;
+
+private:
+  std::chrono::nanoseconds m_bin_width;
+  std::vector<std::uint64_t> m_bins;
+  std::uint64_t m_count;
+  std::chrono::nanoseconds m_max;
+};  // class TimingHistogram
+
+/// Durations of the solver steps of a controller
+struct MPC_CONTROLLER_PUBLIC SolverTimings
+{
+  /// Preparation steps, both in compute_command() and prepare_next()
+  TimingHistogram preparation;
+  /// Feedback steps. With a solver deadline, they include copying the problem to the solver
+  /// thread and waking it up, i.e. everything from the hand-over until the solution is ready
+  TimingHistogram feedback;
+  /// Number of command computations for which the solver missed the deadline
+  std::uint64_t deadline_misses;
+};  // struct SolverTimings
+}  // namespace mpc_controller
+}  // namespace control
+}  // namespace motion
+#endif  // MPC_CONTROLLER__SOLVER_TIMINGS_HPP_
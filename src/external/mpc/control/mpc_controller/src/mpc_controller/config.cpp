@@ -30,14 +30,18 @@ Config::Config(
   const OptimizationConfig & optimization_param,
   const std::chrono::nanoseconds sample_period_tolerance,
   const std::chrono::nanoseconds control_lookahead_duration,
-  const Interpolation interpolation_option)
+  const Interpolation interpolation_option,
+  const SolverMode solver_mode,
+  const std::chrono::nanoseconds solver_deadline)
 : m_limits{limits},
   m_vehicle_param{vehicle_param},
   m_behavior_param{behavior},
   m_optimization_param{optimization_param},
   m_sample_period_tolerance{sample_period_tolerance},
   m_control_lookahead_duration{control_lookahead_duration},
-  m_do_interpolate{interpolation_option == Interpolation::YES}
+  m_do_interpolate{interpolation_option == Interpolation::YES},
+  m_solver_mode{solver_mode},
+  m_solver_deadline{solver_deadline}
 {
   if (sample_period_tolerance < decltype(sample_period_tolerance)::zero()) {
     throw std::domain_error{"Sample period tolerance must be positive"};
@@ -46,6 +50,9 @@ Config::Config(
   if (control_lookahead_duration < decltype(control_lookahead_duration)::zero()) {
     throw std::domain_error{"Control lookahead duration must be positive"};
   }
+  if (solver_deadline < decltype(solver_deadline)::zero()) {
+    throw std::domain_error{"Solver deadline must be positive"};
+  }
 }
 
 const LimitsConfig & Config::limits() const noexcept
@@ -76,6 +83,14 @@ bool Config::do_interpolate() const noexcept
 {
   return m_do_interpolate;
 }
+SolverMode Config::solver_mode() const noexcept
+{
+  return m_solver_mode;
+}
+std::chrono::nanoseconds Config::solver_deadline() const noexcept
+{
+  return m_solver_deadline;
+}
 }  // namespace mpc_controller
 }  // namespace control
 }  // namespace motion
@@ -12,12 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Treat as a system header since we don't want to touch that autogenerated stuff..
-#include <acado_common.h>
-
 #include <ostream>
 
 #include "mpc_controller/mpc_controller.hpp"
+#include "solver_state.hpp"
 
 namespace motion
 {
@@ -32,7 +30,7 @@ void MpcController::debug_print(std::ostream & out) const
   {
     out << "x0:\n";
     for (std::size_t jdx = {}; jdx < ACADO_NX; ++jdx) {
-      out << acadoVariables.x0[jdx] << "\t";
+      out << m_solver->variables.x0[jdx] << "\t";
     }
     out << "\n";
   }
@@ -40,7 +38,7 @@ void MpcController::debug_print(std::ostream & out) const
     out << "x:\n";
     for (std::size_t idx = {}; idx < ACADO_N; ++idx) {
       for (std::size_t jdx = {}; jdx < ACADO_NX; ++jdx) {
-        out << acadoVariables.x[(idx * ACADO_NX) + jdx] << "\t";
+        out << m_solver->variables.x[(idx * ACADO_NX) + jdx] << "\t";
       }
       out << "\n";
     }
@@ -49,7 +47,7 @@ void MpcController::debug_print(std::ostream & out) const
     out << "u:\n";
     for (std::size_t idx = {}; idx < ACADO_N; ++idx) {
       for (std::size_t jdx = {}; jdx < ACADO_NU; ++jdx) {
-        out << acadoVariables.u[(idx * ACADO_NU) + jdx] << "\t";
+        out << m_solver->variables.u[(idx * ACADO_NU) + jdx] << "\t";
       }
       out << "\n";
     }
@@ -58,7 +56,7 @@ void MpcController::debug_print(std::ostream & out) const
     out << "y:\n";
     for (std::size_t idx = {}; idx < ACADO_N; ++idx) {
       for (std::size_t jdx = {}; jdx < ACADO_NY; ++jdx) {
-        out << acadoVariables.y[(idx * ACADO_NY) + jdx] << "\t";
+        out << m_solver->variables.y[(idx * ACADO_NY) + jdx] << "\t";
       }
       out << "\n";
     }
@@ -66,7 +64,7 @@ void MpcController::debug_print(std::ostream & out) const
   {
     out << "yN:\n";
     for (std::size_t jdx = {}; jdx < ACADO_NYN; ++jdx) {
-      out << acadoVariables.yN[jdx] << "\t";
+      out << m_solver->variables.yN[jdx] << "\t";
     }
     out << "\n";
   }
@@ -74,7 +72,7 @@ void MpcController::debug_print(std::ostream & out) const
     out << "W:\n";
     for (std::size_t idx = {}; idx < ACADO_N; ++idx) {
       for (std::size_t jdx = {}; jdx < ACADO_NY; ++jdx) {
-        out << acadoVariables.W[(ACADO_NY * ACADO_NY * idx) + ((jdx * ACADO_NY) + jdx)] <<
+        out << m_solver->variables.W[(ACADO_NY * ACADO_NY * idx) + ((jdx * ACADO_NY) + jdx)] <<
           "\t";
       }
       out << "\n";
@@ -83,7 +81,7 @@ void MpcController::debug_print(std::ostream & out) const
   {
     out << "WN:\n";
     for (std::size_t jdx = {}; jdx < ACADO_NYN; ++jdx) {
-      out << acadoVariables.WN[(jdx * ACADO_NYN) + jdx] << "\t";
+      out << m_solver->variables.WN[(jdx * ACADO_NYN) + jdx] << "\t";
     }
     out << "\n";
   }
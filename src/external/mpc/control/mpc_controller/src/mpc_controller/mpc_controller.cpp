@@ -14,20 +14,23 @@
 
 #include "mpc_controller/mpc_controller.hpp"
 
-// Treat as a system header since we don't want to touch that autogenerated stuff..
-#include <acado_common.h>
 #include <motion_common/motion_common.hpp>
 #include <time_utils/time_utils.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
-// extern variables in autogenerated code
-ACADOworkspace acadoWorkspace;
-ACADOvariables acadoVariables;
+#include "solver_state.hpp"
+
+// extern thread-local variables in autogenerated code, only valid while a SolverScope exists
+__thread ACADOworkspace * acado_workspace = nullptr;
+__thread ACADOvariables * acado_variables = nullptr;
 
 // TODO(c.ho) gsl::at() everywhere
 
@@ -59,22 +62,212 @@ constexpr auto IDX_WHEEL_ANGLE_RATE = 1U;
 
 constexpr std::chrono::nanoseconds MpcController::solver_time_step;
 
+// 50 us resolution up to 10 ms, the solver steps usually take a few milliseconds
+constexpr auto TIMING_BIN_WIDTH = std::chrono::microseconds{50LL};
+constexpr auto TIMING_NUM_BINS = 200U;
+
+////////////////////////////////////////////////////////////////////////////////
+SolverScope::SolverScope(SolverState & state) noexcept
+: m_previous_variables{acado_variables},
+  m_previous_workspace{acado_workspace}
+{
+  acado_variables = &state.variables;
+  acado_workspace = &state.workspace;
+}
+
+SolverScope::~SolverScope()
+{
+  acado_variables = m_previous_variables;
+  acado_workspace = m_previous_workspace;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+std::chrono::nanoseconds preparation_step()
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto prep_ret = acado_preparationStep();
+  if (0 != prep_ret) {
+    std::string err_str{"Solver preparation error: ", std::string::allocator_type{}};
+    err_str += std::to_string(prep_ret);
+    throw std::runtime_error{err_str};
+  }
+  return std::chrono::steady_clock::now() - start;
+}
+
+std::chrono::nanoseconds feedback_step()
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto solve_ret = acado_feedbackStep();
+  if (0 != solve_ret) {
+    std::string err_str{"Solver error: ", std::string::allocator_type{}};
+    err_str += std::to_string(solve_ret);
+    throw std::runtime_error{err_str};
+  }
+  return std::chrono::steady_clock::now() - start;
+}
+}  // namespace
+
+void run_preparation(SolverState & state, TimingHistogram & timing)
+{
+  const SolverScope scope{state};
+  timing.add(preparation_step());
+  state.is_prepared = true;
+}
+
+SolveDurations run_solver(SolverState & state)
+{
+  SolveDurations ret{false, std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::zero()};
+  const SolverScope scope{state};
+  if (!state.is_prepared) {
+    ret.preparation = preparation_step();
+    ret.did_prepare = true;
+  }
+  // The solution changes the linearization point, the next solve needs a new preparation
+  state.is_prepared = false;
+  ret.feedback = feedback_step();
+  return ret;
+}
+
+namespace
+{
+/// Copy the problem to solve, i.e. everything apart from unshifted_variables
+void copy_problem(const SolverState & from, SolverState & to)
+{
+  to.variables = from.variables;
+  to.workspace = from.workspace;
+  to.is_prepared = from.is_prepared;
+}
+}  // namespace
+
+void record_durations(const SolveDurations & durations, SolverTimings & timings)
+{
+  if (durations.did_prepare) {
+    timings.preparation.add(durations.preparation);
+  }
+  timings.feedback.add(durations.feedback);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SolverThread::SolverThread()
+: m_state{std::make_unique<SolverState>()},
+  m_status{Status::IDLE},
+  m_stop{false},
+  m_durations{false, std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::zero()},
+  m_submit_time{},
+  m_thread{[this] {run();}}
+{
+}
+
+SolverThread::~SolverThread()
+{
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+bool SolverThread::solve(
+  std::unique_ptr<SolverState> & state,
+  const std::chrono::steady_clock::time_point deadline,
+  SolverTimings & timings)
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  const auto is_free = [this] {return (Status::IDLE == m_status) || (Status::DONE == m_status);};
+  const auto free_in_time = m_condition.wait_until(lock, deadline, is_free);
+  if (Status::DONE == m_status) {
+    // Late solution of an earlier call
+    record_durations(m_durations, timings);
+    m_error = nullptr;
+    m_status = Status::IDLE;
+  }
+  if (!free_in_time) {
+    ++timings.deadline_misses;
+    return false;
+  }
+  m_submit_time = std::chrono::steady_clock::now();
+  copy_problem(*state, *m_state);
+  m_status = Status::PENDING;
+  m_condition.notify_all();
+  const auto is_done = [this] {return Status::DONE == m_status;};
+  if (!m_condition.wait_until(lock, deadline, is_done)) {
+    ++timings.deadline_misses;
+    return false;
+  }
+  record_durations(m_durations, timings);
+  m_status = Status::IDLE;
+  if (m_error) {
+    const auto error = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(error);
+  }
+  std::swap(state, m_state);
+  return true;
+}
+
+void SolverThread::run()
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  while (true) {
+    m_condition.wait(lock, [this] {return m_stop || (Status::PENDING == m_status);});
+    if (m_stop) {
+      return;
+    }
+    m_status = Status::RUNNING;
+    const auto submit_time = m_submit_time;
+    lock.unlock();
+    SolveDurations durations{false, std::chrono::nanoseconds::zero(),
+      std::chrono::nanoseconds::zero()};
+    std::exception_ptr error{};
+    try {
+      durations = run_solver(*m_state);
+      // The copy of the problem and the hand-over to this thread delay the solution as well
+      durations.feedback =
+        (std::chrono::steady_clock::now() - submit_time) - durations.preparation;
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    m_durations = durations;
+    m_error = error;
+    m_status = Status::DONE;
+    m_condition.notify_all();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 MpcController::MpcController(const Config & config)
 : ControllerBase{config.behavior()},
   m_config{config},
+  m_solver{std::make_unique<SolverState>()},
+  m_timings{
+    TimingHistogram{TIMING_BIN_WIDTH, TIMING_NUM_BINS},
+    TimingHistogram{TIMING_BIN_WIDTH, TIMING_NUM_BINS},
+    std::uint64_t{}},
   m_computed_trajectory{rosidl_generator_cpp::MessageInitialization::ALL},
-  m_last_reference_index{}
+  m_last_reference_index{},
+  m_unshifted_reference_index{},
+  m_last_state_time{},
+  m_is_solved{false}
 {
   if (config.do_interpolate()) {
     m_interpolated_trajectory = std::make_unique<Trajectory>();
     m_interpolated_trajectory->points.reserve(Trajectory::CAPACITY);
   }
   m_computed_trajectory.points.reserve(Trajectory::CAPACITY);
-  acado_initializeSolver();
+  {
+    const SolverScope scope{*m_solver};
+    acado_initializeSolver();
+  }
   apply_config(m_config);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+MpcController::~MpcController() = default;
+
 ////////////////////////////////////////////////////////////////////////////////
 const Config & MpcController::get_config() const
 {
@@ -89,9 +282,26 @@ void MpcController::set_config(const Config & config)
   apply_config(m_config);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+const SolverTimings & MpcController::get_solver_timings() const noexcept
+{
+  return m_timings;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MpcController::reset_solver_timings() noexcept
+{
+  m_timings.preparation.clear();
+  m_timings.feedback.clear();
+  m_timings.deadline_misses = {};
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 Command MpcController::compute_command_impl(const State & state)
 {
+  const auto deadline = std::chrono::steady_clock::now() + m_config.solver_deadline();
+  m_is_solved = false;
+  m_last_state_time = time_utils::from_message(state.header.stamp);
   const auto current_idx = get_current_state_temporal_index();
 
   auto cold_start = update_references(current_idx);
@@ -108,30 +318,80 @@ Command MpcController::compute_command_impl(const State & state)
     // Consider different ways of updating initial guess for reference update
   }
   if (cold_start) {
-    std::fill(&acadoVariables.u[0U], &acadoVariables.u[HORIZON * NU], AcadoReal{});
+    m_solver->is_prepared = false;
+  }
+  if (!m_solver->is_prepared) {
+    reset_first_node();
+  }
+  if (cold_start) {
+    std::fill(&m_solver->variables.u[0U], &m_solver->variables.u[HORIZON * NU], AcadoReal{});
+    const SolverScope scope{*m_solver};
     acado_initializeNodesByForwardSimulation();
   }
   // TODO(c.ho) further validation on state
-  solve();
+  solve(deadline);
+  m_is_solved = true;
   // Get result
   return interpolated_command(dt);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void MpcController::solve()
+void MpcController::solve(const std::chrono::steady_clock::time_point deadline)
 {
-  const auto prep_ret = acado_preparationStep();
-  if (0 != prep_ret) {
-    std::string err_str{"Solver preparation error: ", std::string::allocator_type{}};
-    err_str += std::to_string(prep_ret);
-    throw std::runtime_error{err_str};
+  if (m_solver_thread) {
+    // If the deadline is missed, the previous solution, which update_references() shifted to the
+    // current reference point, stays in place
+    (void)m_solver_thread->solve(m_solver, deadline, m_timings);
+  } else {
+    record_durations(run_solver(*m_solver), m_timings);
   }
-  const auto solve_ret = acado_feedbackStep();
-  if (0 != solve_ret) {
-    std::string err_str{"Solver error: ", std::string::allocator_type{}};
-    err_str += std::to_string(solve_ret);
-    throw std::runtime_error{err_str};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MpcController::prepare_next()
+{
+  if ((SolverMode::REAL_TIME_ITERATION != m_config.solver_mode()) || !m_is_solved) {
+    return;
+  }
+  // Predict the reference point of a state one time step after the last one, like
+  // ControllerBase does for the actual state
+  const auto & traj = get_reference_trajectory();
+  const auto next_time = m_last_state_time + get_base_config().time_step();
+  State next_state{rosidl_generator_cpp::MessageInitialization::ALL};
+  next_state.header.stamp = time_utils::to_message(next_time);
+  const auto time_f =
+    [](const State & state, const Point &, const Point & pt, const Trajectory & ref) -> bool {
+      using time_utils::from_message;
+      return from_message(state.header.stamp) >=
+             (from_message(ref.header.stamp) + from_message(pt.time_from_start));
+    };
+  auto next_idx = motion_common::update_reference_index(
+    traj, next_state, m_last_reference_index, time_f);
+  next_idx = std::min(next_idx, static_cast<Index>(m_last_reference_index + HORIZON - 1U));
+  // The planned state at the next reference point becomes the first node to linearize at
+  const auto advance_idx = next_idx - m_last_reference_index;
+  auto & variables = m_solver->variables;
+  m_unshifted_reference_index = m_last_reference_index;
+  if (advance_idx > 0U) {
+    m_solver->unshifted_variables = variables;
+    (void)std::copy(
+      &variables.x[NX * advance_idx],
+      &variables.x[NX * (advance_idx + 1U)],
+      &variables.x[0U]);
+  }
+  if (update_references(next_idx)) {
+    // Cold start, which initializes the solution anew
+    return;
   }
+  // Unwrap the headings with respect to the planned state; the feedback step redoes this with
+  // the actual state, which only changes the references near a wrap of the heading
+  std::copy(&variables.x[0U], &variables.x[NX], &variables.x0[0U]);
+  const auto max_pts = traj.points.size();
+  const auto horizon = std::min(static_cast<std::size_t>(max_pts - next_idx), HORIZON);
+  if (ensure_reference_consistency(horizon)) {
+    return;
+  }
+  run_preparation(*m_solver, m_timings.preparation);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -140,11 +400,19 @@ bool MpcController::update_references(const Index current_idx)
   const auto cold_start = Index{} == current_idx;
   // Roll forward previous solutions, references; backfill references or prune weights
   if (!cold_start) {
+    if (current_idx < m_last_reference_index) {
+      // prepare_next() shifted the problem further than the state advanced, undo the shift
+      m_solver->variables = m_solver->unshifted_variables;
+      m_last_reference_index = m_unshifted_reference_index;
+    }
     const auto advance_idx = current_idx - m_last_reference_index;
+    if (advance_idx > 0U) {
+      m_solver->is_prepared = false;
+    }
     advance_problem(advance_idx);
     const auto max_pts = get_reference_trajectory().points.size();
     if (max_pts - current_idx >= HORIZON) {
-      backfill_reference(advance_idx);
+      backfill_reference(current_idx, advance_idx);
     } else {
       const auto receded_horizon = max_pts - current_idx;
       apply_terminal_weights(receded_horizon - 1);
@@ -162,16 +430,20 @@ bool MpcController::update_references(const Index current_idx)
 void MpcController::initial_conditions(const Point & state)
 {
   // Set x0
-  acadoVariables.x0[IDX_X] = static_cast<AcadoReal>(state.x);
-  acadoVariables.x0[IDX_Y] = static_cast<AcadoReal>(state.y);
-  acadoVariables.x0[IDX_HEADING] =
+  m_solver->variables.x0[IDX_X] = static_cast<AcadoReal>(state.x);
+  m_solver->variables.x0[IDX_Y] = static_cast<AcadoReal>(state.y);
+  m_solver->variables.x0[IDX_HEADING] =
     static_cast<AcadoReal>(motion_common::to_angle(state.heading));
-  acadoVariables.x0[IDX_VEL_LONG] = static_cast<AcadoReal>(state.longitudinal_velocity_mps);
-  // Initialization stuff
-  acadoVariables.x[IDX_X] = acadoVariables.x0[IDX_X];
-  acadoVariables.x[IDX_Y] = acadoVariables.x0[IDX_Y];
-  acadoVariables.x[IDX_HEADING] = acadoVariables.x0[IDX_HEADING];
-  acadoVariables.x[IDX_VEL_LONG] = acadoVariables.x0[IDX_VEL_LONG];
+  m_solver->variables.x0[IDX_VEL_LONG] = static_cast<AcadoReal>(state.longitudinal_velocity_mps);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MpcController::reset_first_node() noexcept
+{
+  m_solver->variables.x[IDX_X] = m_solver->variables.x0[IDX_X];
+  m_solver->variables.x[IDX_Y] = m_solver->variables.x0[IDX_Y];
+  m_solver->variables.x[IDX_HEADING] = m_solver->variables.x0[IDX_HEADING];
+  m_solver->variables.x[IDX_VEL_LONG] = m_solver->variables.x0[IDX_VEL_LONG];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -208,11 +480,11 @@ Command MpcController::interpolated_command(const std::chrono::nanoseconds x0_ti
     ret.rear_wheel_angle_rad = {};
     // interpolation
     const auto idx = count * ACADO_NU;
-    const auto longitudinal0 = static_cast<Real>(acadoVariables.u[idx + IDX_JERK]);
-    const auto lateral0 = static_cast<Real>(acadoVariables.u[idx + IDX_WHEEL_ANGLE_RATE]);
+    const auto longitudinal0 = static_cast<Real>(m_solver->variables.u[idx + IDX_JERK]);
+    const auto lateral0 = static_cast<Real>(m_solver->variables.u[idx + IDX_WHEEL_ANGLE_RATE]);
     const auto jdx = (count + 1U) * ACADO_NU;
-    const auto longitudinal1 = static_cast<Real>(acadoVariables.u[jdx + IDX_JERK]);
-    const auto lateral1 = static_cast<Real>(acadoVariables.u[jdx + IDX_WHEEL_ANGLE_RATE]);
+    const auto longitudinal1 = static_cast<Real>(m_solver->variables.u[jdx + IDX_JERK]);
+    const auto lateral1 = static_cast<Real>(m_solver->variables.u[jdx + IDX_WHEEL_ANGLE_RATE]);
     ret.front_wheel_angle_rad = motion_common::interpolate(lateral0, lateral1, t);
     ret.long_accel_mps2 = motion_common::interpolate(longitudinal0, longitudinal1, t);
   }
@@ -232,15 +504,15 @@ const MpcController::Trajectory & MpcController::get_computed_trajectory() const
   for (std::size_t i = {}; i < HORIZON; ++i) {
     auto & pt = traj.points[i];
     const auto idx = NX * i;
-    pt.x = static_cast<Real>(acadoVariables.x[idx + IDX_X]);
-    pt.y = static_cast<Real>(acadoVariables.x[idx + IDX_Y]);
-    pt.longitudinal_velocity_mps = static_cast<Real>(acadoVariables.x[idx + IDX_VEL_LONG]);
+    pt.x = static_cast<Real>(m_solver->variables.x[idx + IDX_X]);
+    pt.y = static_cast<Real>(m_solver->variables.x[idx + IDX_Y]);
+    pt.longitudinal_velocity_mps = static_cast<Real>(m_solver->variables.x[idx + IDX_VEL_LONG]);
     pt.lateral_velocity_mps = Real{};
-    const auto heading = static_cast<Real>(acadoVariables.x[idx + IDX_HEADING]);
+    const auto heading = static_cast<Real>(m_solver->variables.x[idx + IDX_HEADING]);
     pt.heading = motion_common::from_angle(heading);
     const auto jdx = NU * i;
-    pt.acceleration_mps2 = static_cast<Real>(acadoVariables.u[jdx + IDX_JERK]);
-    pt.heading_rate_rps = static_cast<Real>(acadoVariables.u[jdx + IDX_WHEEL_ANGLE_RATE]);
+    pt.acceleration_mps2 = static_cast<Real>(m_solver->variables.u[jdx + IDX_JERK]);
+    pt.heading_rate_rps = static_cast<Real>(m_solver->variables.u[jdx + IDX_WHEEL_ANGLE_RATE]);
   }
   return m_computed_trajectory;
 }
@@ -249,17 +521,31 @@ const MpcController::Trajectory & MpcController::get_computed_trajectory() const
 ControlDerivatives MpcController::get_computed_control_derivatives() const noexcept
 {
   // return ControlDerivatives{
-  //   static_cast<Real>(acadoVariables.u[IDX_JERK]),
-  //   static_cast<Real>(acadoVariables.u[IDX_WHEEL_ANGLE_RATE])};
+  //   static_cast<Real>(m_solver->variables.u[IDX_JERK]),
+  //   static_cast<Real>(m_solver->variables.u[IDX_WHEEL_ANGLE_RATE])};
   return ControlDerivatives{{}, {}};
 }
 
+////////////////////////////////////////////////////////////////////////////////
+Real MpcController::get_objective_value() const
+{
+  const SolverScope scope{*m_solver};
+  return static_cast<Real>(acado_getObjective());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void MpcController::apply_config(const Config & cfg)
 {
   apply_parameters(cfg.vehicle_param());
   apply_bounds(cfg.limits());
   apply_weights(cfg.optimization_param());
+  m_solver->is_prepared = false;
+  const auto has_deadline = cfg.solver_deadline() > std::chrono::nanoseconds::zero();
+  if (!has_deadline) {
+    m_solver_thread.reset();
+  } else if (!m_solver_thread) {
+    m_solver_thread = std::make_unique<SolverThread>();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -270,8 +556,8 @@ void MpcController::apply_parameters(const VehicleConfig & cfg) noexcept
     const auto idx = i * ACADO_NOD;
     constexpr auto idx_Lf = 0U;
     constexpr auto idx_Lr = 1U;
-    acadoVariables.od[idx + idx_Lf] = static_cast<AcadoReal>(cfg.length_cg_front_axel());
-    acadoVariables.od[idx + idx_Lr] = static_cast<AcadoReal>(cfg.length_cg_rear_axel());
+    m_solver->variables.od[idx + idx_Lf] = static_cast<AcadoReal>(cfg.length_cg_front_axel());
+    m_solver->variables.od[idx + idx_Lr] = static_cast<AcadoReal>(cfg.length_cg_rear_axel());
   }
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -285,11 +571,11 @@ void MpcController::apply_bounds(const LimitsConfig & cfg) noexcept
       const auto idx = i * NUM_CTRL_CONSTRAINTS;
       constexpr auto idx_ax = 0U;
       constexpr auto idx_delta = 1U;
-      acadoVariables.lbValues[idx + idx_ax] = static_cast<AcadoReal>(cfg.acceleration().min());
-      acadoVariables.ubValues[idx + idx_ax] = static_cast<AcadoReal>(cfg.acceleration().max());
-      acadoVariables.lbValues[idx + idx_delta] =
+      m_solver->variables.lbValues[idx + idx_ax] = static_cast<AcadoReal>(cfg.acceleration().min());
+      m_solver->variables.ubValues[idx + idx_ax] = static_cast<AcadoReal>(cfg.acceleration().max());
+      m_solver->variables.lbValues[idx + idx_delta] =
         static_cast<AcadoReal>(cfg.steer_angle().min());
-      acadoVariables.ubValues[idx + idx_delta] =
+      m_solver->variables.ubValues[idx + idx_delta] =
         static_cast<AcadoReal>(cfg.steer_angle().max());
     }
     {
@@ -300,9 +586,9 @@ void MpcController::apply_bounds(const LimitsConfig & cfg) noexcept
       // have constraints
       // If you're changing this, check the order in the code generation script
       constexpr auto idx_u = 0U;
-      acadoVariables.lbAValues[idx + idx_u] =
+      m_solver->variables.lbAValues[idx + idx_u] =
         static_cast<AcadoReal>(cfg.longitudinal_velocity().min());
-      acadoVariables.ubAValues[idx + idx_u] =
+      m_solver->variables.ubAValues[idx + idx_u] =
         static_cast<AcadoReal>(cfg.longitudinal_velocity().max());
     }
   }
@@ -12,14 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Treat as a system header since we don't want to touch that autogenerated stuff..
-#include <acado_common.h>
 #include <motion_common/motion_common.hpp>
 
 #include <algorithm>
 #include <stdexcept>
 
 #include "mpc_controller/mpc_controller.hpp"
+#include "solver_state.hpp"
 
 namespace motion
 {
@@ -68,21 +67,21 @@ void MpcController::apply_weights(const OptimizationConfig & cfg)
 void MpcController::zero_terminal_weights() noexcept
 {
   static_assert(ACADO_NYN == 4, "Unexpected number of terminal reference variables");
-  acadoVariables.WN[(IDYN_X * NYN) + IDYN_X] = AcadoReal{};
-  acadoVariables.WN[(IDYN_Y * NYN) + IDYN_Y] = AcadoReal{};
-  acadoVariables.WN[(IDYN_HEADING * NYN) + IDYN_HEADING] = AcadoReal{};
-  acadoVariables.WN[(IDYN_VEL_LONG * NYN) + IDYN_VEL_LONG] = AcadoReal{};
+  m_solver->variables.WN[(IDYN_X * NYN) + IDYN_X] = AcadoReal{};
+  m_solver->variables.WN[(IDYN_Y * NYN) + IDYN_Y] = AcadoReal{};
+  m_solver->variables.WN[(IDYN_HEADING * NYN) + IDYN_HEADING] = AcadoReal{};
+  m_solver->variables.WN[(IDYN_VEL_LONG * NYN) + IDYN_VEL_LONG] = AcadoReal{};
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 void MpcController::set_terminal_weights(const StateWeight & cfg) noexcept
 {
   static_assert(ACADO_NYN == 4, "Unexpected number of terminal reference variables");
-  acadoVariables.WN[(IDYN_X * NYN) + IDYN_X] = static_cast<AcadoReal>(cfg.pose());
-  acadoVariables.WN[(IDYN_Y * NYN) + IDYN_Y] = static_cast<AcadoReal>(cfg.pose());
-  acadoVariables.WN[(IDYN_HEADING * NYN) + IDYN_HEADING] =
+  m_solver->variables.WN[(IDYN_X * NYN) + IDYN_X] = static_cast<AcadoReal>(cfg.pose());
+  m_solver->variables.WN[(IDYN_Y * NYN) + IDYN_Y] = static_cast<AcadoReal>(cfg.pose());
+  m_solver->variables.WN[(IDYN_HEADING * NYN) + IDYN_HEADING] =
     static_cast<AcadoReal>(cfg.heading());
-  acadoVariables.WN[(IDYN_VEL_LONG * NYN) + IDYN_VEL_LONG] =
+  m_solver->variables.WN[(IDYN_VEL_LONG * NYN) + IDYN_VEL_LONG] =
     static_cast<AcadoReal>(cfg.longitudinal_velocity());
 }
 
@@ -100,15 +99,15 @@ void MpcController::apply_nominal_weights(const StateWeight & cfg, const Index s
   for (Index i = start; i < end; ++i) {
     constexpr auto NY2 = NY * NY;
     const auto idx = i * NY2;
-    acadoVariables.W[idx + (IDY_X * NY) + IDY_X] = static_cast<AcadoReal>(cfg.pose());
-    acadoVariables.W[idx + (IDY_Y * NY) + IDY_Y] = static_cast<AcadoReal>(cfg.pose());
-    acadoVariables.W[idx + (IDY_HEADING * NY) + IDY_HEADING] =
+    m_solver->variables.W[idx + (IDY_X * NY) + IDY_X] = static_cast<AcadoReal>(cfg.pose());
+    m_solver->variables.W[idx + (IDY_Y * NY) + IDY_Y] = static_cast<AcadoReal>(cfg.pose());
+    m_solver->variables.W[idx + (IDY_HEADING * NY) + IDY_HEADING] =
       static_cast<AcadoReal>(cfg.heading());
-    acadoVariables.W[idx + (IDY_VEL_LONG * NY) + IDY_VEL_LONG] =
+    m_solver->variables.W[idx + (IDY_VEL_LONG * NY) + IDY_VEL_LONG] =
       static_cast<AcadoReal>(cfg.longitudinal_velocity());
-    acadoVariables.W[idx + (IDY_ACC * NY) + IDY_ACC] =
+    m_solver->variables.W[idx + (IDY_ACC * NY) + IDY_ACC] =
       static_cast<AcadoReal>(cfg.acceleration());
-    acadoVariables.W[idx + (IDY_STEER * NY) + IDY_STEER] =
+    m_solver->variables.W[idx + (IDY_STEER * NY) + IDY_STEER] =
       static_cast<AcadoReal>(cfg.steer_angle());
   }
 }
@@ -135,7 +134,7 @@ void MpcController::zero_nominal_weights(const Index start, Index end)
   static_assert(ACADO_WEIGHTING_MATRICES_TYPE == 2, "Weighting matrices should vary per timestep)");
   static_assert(ACADO_NY == 6, "Unexpected number of reference variables");
   constexpr auto NY2 = NY * NY;
-  std::fill(&acadoVariables.W[start * NY2], &acadoVariables.W[end * NY2], AcadoReal{});
+  std::fill(&m_solver->variables.W[start * NY2], &m_solver->variables.W[end * NY2], AcadoReal{});
   // Zero initialization, above; std::fill preferred over memset for type safety
 }
 
@@ -148,21 +147,21 @@ void MpcController::advance_problem(const Index count)
   // TODO(c.ho) error checking on count
   // TODO(c.ho) x[0] should be x0... double check logic
   (void)std::copy(
-    &acadoVariables.x[NX * (count + 1U)],
-    &acadoVariables.x[(HORIZON + 1U) * NX],
-    &acadoVariables.x[NX]);
+    &m_solver->variables.x[NX * (count + 1U)],
+    &m_solver->variables.x[(HORIZON + 1U) * NX],
+    &m_solver->variables.x[NX]);
   (void)std::copy(
-    &acadoVariables.y[NY * count],
-    &acadoVariables.y[HORIZON * NY],
-    &acadoVariables.y[0U]);
+    &m_solver->variables.y[NY * count],
+    &m_solver->variables.y[HORIZON * NY],
+    &m_solver->variables.y[0U]);
   (void)std::copy(
-    &acadoVariables.u[NU * count],
-    &acadoVariables.u[HORIZON * NU],
-    &acadoVariables.u[0U]);
+    &m_solver->variables.u[NU * count],
+    &m_solver->variables.u[HORIZON * NU],
+    &m_solver->variables.u[0U]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-void MpcController::backfill_reference(const Index count)
+void MpcController::backfill_reference(const Index current_idx, const Index count)
 {
   static_assert(sizeof(std::size_t) >= sizeof(Index), "static cast might truncate");
   if (HORIZON <= count) {
@@ -172,8 +171,7 @@ void MpcController::backfill_reference(const Index count)
   const auto ref_start = HORIZON - count;
   // start pulling from the trajectory N - count from the current point
   const auto max_pts = static_cast<std::size_t>(get_reference_trajectory().points.size());
-  const auto curr_idx = get_current_state_temporal_index();
-  const auto traj_start = std::min(curr_idx + ref_start, max_pts);
+  const auto traj_start = std::min(current_idx + ref_start, max_pts);
   // Try to pull up to count
   const auto traj_end = std::min(traj_start + count, max_pts);
   const auto safe_count = traj_end - traj_start;
@@ -205,10 +203,11 @@ void MpcController::set_reference(
   for (auto i = Index{}; i < count; ++i) {
     const auto & pt = traj.points[traj_start + i];
     const auto ydx = (y_start + i) * NY;
-    acadoVariables.y[ydx + IDY_X] = static_cast<AcadoReal>(pt.x);
-    acadoVariables.y[ydx + IDY_Y] = static_cast<AcadoReal>(pt.y);
-    acadoVariables.y[ydx + IDY_VEL_LONG] = static_cast<AcadoReal>(pt.longitudinal_velocity_mps);
-    acadoVariables.y[ydx + IDY_HEADING] =
+    m_solver->variables.y[ydx + IDY_X] = static_cast<AcadoReal>(pt.x);
+    m_solver->variables.y[ydx + IDY_Y] = static_cast<AcadoReal>(pt.y);
+    m_solver->variables.y[ydx + IDY_VEL_LONG] =
+      static_cast<AcadoReal>(pt.longitudinal_velocity_mps);
+    m_solver->variables.y[ydx + IDY_HEADING] =
       static_cast<AcadoReal>(motion_common::to_angle(pt.heading));
   }
 }
@@ -218,7 +217,7 @@ bool MpcController::ensure_reference_consistency(Index horizon)
 {
   static_assert(sizeof(std::size_t) >= sizeof(Index), "static cast might truncate");
   horizon = std::min(static_cast<std::size_t>(horizon), HORIZON);
-  auto last_angle = acadoVariables.x0[IDX_HEADING];
+  auto last_angle = m_solver->variables.x0[IDX_HEADING];
   auto err = AcadoReal{};
   const auto fn = [&last_angle, &err](auto & ref) {
       const auto dth = ref - last_angle;
@@ -230,9 +229,13 @@ bool MpcController::ensure_reference_consistency(Index horizon)
     };
   for (auto i = Index{}; i < horizon; ++i) {
     const auto idx = NY * i;
-    fn(acadoVariables.y[idx + IDY_HEADING]);
+    fn(m_solver->variables.y[idx + IDY_HEADING]);
+  }
+  fn(m_solver->variables.yN[IDY_HEADING]);
+  // Unwrapping moves references by multiples of 2 pi, anything below is round-off
+  if (err > AcadoReal{1.0}) {
+    m_solver->is_prepared = false;
   }
-  fn(acadoVariables.yN[IDY_HEADING]);
   // Semi arbitrary number--maybe make it a config parameter?
   constexpr auto PI = AcadoReal{3.14159};
   return err > PI;
@@ -241,10 +244,11 @@ bool MpcController::ensure_reference_consistency(Index horizon)
 ////////////////////////////////////////////////////////////////////////////////
 void MpcController::set_terminal_reference(const Point & pt) noexcept
 {
-  acadoVariables.yN[IDYN_X] = static_cast<AcadoReal>(pt.x);
-  acadoVariables.yN[IDYN_Y] = static_cast<AcadoReal>(pt.y);
-  acadoVariables.yN[IDYN_VEL_LONG] = static_cast<AcadoReal>(pt.longitudinal_velocity_mps);
-  acadoVariables.yN[IDYN_HEADING] = static_cast<AcadoReal>(motion_common::to_angle(pt.heading));
+  m_solver->variables.yN[IDYN_X] = static_cast<AcadoReal>(pt.x);
+  m_solver->variables.yN[IDYN_Y] = static_cast<AcadoReal>(pt.y);
+  m_solver->variables.yN[IDYN_VEL_LONG] = static_cast<AcadoReal>(pt.longitudinal_velocity_mps);
+  m_solver->variables.yN[IDYN_HEADING] =
+    static_cast<AcadoReal>(motion_common::to_angle(pt.heading));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -276,6 +280,8 @@ const Trajectory & MpcController::handle_new_trajectory(const Trajectory & traje
     set_terminal_reference(traj.points[t_max]);
   }
   m_last_reference_index = {};
+  m_solver->is_prepared = false;
+  m_is_solved = false;
 
   return traj;
 }
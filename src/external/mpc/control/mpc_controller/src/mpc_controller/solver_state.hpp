@@ -0,0 +1,146 @@
+// Copyright 2020 Christopher Ho
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef MPC_CONTROLLER__SOLVER_STATE_HPP_
+#define MPC_CONTROLLER__SOLVER_STATE_HPP_
+
+// Treat as a system header since we don't want to touch that autogenerated stuff..
+#include <acado_common.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "mpc_controller/solver_timings.hpp"
+#include "mpc_controller/visibility_control.hpp"
+
+namespace motion
+{
+namespace control
+{
+namespace mpc_controller
+{
+
+/// Variables and workspace of the autogenerated solver which belong to one controller
+struct SolverState
+{
+  ACADOvariables variables;
+  ACADOworkspace workspace;
+  /// Whether the preparation step already ran for the current variables, so that the feedback
+  /// step can follow directly. Anything which changes the problem apart from x0 resets it
+  bool is_prepared{false};
+  /// Variables before prepare_next() shifted them to the predicted reference point, to undo the
+  /// shift if the state turns out to be at an earlier one. Only read before the next solve, so
+  /// SolverThread does not copy them
+  ACADOvariables unshifted_variables;
+};
+
+/// Points the autogenerated solver on the calling thread to the state of one controller. The
+/// generated code accesses its variables and workspace through thread-local pointers, see the
+/// PER_INSTANCE_STATE option of ament_acado_generate(), so nothing is copied and the scopes of
+/// different threads are independent. The solver functions may only be called while such a scope
+/// exists. The previously used state is restored on destruction.
+class MPC_CONTROLLER_LOCAL SolverScope
+{
+public:
+  explicit SolverScope(SolverState & state) noexcept;
+  ~SolverScope();
+  SolverScope(const SolverScope &) = delete;
+  SolverScope(SolverScope &&) = delete;
+  SolverScope & operator=(const SolverScope &) = delete;
+  SolverScope & operator=(SolverScope &&) = delete;
+
+private:
+  ACADOvariables * m_previous_variables;
+  ACADOworkspace * m_previous_workspace;
+};  // class SolverScope
+
+/// Run the preparation step on the state and record its duration
+/// \throw std::runtime_error If the step fails
+MPC_CONTROLLER_LOCAL void run_preparation(SolverState & state, TimingHistogram & timing);
+
+/// Durations of the solver steps of one solve
+struct MPC_CONTROLLER_LOCAL SolveDurations
+{
+  bool did_prepare;
+  std::chrono::nanoseconds preparation;
+  std::chrono::nanoseconds feedback;
+};  // struct SolveDurations
+
+/// Solve the problem: run the preparation step unless the state is prepared, then the feedback
+/// step
+/// \throw std::runtime_error If a step fails
+MPC_CONTROLLER_LOCAL SolveDurations run_solver(SolverState & state);
+
+/// Add the durations of a solve to the timings
+MPC_CONTROLLER_LOCAL void record_durations(
+  const SolveDurations & durations,
+  SolverTimings & timings);
+
+/// A thread which solves copies of the solver state of one controller, so that the controller can
+/// give up waiting for the solution at a deadline. A solve which misses its deadline still runs to
+/// completion, but its result is discarded. The copy and the hand-over to the thread are part of
+/// the recorded feedback duration, so that it covers the whole wait for the solution
+class MPC_CONTROLLER_LOCAL SolverThread
+{
+public:
+  SolverThread();
+  /// Waits for a running solve to finish
+  ~SolverThread();
+  SolverThread(const SolverThread &) = delete;
+  SolverThread(SolverThread &&) = delete;
+  SolverThread & operator=(const SolverThread &) = delete;
+  SolverThread & operator=(SolverThread &&) = delete;
+
+  /// Solve a copy of the state on the thread and wait for the solution until the deadline. The
+  /// wait includes a solve of an earlier call which missed its deadline and is still running.
+  /// \param[inout] state Swapped with the solved copy if the solve finished in time, otherwise
+  /// unchanged
+  /// \param[in] deadline Time after which the solution is not waited for anymore
+  /// \param[inout] timings Gets the durations of all solves which finished since the last call
+  /// and the missed deadlines
+  /// \return True if the state was solved before the deadline
+  /// \throw std::runtime_error If a solver step failed
+  bool solve(
+    std::unique_ptr<SolverState> & state,
+    std::chrono::steady_clock::time_point deadline,
+    SolverTimings & timings);
+
+private:
+  enum class Status
+  {
+    IDLE,
+    PENDING,
+    RUNNING,
+    DONE
+  };  // enum class Status
+
+  void run();
+
+  std::unique_ptr<SolverState> m_state;
+  Status m_status;
+  bool m_stop;
+  SolveDurations m_durations;
+  std::chrono::steady_clock::time_point m_submit_time;
+  std::exception_ptr m_error;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::thread m_thread;
+};  // class SolverThread
+}  // namespace mpc_controller
+}  // namespace control
+}  // namespace motion
+#endif  // MPC_CONTROLLER__SOLVER_STATE_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2020 Christopher Ho
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mpc_controller/solver_timings.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace motion
+{
+namespace control
+{
+namespace mpc_controller
+{
+TimingHistogram::TimingHistogram(
+  const std::chrono::nanoseconds bin_width,
+  const std::size_t num_bins)
+: m_bin_width{bin_width},
+  m_bins(num_bins, std::uint64_t{}),
+  m_count{},
+  m_max{std::chrono::nanoseconds::zero()}
+{
+  if (bin_width <= decltype(bin_width)::zero()) {
+    throw std::domain_error{"Histogram bin width must be positive"};
+  }
+  if (0U == num_bins) {
+    throw std::domain_error{"Histogram must have at least one bin"};
+  }
+}
+
+void TimingHistogram::add(const std::chrono::nanoseconds duration) noexcept
+{
+  const auto last = m_bins.size() - 1U;
+  const auto idx = (duration.count() < 0) ? std::size_t{} :
+    std::min(static_cast<std::size_t>(duration / m_bin_width), last);
+  ++m_bins[idx];
+  ++m_count;
+  m_max = std::max(m_max, duration);
+}
+
+void TimingHistogram::clear() noexcept
+{
+  std::fill(m_bins.begin(), m_bins.end(), std::uint64_t{});
+  m_count = {};
+  m_max = std::chrono::nanoseconds::zero();
+}
+
+const std::vector<std::uint64_t> & TimingHistogram::bins() const noexcept
+{
+  return m_bins;
+}
+std::chrono::nanoseconds TimingHistogram::bin_width() const noexcept
+{
+  return m_bin_width;
+}
+std::uint64_t TimingHistogram::count() const noexcept
+{
+  return m_count;
+}
+std::chrono::nanoseconds TimingHistogram::max() const noexcept
+{
+  return m_max;
+}
+
+std::chrono::nanoseconds TimingHistogram::percentile(const Real fraction) const noexcept
+{
+  const auto clamped = std::min(std::max(fraction, Real{}), Real{1.0F});
+  const auto target =
+    static_cast<std::uint64_t>(std::ceil(clamped * static_cast<Real>(m_count)));
+  std::uint64_t sum{};
+  for (std::size_t idx = {}; idx < m_bins.size(); ++idx) {
+    sum += m_bins[idx];
+    if ((sum >= target) && (sum > 0U)) {
+      return std::min(m_max, m_bin_width * static_cast<std::int64_t>(idx + 1U));
+    }
+  }
+  return m_max;
+}
+}  // namespace mpc_controller
+}  // namespace control
+}  // namespace motion
@@ -16,6 +16,9 @@
 #include <motion_testing/motion_testing.hpp>
 #include <time_utils/time_utils.hpp>
 
+#include <cmath>
+#include <memory>
+#include <thread>
 #include <vector>
 
 using motion::control::controller_common::ControlReference;
@@ -27,6 +30,7 @@ using motion::control::mpc_controller::LimitsConfig;
 using motion::control::mpc_controller::OptimizationConfig;
 using motion::control::mpc_controller::VehicleConfig;
 using motion::control::mpc_controller::Interpolation;
+using motion::control::mpc_controller::SolverMode;
 using motion::control::mpc_controller::MpcController;
 using motion::motion_testing::make_state;
 using motion::motion_testing::constant_velocity_trajectory;
@@ -449,3 +453,176 @@ TEST_F(sanity_checks, back_to_back)
     controller_.debug_print(std::cout);
   }
 }
+
+// Controllers with different weights give the same commands when they run concurrently as when
+// each of them runs alone, i.e. they do not share solver state
+TEST_F(sanity_checks_base, concurrent_controllers)
+{
+  const auto dt = std::chrono::milliseconds(100LL);
+  const auto traj = constant_velocity_trajectory(0.0F, 0.0F, 0.0F, 10.0F, dt);
+  constexpr auto num_steps = 20U;
+  const std::vector<Real> pose_weights{1.0F, 10.0F, 100.0F};
+  const auto make_controller = [this](Real pose_weight) {
+      const auto & nominal = opt_cfg_.nominal();
+      const StateWeight weight{pose_weight, nominal.heading(), nominal.longitudinal_velocity(),
+        nominal.lateral_velocity(), nominal.yaw_rate(), nominal.acceleration(), nominal.jerk(),
+        nominal.steer_angle(), nominal.steer_angle_rate()};
+      return std::make_unique<MpcController>(Config{
+        limits_cfg_,
+        vehicle_cfg_,
+        behavior_cfg_,
+        OptimizationConfig{weight, opt_cfg_.terminal()},
+        std::chrono::milliseconds(5LL),  // sample_period_tolerance
+        std::chrono::milliseconds(100LL),  // control_lookahead_duration
+        Interpolation::YES});
+    };
+  // Track the trajectory from a lateral offset, so that the commands depend on the weights
+  const auto run = [&traj](MpcController & controller) {
+      std::vector<MpcController::Command> commands;
+      controller.set_trajectory(traj);
+      for (auto idx = 0U; idx < num_steps; ++idx) {
+        const auto & pt = traj.points[idx];
+        const auto state = make_state(pt.x, pt.y - 1.0F, 0.0F, pt.longitudinal_velocity_mps,
+            0.0F, 0.0F, from_message(traj.header.stamp) + from_message(pt.time_from_start));
+        commands.push_back(controller.compute_command(state));
+      }
+      return commands;
+    };
+
+  std::vector<std::vector<MpcController::Command>> expected_commands;
+  for (const auto weight : pose_weights) {
+    const auto controller = make_controller(weight);
+    expected_commands.push_back(run(*controller));
+  }
+
+  std::vector<std::unique_ptr<MpcController>> controllers;
+  for (const auto weight : pose_weights) {
+    controllers.push_back(make_controller(weight));
+  }
+  std::vector<std::vector<MpcController::Command>> commands{controllers.size()};
+  std::vector<std::thread> threads;
+  for (auto idx = 0U; idx < controllers.size(); ++idx) {
+    threads.emplace_back([&run, &controllers, &commands, idx] {
+        commands[idx] = run(*controllers[idx]);
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  for (auto idx = 0U; idx < controllers.size(); ++idx) {
+    ASSERT_EQ(commands[idx].size(), expected_commands[idx].size());
+    for (auto step = 0U; step < commands[idx].size(); ++step) {
+      EXPECT_EQ(commands[idx][step].long_accel_mps2,
+        expected_commands[idx][step].long_accel_mps2) << idx << ", " << step;
+      EXPECT_EQ(commands[idx][step].front_wheel_angle_rad,
+        expected_commands[idx][step].front_wheel_angle_rad) << idx << ", " << step;
+    }
+    EXPECT_TRUE(std::isfinite(controllers[idx]->get_objective_value()));
+  }
+  // The weights matter, otherwise the controllers could share state unnoticed
+  EXPECT_NE(expected_commands.front().front().front_wheel_angle_rad,
+    expected_commands.back().front().front_wheel_angle_rad);
+}
+
+// Real-time iteration: preparing the next cycle ahead of time leaves only the feedback step in the
+// command computation and still follows the trajectory
+TEST_F(sanity_checks_base, real_time_iteration)
+{
+  const auto dt = std::chrono::milliseconds(100LL);
+  const auto traj = constant_velocity_trajectory(0.0F, 0.0F, 0.0F, 10.0F, dt);
+  constexpr auto num_steps = 50U;
+  const auto make_controller = [this](SolverMode mode) {
+      return std::make_unique<MpcController>(Config{
+        limits_cfg_,
+        vehicle_cfg_,
+        behavior_cfg_,
+        opt_cfg_,
+        std::chrono::milliseconds(5LL),  // sample_period_tolerance
+        std::chrono::milliseconds(100LL),  // control_lookahead_duration
+        Interpolation::YES,
+        mode});
+    };
+  const auto full = make_controller(SolverMode::FULL);
+  const auto rti = make_controller(SolverMode::REAL_TIME_ITERATION);
+  full->set_trajectory(traj);
+  rti->set_trajectory(traj);
+  for (auto idx = 0U; idx < num_steps; ++idx) {
+    const auto & pt = traj.points[idx];
+    const auto state = make_state(pt.x, pt.y, 0.0F, pt.longitudinal_velocity_mps, 0.0F, 0.0F,
+        from_message(traj.header.stamp) + from_message(pt.time_from_start));
+    const auto full_cmd = full->compute_command(state);
+    full->prepare_next();
+    const auto rti_cmd = rti->compute_command(state);
+    rti->prepare_next();
+    constexpr auto TOL = 1.0E-2F;
+    EXPECT_NEAR(rti_cmd.long_accel_mps2, full_cmd.long_accel_mps2, TOL) << idx;
+    EXPECT_NEAR(rti_cmd.front_wheel_angle_rad, full_cmd.front_wheel_angle_rad, TOL) << idx;
+  }
+  // Every solve prepares in the command computation in full mode. In real-time iteration mode,
+  // only the first one does, the others were prepared by the prepare_next() call before them
+  const auto & full_timings = full->get_solver_timings();
+  EXPECT_EQ(full_timings.feedback.count(), num_steps);
+  EXPECT_EQ(full_timings.preparation.count(), num_steps);
+  const auto & rti_timings = rti->get_solver_timings();
+  EXPECT_EQ(rti_timings.feedback.count(), num_steps);
+  EXPECT_EQ(rti_timings.preparation.count(), num_steps + 1U);
+  EXPECT_EQ(rti_timings.deadline_misses, 0U);
+  EXPECT_LE(rti_timings.feedback.percentile(0.5F), rti_timings.feedback.percentile(0.99F));
+  EXPECT_LE(rti_timings.feedback.percentile(0.99F), rti_timings.feedback.max());
+  rti->reset_solver_timings();
+  EXPECT_EQ(rti->get_solver_timings().feedback.count(), 0U);
+}
+
+// When the solver misses its deadline, the command comes from the previous solution
+TEST_F(sanity_checks_base, solver_deadline)
+{
+  const auto dt = std::chrono::milliseconds(100LL);
+  const auto traj = constant_velocity_trajectory(0.0F, 0.0F, 0.0F, 10.0F, dt);
+  const auto make_config = [this](std::chrono::nanoseconds deadline) {
+      return Config{
+        limits_cfg_,
+        vehicle_cfg_,
+        behavior_cfg_,
+        opt_cfg_,
+        std::chrono::milliseconds(5LL),  // sample_period_tolerance
+        std::chrono::milliseconds(100LL),  // control_lookahead_duration
+        Interpolation::YES,
+        SolverMode::FULL,
+        deadline};
+    };
+  // Track from a lateral offset so that the commands change between steps
+  const auto make_state_at = [&traj](std::size_t idx) {
+      const auto & pt = traj.points[idx];
+      return make_state(pt.x, pt.y - 1.0F, 0.0F, pt.longitudinal_velocity_mps, 0.0F, 0.0F,
+               from_message(traj.header.stamp) + from_message(pt.time_from_start));
+    };
+  MpcController unbounded{make_config(std::chrono::nanoseconds::zero())};
+  MpcController generous{make_config(std::chrono::seconds(10LL))};
+  unbounded.set_trajectory(traj);
+  generous.set_trajectory(traj);
+  constexpr auto num_steps = 10U;
+  for (auto idx = 0U; idx < num_steps; ++idx) {
+    const auto state = make_state_at(idx);
+    const auto expected = unbounded.compute_command(state);
+    const auto cmd = generous.compute_command(state);
+    EXPECT_EQ(cmd.long_accel_mps2, expected.long_accel_mps2) << idx;
+    EXPECT_EQ(cmd.front_wheel_angle_rad, expected.front_wheel_angle_rad) << idx;
+  }
+  EXPECT_EQ(generous.get_solver_timings().deadline_misses, 0U);
+  EXPECT_EQ(generous.get_solver_timings().feedback.count(), num_steps);
+
+  // A deadline which can't be met: the plan computed so far is reused, shifted to the state
+  generous.set_config(make_config(std::chrono::nanoseconds(1LL)));
+  const auto plan = generous.get_computed_trajectory();
+  const auto state = make_state_at(num_steps);
+  const auto cmd = generous.compute_command(state);
+  EXPECT_TRUE(std::isfinite(cmd.long_accel_mps2));
+  EXPECT_TRUE(std::isfinite(cmd.front_wheel_angle_rad));
+  EXPECT_EQ(generous.get_solver_timings().deadline_misses, 1U);
+  const auto & shifted = generous.get_computed_trajectory();
+  for (auto idx = 1U; idx + 1U < shifted.points.size(); ++idx) {
+    EXPECT_FLOAT_EQ(shifted.points[idx].heading_rate_rps, plan.points[idx + 1U].heading_rate_rps);
+    EXPECT_FLOAT_EQ(shifted.points[idx].acceleration_mps2, plan.points[idx + 1U].acceleration_mps2);
+  }
+}
@@ -135,6 +135,14 @@ MpcControllerNode::MpcControllerNode(const std::string & name, const std::string
   const auto control_lookahead_ms =
     std::chrono::milliseconds(declare_parameter("controller.control_lookahead_ms").get<int64_t>());
 
+  using mpc_controller::SolverMode;
+  auto solver_mode = SolverMode::FULL;
+  if (declare_parameter("controller.solver.real_time_iteration", false)) {
+    solver_mode = SolverMode::REAL_TIME_ITERATION;
+  }
+  const auto solver_deadline_ms =
+    std::chrono::milliseconds(declare_parameter("controller.solver.deadline_ms", int64_t{0}));
+
   auto controller = std::make_unique<mpc_controller::MpcController>(mpc_controller::Config{
           limits,
           vehicle_param,
@@ -142,7 +150,9 @@ MpcControllerNode::MpcControllerNode(const std::string & name, const std::string
           weights,
           sample_tolerance_ms,
           control_lookahead_ms,
-          interpolation});
+          interpolation,
+          solver_mode,
+          solver_deadline_ms});
   // I argue this is ok for the following reasons:
   // The parent class, ControllerBaseNode, has unique ownership of the controller, and the timer
   // only has a non-owning pointer. This is fine because the timer can never go out of scope before
@@ -0,0 +1,128 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef LOCALIZATION_NODES__LATEST_WINS_QUEUE_HPP_
+#define LOCALIZATION_NODES__LATEST_WINS_QUEUE_HPP_
+
+#include <common/types.hpp>
+#include <experimental/optional>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace autoware
+{
+namespace localization
+{
+namespace localization_nodes
+{
+using autoware::common::types::bool8_t;
+
+/// Bounded queue between two threads which never blocks the producer: if the queue is full, the
+/// oldest element is dropped to make room for the new one. Consumers always get the oldest
+/// element still in the queue, so a capacity of 1 hands over only the latest element.
+/// \tparam T Element type.
+template<typename T>
+class LatestWinsQueue
+{
+public:
+  /// Constructor
+  /// \param capacity Maximum number of elements in the queue.
+  /// \throw std::domain_error If the capacity is zero.
+  explicit LatestWinsQueue(std::size_t capacity)
+  : m_capacity{capacity}
+  {
+    if (capacity == 0U) {
+      throw std::domain_error("LatestWinsQueue: capacity must be positive");
+    }
+  }
+
+  /// Add an element to the queue, dropping the oldest element if the queue is full. Elements
+  /// pushed after the queue was closed are discarded.
+  /// \param value Element to add.
+  /// \return True if an element was dropped to make room.
+  bool8_t push(T value)
+  {
+    bool8_t dropped{false};
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (m_closed) {
+        return false;
+      }
+      if (m_queue.size() >= m_capacity) {
+        m_queue.pop_front();
+        dropped = true;
+      }
+      m_queue.push_back(std::move(value));
+    }
+    m_condition.notify_one();
+    return dropped;
+  }
+
+  /// Wait for an element and remove it from the queue.
+  /// \return The oldest element in the queue, or nullopt once the queue is closed.
+  std::experimental::optional<T> pop()
+  {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_condition.wait(lock, [this] {return m_closed || !m_queue.empty();});
+    if (m_closed) {
+      return std::experimental::nullopt;
+    }
+    std::experimental::optional<T> value{std::move(m_queue.front())};
+    m_queue.pop_front();
+    return value;
+  }
+
+  /// Discard all elements and wake up all waiting consumers. Later pushes are discarded and pops
+  /// return immediately.
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_closed = true;
+      m_queue.clear();
+    }
+    m_condition.notify_all();
+  }
+
+  /// Get the number of elements in the queue.
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_queue.size();
+  }
+
+  /// Get the maximum number of elements in the queue.
+  std::size_t capacity() const noexcept
+  {
+    return m_capacity;
+  }
+
+private:
+  std::size_t m_capacity;
+  std::deque<T> m_queue;
+  bool8_t m_closed{false};
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition;
+};
+}  // namespace localization_nodes
+}  // namespace localization
+}  // namespace autoware
+
+#endif  // LOCALIZATION_NODES__LATEST_WINS_QUEUE_HPP_
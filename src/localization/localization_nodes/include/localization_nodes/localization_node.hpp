@@ -25,10 +25,17 @@
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <time_utils/time_utils.hpp>
 #include <helper_functions/message_adapters.hpp>
+#include <localization_nodes/latest_wins_queue.hpp>
 #include <localization_nodes/visibility_control.hpp>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace autoware
 {
@@ -53,6 +60,34 @@ enum class LocalizerPublishMode
   NO_PUBLISH_TF
 };
 
+/// Configuration of the pipelined mode of the localizer node. In this mode, the initial guess
+/// lookup, the registration and the publishing of the result run on three threads, connected by
+/// LatestWinsQueue instances, instead of in the observation callback. A slow registration then
+/// does not block the executor and the latest observation is the next one to be registered.
+struct PipelineConfig
+{
+  /// Whether to run the pipeline. Otherwise, each observation is processed in its callback.
+  bool8_t enabled{false};
+  /// Capacity of each queue between the stages.
+  std::size_t queue_capacity{1U};
+  /// Observations older than this when their registration would start are skipped. Zero for no
+  /// limit.
+  std::chrono::nanoseconds max_observation_age{std::chrono::nanoseconds::zero()};
+};
+
+/// Observation counters of a localizer node.
+struct PipelineStatistics
+{
+  /// Number of received observations.
+  std::size_t num_received;
+  /// Number of observations and results dropped from a full queue of the pipeline.
+  std::size_t num_dropped;
+  /// Number of observations skipped because they exceeded the maximum age.
+  std::size_t num_late;
+  /// Number of published pose estimates.
+  std::size_t num_published;
+};
+
 /// Base relative localizer node that publishes map->base_link relative
 /// transform messages for a given observation source and map.
 /// \tparam ObservationMsgT Message type to register against a map.
@@ -81,13 +116,15 @@ public:
   /// \param pose_initializer Pose initializer.
   /// \param publish_tf Whether to publish to the `tf` topic. This can be used to publish transform
   /// messages when the relative localizer is the only source of localization.
+  /// \param pipeline_config Configuration of the pipelined mode, disabled by default.
   RelativeLocalizerNode(
     const std::string & node_name, const std::string & name_space,
     const TopicQoS & observation_sub_config,
     const TopicQoS & map_sub_config,
     const TopicQoS & pose_pub_config,
     const PoseInitializerT & pose_initializer,
-    LocalizerPublishMode publish_tf = LocalizerPublishMode::NO_PUBLISH_TF)
+    LocalizerPublishMode publish_tf = LocalizerPublishMode::NO_PUBLISH_TF,
+    const PipelineConfig & pipeline_config = PipelineConfig{})
   : Node(node_name, name_space),
     m_pose_initializer(pose_initializer),
     m_tf_listener(m_tf_buffer, std::shared_ptr<rclcpp::Node>(this, [](auto) {}), false),
@@ -101,6 +138,7 @@ public:
     if (publish_tf == LocalizerPublishMode::PUBLISH_TF) {
       m_tf_publisher = create_publisher<tf2_msgs::msg::TFMessage>("/tf", pose_pub_config.qos);
     }
+    start_pipeline(pipeline_config);
   }
 
   // Constructor for ros2 components
@@ -164,20 +202,52 @@ public:
     init();
   }
 
+  ~RelativeLocalizerNode() override
+  {
+    stop_pipeline();
+  }
+
   /// Get a const pointer of the output publisher. Can be used for matching against subscriptions.
   const typename rclcpp::Publisher<PoseWithCovarianceStamped>::ConstSharedPtr get_publisher()
   {
     return m_pose_publisher;
   }
 
+  /// Get the observation counters. They are updated in the inline mode as well.
+  PipelineStatistics pipeline_statistics() const noexcept
+  {
+    return PipelineStatistics{m_num_received.load(), m_num_dropped.load(), m_num_late.load(),
+      m_num_published.load()};
+  }
+
 protected:
   /// Set the localizer.
   /// \param localizer_ptr rvalue to the localizer to set.
   void set_localizer(LocalizerBasePtr && localizer_ptr)
   {
+    std::lock_guard<std::mutex> lock{m_localizer_mutex};
     m_localizer_ptr = std::forward<LocalizerBasePtr>(localizer_ptr);
   }
 
+  /// Stop the pipeline threads and discard the observations in the pipeline. Observations
+  /// received afterwards are ignored. Since the pipeline threads call the virtual methods of this
+  /// class, derived classes which override them must call this in their destructor. Does nothing
+  /// if the pipelined mode is disabled.
+  void stop_pipeline()
+  {
+    if (!m_pipeline) {
+      return;
+    }
+    m_pipeline->observations.close();
+    m_pipeline->guessed_observations.close();
+    m_pipeline->results.close();
+    for (auto & thread : m_pipeline->threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
   /// Handle the exceptions during registration.
   virtual void on_bad_registration(std::exception_ptr eptr) // NOLINT
   {
@@ -260,58 +330,233 @@ private:
     m_use_hack = true;  // On this constructor that is used by the executable,
     // we currently need the hack for the AVP demo MS2.
     ////////////////////////////////////////////////////
+
+    PipelineConfig pipeline_config;
+    pipeline_config.enabled = declare_parameter("pipeline.enabled", false);
+    const auto queue_capacity = declare_parameter("pipeline.queue_capacity", int64_t{1});
+    if (queue_capacity < 1) {
+      throw std::domain_error("RelativeLocalizerNode: pipeline.queue_capacity must be at least 1");
+    }
+    pipeline_config.queue_capacity = static_cast<std::size_t>(queue_capacity);
+    pipeline_config.max_observation_age = std::chrono::milliseconds{
+      declare_parameter("pipeline.max_observation_age_ms", int64_t{0})};
+    start_pipeline(pipeline_config);
+  }
+
+  /// An observation with its initial guess, passed from the first to the second pipeline stage.
+  struct GuessedObservation
+  {
+    typename ObservationMsgT::ConstSharedPtr msg_ptr;
+    TransformStamped guess;
+  };
+
+  /// A registration result, passed from the second to the third pipeline stage.
+  struct RegistrationResult
+  {
+    typename ObservationMsgT::ConstSharedPtr msg_ptr;
+    TransformStamped guess;
+    RegistrationSummary summary;
+    PoseWithCovarianceStamped pose;
+    std::string map_frame_id;
+  };
+
+  /// Queues and threads of the pipelined mode.
+  struct Pipeline
+  {
+    explicit Pipeline(std::size_t queue_capacity)
+    : observations{queue_capacity},
+      guessed_observations{queue_capacity},
+      results{queue_capacity} {}
+
+    LatestWinsQueue<typename ObservationMsgT::ConstSharedPtr> observations;
+    LatestWinsQueue<GuessedObservation> guessed_observations;
+    LatestWinsQueue<RegistrationResult> results;
+    std::vector<std::thread> threads;
+  };
+
+  /// Start the pipeline threads if the pipelined mode is enabled.
+  void start_pipeline(const PipelineConfig & config)
+  {
+    m_max_observation_age = config.max_observation_age;
+    if (!config.enabled) {
+      return;
+    }
+    if (config.queue_capacity < 1U) {
+      throw std::domain_error("RelativeLocalizerNode: pipeline queue capacity must be at least 1");
+    }
+    m_pipeline = std::make_unique<Pipeline>(config.queue_capacity);
+    m_pipeline->threads.emplace_back([this] {guess_stage();});
+    m_pipeline->threads.emplace_back([this] {registration_stage();});
+    m_pipeline->threads.emplace_back([this] {publishing_stage();});
   }
 
   /// Process the registration summary. By default does nothing.
   virtual void handle_registration_summary(const RegistrationSummary &) {}
 
-  /// Callback that registers each received observation and outputs the result.
+  /// Called after a map message was successfully set to the localizer. By default does nothing.
+  virtual void on_map_set() {}
+
+  /// Callback that registers each received observation and outputs the result, or passes it to
+  /// the pipeline in the pipelined mode.
   /// \param msg_ptr Pointer to the observation message.
   void observation_callback(typename ObservationMsgT::ConstSharedPtr msg_ptr)
   {
     check_localizer();
-    if (m_localizer_ptr->map_valid()) {
+    ++m_num_received;
+    if (m_pipeline) {
+      count_drop(m_pipeline->observations.push(msg_ptr));
+      return;
+    }
+    if (localizer_map_valid()) {
       try {
-        const auto observation_time = ::time_utils::from_message(get_stamp(*msg_ptr));
-        const auto & observation_frame = get_frame_id(*msg_ptr);
-        const auto & map_frame = m_localizer_ptr->map_frame_id();
-
-        ////////////////////////////////////////////////////////
-        // TODO(yunus.caliskan): remove in #425
-        if (m_use_hack && !m_hack_initialized) {
-          check_and_execute_hack(get_stamp(*msg_ptr));
-        }
-        /////////////////////////////////////////////////////////
-
-        const auto initial_guess =
-          m_pose_initializer.guess(m_tf_buffer, observation_time, map_frame, observation_frame);
+        const auto map_frame = localizer_map_frame_id();
+        const auto initial_guess = lookup_guess(*msg_ptr, map_frame);
+        PoseWithCovarianceStamped pose_out;
+        const auto summary = register_observation(*msg_ptr, initial_guess, pose_out);
+        publish_result(summary, pose_out, initial_guess, map_frame);
+      } catch (...) {
+        on_registration_failure(*msg_ptr, std::current_exception());
+      }
+    } else {
+      on_observation_with_invalid_map(msg_ptr);
+    }
+  }
 
-        m_hack_initialized = true;  // Only after a successful lookup, disable the hack.
+  /// First pipeline stage: look up the initial guesses of the observations.
+  void guess_stage()
+  {
+    while (const auto msg_ptr = m_pipeline->observations.pop()) {
+      if (!localizer_map_valid()) {
+        on_observation_with_invalid_map(*msg_ptr);
+        continue;
+      }
+      try {
+        GuessedObservation observation{*msg_ptr, lookup_guess(**msg_ptr, localizer_map_frame_id())};
+        count_drop(m_pipeline->guessed_observations.push(std::move(observation)));
+      } catch (...) {
+        on_registration_failure(**msg_ptr, std::current_exception());
+      }
+    }
+  }
 
-        PoseWithCovarianceStamped pose_out;
-        const auto summary =
-          m_localizer_ptr->register_measurement(*msg_ptr, initial_guess, pose_out);
-        if (validate_output(summary, pose_out, initial_guess)) {
-          m_pose_publisher->publish(pose_out);
-          // This is to be used when no state estimator or alternative source of
-          // localization is available.
-          if (m_tf_publisher) {
-            publish_tf(pose_out);
-          }
-          handle_registration_summary(summary);
-        } else {
-          on_invalid_output(pose_out);
+  /// Second pipeline stage: register the observations which are not too old.
+  void registration_stage()
+  {
+    while (const auto observation = m_pipeline->guessed_observations.pop()) {
+      const auto & msg = *observation->msg_ptr;
+      try {
+        if (is_late(msg)) {
+          ++m_num_late;
+          RCLCPP_DEBUG(get_logger(), "Skipping an observation older than the maximum age.");
+          continue;
         }
+        PoseWithCovarianceStamped pose_out;
+        const auto summary = register_observation(msg, observation->guess, pose_out);
+        count_drop(m_pipeline->results.push(RegistrationResult{observation->msg_ptr,
+          observation->guess, summary, pose_out, localizer_map_frame_id()}));
       } catch (...) {
-        // TODO(mitsudome-r) remove this hack in #458
-        if (m_tf_publisher) {
-          republish_tf(get_stamp(*msg_ptr));
-        }
-        on_bad_registration(std::current_exception());
+        on_registration_failure(msg, std::current_exception());
+      }
+    }
+  }
+
+  /// Third pipeline stage: validate and publish the registration results.
+  void publishing_stage()
+  {
+    while (auto result = m_pipeline->results.pop()) {
+      try {
+        publish_result(result->summary, result->pose, result->guess, result->map_frame_id);
+      } catch (...) {
+        on_registration_failure(*result->msg_ptr, std::current_exception());
       }
+    }
+  }
+
+  /// Get the initial guess of an observation.
+  TransformStamped lookup_guess(const ObservationMsgT & msg, const std::string & map_frame)
+  {
+    ////////////////////////////////////////////////////////
+    // TODO(yunus.caliskan): remove in #425
+    if (m_use_hack && !m_hack_initialized) {
+      check_and_execute_hack(get_stamp(msg));
+    }
+    /////////////////////////////////////////////////////////
+
+    const auto initial_guess = m_pose_initializer.guess(m_tf_buffer,
+        ::time_utils::from_message(get_stamp(msg)), map_frame, get_frame_id(msg));
+
+    m_hack_initialized = true;  // Only after a successful lookup, disable the hack.
+    return initial_guess;
+  }
+
+  /// Register an observation with the localizer.
+  RegistrationSummary register_observation(
+    const ObservationMsgT & msg, const TransformStamped & initial_guess,
+    PoseWithCovarianceStamped & pose_out)
+  {
+    std::lock_guard<std::mutex> lock{m_localizer_mutex};
+    return m_localizer_ptr->register_measurement(msg, initial_guess, pose_out);
+  }
+
+  /// Validate a registration result and publish it.
+  void publish_result(
+    const RegistrationSummary & summary, PoseWithCovarianceStamped & pose_out,
+    const TransformStamped & initial_guess, const std::string & map_frame)
+  {
+    if (validate_output(summary, pose_out, initial_guess)) {
+      m_pose_publisher->publish(pose_out);
+      // This is to be used when no state estimator or alternative source of
+      // localization is available.
+      if (m_tf_publisher) {
+        publish_tf(pose_out, map_frame);
+      }
+      ++m_num_published;
+      handle_registration_summary(summary);
     } else {
-      on_observation_with_invalid_map(msg_ptr);
+      on_invalid_output(pose_out);
+    }
+  }
+
+  /// Handle an exception thrown while processing an observation.
+  void on_registration_failure(const ObservationMsgT & msg, std::exception_ptr eptr)
+  {
+    // TODO(mitsudome-r) remove this hack in #458
+    if (m_tf_publisher) {
+      try {
+        republish_tf(get_stamp(msg));
+      } catch (...) {
+        on_exception(std::current_exception(), "republish_tf");
+      }
     }
+    on_bad_registration(eptr);
+  }
+
+  /// Check if an observation exceeds the maximum age.
+  bool8_t is_late(const ObservationMsgT & msg)
+  {
+    return (m_max_observation_age > std::chrono::nanoseconds::zero()) &&
+           ((now() - rclcpp::Time{get_stamp(msg)}).nanoseconds() > m_max_observation_age.count());
+  }
+
+  /// Count an element dropped from a pipeline queue.
+  void count_drop(bool8_t dropped)
+  {
+    if (dropped) {
+      ++m_num_dropped;
+      RCLCPP_DEBUG(get_logger(), "Dropped an observation from a full pipeline queue.");
+    }
+  }
+
+  bool8_t localizer_map_valid()
+  {
+    std::lock_guard<std::mutex> lock{m_localizer_mutex};
+    return m_localizer_ptr->map_valid();
+  }
+
+  std::string localizer_map_frame_id()
+  {
+    std::lock_guard<std::mutex> lock{m_localizer_mutex};
+    return m_localizer_ptr->map_frame_id();
   }
 
   /// Callback that updates the map.
@@ -320,14 +565,16 @@ private:
   {
     check_localizer();
     try {
+      std::lock_guard<std::mutex> lock{m_localizer_mutex};
       m_localizer_ptr->set_map(*msg_ptr);
+      on_map_set();
     } catch (...) {
       on_bad_map(std::current_exception());
     }
   }
 
   /// Publish the pose message as a transform.
-  void publish_tf(const PoseWithCovarianceStamped & pose_msg)
+  void publish_tf(const PoseWithCovarianceStamped & pose_msg, const std::string & map_frame)
   {
     const auto & pose = pose_msg.pose.pose;
     tf2::Quaternion rotation{pose.orientation.x, pose.orientation.y, pose.orientation.z,
@@ -353,7 +600,7 @@ private:
     tf2_msgs::msg::TFMessage tf_message;
     geometry_msgs::msg::TransformStamped tf_stamped;
     tf_stamped.header.stamp = pose_msg.header.stamp;
-    tf_stamped.header.frame_id = m_localizer_ptr->map_frame_id();
+    tf_stamped.header.frame_id = map_frame;
     tf_stamped.child_frame_id = "odom";
     const auto & tf_trans = map_odom_tf.getOrigin();
     const auto & tf_rot = map_odom_tf.getRotation();
@@ -369,7 +616,7 @@ private:
   /// Publish the pose message as a transform.
   void republish_tf(builtin_interfaces::msg::Time stamp)
   {
-    auto map_odom_tf = m_tf_buffer.lookupTransform(m_localizer_ptr->map_frame_id(), "odom",
+    auto map_odom_tf = m_tf_buffer.lookupTransform(localizer_map_frame_id(), "odom",
         tf2::TimePointZero);
     map_odom_tf.header.stamp = stamp;
     tf2_msgs::msg::TFMessage tf_message;
@@ -408,6 +655,14 @@ private:
   bool m_use_hack{false};
   bool m_hack_initialized{false};
   geometry_msgs::msg::TransformStamped m_init_hack_transform;
+  // Serializes the access to the localizer between the map callback and the pipeline threads.
+  std::mutex m_localizer_mutex;
+  std::chrono::nanoseconds m_max_observation_age{std::chrono::nanoseconds::zero()};
+  std::atomic<std::size_t> m_num_received{0U};
+  std::atomic<std::size_t> m_num_dropped{0U};
+  std::atomic<std::size_t> m_num_late{0U};
+  std::atomic<std::size_t> m_num_published{0U};
+  std::unique_ptr<Pipeline> m_pipeline;
 };
 }  // namespace localization_nodes
 }  // namespace localization
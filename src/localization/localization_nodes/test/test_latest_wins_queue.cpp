@@ -0,0 +1,50 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <gtest/gtest.h>
+#include <localization_nodes/latest_wins_queue.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using autoware::localization::localization_nodes::LatestWinsQueue;
+
+TEST(LatestWinsQueueTest, drops_oldest) {
+  EXPECT_THROW(LatestWinsQueue<int>{0U}, std::domain_error);
+
+  LatestWinsQueue<int> queue{2U};
+  EXPECT_FALSE(queue.push(1));
+  EXPECT_FALSE(queue.push(2));
+  EXPECT_TRUE(queue.push(3));
+  EXPECT_EQ(queue.size(), 2U);
+  EXPECT_EQ(*queue.pop(), 2);
+  EXPECT_EQ(*queue.pop(), 3);
+  EXPECT_EQ(queue.size(), 0U);
+}
+
+TEST(LatestWinsQueueTest, close) {
+  LatestWinsQueue<int> queue{1U};
+  // A consumer waiting on the empty queue is woken up by closing it.
+  std::thread consumer{[&queue] {EXPECT_FALSE(queue.pop());}};
+  std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  queue.close();
+  consumer.join();
+
+  EXPECT_FALSE(queue.push(1));
+  EXPECT_EQ(queue.size(), 0U);
+  EXPECT_FALSE(queue.pop());
+}
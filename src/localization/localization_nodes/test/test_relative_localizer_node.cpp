@@ -247,6 +247,148 @@ TEST_F(RelativeLocalizationNodeTest, exception_handling) {
   EXPECT_TRUE(localizer_node->register_exception());
 }
 
+// Observations arrive faster than they are registered: the pipeline keeps up with the input by
+// dropping the older observations and the latest observation is always registered.
+TEST_F(RelativeLocalizationNodeTest, pipelined) {
+  constexpr auto initial_id = -1;
+  constexpr auto valid_map_id = 0;
+  constexpr auto num_observations = 10;
+  const auto max_poll_iters = 100U;
+  auto last_pose_id = initial_id;
+
+  auto map_tracker_ptr = std::make_shared<TestMap>();
+  set_msg_id(*map_tracker_ptr, initial_id);
+  // The observations are not tracked as they are registered on another thread.
+  auto localizer_ptr = std::make_unique<MockRelativeLocalizer>(nullptr, map_tracker_ptr,
+      std::chrono::milliseconds{100});
+  PipelineConfig pipeline_config;
+  pipeline_config.enabled = true;
+  auto localizer_node = std::make_shared<TestRelativeLocalizerNode>("TestNode", "",
+      TopicQoS{m_observation_topic, rclcpp::SystemDefaultsQoS{}},
+      TopicQoS{m_map_topic, rclcpp::SystemDefaultsQoS{}},
+      TopicQoS{m_out_topic, rclcpp::SystemDefaultsQoS{}},
+      MockInitializer{},
+      autoware::localization::localization_nodes::LocalizerPublishMode::NO_PUBLISH_TF,
+      pipeline_config);
+  localizer_node->set_localizer_(std::move(localizer_ptr));
+
+  const auto observation_pub = localizer_node->create_publisher<TestObservation>(
+    m_observation_topic, m_history_depth);
+  const auto map_pub = localizer_node->create_publisher<TestMap>(m_map_topic, m_history_depth);
+  const auto pose_out_sub = localizer_node->create_subscription<PoseWithCovarianceStamped>(
+    m_out_topic,
+    rclcpp::QoS{rclcpp::KeepLast{m_history_depth}},
+    [&last_pose_id](PoseWithCovarianceStamped::ConstSharedPtr pose) {
+      // Results are published in the order of the observations.
+      EXPECT_GT(get_msg_id(*pose), last_pose_id);
+      last_pose_id = static_cast<int32_t>(get_msg_id(*pose));
+    });
+  wait_for_matched(map_pub);
+  wait_for_matched(observation_pub);
+  wait_for_matched(localizer_node->get_publisher());
+
+  set_msg_id(m_map_msg, valid_map_id);
+  map_pub->publish(m_map_msg);
+  for (auto iter = 0U; (iter < max_poll_iters) && (get_msg_id(*map_tracker_ptr) != valid_map_id);
+    ++iter)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    rclcpp::spin_some(localizer_node);
+  }
+  ASSERT_EQ(get_msg_id(*map_tracker_ptr), valid_map_id);
+
+  for (auto i = 0; i < num_observations; ++i) {
+    set_msg_id(m_observation_msg, i);
+    observation_pub->publish(m_observation_msg);
+    rclcpp::spin_some(localizer_node);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  for (auto iter = 0U; (iter < max_poll_iters) && (last_pose_id != num_observations - 1);
+    ++iter)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    rclcpp::spin_some(localizer_node);
+  }
+
+  EXPECT_EQ(last_pose_id, num_observations - 1);
+  const auto statistics = localizer_node->pipeline_statistics();
+  EXPECT_EQ(statistics.num_received, static_cast<std::size_t>(num_observations));
+  EXPECT_GT(statistics.num_dropped, 0U);
+  EXPECT_EQ(statistics.num_late, 0U);
+  EXPECT_EQ(statistics.num_published + statistics.num_dropped,
+    static_cast<std::size_t>(num_observations));
+  EXPECT_FALSE(localizer_node->register_exception());
+}
+
+TEST_F(RelativeLocalizationNodeTest, pipeline_zero_capacity) {
+  PipelineConfig pipeline_config;
+  pipeline_config.enabled = true;
+  pipeline_config.queue_capacity = 0U;
+  EXPECT_THROW(std::make_shared<TestRelativeLocalizerNode>("TestNode", "",
+    TopicQoS{m_observation_topic, rclcpp::SystemDefaultsQoS{}},
+    TopicQoS{m_map_topic, rclcpp::SystemDefaultsQoS{}},
+    TopicQoS{m_out_topic, rclcpp::SystemDefaultsQoS{}},
+    MockInitializer{},
+    autoware::localization::localization_nodes::LocalizerPublishMode::NO_PUBLISH_TF,
+    pipeline_config), std::domain_error);
+}
+
+TEST_F(RelativeLocalizationNodeTest, pipelined_late_observations) {
+  constexpr auto valid_map_id = 0;
+  constexpr auto num_observations = 3U;
+  const auto max_poll_iters = 100U;
+
+  auto map_tracker_ptr = std::make_shared<TestMap>();
+  auto localizer_ptr = std::make_unique<MockRelativeLocalizer>(nullptr, map_tracker_ptr);
+  PipelineConfig pipeline_config;
+  pipeline_config.enabled = true;
+  pipeline_config.queue_capacity = num_observations;
+  pipeline_config.max_observation_age = std::chrono::milliseconds{1};
+  auto localizer_node = std::make_shared<TestRelativeLocalizerNode>("TestNode", "",
+      TopicQoS{m_observation_topic, rclcpp::SystemDefaultsQoS{}},
+      TopicQoS{m_map_topic, rclcpp::SystemDefaultsQoS{}},
+      TopicQoS{m_out_topic, rclcpp::SystemDefaultsQoS{}},
+      MockInitializer{},
+      autoware::localization::localization_nodes::LocalizerPublishMode::NO_PUBLISH_TF,
+      pipeline_config);
+  localizer_node->set_localizer_(std::move(localizer_ptr));
+
+  const auto observation_pub = localizer_node->create_publisher<TestObservation>(
+    m_observation_topic, m_history_depth);
+  const auto map_pub = localizer_node->create_publisher<TestMap>(m_map_topic, m_history_depth);
+  wait_for_matched(map_pub);
+  wait_for_matched(observation_pub);
+
+  set_msg_id(m_map_msg, valid_map_id);
+  map_pub->publish(m_map_msg);
+  for (auto iter = 0U; (iter < max_poll_iters) && (get_msg_id(*map_tracker_ptr) != valid_map_id);
+    ++iter)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    rclcpp::spin_some(localizer_node);
+  }
+  ASSERT_EQ(get_msg_id(*map_tracker_ptr), valid_map_id);
+
+  // The observations are stamped with the epoch, which is older than the maximum age.
+  for (auto i = 0U; i < num_observations; ++i) {
+    set_msg_id(m_observation_msg, i);
+    observation_pub->publish(m_observation_msg);
+  }
+  for (auto iter = 0U;
+    (iter < max_poll_iters) && (localizer_node->pipeline_statistics().num_late < num_observations);
+    ++iter)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    rclcpp::spin_some(localizer_node);
+  }
+
+  const auto statistics = localizer_node->pipeline_statistics();
+  EXPECT_EQ(statistics.num_received, num_observations);
+  EXPECT_EQ(statistics.num_late, num_observations);
+  EXPECT_EQ(statistics.num_dropped, 0U);
+  EXPECT_EQ(statistics.num_published, 0U);
+}
+
 //////////////////////////////////////////////////////////////////////// Implementations
 
 void TestRelativeLocalizerNode::set_localizer_(std::unique_ptr<MockRelativeLocalizer> && localizer)
@@ -254,10 +396,17 @@ void TestRelativeLocalizerNode::set_localizer_(std::unique_ptr<MockRelativeLocal
   set_localizer(std::forward<std::unique_ptr<MockRelativeLocalizer>>(localizer));
 }
 
+TestRelativeLocalizerNode::~TestRelativeLocalizerNode()
+{
+  stop_pipeline();
+}
+
 MockRelativeLocalizer::MockRelativeLocalizer(
   std::shared_ptr<TestMap> obs_ptr,
-  std::shared_ptr<TestObservation> map_ptr)
-: m_map_tracking_ptr{map_ptr}, m_observation_tracking_ptr{obs_ptr} {}
+  std::shared_ptr<TestObservation> map_ptr,
+  std::chrono::milliseconds registration_delay)
+: m_map_tracking_ptr{map_ptr}, m_observation_tracking_ptr{obs_ptr},
+  m_registration_delay{registration_delay} {}
 
 MockRelativeLocalizer::RegistrationSummary MockRelativeLocalizer::register_measurement_impl(
   const TestObservation & msg, const Transform & transform_initial,
@@ -266,6 +415,7 @@ MockRelativeLocalizer::RegistrationSummary MockRelativeLocalizer::register_measu
   if (get_msg_id(msg) == TEST_ERROR_ID) {
     throw TestRegistrationException{};
   }
+  std::this_thread::sleep_for(m_registration_delay);
   // The resulting frame id should contain observation's frame + initial guess' frame ID
   // So the result should be: obs_frame + obs_frame + map_frame
   pose_out.header.frame_id = msg.header.frame_id + transform_initial.header.frame_id;
@@ -29,6 +29,7 @@ using autoware::common::types::bool8_t;
 using autoware::localization::localization_common::RelativeLocalizerBase;
 using autoware::localization::localization_nodes::RelativeLocalizerNode;
 using autoware::localization::localization_nodes::TopicQoS;
+using autoware::localization::localization_nodes::PipelineConfig;
 
 using MsgWithHeader = geometry_msgs::msg::TransformStamped;
 using TestObservation = MsgWithHeader;
@@ -44,7 +45,8 @@ class MockRelativeLocalizer : public RelativeLocalizerBase<TestObservation, Test
 public:
   MockRelativeLocalizer(
     std::shared_ptr<TestMap> obs_ptr,
-    std::shared_ptr<TestObservation> map_ptr);
+    std::shared_ptr<TestObservation> map_ptr,
+    std::chrono::milliseconds registration_delay = std::chrono::milliseconds::zero());
   // constructor when the tracking is not needed.
   MockRelativeLocalizer() = default;
 
@@ -64,6 +66,7 @@ private:
   TestMap m_map;
   std::shared_ptr<TestMap> m_map_tracking_ptr;
   std::shared_ptr<TestObservation> m_observation_tracking_ptr;
+  std::chrono::milliseconds m_registration_delay{std::chrono::milliseconds::zero()};
 };
 
 class MockInitializer
@@ -79,6 +82,7 @@ class TestRelativeLocalizerNode : public RelativeLocalizerNode<TestObservation,
 {
 public:
   using RelativeLocalizerNode::RelativeLocalizerNode;
+  ~TestRelativeLocalizerNode() override;
 
   // Expose protected method for convenience
   void set_localizer_(std::unique_ptr<MockRelativeLocalizer> && localizer);
@@ -0,0 +1,203 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef NDT__FROZEN_NDT_MAP_HPP_
+#define NDT__FROZEN_NDT_MAP_HPP_
+
+#include <ndt/ndt_common.hpp>
+#include <ndt/ndt_map.hpp>
+#include <ndt/visibility_control.hpp>
+#include <voxel_grid/config.hpp>
+#include <Eigen/Core>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/types.hpp"
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt
+{
+/// Read-only ndt map built once from a StaticNDTMap. Only the usable voxels are kept. Their
+/// centroids and the 6 unique elements of their inverse covariances are stored in separate,
+/// cache line aligned arrays, ordered by voxel index so that voxels which are close in space are
+/// close in memory. Lookups go through an open addressing table of voxel indices instead of an
+/// `std::unordered_map`, so a lookup touches a single contiguous slot in the common case.
+///
+/// The map has the lookup interface of NDTMapBase and can be used in place of StaticNDTMap in
+/// P2DNDTObjective. It does not support insertion: it has to be rebuilt when the map changes.
+class NDT_PUBLIC FrozenNDTMap
+{
+public:
+  using Point = Eigen::Vector3d;
+  using Cov = Eigen::Matrix3d;
+  using Config = autoware::perception::filters::voxel_grid::Config;
+  using TimePoint = std::chrono::system_clock::time_point;
+
+  /// Copy of a voxel's centroid and inverse covariance, with the interface of VoxelView.
+  class NDT_PUBLIC VoxelView
+  {
+public:
+    /// Constructor
+    /// \param centroid Centroid of the voxel.
+    /// \param inv_covariance Inverse covariance of the voxel.
+    VoxelView(const Point & centroid, const Cov & inv_covariance);
+
+    /// Returns the mean of the points in the cell.
+    /// \return centroid of the cell
+    const Point & centroid() const noexcept;
+
+    /// Returns the inverse covariance of the points in the voxel.
+    /// \return inverse covariance of the cell
+    const Cov & inverse_covariance() const noexcept;
+
+    /// Check if the cell can be used in ndt matching. Always true, as the frozen map only holds
+    /// usable voxels.
+    /// \return True
+    bool8_t usable() const noexcept;
+
+private:
+    Point m_centroid;
+    Cov m_inv_covariance;
+  };
+
+  using VoxelViewVector = std::vector<VoxelView>;
+
+  /// Value returned by find() if there is no voxel at the queried location.
+  static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+  /// Constructor. Copies all usable voxels, the grid configuration, the stamp and the frame id
+  /// of the given map. The frozen map does not refer to the given map after construction.
+  /// \param map Map to freeze.
+  explicit FrozenNDTMap(const StaticNDTMap & map);
+
+  // Maps should be moved rather than being copied. Copying would also break the alignment of
+  // the voxel arrays.
+  FrozenNDTMap(const FrozenNDTMap &) = delete;
+  FrozenNDTMap & operator=(const FrozenNDTMap &) = delete;
+
+  FrozenNDTMap(FrozenNDTMap &&) = default;
+  FrozenNDTMap & operator=(FrozenNDTMap &&) = default;
+
+  /// Lookup the cell at location.
+  /// \param x x coordinate
+  /// \param y y coordinate
+  /// \param z z coordinate
+  /// \return A vector containing the cell at given coordinates, or an empty vector if there is
+  /// no usable cell there.
+  const VoxelViewVector & cell(float32_t x, float32_t y, float32_t z) const;
+
+  /// Lookup the cell at location.
+  /// \param pt point to lookup
+  /// \return A vector containing the cell at given coordinates, or an empty vector if there is
+  /// no usable cell there.
+  const VoxelViewVector & cell(const Point & pt) const;
+
+  /// Lookup the cell at location, writing the result into the given vector. Can be called from
+  /// multiple threads as long as each thread uses its own output vector.
+  /// \param pt point to lookup
+  /// \param[out] cells Vector which is cleared and then filled with the cell at the given point,
+  /// if there is a usable one.
+  void cell(const Point & pt, VoxelViewVector & cells) const;
+
+  /// Find the position of the voxel containing a point in the voxel arrays.
+  /// \param pt point to lookup
+  /// \return Position of the voxel, or NOT_FOUND if there is no usable voxel at the point.
+  std::size_t find(const Point & pt) const;
+
+  /// Get the voxel at a position in the voxel arrays.
+  /// \param pos Position of the voxel, less than size().
+  /// \return View of the voxel.
+  VoxelView voxel(const std::size_t pos) const;
+
+  /// Get the voxel index of the voxel at a position in the voxel arrays.
+  /// \param pos Position of the voxel, less than size().
+  /// \return Voxel index as computed by the grid config.
+  uint64_t voxel_index(const std::size_t pos) const;
+
+  /// Get size of the map
+  /// \return Number of voxels in the map, all of which are usable.
+  std::size_t size() const noexcept;
+
+  /// Get size of the cell.
+  /// \return A point representing the dimensions of the cell.
+  const autoware::perception::filters::voxel_grid::PointXYZ & cell_size() const noexcept;
+
+  /// Get the voxel grid config of the map.
+  /// \return Config of the grid, equal to the one of the map this map was built from.
+  const Config & config() const noexcept;
+
+  /// Get map's time stamp.
+  /// \return map's time stamp.
+  TimePoint stamp() const noexcept;
+
+  /// Get map's frame id.
+  /// \return Frame id of the map.
+  const std::string & frame_id() const noexcept;
+
+private:
+  /// The arrays of per voxel values, each one starts at a multiple of the array stride.
+  enum class Array : std::size_t
+  {
+    CENTROID_X = 0U,
+    CENTROID_Y,
+    CENTROID_Z,
+    ICOV_XX,
+    ICOV_XY,
+    ICOV_XZ,
+    ICOV_YY,
+    ICOV_YZ,
+    ICOV_ZZ,
+    NUM_ARRAYS
+  };
+
+  /// An entry in the open addressing table, mapping a voxel index to its position
+  struct Slot
+  {
+    uint64_t index;
+    std::size_t pos;
+  };
+
+  /// Get the start of an array
+  const Real * array(const Array arr) const noexcept;
+  /// Get the start of an array
+  Real * array(const Array arr) noexcept;
+
+  Config m_config;
+  std::size_t m_size;
+  // Number of elements between the starts of consecutive arrays, a multiple of the cache line
+  std::size_t m_stride;
+  // Offset of the first cache line aligned element of m_data
+  std::size_t m_offset;
+  std::vector<Real> m_data;
+  std::vector<uint64_t> m_indices;
+  std::size_t m_mask;
+  std::vector<Slot> m_table;
+  mutable VoxelViewVector m_output_vector;
+  TimePoint m_stamp;
+  std::string m_frame_id;
+};
+}  // namespace ndt
+}  // namespace localization
+}  // namespace autoware
+
+#endif  // NDT__FROZEN_NDT_MAP_HPP_
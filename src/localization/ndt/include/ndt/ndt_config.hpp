@@ -19,7 +19,17 @@
 
 #include <ndt/ndt_common.hpp>
 #include <voxel_grid/config.hpp>
+#include <helper_functions/worker_pool.hpp>
+#include <experimental/optional>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
 #include <utility>
+#include <vector>
+#include "common/types.hpp"
+
+using autoware::common::types::float32_t;
 
 namespace autoware
 {
@@ -37,22 +47,44 @@ public:
   /// Constructor
   /// \param map_config
   /// \param guess_time_tolerance
+  /// \param pyramid_scales See the other constructor.
+  /// \param scan_downsampling_config See the other constructor.
   NDTLocalizerConfigBase(
     MapConfig && map_config,
-    std::chrono::nanoseconds guess_time_tolerance)
+    std::chrono::nanoseconds guess_time_tolerance,
+    std::vector<uint32_t> pyramid_scales = {},
+    std::experimental::optional<MapConfig> scan_downsampling_config = std::experimental::nullopt)
   : m_map_config{std::forward<MapConfig>(map_config)},
-    m_guess_time_tol{guess_time_tolerance} {}
+    m_guess_time_tol{guess_time_tolerance},
+    m_pyramid_scales{std::move(pyramid_scales)},
+    m_scan_downsampling_config{std::move(scan_downsampling_config)}
+  {
+    validate_pyramid_scales();
+  }
 
   /// Constructor
   /// \param map_config Map configuration
   /// \param guess_time_tolerance Time difference tolerance between the initial guess timestamp
   /// and the timestamp of the scan.
+  /// \param pyramid_scales Voxel sizes of the coarse maps of a multi-resolution registration, as
+  /// multiples of the voxel size of the map, from the coarsest to the finest. A scan is first
+  /// registered against the coarsest map and each result is the guess for the next finer map.
+  /// Empty for a registration against the map only.
+  /// \param scan_downsampling_config Voxel grid in the frame of the scans to downsample them with
+  /// before the registration, see ScanDownsampler. No downsampling if not set.
+  /// \throw std::domain_error If a scale is not larger than 1 or the scales are not decreasing.
   NDTLocalizerConfigBase(
     const MapConfig & map_config,
-    std::chrono::nanoseconds guess_time_tolerance)
+    std::chrono::nanoseconds guess_time_tolerance,
+    std::vector<uint32_t> pyramid_scales = {},
+    std::experimental::optional<MapConfig> scan_downsampling_config = std::experimental::nullopt)
   : m_map_config{map_config},
-    m_guess_time_tol{guess_time_tolerance}
-  {}
+    m_guess_time_tol{guess_time_tolerance},
+    m_pyramid_scales{std::move(pyramid_scales)},
+    m_scan_downsampling_config{std::move(scan_downsampling_config)}
+  {
+    validate_pyramid_scales();
+  }
 
   // TODO(yunus.caliskan): Consider delegating map config get/set to the implementation
   // when map types with different configuration needs are added.
@@ -70,9 +102,67 @@ public:
     return m_guess_time_tol;
   }
 
+  /// Get the voxel size multiples of the coarse maps.
+  /// \return Scales from the coarsest to the finest map, empty if there are no coarse maps.
+  const std::vector<uint32_t> & pyramid_scales() const noexcept
+  {
+    return m_pyramid_scales;
+  }
+
+  /// Get the voxel grid config to downsample scans with.
+  /// \return Config, or nullopt if scans are registered as they are.
+  const std::experimental::optional<MapConfig> & scan_downsampling_config() const noexcept
+  {
+    return m_scan_downsampling_config;
+  }
+
+  /// Get the config of a coarse map. Its voxels are `scale` times as large as the voxels of the
+  /// map in each direction and their boundaries are boundaries of the map's voxels. The grid is
+  /// extended beyond the map's max. point to a multiple of the coarse voxel size.
+  /// \param scale Voxel size multiple.
+  /// \return Coarse map config.
+  MapConfig coarse_map_config(uint32_t scale) const
+  {
+    const auto & min_point = m_map_config.get_min_point();
+    const auto & max_point = m_map_config.get_max_point();
+    const auto & voxel_size = m_map_config.get_voxel_size();
+    const auto scale_f = static_cast<float32_t>(scale);
+    const auto coarse_max = [scale_f](float32_t min, float32_t max, float32_t size) {
+        const auto coarse_size = size * scale_f;
+        return min + std::ceil((max - min) / coarse_size) * coarse_size;
+      };
+    perception::filters::voxel_grid::PointXYZ coarse_max_point;
+    coarse_max_point.x = coarse_max(min_point.x, max_point.x, voxel_size.x);
+    coarse_max_point.y = coarse_max(min_point.y, max_point.y, voxel_size.y);
+    coarse_max_point.z = coarse_max(min_point.z, max_point.z, voxel_size.z);
+    perception::filters::voxel_grid::PointXYZ coarse_voxel_size;
+    coarse_voxel_size.x = voxel_size.x * scale_f;
+    coarse_voxel_size.y = voxel_size.y * scale_f;
+    coarse_voxel_size.z = voxel_size.z * scale_f;
+    // Maps are mostly surfaces, so the number of voxels shrinks with the square of the scale.
+    const auto capacity = std::max<uint64_t>(
+      m_map_config.get_capacity() / (static_cast<uint64_t>(scale) * scale), 1U);
+    return MapConfig{min_point, coarse_max_point, coarse_voxel_size, capacity};
+  }
+
 private:
+  void validate_pyramid_scales() const
+  {
+    for (std::size_t idx = 0U; idx < m_pyramid_scales.size(); ++idx) {
+      if (m_pyramid_scales[idx] <= 1U) {
+        throw std::domain_error("NDTLocalizerConfigBase: pyramid scales must be larger than 1");
+      }
+      if ((idx > 0U) && (m_pyramid_scales[idx] >= m_pyramid_scales[idx - 1U])) {
+        throw std::domain_error("NDTLocalizerConfigBase: pyramid scales must be ordered from the "
+                "coarsest to the finest map");
+      }
+    }
+  }
+
   MapConfig m_map_config;
   std::chrono::nanoseconds m_guess_time_tol;
+  std::vector<uint32_t> m_pyramid_scales;
+  std::experimental::optional<MapConfig> m_scan_downsampling_config;
 };
 
 
@@ -80,18 +170,46 @@ private:
 class NDT_PUBLIC P2DNDTOptimizationConfig
 {
 public:
+  using WorkerPool = common::helper_functions::WorkerPool;
+
   /// Constructor
   /// \param outlier_ratio Outlier ratio to be used in the gaussian distribution variation used
   /// in (eq. 6.7) [Magnusson 2009]
-  explicit P2DNDTOptimizationConfig(Real outlier_ratio)
-  : m_outlier_ratio{outlier_ratio} {}
+  /// \param num_threads Number of threads used to evaluate the objective, including the calling
+  /// thread. For more than one thread, a worker pool is started here and shared by all copies
+  /// of this config. Hence objectives built from the same config must not be evaluated
+  /// concurrently.
+  /// \throw std::domain_error If num_threads is zero.
+  explicit P2DNDTOptimizationConfig(Real outlier_ratio, std::size_t num_threads = 1U)
+  : m_outlier_ratio{outlier_ratio}
+  {
+    if (num_threads == 0U) {
+      throw std::domain_error("P2DNDTOptimizationConfig: Need at least one thread");
+    }
+    if (num_threads > 1U) {
+      m_worker_pool = std::make_shared<WorkerPool>(num_threads);
+    }
+  }
 
   /// Get outlier ratio.
   /// \return outlier ratio.
   Real outlier_ratio() const noexcept {return m_outlier_ratio;}
 
+  /// Get the number of threads used to evaluate the objective.
+  /// \return number of threads, including the calling thread.
+  std::size_t num_threads() const noexcept
+  {
+    return m_worker_pool ? m_worker_pool->size() : 1U;
+  }
+
+  /// Get the worker pool used to evaluate the objective.
+  /// \return Worker pool, or a null pointer if the objective is evaluated by the calling thread
+  /// alone.
+  const std::shared_ptr<WorkerPool> & worker_pool() const noexcept {return m_worker_pool;}
+
 private:
   Real m_outlier_ratio;
+  std::shared_ptr<WorkerPool> m_worker_pool;
 };
 
 
@@ -107,12 +225,28 @@ public:
   /// points expected in a single lidar scan.
   /// \param guess_time_tolerance Time difference tolerance between the initial guess timestamp
   /// and the timestamp of the scan.
+  /// \param num_threads Number of threads used to evaluate the optimization problem, including
+  /// the calling thread.
+  /// \param pyramid_scales Voxel size multiples of the coarse maps, see NDTLocalizerConfigBase.
+  /// \param scan_downsampling_config Voxel grid to downsample the scans with, see
+  /// NDTLocalizerConfigBase.
+  /// \throw std::domain_error If num_threads is zero or the pyramid scales are invalid.
   P2DNDTLocalizerConfig(
     const MapConfig & map_config,
     const uint32_t scan_capacity,
-    std::chrono::nanoseconds guess_time_tolerance)
-  : NDTLocalizerConfigBase{map_config, guess_time_tolerance},
-    m_scan_capacity(scan_capacity) {}
+    std::chrono::nanoseconds guess_time_tolerance,
+    const std::size_t num_threads = 1U,
+    std::vector<uint32_t> pyramid_scales = {},
+    std::experimental::optional<MapConfig> scan_downsampling_config = std::experimental::nullopt)
+  : NDTLocalizerConfigBase{map_config, guess_time_tolerance, std::move(pyramid_scales),
+      std::move(scan_downsampling_config)},
+    m_scan_capacity(scan_capacity),
+    m_num_threads(num_threads)
+  {
+    if (num_threads == 0U) {
+      throw std::domain_error("P2DNDTLocalizerConfig: Need at least one thread");
+    }
+  }
 
   /// Get scan capacity.
   /// \return scan capacity.
@@ -121,8 +255,16 @@ public:
     return m_scan_capacity;
   }
 
+  /// Get the number of threads used to evaluate the optimization problem.
+  /// \return number of threads, including the calling thread.
+  std::size_t num_threads() const noexcept
+  {
+    return m_num_threads;
+  }
+
 private:
   uint32_t m_scan_capacity;
+  std::size_t m_num_threads;
 };
 
 }  // namespace ndt
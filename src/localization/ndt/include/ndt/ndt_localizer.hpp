@@ -22,9 +22,13 @@
 #include <geometry_msgs/msg/transform.hpp>
 #include <ndt/ndt_common.hpp>
 #include <ndt/ndt_optimization_problem.hpp>
+#include <ndt/scan_downsampler.hpp>
 #include <optimization/optimizer_options.hpp>
+#include <chrono>
+#include <memory>
 #include <utility>
 #include <string>
+#include <vector>
 
 namespace autoware
 {
@@ -34,12 +38,73 @@ namespace ndt
 {
 using CloudT = sensor_msgs::msg::PointCloud2;
 
+/// Result of the optimization against one map of a multi-resolution registration.
+struct NDT_PUBLIC RegistrationLevelSummary
+{
+  common::optimization::OptimizationSummary optimization_summary;
+  /// Voxel size of the map as a multiple of the localizer's map voxel size, 1 for the map itself
+  uint32_t scale;
+  /// Time spent on this level
+  std::chrono::nanoseconds duration;
+  /// Map voxel lookups of the scan points on this level and the share served from the cache
+  CellCacheStatistics cell_cache_statistics;
+};
+
+/// Registration summary of the ndt localizers. The optimization summary is the one of the
+/// registration against the map itself, the level summaries add the results of all maps from
+/// the coarsest to the finest one.
+class NDT_PUBLIC NDTRegistrationSummary
+  : public localization_common::OptimizedRegistrationSummary
+{
+public:
+  using LevelSummaries = std::vector<RegistrationLevelSummary>;
+
+  /// Constructor
+  /// \param level_summaries Summaries of all levels, the last one being the summary of the
+  /// registration against the map itself.
+  explicit NDTRegistrationSummary(const LevelSummaries & level_summaries)
+  : OptimizedRegistrationSummary{level_summaries.back().optimization_summary},
+    m_level_summaries{level_summaries} {}
+
+  /// Get the summaries of all levels, from the coarsest to the finest.
+  const LevelSummaries & level_summaries() const noexcept
+  {
+    return m_level_summaries;
+  }
+
+  /// Get the number of iterations on all levels.
+  uint64_t total_iterations() const noexcept
+  {
+    uint64_t iterations = 0U;
+    for (const auto & level : m_level_summaries) {
+      iterations += level.optimization_summary.number_of_iterations_made();
+    }
+    return iterations;
+  }
+
+  /// Get the map voxel cache statistics of all levels.
+  CellCacheStatistics cell_cache_statistics() const noexcept
+  {
+    CellCacheStatistics statistics;
+    for (const auto & level : m_level_summaries) {
+      statistics += level.cell_cache_statistics;
+    }
+    return statistics;
+  }
+
+private:
+  LevelSummaries m_level_summaries;
+};
+
 /// Base class for NDT based localizers. Implementations must implement the validation logic.
 /// \tparam ScanT Type of ndt scan.
 /// \tparam MapT Type of ndt map.
 /// \tparam NDTOptimizationProblemT Type of ndt optimization problem.
 /// \tparam OptimizerT Type of optimizer.
 /// \tparam ConfigT Type of localization configuration.
+/// If the config has pyramid scales, the localizer also holds coarser versions of the map, which
+/// only MapT = StaticNDTMap supports, and registers coarse-to-fine. If the config has a scan
+/// downsampling config, each scan is voxel grid filtered before the registration.
 template<
   typename ScanT,
   typename MapT,
@@ -47,7 +112,7 @@ template<
   typename OptimizationProblemConfigT,
   typename OptimizerT>
 class NDT_PUBLIC NDTLocalizerBase : public localization_common::RelativeLocalizerBase<CloudT,
-    CloudT, localization_common::OptimizedRegistrationSummary>
+    CloudT, NDTRegistrationSummary>
 {
 public:
   using Transform = geometry_msgs::msg::TransformStamped;
@@ -75,7 +140,18 @@ public:
     m_optimization_problem_config{optimization_problem_config},
     m_optimizer{optimizer},
     m_scan{std::forward<ScanT>(scan)},
-    m_map{std::forward<MapT>(map)} {}
+    m_map{std::forward<MapT>(map)}
+  {
+    for (const auto scale : m_config.pyramid_scales()) {
+      m_coarse_maps.emplace_back(m_config.coarse_map_config(scale));
+    }
+    // Only the coarse maps need the changes of the map
+    set_record_changes(m_map, !m_coarse_maps.empty());
+    if (m_config.scan_downsampling_config()) {
+      m_scan_downsampler =
+        std::make_unique<ScanDownsampler>(m_config.scan_downsampling_config().value());
+    }
+  }
 
   /// Register a measurement to the current map and return the transformation from map to the
   /// measurement.
@@ -86,7 +162,8 @@ public:
   /// \throws std::logic_error on measurements older than the map.
   /// \throws std::domain_error on pose estimates that are not within the configured duration
   /// range from the measurement.
-  /// \throws std::runtime_error on numerical errors in the optimizer.
+  /// \throws std::runtime_error on numerical errors in the optimizer while registering against
+  /// the map. Numerical errors on a coarse map only discard the result of that map.
   RegistrationSummary register_measurement_impl(
     const CloudT & msg,
     const Transform & transform_initial, PoseWithCovarianceStamped & pose_out) override
@@ -101,13 +178,52 @@ public:
     // Convert the ros transform/pose to eigen pose vector
     transform_adapters::transform_to_pose(transform_initial.transform, eig_pose_initial);
 
-    // Set the scan
+    // Set the scan. A scan that references the message must not outlive this call, the
+    // downsampled cloud is owned by the localizer though.
+    class ScanGuard
+    {
+public:
+      ScanGuard(ScanT & scan, const bool8_t references_msg)
+      : m_scan(scan), m_references_msg(references_msg) {}
+      ~ScanGuard()
+      {
+        if (m_references_msg) {
+          release_message(m_scan);
+        }
+      }
+
+private:
+      ScanT & m_scan;
+      const bool8_t m_references_msg;
+    };
+    const ScanGuard scan_guard{m_scan, !m_scan_downsampler};
     m_scan.clear();
-    m_scan.insert(msg);
+    m_scan.insert(m_scan_downsampler ? m_scan_downsampler->downsample(msg) : msg);
+
+    NDTRegistrationSummary::LevelSummaries level_summaries;
+    level_summaries.reserve(m_coarse_maps.size() + 1U);
+    // Coarse-to-fine: the result on each coarse map is the guess for the next finer one.
+    EigenPose<Real> eig_pose_guess = eig_pose_initial;
+    for (std::size_t level = 0U; level < m_coarse_maps.size(); ++level) {
+      const auto start = std::chrono::steady_clock::now();
+      NDTOptimizationProblemT coarse_problem(m_scan, m_coarse_maps[level],
+        m_optimization_problem_config);
+      const auto coarse_summary = m_optimizer.solve(coarse_problem, eig_pose_guess,
+          eig_pose_result);
+      if (coarse_summary.termination_type() != common::optimization::TerminationType::FAILURE) {
+        eig_pose_guess = eig_pose_result;
+      }
+      level_summaries.push_back({coarse_summary, m_config.pyramid_scales()[level],
+          std::chrono::steady_clock::now() - start,
+          coarse_problem.objective().cell_cache_statistics()});
+    }
 
     // Define and solve the problem.
+    const auto start = std::chrono::steady_clock::now();
     NDTOptimizationProblemT problem(m_scan, m_map, m_optimization_problem_config);
-    const auto opt_summary = m_optimizer.solve(problem, eig_pose_initial, eig_pose_result);
+    const auto opt_summary = m_optimizer.solve(problem, eig_pose_guess, eig_pose_result);
+    level_summaries.push_back({opt_summary, 1U, std::chrono::steady_clock::now() - start,
+        problem.objective().cell_cache_statistics()});
 
     if (opt_summary.termination_type() == common::optimization::TerminationType::FAILURE) {
       throw std::runtime_error("NDT localizer has likely encountered a numerical "
@@ -123,15 +239,16 @@ public:
 
     // Populate covariance information. It is implementation defined.
     set_covariance(problem, eig_pose_initial, eig_pose_result, pose_out);
-    return localization_common::OptimizedRegistrationSummary{opt_summary};
+    return NDTRegistrationSummary{level_summaries};
   }
 
-  /// Replace the map with a given message
+  /// Replace the map with a given message. Only the voxels that changed are touched, so that
+  /// the map can be refreshed without a latency spike in the registration.
   /// \param msg Message containing the map
   void set_map_impl(const CloudT & msg) override
   {
-    m_map.clear();
-    m_map.insert(msg);
+    m_map_update_summary = m_map.update(msg);
+    m_map_update_summary.coarse_maps_duration = update_coarse_maps();
   }
 
   /// Insert the given message to the existing map.
@@ -139,9 +256,11 @@ public:
   void insert_to_map_impl(const CloudT & msg) override
   {
     m_map.insert(msg);
+    (void) update_coarse_maps();
   }
 
-  /// Get the last used scan.
+  /// Get the last used scan. A scan that references the registered message, i.e.
+  /// P2DNDTScanView without scan downsampling, is empty after the registration.
   const ScanT & scan() const noexcept
   {
     return m_scan;
@@ -151,6 +270,17 @@ public:
   {
     return m_map;
   }
+  /// Get the coarse maps of a multi-resolution registration.
+  /// \return Maps from the coarsest to the finest, empty if there are no pyramid scales.
+  const std::vector<MapT> & coarse_maps() const noexcept
+  {
+    return m_coarse_maps;
+  }
+  /// Get the summary of the last map replacement.
+  const MapUpdateSummary & map_update_summary() const noexcept
+  {
+    return m_map_update_summary;
+  }
   /// Get the optimizer.
   const OptimizerT & optimizer() const noexcept
   {
@@ -236,11 +366,27 @@ protected:
   }
 
 private:
+  /// Carry the last change of the map over to the coarse maps. Only the coarse voxels into
+  /// which a changed voxel falls are merged again.
+  /// \return Time it took.
+  std::chrono::nanoseconds update_coarse_maps()
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (auto & coarse_map : m_coarse_maps) {
+      (void) update_merged(coarse_map, m_map);
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  }
+
   NDTLocalizerConfigBase m_config;
   OptimizationProblemConfigT m_optimization_problem_config;
   OptimizerT m_optimizer;
   ScanT m_scan;
   MapT m_map;
+  std::vector<MapT> m_coarse_maps;
+  std::unique_ptr<ScanDownsampler> m_scan_downsampler;
+  MapUpdateSummary m_map_update_summary;
 };
 
 /// P2D localizer implementation.
@@ -248,17 +394,18 @@ private:
 /// \tparam OptimizerT Optimizer type.
 /// \tparam OptimizerOptionsT Optimizer options type.
 /// \tparam MapT Type of map to be used. By default it is StaticNDTMap.
-template<typename OptimizerT, typename MapT = StaticNDTMap>
+/// \tparam ScanT Type of scan to be used. By default it is P2DNDTScan, P2DNDTScanView avoids
+/// copying the points of the registered messages.
+template<typename OptimizerT, typename MapT = StaticNDTMap, typename ScanT = P2DNDTScan>
 class NDT_PUBLIC P2DNDTLocalizer : public NDTLocalizerBase<
-    P2DNDTScan, MapT, P2DNDTOptimizationProblem<MapT>, P2DNDTOptimizationConfig, OptimizerT>
+    ScanT, MapT, P2DNDTOptimizationProblem<MapT, ScanT>, P2DNDTOptimizationConfig, OptimizerT>
 {
 public:
   using CloudT = sensor_msgs::msg::PointCloud2;
   using ParentT = NDTLocalizerBase<
-    P2DNDTScan, MapT, P2DNDTOptimizationProblem<MapT>, P2DNDTOptimizationConfig, OptimizerT>;
+    ScanT, MapT, P2DNDTOptimizationProblem<MapT, ScanT>, P2DNDTOptimizationConfig, OptimizerT>;
   using Transform = typename ParentT::Transform;
   using PoseWithCovarianceStamped = typename ParentT::PoseWithCovarianceStamped;
-  using ScanT = P2DNDTScan;
 
   explicit P2DNDTLocalizer(
     const P2DNDTLocalizerConfig & config,
@@ -266,14 +413,14 @@ public:
     const Real outlier_ratio)
   : ParentT{
       config,
-      P2DNDTOptimizationConfig{outlier_ratio},
+      P2DNDTOptimizationConfig{outlier_ratio, config.num_threads()},
       optimizer,
       ScanT{config.scan_capacity()},
       MapT{config.map_config()}} {}
 
 protected:
   void set_covariance(
-    const P2DNDTOptimizationProblem<MapT> &,
+    const P2DNDTOptimizationProblem<MapT, ScanT> &,
     const EigenPose<Real> &,
     const EigenPose<Real> &,
     PoseWithCovarianceStamped &) const override
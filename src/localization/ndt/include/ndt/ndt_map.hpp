@@ -22,6 +22,8 @@
 #include <ndt/ndt_voxel_view.hpp>
 #include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <time_utils/time_utils.hpp>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <limits>
 #include <unordered_map>
@@ -46,6 +48,20 @@ namespace ndt
 /// If the cloud is assessed to be invalid (i.e. due to invalid fields), then 0 is returned.
 uint32_t NDT_PUBLIC validate_pcl_map(const sensor_msgs::msg::PointCloud2 & msg);
 
+/// Summary of a map update: the number of voxels that were inserted, replaced, removed or left
+/// as they were, and the time it took to apply the update.
+struct NDT_PUBLIC MapUpdateSummary
+{
+  std::size_t num_inserted{0U};
+  std::size_t num_updated{0U};
+  std::size_t num_removed{0U};
+  std::size_t num_unchanged{0U};
+  std::chrono::nanoseconds duration{0};
+  /// Time it took to carry the update over to the coarse maps of a multi-resolution localizer,
+  /// zero if there are none.
+  std::chrono::nanoseconds coarse_maps_duration{0};
+};
+
 /////////////////////////////////////////////
 
 template<typename Derived, typename VoxelT>
@@ -90,15 +106,25 @@ public:
   /// \return A vector containing the cell at given coordinates. A vector is used to support
   /// near-neighbour cell queries in the future.
   const VoxelViewVector & cell(const Point & pt) const
+  {
+    cell(pt, m_output_vector);
+    return m_output_vector;
+  }
+
+  /// Lookup the cell at location, writing the result into the given vector instead of the
+  /// internal one. Unlike the other lookups, this one can be called from multiple threads
+  /// as long as each thread uses its own output vector.
+  /// \param pt point to lookup
+  /// \param[out] cells Vector which is cleared and then filled with the cells at the given point.
+  void cell(const Point & pt, VoxelViewVector & cells) const
   {
     // TODO(yunus.caliskan): revisit after multi-cell lookup support.
-    m_output_vector.clear();
+    cells.clear();
     const auto vx_it = m_map.find(m_config.index(pt));
     // Only return a voxel if it's occupied (i.e. has enough points to compute covariance.)
     if (vx_it != m_map.end() && vx_it->second.usable()) {
-      m_output_vector.emplace_back(vx_it->second);
+      cells.emplace_back(vx_it->second);
     }
-    return m_output_vector;
   }
 
   /// Insert a point cloud to the map.
@@ -110,6 +136,17 @@ public:
     this->impl().insert_(msg);
   }
 
+  /// Update the map to be equal to the map in a point cloud message, changing only the voxels
+  /// that differ. How the differences are found depends on the map type.
+  /// \param msg PointCloud2 message with the complete new map.
+  /// \return Summary of the update.
+  MapUpdateSummary update(const sensor_msgs::msg::PointCloud2 & msg)
+  {
+    m_stamp = ::time_utils::from_message(msg.header.stamp);
+    m_frame_id = msg.header.frame_id;
+    return this->impl().update_(msg);
+  }
+
   /// Get size of the map
   /// \return Number of voxels in the map. This number includes the voxels that do not have
   /// enough numbers to be used yet.
@@ -125,6 +162,13 @@ public:
     return m_config.get_voxel_size();
   }
 
+  /// Get the configuration of the underlying voxel grid.
+  /// \return Voxel grid config.
+  const Config & config() const noexcept
+  {
+    return m_config;
+  }
+
   /// \brief Returns an const iterator to the first element of the map
   /// \return Iterator
   typename Grid::const_iterator begin() const noexcept
@@ -162,12 +206,48 @@ public:
     return m_map.cend();
   }
 
+  /// Get the voxel with the given index.
+  /// \param idx Voxel index.
+  /// \return Iterator to the voxel, or end() if there is no voxel with this index.
+  typename Grid::const_iterator find(uint64_t idx) const
+  {
+    return m_map.find(idx);
+  }
+
   /// Clear all voxels in the map
   void clear() noexcept
   {
     m_map.clear();
   }
 
+  /// Remove the voxel with the given index, if there is one.
+  /// \param idx Voxel index.
+  /// \return Number of removed voxels.
+  std::size_t erase(uint64_t idx)
+  {
+    return m_map.erase(idx);
+  }
+
+  /// Remove all voxels whose index satisfies a predicate. Used to evict parts of a map, e.g. the
+  /// voxels of a map tile, without rebuilding the rest of it.
+  /// \tparam PredicateT Callable taking a voxel index (uint64_t) and returning bool8_t.
+  /// \param predicate Predicate deciding which voxels get removed.
+  /// \return Number of removed voxels.
+  template<typename PredicateT>
+  std::size_t erase_if(const PredicateT & predicate)
+  {
+    std::size_t num_removed = 0U;
+    for (auto it = m_map.begin(); it != m_map.end(); ) {
+      if (predicate(it->first)) {
+        it = m_map.erase(it);
+        ++num_removed;
+      } else {
+        ++it;
+      }
+    }
+    return num_removed;
+  }
+
   /// Get map's time stamp.
   /// \return map's time stamp.
   TimePoint stamp() const noexcept
@@ -254,6 +334,24 @@ public:
       (void) vx.try_stabilize();
     }
   }
+
+  /// Replace the map with the dense point cloud. Since the voxels are computed from the raw
+  /// points, they cannot be matched against the existing ones and the map is rebuilt.
+  /// \param msg PointCloud2 message with the dense point cloud of the complete new map.
+  /// \return Summary of the update. All previous voxels count as removed and all new ones as
+  /// inserted.
+  MapUpdateSummary update_(const sensor_msgs::msg::PointCloud2 & msg)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    MapUpdateSummary summary;
+    summary.num_removed = size();
+    clear();
+    insert_(msg);
+    summary.num_inserted = size();
+    summary.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+    return summary;
+  }
 };
 
 /// NDT map using StaticNDTVoxels. This class is to be used when the pointcloud
@@ -266,6 +364,14 @@ public:
   using NDTMapBase::NDTMapBase;
   using Voxel = StaticNDTVoxel;
 
+  /// A voxel that was taken out of or put into the map.
+  struct VoxelChange
+  {
+    uint64_t index;
+    Point centroid;
+  };
+  using VoxelChanges = std::vector<VoxelChange>;
+
   /// Insert point cloud message representing the map to the map representation instance.
   /// Map is assumed to have correct format (see `validate_pcl_map(...)`) and was generated
   /// by a dense map representation with identical configuration to this representation.
@@ -275,6 +381,263 @@ public:
   /// the grid's index will be a long value to avoid overflows, `cell_id` field should be an array
   /// of 2 unsigned integers. That is because there is no direct long support as a PointField.
   void insert_(const sensor_msgs::msg::PointCloud2 & msg)
+  {
+    m_removed_voxels.clear();
+    m_added_voxels.clear();
+    for_each_voxel(msg, [this](uint64_t voxel_idx, const Point & centroid,
+      const Eigen::Matrix3d & inv_covariance) {
+        const Voxel vx{centroid, inv_covariance};
+        const auto insert_res = emplace(voxel_idx, Voxel{centroid, inv_covariance});
+        if (!insert_res.second) {
+          // if a voxel already exist at this point, replace.
+          if (m_record_changes) {
+            m_removed_voxels.push_back({voxel_idx, insert_res.first->second.centroid()});
+          }
+          insert_res.first->second = vx;
+        }
+        if (m_record_changes) {
+          m_added_voxels.push_back({voxel_idx, centroid});
+        }
+      });
+  }
+
+  /// Make the map equal to the map in the point cloud message by applying only the differences:
+  /// voxels with a `cell_id` that is not in the map yet are inserted, voxels whose centroid or
+  /// inverse covariance changed are replaced and voxels that are not in the message are removed.
+  /// Unchanged voxels are left untouched. The message format and the cell ids are checked as in
+  /// insert(). Each `cell_id` is expected to occur at most once in the message.
+  /// \param msg PointCloud2 message with the complete new map.
+  /// \return Number of changed voxels and the time it took to apply the update.
+  MapUpdateSummary update_(const sensor_msgs::msg::PointCloud2 & msg)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    MapUpdateSummary summary;
+    m_update_indices.clear();
+    m_removed_voxels.clear();
+    m_added_voxels.clear();
+    for_each_voxel(msg, [this, &summary](uint64_t voxel_idx, const Point & centroid,
+      const Eigen::Matrix3d & inv_covariance) {
+        m_update_indices.push_back(voxel_idx);
+        const auto insert_res = emplace(voxel_idx, Voxel{centroid, inv_covariance});
+        if (insert_res.second) {
+          if (m_record_changes) {
+            m_added_voxels.push_back({voxel_idx, centroid});
+          }
+          ++summary.num_inserted;
+          return;
+        }
+        auto & vx = insert_res.first->second;
+        if (vx.usable() && (vx.centroid() == centroid) &&
+          (vx.inverse_covariance() == inv_covariance))
+        {
+          ++summary.num_unchanged;
+        } else {
+          if (m_record_changes) {
+            m_removed_voxels.push_back({voxel_idx, vx.centroid()});
+            m_added_voxels.push_back({voxel_idx, centroid});
+          }
+          vx = Voxel{centroid, inv_covariance};
+          ++summary.num_updated;
+        }
+      });
+
+    // Every voxel of the message is in the map now, any additional one has to go.
+    if (size() > m_update_indices.size()) {
+      std::sort(m_update_indices.begin(), m_update_indices.end());
+      const auto is_stale = [this](uint64_t voxel_idx) {
+          return !std::binary_search(m_update_indices.begin(), m_update_indices.end(),
+                   voxel_idx);
+        };
+      if (m_record_changes) {
+        for (const auto & vx_it : *this) {
+          if (is_stale(vx_it.first)) {
+            m_removed_voxels.push_back({vx_it.first, vx_it.second.centroid()});
+          }
+        }
+      }
+      summary.num_removed = erase_if(is_stale);
+    }
+    summary.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+    return summary;
+  }
+
+  /// Record the changes of each insert() or update() call in removed_voxels() and
+  /// added_voxels(). The lists hold an entry per changed voxel until the next call, so this is
+  /// off by default and only needed by coarser maps that are kept up to date with
+  /// update_merged(). Turning it off frees the lists.
+  /// \param record Whether to record the changes.
+  void set_record_changes(const bool8_t record)
+  {
+    m_record_changes = record;
+    if (!record) {
+      VoxelChanges{}.swap(m_removed_voxels);
+      VoxelChanges{}.swap(m_added_voxels);
+    }
+  }
+
+  /// Check whether the changes of each insert() or update() call are recorded.
+  bool8_t records_changes() const noexcept
+  {
+    return m_record_changes;
+  }
+
+  /// Get the voxels taken out of the map by the last insert() or update() call. A replaced voxel
+  /// is in this list with its old centroid and in added_voxels() with its new one. Empty unless
+  /// the changes are recorded, see set_record_changes().
+  /// \return Voxel indices and centroids.
+  const VoxelChanges & removed_voxels() const noexcept
+  {
+    return m_removed_voxels;
+  }
+
+  /// Get the voxels put into the map by the last insert() or update() call. Empty unless the
+  /// changes are recorded, see set_record_changes().
+  /// \return Voxel indices and centroids.
+  const VoxelChanges & added_voxels() const noexcept
+  {
+    return m_added_voxels;
+  }
+
+  /// Insert the voxels of a map with a finer grid, merging all voxels which fall into the same
+  /// voxel of this map into one. The merged voxel has the mean and covariance of the mixture of
+  /// the merged gaussians, which are weighted equally as the number of points per voxel is not
+  /// known. Used to build the coarse levels of a multi-resolution map.
+  /// \param finer_map Map whose voxel boundaries are also voxel boundaries of this map.
+  void insert_merged(const StaticNDTMap & finer_map)
+  {
+    std::unordered_map<uint64_t, MergedMoments> moments;
+    for (const auto & vx_it : finer_map) {
+      moments[index(vx_it.second.centroid())].add(vx_it.second);
+    }
+    for (const auto & moments_it : moments) {
+      set_merged(moments_it.first, moments_it.second);
+    }
+  }
+
+  /// Carry the changes of the last insert() or update() of a map with a finer grid over to this
+  /// map. Only the voxels into which a changed voxel falls are merged again as in
+  /// insert_merged(), the others are left untouched. This map has to be kept up to date with
+  /// this function from the moment the finer map was empty, with its changes recorded.
+  /// \param finer_map Map whose voxel boundaries are also voxel boundaries of this map.
+  /// \return Number of voxels of this map that were merged again.
+  /// \throws std::logic_error if the finer map does not record its changes.
+  std::size_t update_merged(const StaticNDTMap & finer_map)
+  {
+    if (!finer_map.records_changes()) {
+      throw std::logic_error("StaticNDTMap: update_merged() needs the changes of the finer map, "
+              "see set_record_changes().");
+    }
+    m_dirty_indices.clear();
+    for (const auto & change : finer_map.removed_voxels()) {
+      const auto voxel_idx = index(change.centroid);
+      auto & merged = m_merged_indices[voxel_idx];
+      merged.erase(std::remove(merged.begin(), merged.end(), change.index), merged.end());
+      m_dirty_indices.push_back(voxel_idx);
+    }
+    for (const auto & change : finer_map.added_voxels()) {
+      const auto voxel_idx = index(change.centroid);
+      m_merged_indices[voxel_idx].push_back(change.index);
+      m_dirty_indices.push_back(voxel_idx);
+    }
+    std::sort(m_dirty_indices.begin(), m_dirty_indices.end());
+    m_dirty_indices.erase(std::unique(m_dirty_indices.begin(), m_dirty_indices.end()),
+      m_dirty_indices.end());
+
+    for (const auto voxel_idx : m_dirty_indices) {
+      const auto merged_it = m_merged_indices.find(voxel_idx);
+      MergedMoments moments;
+      for (const auto finer_idx : merged_it->second) {
+        const auto finer_it = finer_map.find(finer_idx);
+        if (finer_it != finer_map.end()) {
+          moments.add(finer_it->second);
+        }
+      }
+      if (merged_it->second.empty()) {
+        m_merged_indices.erase(merged_it);
+      }
+      set_merged(voxel_idx, moments);
+    }
+    return m_dirty_indices.size();
+  }
+
+private:
+  /// Moments of the gaussians merged into one voxel, relative to the first merged centroid, which
+  /// avoids the cancellation of large map coordinates in the covariance computation.
+  class MergedMoments
+  {
+public:
+    /// Add a voxel, unless it is not usable or its covariance cannot be recovered.
+    void add(const Voxel & vx)
+    {
+      if (!vx.usable()) {
+        return;
+      }
+      Eigen::Matrix3d covariance;
+      bool8_t invertible{false};
+      vx.inverse_covariance().computeInverseWithCheck(covariance, invertible);
+      if (!invertible) {
+        return;
+      }
+      if (m_count == 0U) {
+        m_reference = vx.centroid();
+      }
+      const Point offset = vx.centroid() - m_reference;
+      m_sum_offset += offset;
+      m_sum_second_moment += covariance + offset * offset.transpose();
+      ++m_count;
+    }
+
+    /// Compute the voxel of the mixture.
+    /// \param[out] vx Merged voxel.
+    /// \return False if no voxel was added or the covariance of the mixture is singular.
+    bool8_t merge(Voxel & vx) const
+    {
+      if (m_count == 0U) {
+        return false;
+      }
+      const auto count = static_cast<Real>(m_count);
+      const Point mean_offset = m_sum_offset / count;
+      const Eigen::Matrix3d covariance = m_sum_second_moment / count -
+        mean_offset * mean_offset.transpose();
+      Eigen::Matrix3d inv_covariance;
+      bool8_t invertible{false};
+      covariance.computeInverseWithCheck(inv_covariance, invertible);
+      if (invertible) {
+        vx = Voxel{m_reference + mean_offset, inv_covariance};
+      }
+      return invertible;
+    }
+
+private:
+    Point m_reference{Point::Zero()};
+    Point m_sum_offset{Point::Zero()};
+    Eigen::Matrix3d m_sum_second_moment{Eigen::Matrix3d::Zero()};
+    std::size_t m_count{0U};
+  };
+
+  /// Set the voxel at the given index to the merged one, or remove it if nothing can be merged.
+  void set_merged(uint64_t voxel_idx, const MergedMoments & moments)
+  {
+    Voxel vx;
+    if (!moments.merge(vx)) {
+      (void) erase(voxel_idx);
+      return;
+    }
+    const auto insert_res = emplace(voxel_idx, Voxel{vx});
+    if (!insert_res.second) {
+      insert_res.first->second = vx;
+    }
+  }
+
+  /// Validate a map message and call a function for each of its voxels.
+  /// \param msg PointCloud2 message representing an ndt map.
+  /// \param fn Function called with the voxel index, the centroid and the inverse covariance of
+  /// each voxel.
+  /// \throws std::runtime_error if the message is empty or does not have the correct format.
+  /// \throws std::domain_error if a cell id does not match the voxel grid of the map.
+  template<typename FnT>
+  void for_each_voxel(const sensor_msgs::msg::PointCloud2 & msg, const FnT & fn) const
   {
     if (validate_pcl_map(msg) == 0U) {
       // throwing rather than silently failing since ndt matching cannot be done with an
@@ -326,13 +689,7 @@ public:
       inv_covariance << *icov_xx_it, *icov_xy_it, *icov_xz_it,
         *icov_xy_it, *icov_yy_it, *icov_yz_it,
         *icov_xz_it, *icov_yz_it, *icov_zz_it;
-      const Voxel vx{centroid, inv_covariance};
-
-      const auto insert_res = emplace(voxel_idx, Voxel{centroid, inv_covariance});
-      if (!insert_res.second) {
-        // if a voxel already exist at this point, replace.
-        insert_res.first->second = vx;
-      }
+      fn(voxel_idx, centroid, inv_covariance);
 
       ++x_it;
       ++y_it;
@@ -346,8 +703,67 @@ public:
       ++cell_id_it;
     }
   }
+
+  // Voxel indices of the last update, kept to avoid reallocations
+  std::vector<uint64_t> m_update_indices;
+  // Changes of the last insert or update, for the maps merged from this one
+  bool8_t m_record_changes{false};
+  VoxelChanges m_removed_voxels;
+  VoxelChanges m_added_voxels;
+  // Indices of the finer voxels that fall into each voxel, only used by update_merged()
+  std::unordered_map<uint64_t, std::vector<uint64_t>> m_merged_indices;
+  std::vector<uint64_t> m_dirty_indices;
 };
 
+/// Merge the voxels of a map into a map with a coarser grid, see StaticNDTMap::insert_merged().
+/// \throws std::domain_error for map types whose voxels cannot be merged.
+template<typename MapT>
+void insert_merged(MapT & coarse_map, const MapT & map)
+{
+  (void) coarse_map;
+  (void) map;
+  throw std::domain_error("Merging voxels into a coarser map is not supported by this map type.");
+}
+
+/// Merge the voxels of a map into a map with a coarser grid, see StaticNDTMap::insert_merged().
+inline void insert_merged(StaticNDTMap & coarse_map, const StaticNDTMap & map)
+{
+  coarse_map.insert_merged(map);
+}
+
+/// Record the changes of a map for update_merged(), see StaticNDTMap::set_record_changes().
+/// Map types whose voxels cannot be merged have nothing to record.
+template<typename MapT>
+void set_record_changes(MapT & map, const bool8_t record)
+{
+  (void) map;
+  (void) record;
+}
+
+/// Record the changes of a map for update_merged(), see StaticNDTMap::set_record_changes().
+inline void set_record_changes(StaticNDTMap & map, const bool8_t record)
+{
+  map.set_record_changes(record);
+}
+
+/// Carry the last changes of a map over to a map with a coarser grid, see
+/// StaticNDTMap::update_merged().
+/// \throws std::domain_error for map types whose voxels cannot be merged.
+template<typename MapT>
+std::size_t update_merged(MapT & coarse_map, const MapT & map)
+{
+  (void) coarse_map;
+  (void) map;
+  throw std::domain_error("Merging voxels into a coarser map is not supported by this map type.");
+}
+
+/// Carry the last changes of a map over to a map with a coarser grid, see
+/// StaticNDTMap::update_merged().
+inline std::size_t update_merged(StaticNDTMap & coarse_map, const StaticNDTMap & map)
+{
+  return coarse_map.update_merged(map);
+}
+
 }  // namespace ndt
 }  // namespace localization
 
@@ -62,10 +62,15 @@
 #include <optimization/optimization_problem.hpp>
 #include <optimization/utils.hpp>
 #include <ndt/utils.hpp>
+#include <helper_functions/worker_pool.hpp>
 #include <experimental/optional>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <tuple>
+#include <vector>
 #include "common/types.hpp"
 
 using autoware::common::types::bool8_t;
@@ -88,29 +93,65 @@ bool8_t is_valid_probability(ScalarT p)
   return ret;
 }
 
+/// Number of map voxel lookups of scan points and how many of them were served from a cache.
+struct NDT_PUBLIC CellCacheStatistics
+{
+  std::size_t num_lookups{0U};
+  std::size_t num_hits{0U};
+
+  /// Get the share of the lookups served from the cache.
+  /// \return Hit rate in [0, 1], 0 if there were no lookups.
+  float64_t hit_rate() const noexcept
+  {
+    return (num_lookups == 0U) ? 0.0 :
+           static_cast<float64_t>(num_hits) / static_cast<float64_t>(num_lookups);
+  }
+
+  CellCacheStatistics & operator+=(const CellCacheStatistics & other) noexcept
+  {
+    num_lookups += other.num_lookups;
+    num_hits += other.num_hits;
+    return *this;
+  }
+};
+
 /// P2D ndt objective. This class implements the P2D ndt score function, its analytical
 /// jacobian and hessian values.
+///
+/// Consecutive evaluations of an optimization, e.g. line search steps, move the scan points only
+/// slightly. The objective therefore remembers the map voxel of each scan point together with
+/// the voxel index of the transformed point and only looks the voxel up again once the point
+/// crossed into another voxel. The cache assumes at most one voxel per lookup, as returned by
+/// all current map types.
 /// \tparam MapT Type of map to be used.
-template<typename MapT>
-class P2DNDTObjective : public common::optimization::CachedExpression<P2DNDTObjective<MapT>,
+/// \tparam ScanT Type of scan to be used. If its points are in single precision, e.g. with
+/// P2DNDTScanView, they are rotated in single precision and only the translation and all
+/// subsequent computations are done in double precision.
+template<typename MapT, typename ScanT = P2DNDTScan>
+class P2DNDTObjective : public common::optimization::CachedExpression<P2DNDTObjective<MapT, ScanT>,
     EigenPose<Real>, 1U, 6U, common::optimization::EigenComparator>
 {
 public:
   // getting aliases from the base class.
-  using ExpressionT = common::optimization::CachedExpression<P2DNDTObjective<MapT>,
+  using ExpressionT = common::optimization::CachedExpression<P2DNDTObjective<MapT, ScanT>,
       EigenPose<Real>, 1U, 6U, common::optimization::EigenComparator>;
   using DomainValue = typename ExpressionT::DomainValue;
   using Value = typename ExpressionT::Value;
   using Jacobian = typename ExpressionT::Jacobian;
   using Hessian = typename ExpressionT::Hessian;
   using Map = MapT;
-  using Scan = P2DNDTScan;
+  using Scan = ScanT;
   using Point = typename Map::Point;
   using Comparator = common::optimization::EigenComparator;
   using ComputeMode = common::optimization::ComputeMode;
   using PointGrad = Eigen::Matrix<float64_t, 3, 6>;
   using PointHessian = Eigen::Matrix<float64_t, 18, 6>;
 
+  /// Number of consecutive scan points evaluated in one task of the parallel reduction.
+  static constexpr std::size_t POINTS_PER_TASK = 512U;
+  /// Number of (point, cell) pairs whose exponentials are evaluated together in one batch.
+  static constexpr std::size_t BATCH_SIZE = 64U;
+
   /// Constructor.
   ///
   /// It should be noted here that ndt optimization problem does not take ownership of neither the
@@ -119,106 +160,90 @@ public:
   ///
   /// @param      scan    Scan to align with the map.
   /// @param      map     NDT map to be aligned.
-  /// @param      config  Optimization config for this objective.
+  /// @param      config  Optimization config for this objective. If the config has a worker pool,
+  ///                     the evaluation is distributed over the pool's threads.
   ///
   P2DNDTObjective(
-    const P2DNDTScan & scan, const Map & map, const P2DNDTOptimizationConfig config)
-  : m_scan_ref(scan), m_map_ref(map)
+    const Scan & scan, const Map & map, const P2DNDTOptimizationConfig config)
+  : m_scan_ref(scan), m_map_ref(map), m_worker_pool(config.worker_pool()),
+    m_cell_cache(scan.size())
   {
     init(config.outlier_ratio());
   }
 
+  /// Get the statistics of the map voxel cache over all evaluations of this objective.
+  const CellCacheStatistics & cell_cache_statistics() const noexcept
+  {
+    return m_cell_cache_statistics;
+  }
+
+  /// Evaluate the objective. The scan is split into tasks of POINTS_PER_TASK points which
+  /// accumulate their own score, jacobian and hessian. The tasks are run on the worker pool if
+  /// there is one, and their results are summed up in a fixed order afterwards, so the result
+  /// does not depend on the number of threads.
   void evaluate_(const DomainValue & x, const ComputeMode & mode)
   {
     // Convert pose vector to transform matrix for easy point transformation
-    Eigen::Transform<float64_t, 3, Eigen::Affine, Eigen::ColMajor> transform;
+    Transform transform;
     transform.setIdentity();
     transform_adapters::pose_to_transform(x, transform);
+    const ScanRotation rotation = transform.linear().template cast<ScanScalar>();
+    const Point translation = transform.translation();
 
-    Value score{0.0};
-
-    Jacobian jacobian;
     std::experimental::optional<GradientAngleParameters> grad_params;
-
-    Hessian hessian;
     std::experimental::optional<HessianAngleParameters> hessian_params;
-
     {
       // Angle parameters to be used by all elements (eq. 6.12) [Magnusson 2009]
       const AngleParameters angle_params{x};
       // Only construct jacobian/hessian variables if they are needed.
       if (mode.jacobian() || mode.hessian()) {
-        jacobian.setZero();
         grad_params.emplace(angle_params);
       }
       if (mode.hessian()) {
-        hessian.setZero();
         hessian_params.emplace(angle_params);
       }
     }
-
-    for (const auto & pt : m_scan_ref) {
-      PointGrad point_gradient;
-      PointHessian point_hessian;
-
-      if (mode.jacobian() || mode.hessian()) {
-        point_gradient.setZero();
-        point_gradient.block<3, 3>(0, 0).setIdentity();
-        compute_point_gradients(grad_params.value(), pt, point_gradient);
-
-        if (mode.hessian()) {
-          point_hessian.setZero();
-          compute_point_hessians(hessian_params.value(), pt, point_hessian);
-        }
+    const GradientAngleParameters * const grad_params_ptr =
+      grad_params ? &grad_params.value() : nullptr;
+    const HessianAngleParameters * const hessian_params_ptr =
+      hessian_params ? &hessian_params.value() : nullptr;
+
+    const auto num_points = m_scan_ref.size();
+    const auto num_tasks = (num_points + POINTS_PER_TASK - 1U) / POINTS_PER_TASK;
+    if (m_task_sums.size() < num_tasks) {
+      m_task_sums.resize(num_tasks);
+    }
+    const auto task = [&](const std::size_t task_idx) {
+        const auto begin_idx = task_idx * POINTS_PER_TASK;
+        const auto end_idx = std::min(begin_idx + POINTS_PER_TASK, num_points);
+        evaluate_points(begin_idx, end_idx, rotation, translation, mode, grad_params_ptr,
+          hessian_params_ptr, m_task_sums[task_idx]);
+      };
+    if (m_worker_pool) {
+      m_worker_pool->run(num_tasks, task);
+    } else {
+      for (std::size_t task_idx = 0U; task_idx < num_tasks; ++task_idx) {
+        task(task_idx);
       }
+    }
 
-      const Point pt_trans = transform * pt;
-      const auto & cells = m_map_ref.cell(pt_trans);
-
-      for (const auto & cell : cells) {
-        const Point pt_trans_norm = pt_trans - cell.centroid();
-        // Cell iteration used for compatibility with maps with multi-cell lookup
-        if (cell.usable()) {
-          const auto & inv_cov = cell.inverse_covariance();
-          // e^(-d_2/2 * (x_k - mu_k)^T Sigma_k^-1 (x_k - mu_k)) Equation 6.9 [Magnusson 2009]
-          Real e_x_cov_x = std::exp(-m_gauss_d2 * pt_trans_norm.dot(
-                inv_cov * pt_trans_norm) / 2.0);
-
-          if (mode.score()) {
-            score += -m_gauss_d1 * e_x_cov_x;
-          }
-
-          if (mode.jacobian() || mode.hessian()) {
-            const auto d2_e_x_cov_x = m_gauss_d2 * e_x_cov_x;
-
-            // Error checking for invalid values.
-            // TODO(yunus.caliskan): Can be removed after covariance is checked
-            //  for definiteness #216
-            if (!is_valid_probability(d2_e_x_cov_x)) {
-              continue;
-            }
-
-            // Reusable portion of Equation 6.12 and 6.13 [Magnusson 2009]
-            const auto d1_d2_e_x_cov_x = m_gauss_d1 * d2_e_x_cov_x;
-
-            for (auto i = 0U; i < jacobian.rows(); ++i) {
-              const Point cov_dxd_pi = inv_cov * point_gradient.col(i);
-              if (mode.jacobian()) {
-                jacobian(i) += pt_trans_norm.dot(cov_dxd_pi) * d1_d2_e_x_cov_x;
-              }
-              if (mode.hessian()) {
-                for (auto j = 0U; j < hessian.cols(); ++j) {
-                  hessian(i, j) += d1_d2_e_x_cov_x * (-m_gauss_d2 * pt_trans_norm.dot(cov_dxd_pi) *
-                    pt_trans_norm.dot(inv_cov * point_gradient.col(j)) +
-                    pt_trans_norm.dot(inv_cov * point_hessian.block<3, 1>(3 * i, j)) +
-                    point_gradient.col(j).dot(cov_dxd_pi));
-                }
-              }
-            }
-          }
-        }
+    Value score{0.0};
+    Jacobian jacobian;
+    jacobian.setZero();
+    Hessian hessian;
+    hessian.setZero();
+    for (std::size_t task_idx = 0U; task_idx < num_tasks; ++task_idx) {
+      const auto & sum = m_task_sums[task_idx];
+      m_cell_cache_statistics += sum.cell_cache_statistics;
+      score += sum.score;
+      if (mode.jacobian()) {
+        jacobian += sum.jacobian;
+      }
+      if (mode.hessian()) {
+        hessian += sum.hessian;
       }
     }
+
     if (mode.score()) {
       this->set_score(score);
     }
@@ -231,6 +256,12 @@ public:
   }
 
 private:
+  using Transform = Eigen::Transform<float64_t, 3, Eigen::Affine, Eigen::ColMajor>;
+  using ScanScalar = typename Scan::Point::Scalar;
+  using ScanRotation = Eigen::Matrix<ScanScalar, 3, 3>;
+  using Cov = Eigen::Matrix3d;
+  using PointAlignment = Eigen::Matrix<float64_t, 6, 1>;
+
   /// Struct encapculating the intermediate parameters used in (eq. 6.17) [Magnusson 2009]
   struct AngleParameters
   {
@@ -391,10 +422,171 @@ public:
       h_ang_f1, h_ang_f2, h_ang_f3;
   };
 
+  /// Partial sums of a task of the parallel reduction
+  struct TaskSum
+  {
+    Value score{0.0};
+    Jacobian jacobian;
+    Hessian hessian;
+    // Buffer for the thread-safe map lookup
+    typename Map::VoxelViewVector cells;
+    CellCacheStatistics cell_cache_statistics;
+  };
+
+  using CellView = typename Map::VoxelViewVector::value_type;
+  static constexpr uint64_t INVALID_INDEX = static_cast<uint64_t>(-1);
+
+  /// Map voxel of a scan point in the last evaluation
+  struct CellCacheEntry
+  {
+    /// Voxel index of the transformed point, INVALID_INDEX before the first lookup
+    uint64_t index{INVALID_INDEX};
+    /// Usable voxel at that index, if there is one
+    std::experimental::optional<CellView> cell;
+  };
+
+  /// Intermediate values of the (point, cell) pairs of a batch, which are gathered first so that
+  /// the exponentials can be evaluated together in a vectorized way.
+  struct Batch
+  {
+    std::size_t size{0U};
+    std::array<std::size_t, BATCH_SIZE> point_idx;
+    std::array<Point, BATCH_SIZE> cov_pt_trans_norm;
+    std::array<Cov, BATCH_SIZE> inv_cov;
+    Eigen::Array<Real, BATCH_SIZE, 1> exponent;
+  };
+
+  /// Accumulate score, jacobian and hessian of a range of scan points
+  void evaluate_points(
+    const std::size_t begin_idx,
+    const std::size_t end_idx,
+    const ScanRotation & rotation,
+    const Point & translation,
+    const ComputeMode & mode,
+    const GradientAngleParameters * const grad_params,
+    const HessianAngleParameters * const hessian_params,
+    TaskSum & sum)
+  {
+    sum.score = 0.0;
+    sum.jacobian.setZero();
+    sum.hessian.setZero();
+    sum.cell_cache_statistics = CellCacheStatistics{};
+    Batch batch;
+    const auto scan_begin = m_scan_ref.begin();
+    for (auto idx = begin_idx; idx < end_idx; ++idx) {
+      // The rotated scan point is small, so only the translation into the map frame needs the
+      // double precision.
+      const Point pt_trans =
+        (rotation * scan_begin[static_cast<std::ptrdiff_t>(idx)]).template cast<Real>() +
+        translation;
+      // Tasks cover disjoint ranges of points, so each entry is only accessed by one thread.
+      auto & cache_entry = m_cell_cache[idx];
+      const auto cell_index = m_map_ref.config().index(pt_trans);
+      ++sum.cell_cache_statistics.num_lookups;
+      if (cell_index == cache_entry.index) {
+        ++sum.cell_cache_statistics.num_hits;
+      } else {
+        m_map_ref.cell(pt_trans, sum.cells);
+        cache_entry.index = cell_index;
+        cache_entry.cell = std::experimental::nullopt;
+        if (!sum.cells.empty() && sum.cells.front().usable()) {
+          cache_entry.cell.emplace(sum.cells.front());
+        }
+      }
+      if (cache_entry.cell) {
+        const auto & cell = *cache_entry.cell;
+        const auto pos = batch.size;
+        const Point pt_trans_norm = pt_trans - cell.centroid();
+        batch.point_idx[pos] = idx;
+        batch.inv_cov[pos] = cell.inverse_covariance();
+        batch.cov_pt_trans_norm[pos] = batch.inv_cov[pos] * pt_trans_norm;
+        // Exponent of e^(-d_2/2 * (x_k - mu_k)^T Sigma_k^-1 (x_k - mu_k))
+        // Equation 6.9 [Magnusson 2009]
+        batch.exponent(static_cast<Eigen::Index>(pos)) =
+          -m_gauss_d2 * pt_trans_norm.dot(batch.cov_pt_trans_norm[pos]) / 2.0;
+        ++batch.size;
+        if (batch.size == BATCH_SIZE) {
+          accumulate_batch(batch, mode, grad_params, hessian_params, sum);
+        }
+      }
+    }
+    accumulate_batch(batch, mode, grad_params, hessian_params, sum);
+  }
+
+  /// Evaluate the exponentials of a batch and accumulate its contributions, then empty the batch
+  void accumulate_batch(
+    Batch & batch,
+    const ComputeMode & mode,
+    const GradientAngleParameters * const grad_params,
+    const HessianAngleParameters * const hessian_params,
+    TaskSum & sum) const
+  {
+    if (batch.size == 0U) {
+      return;
+    }
+    // Eigen evaluates the exponential of an array with SIMD instructions where available.
+    const auto num_exp = static_cast<Eigen::Index>(batch.size);
+    batch.exponent.head(num_exp) = batch.exponent.head(num_exp).exp();
+
+    const auto scan_begin = m_scan_ref.begin();
+    PointGrad point_gradient;
+    PointHessian point_hessian;
+    point_gradient.setZero();
+    point_gradient.block<3, 3>(0, 0).setIdentity();
+    point_hessian.setZero();
+    for (std::size_t pos = 0U; pos < batch.size; ++pos) {
+      const Real e_x_cov_x = batch.exponent(static_cast<Eigen::Index>(pos));
+      if (mode.score()) {
+        sum.score += -m_gauss_d1 * e_x_cov_x;
+      }
+      if (!mode.jacobian() && !mode.hessian()) {
+        continue;
+      }
+      const auto d2_e_x_cov_x = m_gauss_d2 * e_x_cov_x;
+
+      // Error checking for invalid values.
+      // TODO(yunus.caliskan): Can be removed after covariance is checked
+      //  for definiteness #216
+      if (!is_valid_probability(d2_e_x_cov_x)) {
+        continue;
+      }
+
+      // Reusable portion of Equation 6.12 and 6.13 [Magnusson 2009]
+      const auto d1_d2_e_x_cov_x = m_gauss_d1 * d2_e_x_cov_x;
+
+      const Point pt =
+        scan_begin[static_cast<std::ptrdiff_t>(batch.point_idx[pos])].template cast<Real>();
+      compute_point_gradients(*grad_params, pt, point_gradient);
+      // Since the inverse covariance is symmetric,
+      // (x_k - mu_k)^T Sigma_k^-1 dx/dp_i = (Sigma_k^-1 (x_k - mu_k))^T dx/dp_i.
+      const Point & cov_pt_trans_norm = batch.cov_pt_trans_norm[pos];
+      const PointAlignment x_cov_dxd_p = point_gradient.transpose() * cov_pt_trans_norm;
+      if (mode.jacobian()) {
+        sum.jacobian += d1_d2_e_x_cov_x * x_cov_dxd_p;
+      }
+      if (mode.hessian()) {
+        compute_point_hessians(*hessian_params, pt, point_hessian);
+        // Terms of Equation 6.13 [Magnusson 2009]
+        Hessian point_contribution = point_gradient.transpose() *
+          (batch.inv_cov[pos] * point_gradient);
+        point_contribution.noalias() -= m_gauss_d2 * (x_cov_dxd_p * x_cov_dxd_p.transpose());
+        // Second order point derivatives only exist for the rotation parameters.
+        for (auto i = 3U; i < 6U; ++i) {
+          for (auto j = 3U; j < 6U; ++j) {
+            point_contribution(i, j) +=
+              cov_pt_trans_norm.dot(point_hessian.block<3, 1>(3U * i, j));
+          }
+        }
+        sum.hessian += d1_d2_e_x_cov_x * point_contribution;
+      }
+    }
+    batch.size = 0U;
+  }
+
   void compute_point_gradients(
     const GradientAngleParameters & params,
     const Point & x,
-    PointGrad & point_gradient)
+    PointGrad & point_gradient) const
   {
     point_gradient(1, 3) = x.dot(params.j_ang_a);
     point_gradient(2, 3) = x.dot(params.j_ang_b);
@@ -409,7 +601,7 @@ public:
   void compute_point_hessians(
     const HessianAngleParameters & params,
     const Point & x,
-    PointHessian & point_hessian)
+    PointHessian & point_hessian) const
   {
     const Point a{0.0, x.dot(params.h_ang_a2), x.dot(params.h_ang_a3)};
     const Point b{0.0, x.dot(params.h_ang_b2), x.dot(params.h_ang_b3)};
@@ -458,12 +650,43 @@ public:
   // States:
   Real m_gauss_d1{0.0};
   Real m_gauss_d2{0.0};
+  std::shared_ptr<common::helper_functions::WorkerPool> m_worker_pool;
+  // Per task results and lookup buffers, kept to avoid allocations in subsequent evaluations
+  std::vector<TaskSum, Eigen::aligned_allocator<TaskSum>> m_task_sums;
+  // Per scan point voxel cache, kept over all evaluations of the objective
+  std::vector<CellCacheEntry> m_cell_cache;
+  CellCacheStatistics m_cell_cache_statistics;
 };
 
-template<typename MapT>
-using P2DNDTOptimizationProblem =
-  common::optimization::UnconstrainedOptimizationProblem<P2DNDTObjective<MapT>, EigenPose<Real>,
-    6U>;
+template<typename MapT, typename ScanT>
+constexpr std::size_t P2DNDTObjective<MapT, ScanT>::POINTS_PER_TASK;
+
+template<typename MapT, typename ScanT>
+constexpr std::size_t P2DNDTObjective<MapT, ScanT>::BATCH_SIZE;
+
+template<typename MapT, typename ScanT>
+constexpr uint64_t P2DNDTObjective<MapT, ScanT>::INVALID_INDEX;
+
+/// Unconstrained optimization problem of the P2D ndt objective, which also gives read access to
+/// the objective, e.g. for its cache statistics after the optimization.
+template<typename MapT, typename ScanT = P2DNDTScan>
+class P2DNDTOptimizationProblem
+  : public common::optimization::UnconstrainedOptimizationProblem<P2DNDTObjective<MapT, ScanT>,
+    EigenPose<Real>, 6U>
+{
+public:
+  using Objective = P2DNDTObjective<MapT, ScanT>;
+  using Base = common::optimization::UnconstrainedOptimizationProblem<Objective,
+      EigenPose<Real>, 6U>;
+
+  /// Constructor, see P2DNDTObjective.
+  P2DNDTOptimizationProblem(
+    const ScanT & scan, const MapT & map, const P2DNDTOptimizationConfig & config)
+  : Base{scan, map, config} {}
+
+  /// Get the objective.
+  using Base::objective;
+};
 }  // namespace ndt
 }  // namespace localization
 }  // namespace autoware
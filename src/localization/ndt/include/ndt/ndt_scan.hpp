@@ -23,6 +23,10 @@
 #include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <time_utils/time_utils.hpp>
 #include <Eigen/Core>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include "common/types.hpp"
 
@@ -220,6 +224,266 @@ private:
   NDTScanBase::TimePoint m_stamp{};
 };
 
+/// Random access iterator over the float32 x, y and z fields of the points in a PointCloud2
+/// data buffer. Dereferencing reads the coordinates directly from the buffer.
+class NDT_PUBLIC PointCloud2XYZIterator
+{
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = Eigen::Vector3f;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+  using reference = value_type;
+
+  PointCloud2XYZIterator() = default;
+
+  /// Constructor
+  /// \param data Pointer to the first byte of the point.
+  /// \param point_step Size of a point in bytes.
+  /// \param x_offset Offset of the x field within a point in bytes.
+  /// \param y_offset Offset of the y field within a point in bytes.
+  /// \param z_offset Offset of the z field within a point in bytes.
+  PointCloud2XYZIterator(
+    const uint8_t * data, std::size_t point_step,
+    std::size_t x_offset, std::size_t y_offset, std::size_t z_offset) noexcept
+  : m_data{data}, m_point_step{static_cast<difference_type>(point_step)},
+    m_x_offset{x_offset}, m_y_offset{y_offset}, m_z_offset{z_offset} {}
+
+  reference operator*() const noexcept
+  {
+    return value_type{field(m_data, m_x_offset), field(m_data, m_y_offset),
+      field(m_data, m_z_offset)};
+  }
+
+  reference operator[](difference_type n) const noexcept
+  {
+    return *(*this + n);
+  }
+
+  PointCloud2XYZIterator & operator++() noexcept
+  {
+    m_data += m_point_step;
+    return *this;
+  }
+
+  PointCloud2XYZIterator operator++(int) noexcept
+  {
+    auto ret = *this;
+    ++(*this);
+    return ret;
+  }
+
+  PointCloud2XYZIterator & operator--() noexcept
+  {
+    m_data -= m_point_step;
+    return *this;
+  }
+
+  PointCloud2XYZIterator operator--(int) noexcept
+  {
+    auto ret = *this;
+    --(*this);
+    return ret;
+  }
+
+  PointCloud2XYZIterator & operator+=(difference_type n) noexcept
+  {
+    m_data += n * m_point_step;
+    return *this;
+  }
+
+  PointCloud2XYZIterator & operator-=(difference_type n) noexcept
+  {
+    m_data -= n * m_point_step;
+    return *this;
+  }
+
+  PointCloud2XYZIterator operator+(difference_type n) const noexcept
+  {
+    auto ret = *this;
+    return ret += n;
+  }
+
+  PointCloud2XYZIterator operator-(difference_type n) const noexcept
+  {
+    auto ret = *this;
+    return ret -= n;
+  }
+
+  difference_type operator-(const PointCloud2XYZIterator & other) const noexcept
+  {
+    return (m_data - other.m_data) / m_point_step;
+  }
+
+  bool8_t operator==(const PointCloud2XYZIterator & other) const noexcept
+  {
+    return m_data == other.m_data;
+  }
+
+  bool8_t operator!=(const PointCloud2XYZIterator & other) const noexcept
+  {
+    return m_data != other.m_data;
+  }
+
+  bool8_t operator<(const PointCloud2XYZIterator & other) const noexcept
+  {
+    return m_data < other.m_data;
+  }
+
+private:
+  static float32_t field(const uint8_t * data, std::size_t offset) noexcept
+  {
+    // Same access as in sensor_msgs::PointCloud2ConstIterator
+    return *reinterpret_cast<const float32_t *>(data + offset);
+  }
+
+  const uint8_t * m_data{nullptr};
+  difference_type m_point_step{0};
+  std::size_t m_x_offset{0U};
+  std::size_t m_y_offset{0U};
+  std::size_t m_z_offset{0U};
+};
+
+/// Represents a lidar scan in a P2D optimization problem without copying the points: it only
+/// references the data buffer of the inserted PointCloud2 message, whose x, y and z fields have
+/// to be float32. The message has to outlive the use of the scan, which is the case for the
+/// registration of a message in the localizer. The localizer drops the reference once the
+/// registration returns, see release_message(). The points keep their single precision, the
+/// P2D objective then transforms them in single precision as well.
+class NDT_PUBLIC P2DNDTScanView : public NDTScanBase<P2DNDTScanView,
+    Eigen::Vector3f, PointCloud2XYZIterator>
+{
+public:
+  using iterator = PointCloud2XYZIterator;
+
+  /// Constructor
+  /// \param msg Point cloud message to initialize this scan with.
+  /// \param capacity Max. number of points of a message, kept for compatibility with P2DNDTScan
+  /// as no memory has to be reserved.
+  P2DNDTScanView(
+    const sensor_msgs::msg::PointCloud2 & msg,
+    std::size_t capacity)
+  : m_capacity{capacity}
+  {
+    insert_(msg);
+  }
+
+  /// Constructor
+  /// \param capacity Max. number of points of a message, kept for compatibility with P2DNDTScan
+  /// as no memory has to be reserved.
+  explicit P2DNDTScanView(std::size_t capacity)
+  : m_capacity{capacity} {}
+
+  /// Reference the points of a point cloud.
+  /// \param msg Point cloud to reference.
+  /// \throws std::length_error if the message has more points than the capacity.
+  /// \throws std::runtime_error if the message has no float32 x, y and z fields or its data is
+  /// smaller than its dimensions.
+  void insert_(const sensor_msgs::msg::PointCloud2 & msg)
+  {
+    clear_();
+    m_stamp = ::time_utils::from_message(msg.header.stamp);
+
+    const auto num_points = static_cast<std::size_t>(msg.width) *
+      static_cast<std::size_t>(msg.height);
+    if (num_points > m_capacity) {
+      throw std::length_error("received a lidar scan with more points than the "
+              "ndt scan representation can contain. Please re-configure the scan"
+              "representation accordingly.");
+    }
+    if (msg.data.size() < (num_points * msg.point_step)) {
+      throw std::runtime_error("P2DNDTScanView: point cloud data is smaller than its dimensions");
+    }
+    const auto x_offset = float32_field_offset(msg, "x");
+    const auto y_offset = float32_field_offset(msg, "y");
+    const auto z_offset = float32_field_offset(msg, "z");
+
+    m_begin = iterator{msg.data.data(), msg.point_step, x_offset, y_offset, z_offset};
+    m_end = m_begin + static_cast<std::ptrdiff_t>(num_points);
+    m_size = num_points;
+  }
+
+  /// Get iterator pointing to the first point.
+  /// \return Begin iterator.
+  iterator begin_() const
+  {
+    return m_begin;
+  }
+
+  /// Get iterator pointing past the last point.
+  /// \return End iterator.
+  iterator end_() const
+  {
+    return m_end;
+  }
+
+  /// Check if there is any data in the scan.
+  /// \return True if no points are referenced.
+  bool8_t empty_()
+  {
+    return m_size == 0U;
+  }
+
+  /// Drop the reference to the point cloud.
+  void clear_()
+  {
+    m_begin = iterator{};
+    m_end = iterator{};
+    m_size = 0U;
+  }
+
+  /// Number of points inside the scan.
+  /// \return Number of points
+  std::size_t size_() const
+  {
+    return m_size;
+  }
+
+  TimePoint stamp_()
+  {
+    return m_stamp;
+  }
+
+private:
+  static std::size_t float32_field_offset(
+    const sensor_msgs::msg::PointCloud2 & msg,
+    const std::string & name)
+  {
+    for (const auto & field : msg.fields) {
+      if (field.name == name) {
+        if ((field.datatype != sensor_msgs::msg::PointField::FLOAT32) ||
+          ((field.offset + sizeof(float32_t)) > msg.point_step))
+        {
+          throw std::runtime_error("P2DNDTScanView: field " + name + " is not a float32 field");
+        }
+        return field.offset;
+      }
+    }
+    throw std::runtime_error("P2DNDTScanView: point cloud has no field " + name);
+  }
+
+  std::size_t m_capacity;
+  iterator m_begin{};
+  iterator m_end{};
+  std::size_t m_size{0U};
+  NDTScanBase::TimePoint m_stamp{};
+};
+
+/// Drop the reference of a scan to the message it was inserted from, so that the scan cannot
+/// dangle once the message is gone. Scans which copy the points keep them.
+template<typename ScanT>
+void release_message(ScanT & scan)
+{
+  (void) scan;
+}
+
+/// Drop the reference of a scan to the message it was inserted from, see
+/// release_message(ScanT &). A view scan is empty afterwards.
+inline void release_message(P2DNDTScanView & scan)
+{
+  scan.clear();
+}
+
 }  // namespace ndt
 }  // namespace localization
 }  // namespace autoware
@@ -0,0 +1,64 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef NDT__SCAN_DOWNSAMPLER_HPP_
+#define NDT__SCAN_DOWNSAMPLER_HPP_
+
+#include <ndt/visibility_control.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <voxel_grid/centroid_accumulator.hpp>
+#include <voxel_grid/config.hpp>
+#include <cstddef>
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt
+{
+/// Voxel grid filter for scans before their registration. A scan is replaced by the centroids of
+/// its points in each voxel, which bounds the number of points the objective is evaluated on and
+/// evens out the point density between near and far range. Points outside of the grid are
+/// dropped instead of being merged into the border voxels.
+class NDT_PUBLIC ScanDownsampler
+{
+public:
+  using Config = perception::filters::voxel_grid::Config;
+
+  /// Constructor
+  /// \param config Voxel grid config in the frame of the scans. Its capacity is the maximum
+  /// number of points of a downsampled scan.
+  explicit ScanDownsampler(const Config & config);
+
+  /// Downsample a scan.
+  /// \param msg Scan with float32 x, y and z fields.
+  /// \return Downsampled scan with the header of msg. It is valid until the next call.
+  /// \throws std::length_error if the scan occupies more voxels than the capacity of the config.
+  const sensor_msgs::msg::PointCloud2 & downsample(const sensor_msgs::msg::PointCloud2 & msg);
+
+  /// Get the voxel grid config.
+  const Config & config() const noexcept;
+
+private:
+  Config m_config;
+  perception::filters::voxel_grid::CentroidAccumulator m_grid;
+  sensor_msgs::msg::PointCloud2 m_cloud;
+};
+}  // namespace ndt
+}  // namespace localization
+}  // namespace autoware
+
+#endif  // NDT__SCAN_DOWNSAMPLER_HPP_
@@ -0,0 +1,231 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <ndt/frozen_ndt_map.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt
+{
+namespace
+{
+constexpr std::size_t CACHE_LINE_SIZE = 64U;
+constexpr std::size_t REALS_PER_CACHE_LINE = CACHE_LINE_SIZE / sizeof(Real);
+
+/// Smallest power of two that is at least twice the size, for a load factor <= 0.5
+std::size_t table_size(const std::size_t size)
+{
+  std::size_t ret = 1U;
+  while (ret < (size * 2U)) {
+    ret <<= 1U;
+  }
+  return ret;
+}
+
+/// Fibonacci hashing to spread out the (mostly sequential) voxel indices
+std::size_t hash(const uint64_t index)
+{
+  constexpr uint64_t MULTIPLIER = 11400714819323198485ULL;
+  return static_cast<std::size_t>(index * MULTIPLIER);
+}
+}  // namespace
+
+constexpr std::size_t FrozenNDTMap::NOT_FOUND;
+
+FrozenNDTMap::VoxelView::VoxelView(const Point & centroid, const Cov & inv_covariance)
+: m_centroid{centroid}, m_inv_covariance{inv_covariance} {}
+
+const FrozenNDTMap::Point & FrozenNDTMap::VoxelView::centroid() const noexcept
+{
+  return m_centroid;
+}
+
+const FrozenNDTMap::Cov & FrozenNDTMap::VoxelView::inverse_covariance() const noexcept
+{
+  return m_inv_covariance;
+}
+
+bool8_t FrozenNDTMap::VoxelView::usable() const noexcept
+{
+  return true;
+}
+
+FrozenNDTMap::FrozenNDTMap(const StaticNDTMap & map)
+: m_config{map.config()},
+  m_size{0U},
+  m_stride{0U},
+  m_offset{0U},
+  m_mask{0U},
+  m_stamp{map.stamp()},
+  m_frame_id{map.frame_id()}
+{
+  // Sort by voxel index: neighbouring voxels along x end up next to each other
+  std::vector<std::pair<uint64_t, const StaticNDTVoxel *>> voxels;
+  voxels.reserve(map.size());
+  for (const auto & vx_it : map) {
+    if (vx_it.second.usable()) {
+      voxels.emplace_back(vx_it.first, &vx_it.second);
+    }
+  }
+  std::sort(voxels.begin(), voxels.end(),
+    [](const auto & a, const auto & b) {return a.first < b.first;});
+  m_size = voxels.size();
+
+  // One allocation for all arrays, with room to shift the first one to a cache line boundary
+  m_stride = ((m_size + REALS_PER_CACHE_LINE - 1U) / REALS_PER_CACHE_LINE) * REALS_PER_CACHE_LINE;
+  m_data.resize((m_stride * static_cast<std::size_t>(Array::NUM_ARRAYS)) + REALS_PER_CACHE_LINE);
+  const auto address = reinterpret_cast<std::uintptr_t>(m_data.data());
+  m_offset = ((CACHE_LINE_SIZE - (address % CACHE_LINE_SIZE)) % CACHE_LINE_SIZE) / sizeof(Real);
+
+  Real * const cx = array(Array::CENTROID_X);
+  Real * const cy = array(Array::CENTROID_Y);
+  Real * const cz = array(Array::CENTROID_Z);
+  Real * const xx = array(Array::ICOV_XX);
+  Real * const xy = array(Array::ICOV_XY);
+  Real * const xz = array(Array::ICOV_XZ);
+  Real * const yy = array(Array::ICOV_YY);
+  Real * const yz = array(Array::ICOV_YZ);
+  Real * const zz = array(Array::ICOV_ZZ);
+  m_indices.reserve(m_size);
+  m_mask = table_size(m_size) - 1U;
+  m_table.assign(m_mask + 1U, Slot{0U, NOT_FOUND});
+  for (std::size_t pos = 0U; pos < m_size; ++pos) {
+    const StaticNDTVoxel & voxel = *voxels[pos].second;
+    const Point & centroid = voxel.centroid();
+    const Cov & inv_cov = voxel.inverse_covariance();
+    cx[pos] = centroid(0U);
+    cy[pos] = centroid(1U);
+    cz[pos] = centroid(2U);
+    // Inverse covariances are symmetric, the upper triangle is enough
+    xx[pos] = inv_cov(0U, 0U);
+    xy[pos] = inv_cov(0U, 1U);
+    xz[pos] = inv_cov(0U, 2U);
+    yy[pos] = inv_cov(1U, 1U);
+    yz[pos] = inv_cov(1U, 2U);
+    zz[pos] = inv_cov(2U, 2U);
+
+    const uint64_t index = voxels[pos].first;
+    m_indices.push_back(index);
+    std::size_t sdx = hash(index) & m_mask;
+    while (NOT_FOUND != m_table[sdx].pos) {
+      sdx = (sdx + 1U) & m_mask;
+    }
+    m_table[sdx] = Slot{index, pos};
+  }
+  m_output_vector.reserve(1U);
+}
+
+const FrozenNDTMap::VoxelViewVector & FrozenNDTMap::cell(
+  float32_t x, float32_t y, float32_t z) const
+{
+  return cell(Point({x, y, z}));
+}
+
+const FrozenNDTMap::VoxelViewVector & FrozenNDTMap::cell(const Point & pt) const
+{
+  cell(pt, m_output_vector);
+  return m_output_vector;
+}
+
+void FrozenNDTMap::cell(const Point & pt, VoxelViewVector & cells) const
+{
+  cells.clear();
+  const std::size_t pos = find(pt);
+  if (NOT_FOUND != pos) {
+    cells.push_back(voxel(pos));
+  }
+}
+
+std::size_t FrozenNDTMap::find(const Point & pt) const
+{
+  const uint64_t index = m_config.index(pt);
+  std::size_t sdx = hash(index) & m_mask;
+  while (NOT_FOUND != m_table[sdx].pos) {
+    if (index == m_table[sdx].index) {
+      return m_table[sdx].pos;
+    }
+    sdx = (sdx + 1U) & m_mask;
+  }
+  return NOT_FOUND;
+}
+
+FrozenNDTMap::VoxelView FrozenNDTMap::voxel(const std::size_t pos) const
+{
+  const Point centroid{array(Array::CENTROID_X)[pos], array(Array::CENTROID_Y)[pos],
+    array(Array::CENTROID_Z)[pos]};
+  const Real xx = array(Array::ICOV_XX)[pos];
+  const Real xy = array(Array::ICOV_XY)[pos];
+  const Real xz = array(Array::ICOV_XZ)[pos];
+  const Real yy = array(Array::ICOV_YY)[pos];
+  const Real yz = array(Array::ICOV_YZ)[pos];
+  const Real zz = array(Array::ICOV_ZZ)[pos];
+  Cov inv_covariance;
+  inv_covariance << xx, xy, xz,
+    xy, yy, yz,
+    xz, yz, zz;
+  return VoxelView{centroid, inv_covariance};
+}
+
+uint64_t FrozenNDTMap::voxel_index(const std::size_t pos) const
+{
+  return m_indices[pos];
+}
+
+std::size_t FrozenNDTMap::size() const noexcept
+{
+  return m_size;
+}
+
+const autoware::perception::filters::voxel_grid::PointXYZ & FrozenNDTMap::cell_size()
+const noexcept
+{
+  return m_config.get_voxel_size();
+}
+
+const FrozenNDTMap::Config & FrozenNDTMap::config() const noexcept
+{
+  return m_config;
+}
+
+FrozenNDTMap::TimePoint FrozenNDTMap::stamp() const noexcept
+{
+  return m_stamp;
+}
+
+const std::string & FrozenNDTMap::frame_id() const noexcept
+{
+  return m_frame_id;
+}
+
+const Real * FrozenNDTMap::array(const Array arr) const noexcept
+{
+  return &m_data[m_offset + (static_cast<std::size_t>(arr) * m_stride)];
+}
+
+Real * FrozenNDTMap::array(const Array arr) noexcept
+{
+  return &m_data[m_offset + (static_cast<std::size_t>(arr) * m_stride)];
+}
+}  // namespace ndt
+}  // namespace localization
+}  // namespace autoware
@@ -0,0 +1,101 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <ndt/scan_downsampler.hpp>
+#include <lidar_utils/point_cloud_utils.hpp>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <array>
+#include <cstdint>
+#include "common/types.hpp"
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt
+{
+namespace
+{
+using PointXYZ = perception::filters::voxel_grid::PointXYZ;
+
+bool8_t inside(const float32_t val, const float32_t min, const float32_t max)
+{
+  return (val >= min) && (val <= max);
+}
+}  // namespace
+
+ScanDownsampler::ScanDownsampler(const Config & config)
+: m_config{config},
+  m_grid{config}
+{
+  common::lidar_utils::init_pcl_msg(m_cloud, "base_link", config.get_capacity());
+}
+
+const sensor_msgs::msg::PointCloud2 & ScanDownsampler::downsample(
+  const sensor_msgs::msg::PointCloud2 & msg)
+{
+  const PointXYZ & min_pt = m_config.get_min_point();
+  const PointXYZ & max_pt = m_config.get_max_point();
+  constexpr auto BLOCK_SIZE = perception::filters::voxel_grid::CentroidAccumulator::BLOCK_SIZE;
+  std::array<float32_t, BLOCK_SIZE> x;
+  std::array<float32_t, BLOCK_SIZE> y;
+  std::array<float32_t, BLOCK_SIZE> z;
+  std::size_t count = 0U;
+
+  m_grid.clear();
+  sensor_msgs::PointCloud2ConstIterator<float32_t> x_it(msg, "x");
+  sensor_msgs::PointCloud2ConstIterator<float32_t> y_it(msg, "y");
+  sensor_msgs::PointCloud2ConstIterator<float32_t> z_it(msg, "z");
+  while (x_it != x_it.end()) {
+    if (inside(*x_it, min_pt.x, max_pt.x) && inside(*y_it, min_pt.y, max_pt.y) &&
+      inside(*z_it, min_pt.z, max_pt.z))
+    {
+      x[count] = *x_it;
+      y[count] = *y_it;
+      z[count] = *z_it;
+      ++count;
+      if (count == BLOCK_SIZE) {
+        m_grid.insert(x.data(), y.data(), z.data(), nullptr, count);
+        count = 0U;
+      }
+    }
+    ++x_it;
+    ++y_it;
+    ++z_it;
+  }
+  m_grid.insert(x.data(), y.data(), z.data(), nullptr, count);
+
+  uint32_t point_cloud_idx = 0U;
+  common::lidar_utils::reset_pcl_msg(m_cloud, m_grid.capacity(), point_cloud_idx);
+  for (std::size_t voxel = 0U; voxel < m_grid.size(); ++voxel) {
+    // The message has the capacity of the grid, so every voxel fits.
+    (void)common::lidar_utils::add_point_to_cloud(m_cloud, m_grid.get(voxel), point_cloud_idx);
+  }
+  common::lidar_utils::resize_pcl_msg(m_cloud, point_cloud_idx);
+  m_cloud.header = msg.header;
+  return m_cloud;
+}
+
+const ScanDownsampler::Config & ScanDownsampler::config() const noexcept
+{
+  return m_config;
+}
+}  // namespace ndt
+}  // namespace localization
+}  // namespace autoware
@@ -29,6 +29,7 @@ using autoware::common::types::float64_t;
 
 using autoware::localization::ndt::P2DNDTLocalizer;
 using autoware::localization::ndt::P2DNDTLocalizerConfig;
+using autoware::localization::ndt::ScanDownsampler;
 using autoware::localization::ndt::transform_adapters::pose_to_transform;
 using autoware::localization::ndt::transform_adapters::transform_to_pose;
 
@@ -37,6 +38,8 @@ using NewtonOptimizer = autoware::common::optimization::NewtonsMethodOptimizer<F
 using OptimizerOptions = autoware::common::optimization::OptimizationOptions;
 using FixedLineSearch = autoware::common::optimization::FixedLineSearch;
 using P2DTestLocalizer = P2DNDTLocalizer<NewtonOptimizer>;
+using P2DViewTestLocalizer = P2DNDTLocalizer<NewtonOptimizer,
+    autoware::localization::ndt::StaticNDTMap, autoware::localization::ndt::P2DNDTScanView>;
 
 class P2DLocalizerTest : public OptimizationTestContext, public ::testing::Test
 {
@@ -163,6 +166,30 @@ TEST_F(P2DLocalizerParameterTest, delayed_scan) {
   );
 }
 
+// A view scan must not reference the registered message once the registration returned
+TEST_F(P2DLocalizerParameterTest, view_scan_is_released) {
+  const auto map_time = std::chrono::system_clock::now();
+  const auto scan_time = map_time + std::chrono::seconds(10);
+  P2DViewTestLocalizer localizer{
+    m_localizer_config,
+    NewtonOptimizer{FixedLineSearch{m_step_size}, m_optimizer_options},
+    m_outlier_ratio};
+  auto map_cloud = dynamic_map_to_cloud(m_dynamic_map);
+  map_cloud.header.stamp = ::time_utils::to_message(map_time);
+  localizer.set_map(map_cloud);
+
+  P2DViewTestLocalizer::Transform transform_initial;
+  transform_initial.header.stamp = ::time_utils::to_message(scan_time);
+  transform_initial.transform.rotation.w = 1.0;
+  P2DViewTestLocalizer::PoseWithCovarianceStamped ros_pose_out{};
+  {
+    auto scan_cloud = m_downsampled_cloud;
+    scan_cloud.header.stamp = ::time_utils::to_message(scan_time);
+    (void) localizer.register_measurement(scan_cloud, transform_initial, ros_pose_out);
+  }
+  EXPECT_EQ(localizer.scan().size(), 0U);
+}
+
 TEST_F(P2DLocalizerParameterTest, async_initial_guess) {
   P2DTestLocalizer::Transform transform_initial{};
   P2DTestLocalizer::PoseWithCovarianceStamped ros_pose_out{};
@@ -219,3 +246,122 @@ TEST_F(P2DLocalizerParameterTest, async_initial_guess) {
     localizer.register_measurement(m_downsampled_cloud, set_and_get(guess_time_early), dummy_pose),
     std::domain_error);
 }
+
+TEST_F(P2DLocalizerParameterTest, pyramid_registration) {
+  constexpr auto translation_tol = 1e-2;
+  constexpr auto rotation_tol = 1e-2;
+  const auto map_time = std::chrono::system_clock::now();
+  const auto scan_time = map_time + std::chrono::seconds(10);
+
+  EXPECT_THROW(P2DNDTLocalizerConfig(m_grid_config, m_downsampled_cloud.width,
+    m_guess_time_tol, 1U, {1U}), std::domain_error);
+  EXPECT_THROW(P2DNDTLocalizerConfig(m_grid_config, m_downsampled_cloud.width,
+    m_guess_time_tol, 1U, {2U, 4U}), std::domain_error);
+
+  const P2DNDTLocalizerConfig pyramid_config{m_grid_config, m_downsampled_cloud.width,
+    m_guess_time_tol, 1U, {2U}};
+  P2DTestLocalizer localizer{
+    pyramid_config,
+    NewtonOptimizer{FixedLineSearch{m_step_size}, m_optimizer_options},
+    m_outlier_ratio};
+  ASSERT_EQ(localizer.coarse_maps().size(), 1U);
+
+  auto map_cloud = dynamic_map_to_cloud(m_dynamic_map);
+  map_cloud.header.stamp = ::time_utils::to_message(map_time);
+  localizer.set_map(map_cloud);
+  EXPECT_GT(localizer.coarse_maps()[0U].size(), 0U);
+  EXPECT_LT(localizer.coarse_maps()[0U].size(), localizer.map().size());
+  EXPECT_GT(localizer.map_update_summary().coarse_maps_duration.count(), 0);
+
+  // Translate the scan away from the map
+  EigenPose<Real> diff;
+  diff << 0.0, 0.65, 0.0, 0.0, 0.0, 0.0;
+  geometry_msgs::msg::TransformStamped diff_tf2;
+  pose_to_transform(diff, diff_tf2.transform);
+  diff_tf2.header.frame_id = "custom";
+  auto translated_cloud = m_downsampled_cloud;
+  tf2::doTransform(m_downsampled_cloud, translated_cloud, diff_tf2);
+  translated_cloud.header.stamp = ::time_utils::to_message(scan_time);
+
+  P2DTestLocalizer::Transform transform_initial;
+  transform_initial.header.stamp = ::time_utils::to_message(scan_time);
+  transform_initial.transform.rotation.w = 1.0;
+  P2DTestLocalizer::PoseWithCovarianceStamped ros_pose_out{};
+  const auto summary =
+    localizer.register_measurement(translated_cloud, transform_initial, ros_pose_out);
+
+  EigenPose<Real> pose_out;
+  transform_to_pose(ros_pose_out.pose.pose, pose_out);
+  EigenPose<Real> neg_diff = -diff;
+  is_pose_approx(pose_out, neg_diff, translation_tol, rotation_tol);
+
+  // Coarse-to-fine level summaries, the last one being the registration against the map itself
+  const auto & levels = summary.level_summaries();
+  ASSERT_EQ(levels.size(), 2U);
+  EXPECT_EQ(levels[0U].scale, 2U);
+  EXPECT_EQ(levels[1U].scale, 1U);
+  EXPECT_EQ(summary.total_iterations(),
+    levels[0U].optimization_summary.number_of_iterations_made() +
+    levels[1U].optimization_summary.number_of_iterations_made());
+  EXPECT_EQ(summary.optimization_summary().number_of_iterations_made(),
+    levels[1U].optimization_summary.number_of_iterations_made());
+}
+
+TEST_F(P2DLocalizerParameterTest, downsampled_scan) {
+  constexpr auto translation_tol = 1e-2;
+  constexpr auto rotation_tol = 1e-2;
+  const auto map_time = std::chrono::system_clock::now();
+  const auto scan_time = map_time + std::chrono::seconds(10);
+
+  // Every point twice: the downsampled scan is the original one, which fits into a scan with
+  // the capacity of the original one.
+  std::vector<Eigen::Vector3d> scan_points;
+  for (const auto & pt_it : m_voxel_centers) {
+    scan_points.push_back(pt_it.second);
+    scan_points.push_back(pt_it.second);
+  }
+  autoware::perception::filters::voxel_grid::PointXYZ min_point, max_point, voxel_size;
+  min_point.x = min_point.y = min_point.z = -5.0F;
+  max_point.x = max_point.y = max_point.z = 15.0F;
+  voxel_size.x = voxel_size.y = voxel_size.z = 0.1F;
+  const P2DNDTLocalizerConfig downsampling_config{m_grid_config, m_downsampled_cloud.width,
+    m_guess_time_tol, 1U, {}, ScanDownsampler::Config{min_point, max_point, voxel_size,
+      m_downsampled_cloud.width}};
+  P2DTestLocalizer localizer{
+    downsampling_config,
+    NewtonOptimizer{FixedLineSearch{m_step_size}, m_optimizer_options},
+    m_outlier_ratio};
+
+  auto map_cloud = dynamic_map_to_cloud(m_dynamic_map);
+  map_cloud.header.stamp = ::time_utils::to_message(map_time);
+  localizer.set_map(map_cloud);
+
+  EigenPose<Real> diff;
+  diff << 0.7, 0.0, 0.7, 0.0, 0.0, 0.0;
+  geometry_msgs::msg::TransformStamped diff_tf2;
+  pose_to_transform(diff, diff_tf2.transform);
+  diff_tf2.header.frame_id = "custom";
+  const auto scan_cloud = make_pcl(scan_points);
+  auto translated_cloud = scan_cloud;
+  tf2::doTransform(scan_cloud, translated_cloud, diff_tf2);
+  translated_cloud.header.stamp = ::time_utils::to_message(scan_time);
+
+  P2DTestLocalizer::Transform transform_initial;
+  transform_initial.header.stamp = ::time_utils::to_message(scan_time);
+  transform_initial.transform.rotation.w = 1.0;
+  P2DTestLocalizer::PoseWithCovarianceStamped ros_pose_out{};
+  const auto summary =
+    localizer.register_measurement(translated_cloud, transform_initial, ros_pose_out);
+  EXPECT_EQ(localizer.scan().size(), m_downsampled_cloud.width);
+
+  EigenPose<Real> pose_out;
+  transform_to_pose(ros_pose_out.pose.pose, pose_out);
+  EigenPose<Real> neg_diff = -diff;
+  is_pose_approx(pose_out, neg_diff, translation_tol, rotation_tol);
+
+  // Each evaluation looks up every point, points which stayed in their voxel are cache hits
+  const auto statistics = summary.cell_cache_statistics();
+  EXPECT_GT(statistics.num_lookups, m_downsampled_cloud.width);
+  EXPECT_EQ(statistics.num_lookups % m_downsampled_cloud.width, 0U);
+  EXPECT_GT(statistics.num_hits, 0U);
+}
@@ -15,6 +15,7 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include <gtest/gtest.h>
+#include <ndt/frozen_ndt_map.hpp>
 #include <ndt/utils.hpp>
 #include <Eigen/LU>
 #include <vector>
@@ -33,6 +34,9 @@ using autoware::localization::ndt::StaticNDTVoxel;
 using autoware::localization::ndt::Real;
 using autoware::localization::ndt::try_stabilize_covariance;
 using autoware::localization::ndt::StaticNDTMap;
+using autoware::localization::ndt::FrozenNDTMap;
+using autoware::localization::ndt::insert_merged;
+using autoware::localization::ndt::update_merged;
 using autoware::perception::filters::voxel_grid::Config;
 using autoware::common::lidar_utils::add_point_to_cloud;
 
@@ -265,6 +269,244 @@ TEST_F(DenseNDTMapTest, map_lookup) {
   }
 }
 
+TEST_F(DenseNDTMapTest, frozen_map_lookup) {
+  auto grid_config = Config(m_min_point, m_max_point, m_voxel_size, m_capacity);
+
+  StaticNDTMap static_map(grid_config);
+  {
+    // An empty map freezes into an empty map
+    const FrozenNDTMap frozen_map(static_map);
+    EXPECT_EQ(frozen_map.size(), 0U);
+    EXPECT_TRUE(frozen_map.cell(1.0, 1.0, 1.0).empty());
+    EXPECT_EQ(frozen_map.find(Eigen::Vector3d{1.0, 1.0, 1.0}), FrozenNDTMap::NOT_FOUND);
+  }
+
+  build_pc(grid_config);
+  DynamicNDTMap dynamic_map(grid_config);
+  dynamic_map.insert(m_pc);
+  static_map.insert(dynamic_map_to_cloud(dynamic_map));
+  const FrozenNDTMap frozen_map(static_map);
+
+  EXPECT_EQ(frozen_map.size(), 125U);
+  EXPECT_EQ(frozen_map.stamp(), static_map.stamp());
+  EXPECT_EQ(frozen_map.frame_id(), static_map.frame_id());
+  EXPECT_FLOAT_EQ(frozen_map.cell_size().x, static_map.cell_size().x);
+
+  // Voxels are stored in order of their indices
+  for (auto pos = 1U; pos < frozen_map.size(); ++pos) {
+    EXPECT_LT(frozen_map.voxel_index(pos - 1U), frozen_map.voxel_index(pos));
+  }
+
+  // slightly move the points before looking up to check if they get the correct voxel
+  constexpr auto diff = 0.1;
+  ASSERT_LT(diff, grid_config.get_voxel_size().x / 2.0);
+  for (const auto & center_it : m_voxel_centers) {
+    const Eigen::Vector3d pt = center_it.second + Eigen::Vector3d{diff, -diff, diff};
+    const auto & static_cells = static_map.cell(pt);
+    const auto & frozen_cells = frozen_map.cell(pt);
+    ASSERT_EQ(static_cells.size(), 1U);
+    ASSERT_EQ(frozen_cells.size(), 1U);
+    EXPECT_TRUE(frozen_cells[0U].usable());
+    // Values are copied, not recomputed
+    EXPECT_EQ(frozen_cells[0U].centroid(), static_cells[0U].centroid());
+    EXPECT_EQ(frozen_cells[0U].inverse_covariance(), static_cells[0U].inverse_covariance());
+
+    const auto pos = frozen_map.find(pt);
+    ASSERT_NE(pos, FrozenNDTMap::NOT_FOUND);
+    EXPECT_EQ(frozen_map.voxel_index(pos), center_it.first);
+    EXPECT_EQ(frozen_map.voxel(pos).centroid(), static_cells[0U].centroid());
+  }
+}
+
+TEST_F(DenseNDTMapTest, map_update) {
+  auto grid_config = Config(m_min_point, m_max_point, m_voxel_size, m_capacity);
+  build_pc(grid_config);
+  DynamicNDTMap dynamic_map(grid_config);
+  dynamic_map.insert(m_pc);
+  const auto full_msg = dynamic_map_to_cloud(dynamic_map);
+
+  // Same map without the voxels at x = 5
+  const auto is_last_slice = [&grid_config](uint64_t idx) {
+      return grid_config.centroid<Eigen::Vector3d>(idx)(0U) > 4.5;
+    };
+  EXPECT_EQ(dynamic_map.erase_if(is_last_slice), 25U);
+  const auto reduced_msg = dynamic_map_to_cloud(dynamic_map);
+
+  StaticNDTMap map_grid(grid_config);
+  EXPECT_THROW(map_grid.update(sensor_msgs::msg::PointCloud2{}), std::runtime_error);
+
+  auto summary = map_grid.update(reduced_msg);
+  EXPECT_EQ(summary.num_inserted, 100U);
+  EXPECT_EQ(summary.num_updated, 0U);
+  EXPECT_EQ(summary.num_removed, 0U);
+  EXPECT_EQ(summary.num_unchanged, 0U);
+  EXPECT_EQ(map_grid.size(), 100U);
+
+  summary = map_grid.update(full_msg);
+  EXPECT_EQ(summary.num_inserted, 25U);
+  EXPECT_EQ(summary.num_updated, 0U);
+  EXPECT_EQ(summary.num_removed, 0U);
+  EXPECT_EQ(summary.num_unchanged, 100U);
+  EXPECT_EQ(map_grid.size(), 125U);
+
+  // Change a single voxel and drop the last slice again
+  auto changed_msg = reduced_msg;
+  sensor_msgs::PointCloud2Iterator<Real> icov_xx_it(changed_msg, "icov_xx");
+  sensor_msgs::PointCloud2Iterator<uint32_t> cell_id_it(changed_msg, "cell_id");
+  *icov_xx_it *= 2.0;
+  uint64_t changed_idx = 0U;
+  std::memcpy(&changed_idx, &cell_id_it[0U], sizeof(changed_idx));
+
+  summary = map_grid.update(changed_msg);
+  EXPECT_EQ(summary.num_inserted, 0U);
+  EXPECT_EQ(summary.num_updated, 1U);
+  EXPECT_EQ(summary.num_removed, 25U);
+  EXPECT_EQ(summary.num_unchanged, 99U);
+  EXPECT_EQ(map_grid.size(), 100U);
+
+  // The result is the same as replacing the whole map
+  StaticNDTMap replaced_grid(grid_config);
+  replaced_grid.insert(changed_msg);
+  for (const auto & center_it : m_voxel_centers) {
+    const auto & cells = map_grid.cell(center_it.second);
+    const auto & expected_cells = replaced_grid.cell(center_it.second);
+    ASSERT_EQ(cells.size(), expected_cells.size());
+    EXPECT_EQ(cells.empty(), is_last_slice(center_it.first));
+    if (!cells.empty()) {
+      EXPECT_EQ(cells[0U].centroid(), expected_cells[0U].centroid());
+      EXPECT_EQ(cells[0U].inverse_covariance(), expected_cells[0U].inverse_covariance());
+    }
+  }
+  const auto & changed_cells = map_grid.cell(grid_config.centroid<Eigen::Vector3d>(changed_idx));
+  ASSERT_EQ(changed_cells.size(), 1U);
+  EXPECT_EQ(changed_cells[0U].inverse_covariance()(0U, 0U), *icov_xx_it);
+}
+
+TEST_F(DenseNDTMapTest, merged_map) {
+  auto grid_config = Config(m_min_point, m_max_point, m_voxel_size, m_capacity);
+  build_pc(grid_config);
+  DynamicNDTMap dynamic_map(grid_config);
+  dynamic_map.insert(m_pc);
+  StaticNDTMap static_map(grid_config);
+  static_map.insert(dynamic_map_to_cloud(dynamic_map));
+
+  // A single voxel covering the whole grid
+  PointXYZ coarse_voxel_size;
+  coarse_voxel_size.x = 5.0F;
+  coarse_voxel_size.y = 5.0F;
+  coarse_voxel_size.z = 5.0F;
+  StaticNDTMap single_voxel_map(Config(m_min_point, m_max_point, coarse_voxel_size, 1U));
+  insert_merged(single_voxel_map, static_map);
+  ASSERT_EQ(single_voxel_map.size(), 1U);
+  const auto & cells = single_voxel_map.cell(3.0, 3.0, 3.0);
+  ASSERT_EQ(cells.size(), 1U);
+  EXPECT_TRUE(cells[0U].centroid().isApprox(Eigen::Vector3d{3.0, 3.0, 3.0}, 1e-6));
+  // The covariance is the one of the voxels (see map_lookup) plus the variance of the centroids,
+  // which are at 1 to 5 in each dimension.
+  Eigen::Matrix3d expected_covariance;
+  expected_covariance << 2.03, 0.0, 0.0,
+    0.0, 2.03, 0.0,
+    0.0, 0.0, 2.03;
+  EXPECT_TRUE(cells[0U].inverse_covariance().inverse().isApprox(expected_covariance, 1e-5));
+
+  // Merging into voxels of twice the size
+  PointXYZ double_voxel_size;
+  double_voxel_size.x = 2.0F;
+  double_voxel_size.y = 2.0F;
+  double_voxel_size.z = 2.0F;
+  // The grid extent has to be a multiple of the voxel size
+  PointXYZ coarse_max_point;
+  coarse_max_point.x = 6.5F;
+  coarse_max_point.y = 6.5F;
+  coarse_max_point.z = 6.5F;
+  const Config coarse_config(m_min_point, coarse_max_point, double_voxel_size, m_capacity);
+  StaticNDTMap coarse_map(coarse_config);
+  insert_merged(coarse_map, static_map);
+  EXPECT_EQ(coarse_map.size(), 27U);
+  for (const auto & vx : coarse_map) {
+    EXPECT_EQ(coarse_config.index(vx.second.centroid()), vx.first);
+  }
+
+  // Only static maps can be merged
+  DynamicNDTMap coarse_dynamic_map(coarse_config);
+  EXPECT_THROW(insert_merged(coarse_dynamic_map, dynamic_map), std::domain_error);
+  EXPECT_THROW(update_merged(coarse_dynamic_map, dynamic_map), std::domain_error);
+}
+
+TEST_F(DenseNDTMapTest, merged_map_update) {
+  auto grid_config = Config(m_min_point, m_max_point, m_voxel_size, m_capacity);
+  build_pc(grid_config);
+  DynamicNDTMap dynamic_map(grid_config);
+  dynamic_map.insert(m_pc);
+  const auto full_msg = dynamic_map_to_cloud(dynamic_map);
+  // Same map without the voxels at x = 5, which are the only ones in the last coarse voxels
+  EXPECT_EQ(dynamic_map.erase_if([&grid_config](uint64_t idx) {
+      return grid_config.centroid<Eigen::Vector3d>(idx)(0U) > 4.5;
+    }), 25U);
+  auto changed_msg = dynamic_map_to_cloud(dynamic_map);
+  sensor_msgs::PointCloud2Iterator<Real> icov_xx_it(changed_msg, "icov_xx");
+  *icov_xx_it *= 2.0;
+
+  PointXYZ double_voxel_size;
+  double_voxel_size.x = 2.0F;
+  double_voxel_size.y = 2.0F;
+  double_voxel_size.z = 2.0F;
+  PointXYZ coarse_max_point;
+  coarse_max_point.x = 6.5F;
+  coarse_max_point.y = 6.5F;
+  coarse_max_point.z = 6.5F;
+  const Config coarse_config(m_min_point, coarse_max_point, double_voxel_size, m_capacity);
+
+  // Only the coarse voxels with changed voxels are merged again, and the result matches merging
+  // the whole map
+  const auto check_update = [&grid_config, &coarse_config](
+    const StaticNDTMap & map, const StaticNDTMap & coarse_map) {
+      StaticNDTMap expected_map(coarse_config);
+      insert_merged(expected_map, map);
+      ASSERT_EQ(coarse_map.size(), expected_map.size());
+      for (const auto & vx : expected_map) {
+        const auto coarse_it = coarse_map.find(vx.first);
+        ASSERT_NE(coarse_it, coarse_map.end());
+        EXPECT_TRUE(coarse_it->second.centroid().isApprox(vx.second.centroid(), 1e-12));
+        EXPECT_TRUE(coarse_it->second.inverse_covariance().isApprox(
+            vx.second.inverse_covariance(), 1e-9));
+      }
+    };
+  StaticNDTMap map(grid_config);
+  StaticNDTMap coarse_map(coarse_config);
+  // The changes are not kept by default
+  map.update(full_msg);
+  EXPECT_TRUE(map.added_voxels().empty());
+  EXPECT_THROW(update_merged(coarse_map, map), std::logic_error);
+  map.clear();
+
+  map.set_record_changes(true);
+  map.update(full_msg);
+  EXPECT_EQ(map.added_voxels().size(), 125U);
+  EXPECT_EQ(update_merged(coarse_map, map), 27U);
+  check_update(map, coarse_map);
+
+  // One voxel changes and the 9 coarse voxels at x = 5 disappear
+  map.update(changed_msg);
+  EXPECT_EQ(map.removed_voxels().size(), 26U);
+  EXPECT_EQ(map.added_voxels().size(), 1U);
+  EXPECT_EQ(update_merged(coarse_map, map), 10U);
+  EXPECT_EQ(coarse_map.size(), 18U);
+  check_update(map, coarse_map);
+
+  map.update(changed_msg);
+  EXPECT_EQ(update_merged(coarse_map, map), 0U);
+
+  map.insert(full_msg);
+  EXPECT_EQ(update_merged(coarse_map, map), 27U);
+  EXPECT_EQ(coarse_map.size(), 27U);
+  check_update(map, coarse_map);
+
+  map.set_record_changes(false);
+  EXPECT_TRUE(map.removed_voxels().empty());
+  EXPECT_TRUE(map.added_voxels().empty());
+}
+
 ///////////////////////////////////////
 
 TEST(StaticNDTVoxelTest, ndt_map_voxel_basics) {
@@ -439,6 +681,20 @@ TEST_F(NDTMapTest, map_representation_basics) {
       std::numeric_limits<Real>::epsilon()));
   }
 
+  // Remove the voxels in the lower half of the grid, the rest has to stay untouched.
+  const auto half = static_cast<Real>(num_points / 2U) + 0.5;
+  const auto is_lower_half = [&grid_config, half](uint64_t idx) {
+      return grid_config.centroid<Eigen::Vector3d>(idx)(0U) < half;
+    };
+  const auto num_removed = map_grid.erase_if(is_lower_half);
+  EXPECT_EQ(num_removed, num_points / 2U);
+  EXPECT_EQ(map_grid.size(), num_points - num_removed);
+  for (auto & vx : generator_grid) {
+    const auto & pt = vx.second.centroid();
+    EXPECT_EQ(map_grid.cell(pt).empty(), is_lower_half(vx.first));
+  }
+  EXPECT_EQ(map_grid.erase_if(is_lower_half), 0U);
+
   map_grid.clear();
   EXPECT_EQ(map_grid.size(), 0U);
 }
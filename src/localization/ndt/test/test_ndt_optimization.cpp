@@ -17,7 +17,12 @@
 #include "test_ndt_optimization.hpp"
 #include <tf2_sensor_msgs/tf2_sensor_msgs.h>
 #include <geometry_msgs/msg/transform_stamped.hpp>
+#include <ndt/frozen_ndt_map.hpp>
+#include <chrono>
+#include <iostream>
 #include <limits>
+#include <random>
+#include <vector>
 #include "common/types.hpp"
 
 using autoware::common::types::bool8_t;
@@ -25,11 +30,19 @@ using autoware::common::types::float32_t;
 using autoware::common::types::float64_t;
 
 using autoware::localization::ndt::P2DNDTScan;
+using autoware::localization::ndt::P2DNDTScanView;
 using autoware::localization::ndt::P2DNDTOptimizationProblem;
 using autoware::localization::ndt::P2DNDTOptimizationConfig;
+using autoware::localization::ndt::P2DNDTObjective;
+using autoware::localization::ndt::StaticNDTMap;
+using autoware::localization::ndt::FrozenNDTMap;
+using autoware::common::optimization::ComputeMode;
 using autoware::localization::ndt::transform_adapters::pose_to_transform;
 
 using P2DProblem = P2DNDTOptimizationProblem<autoware::localization::ndt::StaticNDTMap>;
+using P2DObjective = P2DNDTObjective<StaticNDTMap>;
+using P2DFrozenObjective = P2DNDTObjective<FrozenNDTMap>;
+using P2DViewObjective = P2DNDTObjective<StaticNDTMap, P2DNDTScanView>;
 
 OptTestParams::OptTestParams(
   float64_t x, float64_t y, float64_t z, float64_t ang_x, float64_t ang_y, float64_t ang_z,
@@ -199,6 +212,330 @@ INSTANTIATE_TEST_CASE_P(numerical_analysis, P2DOptimizationNumericalTest,
     OptTestParams{2.5, -1.9, 0.1, -2.1, 0.1, 3.05, true, false}
   ), );
 
+TEST_F(P2DOptimizationTest, frozen_map_objective) {
+  const FrozenNDTMap frozen_map(m_static_map);
+  P2DNDTScan scan(m_downsampled_cloud, m_downsampled_cloud.width);
+  const P2DNDTOptimizationConfig config{0.55};
+  P2DObjective objective{scan, m_static_map, config};
+  P2DFrozenObjective frozen_objective{scan, frozen_map, config};
+  const ComputeMode mode{true, true, true};
+
+  for (const auto & diff : std::vector<EigenPose<Real>>{
+      (EigenPose<Real>{} << 0.0, 0.0, 0.0, 0.0, 0.0, 0.0).finished(),
+      (EigenPose<Real>{} << 0.2, -0.3, 0.1, 0.01, 0.02, -0.05).finished(),
+      (EigenPose<Real>{} << 0.5, 0.9, 0.1, 1.0, -3.1, 0.05).finished()})
+  {
+    objective.evaluate(diff, mode);
+    frozen_objective.evaluate(diff, mode);
+    P2DObjective::Jacobian jacobian, frozen_jacobian;
+    P2DObjective::Hessian hessian, frozen_hessian;
+    objective.jacobian(diff, jacobian);
+    objective.hessian(diff, hessian);
+    frozen_objective.jacobian(diff, frozen_jacobian);
+    frozen_objective.hessian(diff, frozen_hessian);
+    // Same voxels, same arithmetic: the results are identical
+    EXPECT_EQ(objective(diff), frozen_objective(diff));
+    EXPECT_EQ(jacobian, frozen_jacobian);
+    EXPECT_EQ(hessian, frozen_hessian);
+  }
+}
+
+TEST_F(P2DOptimizationTest, scan_view_objective) {
+  P2DNDTScan scan(m_downsampled_cloud, m_downsampled_cloud.width);
+  P2DNDTScanView scan_view(m_downsampled_cloud, m_downsampled_cloud.width);
+  const P2DNDTOptimizationConfig config{0.55};
+  P2DObjective objective{scan, m_static_map, config};
+  P2DViewObjective view_objective{scan_view, m_static_map, config};
+  const ComputeMode mode{true, true, true};
+
+  for (const auto & diff : std::vector<EigenPose<Real>>{
+      (EigenPose<Real>{} << 0.0, 0.0, 0.0, 0.0, 0.0, 0.0).finished(),
+      (EigenPose<Real>{} << 0.2, -0.3, 0.1, 0.01, 0.02, -0.05).finished(),
+      (EigenPose<Real>{} << 0.5, 0.9, 0.1, 1.0, -3.1, 0.05).finished()})
+  {
+    objective.evaluate(diff, mode);
+    view_objective.evaluate(diff, mode);
+    P2DObjective::Jacobian jacobian, view_jacobian;
+    P2DObjective::Hessian hessian, view_hessian;
+    objective.jacobian(diff, jacobian);
+    objective.hessian(diff, hessian);
+    view_objective.jacobian(diff, view_jacobian);
+    view_objective.hessian(diff, view_hessian);
+    // Only the rotation of the scan points is done in single precision
+    constexpr auto tolerance = 1e-4;
+    EXPECT_NEAR(objective(diff), view_objective(diff), tolerance * std::fabs(objective(diff)));
+    EXPECT_TRUE(view_jacobian.isApprox(jacobian, tolerance));
+    EXPECT_TRUE(view_hessian.isApprox(hessian, tolerance));
+  }
+}
+
+TEST_F(P2DOptimizationTest, cell_cache) {
+  P2DNDTScan scan(m_downsampled_cloud, m_downsampled_cloud.width);
+  const P2DNDTOptimizationConfig config{0.55};
+  P2DObjective objective{scan, m_static_map, config};
+  const ComputeMode mode{true, true, true};
+  const auto num_points = scan.size();
+
+  // Poses as in a line search: small steps, then a jump which moves points into other voxels
+  const std::vector<EigenPose<Real>> poses{
+    (EigenPose<Real>{} << 0.2, -0.3, 0.1, 0.01, 0.02, -0.05).finished(),
+    (EigenPose<Real>{} << 0.2001, -0.3, 0.1, 0.01, 0.02, -0.05).finished(),
+    (EigenPose<Real>{} << 0.2001, -0.2999, 0.1, 0.01, 0.0201, -0.05).finished(),
+    (EigenPose<Real>{} << 0.5, 0.9, 0.1, 1.0, -3.1, 0.05).finished()};
+  for (std::size_t idx = 0U; idx < poses.size(); ++idx) {
+    const auto & pose = poses[idx];
+    objective.evaluate(pose, mode);
+    EXPECT_EQ(objective.cell_cache_statistics().num_lookups, (idx + 1U) * num_points);
+
+    // The cached voxels give exactly the result of a lookup of every point
+    P2DObjective uncached_objective{scan, m_static_map, config};
+    uncached_objective.evaluate(pose, mode);
+    EXPECT_EQ(uncached_objective.cell_cache_statistics().num_hits, 0U);
+    P2DObjective::Jacobian jacobian, uncached_jacobian;
+    P2DObjective::Hessian hessian, uncached_hessian;
+    objective.jacobian(pose, jacobian);
+    objective.hessian(pose, hessian);
+    uncached_objective.jacobian(pose, uncached_jacobian);
+    uncached_objective.hessian(pose, uncached_hessian);
+    EXPECT_EQ(objective(pose), uncached_objective(pose));
+    EXPECT_EQ(jacobian, uncached_jacobian);
+    EXPECT_EQ(hessian, uncached_hessian);
+
+    if (idx == 2U) {
+      // Barely any point crossed a voxel boundary in the small steps
+      EXPECT_GT(objective.cell_cache_statistics().num_hits, (19U * 2U * num_points) / 20U);
+    }
+  }
+  const auto & statistics = objective.cell_cache_statistics();
+  EXPECT_LT(statistics.num_hits, statistics.num_lookups);
+  EXPECT_GT(statistics.hit_rate(), 0.0);
+  EXPECT_LT(statistics.hit_rate(), 1.0);
+}
+
+TEST_F(P2DOptimizationTest, parallel_objective) {
+  // Repeat the voxel centers with some noise to get a scan which is split into multiple tasks
+  std::vector<Eigen::Vector3d> scan_points;
+  std::mt19937 gen{42U};
+  std::normal_distribution<float64_t> noise{0.0, 0.1};
+  while (scan_points.size() < (5U * P2DObjective::POINTS_PER_TASK) / 2U) {
+    for (const auto & pt_it : m_voxel_centers) {
+      scan_points.emplace_back(pt_it.second + Eigen::Vector3d{noise(gen), noise(gen), noise(gen)});
+    }
+  }
+  const auto scan_cloud = make_pcl(scan_points);
+  P2DNDTScan scan(scan_cloud, scan_cloud.width);
+  const P2DNDTOptimizationConfig serial_config{0.55};
+  const P2DNDTOptimizationConfig parallel_config{0.55, 3U};
+  EXPECT_EQ(serial_config.num_threads(), 1U);
+  EXPECT_EQ(parallel_config.num_threads(), 3U);
+  EXPECT_THROW(P2DNDTOptimizationConfig(0.55, 0U), std::domain_error);
+  P2DObjective objective{scan, m_static_map, serial_config};
+  P2DObjective parallel_objective{scan, m_static_map, parallel_config};
+  const ComputeMode mode{true, true, true};
+
+  for (const auto & diff : std::vector<EigenPose<Real>>{
+      (EigenPose<Real>{} << 0.0, 0.0, 0.0, 0.0, 0.0, 0.0).finished(),
+      (EigenPose<Real>{} << 0.2, -0.3, 0.1, 0.01, 0.02, -0.05).finished()})
+  {
+    objective.evaluate(diff, mode);
+    parallel_objective.evaluate(diff, mode);
+    P2DObjective::Jacobian jacobian, parallel_jacobian;
+    P2DObjective::Hessian hessian, parallel_hessian;
+    objective.jacobian(diff, jacobian);
+    objective.hessian(diff, hessian);
+    parallel_objective.jacobian(diff, parallel_jacobian);
+    parallel_objective.hessian(diff, parallel_hessian);
+    // The partial sums are added up in the same order: the results are identical
+    EXPECT_GT(objective(diff), 0.0);
+    EXPECT_EQ(objective(diff), parallel_objective(diff));
+    EXPECT_EQ(jacobian, parallel_jacobian);
+    EXPECT_EQ(hessian, parallel_hessian);
+  }
+}
+
+// Compares the objective evaluation on the hash map based StaticNDTMap with the FrozenNDTMap,
+// on the synthetic parking lot map.
+TEST(FrozenNDTMapBenchmark, benchmark) {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::size_t num_scan_points = 20000U;
+  constexpr std::size_t num_evaluations = 10U;
+
+  const StaticNDTMap static_map{make_parking_lot_map()};
+  const auto scan_cloud = make_pcl(make_parking_lot_scan(num_scan_points));
+  P2DNDTScan scan(scan_cloud, scan_cloud.width);
+
+  const auto start_freeze = Clock::now();
+  const FrozenNDTMap frozen_map(static_map);
+  const auto freeze_time = Clock::now() - start_freeze;
+  ASSERT_EQ(frozen_map.size(), static_map.size());
+
+  const P2DNDTOptimizationConfig config{0.55};
+  P2DObjective objective{scan, static_map, config};
+  P2DFrozenObjective frozen_objective{scan, frozen_map, config};
+  EigenPose<Real> diff;
+  diff << 0.1, -0.1, 0.05, 0.0, 0.0, 0.01;
+
+  for (const auto & mode : {ComputeMode{true, false, false}, ComputeMode{true, true, true}}) {
+    const auto start_static = Clock::now();
+    for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+      objective.evaluate_(diff, mode);
+    }
+    const auto static_time = Clock::now() - start_static;
+    const auto start_frozen = Clock::now();
+    for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+      frozen_objective.evaluate_(diff, mode);
+    }
+    const auto frozen_time = Clock::now() - start_frozen;
+    EXPECT_EQ(objective(diff), frozen_objective(diff));
+
+    std::cerr << "evaluate_ of " << num_scan_points << " points on " << static_map.size() <<
+      " voxels, " << (mode.hessian() ? "score, jacobian and hessian" : "score only") << ":\n";
+    std::cerr << "  StaticNDTMap: " << std::chrono::duration_cast<std::chrono::microseconds>(
+      static_time).count() / num_evaluations << " µs\n";
+    std::cerr << "  FrozenNDTMap: " << std::chrono::duration_cast<std::chrono::microseconds>(
+      frozen_time).count() / num_evaluations << " µs\n";
+  }
+  std::cerr << "Freezing the map: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(freeze_time).count() << " µs\n";
+}
+
+// Evaluation time of the full objective for a scan of the size of a 32 beam lidar at 10 Hz,
+// which has to fit in a fraction of the 100 ms period, with different numbers of threads.
+TEST(P2DNDTObjectiveBenchmark, benchmark) {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::size_t num_scan_points = 30000U;
+  constexpr std::size_t num_evaluations = 10U;
+
+  const FrozenNDTMap map{make_parking_lot_map()};
+  const auto scan_cloud = make_pcl(make_parking_lot_scan(num_scan_points));
+  P2DNDTScan scan(scan_cloud, scan_cloud.width);
+  EigenPose<Real> diff;
+  diff << 0.1, -0.1, 0.05, 0.0, 0.0, 0.01;
+  const ComputeMode mode{true, true, true};
+
+  Real serial_score{0.0};
+  for (const std::size_t num_threads : {1U, 2U, 4U}) {
+    P2DFrozenObjective objective{scan, map, P2DNDTOptimizationConfig{0.55, num_threads}};
+    // Warm up the per task buffers
+    objective.evaluate_(diff, mode);
+    const auto start = Clock::now();
+    for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+      objective.evaluate_(diff, mode);
+    }
+    const auto time = Clock::now() - start;
+    if (num_threads == 1U) {
+      serial_score = objective(diff);
+    }
+    EXPECT_EQ(objective(diff), serial_score);
+
+    std::cerr << "evaluate_ of " << num_scan_points << " points with " << num_threads <<
+      " thread(s): " << std::chrono::duration_cast<std::chrono::microseconds>(
+      time).count() / num_evaluations << " µs\n";
+  }
+}
+
+// Compares copying a scan of the size of a 32 beam lidar into a P2DNDTScan with referencing it
+// with a P2DNDTScanView, and the objective evaluation with both.
+TEST(P2DNDTScanViewBenchmark, benchmark) {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::size_t num_scan_points = 30000U;
+  constexpr std::size_t num_evaluations = 10U;
+
+  const FrozenNDTMap map{make_parking_lot_map()};
+  const auto scan_cloud = make_pcl(make_parking_lot_scan(num_scan_points));
+  P2DNDTScan scan(num_scan_points);
+  P2DNDTScanView scan_view(num_scan_points);
+
+  const auto start_insert = Clock::now();
+  for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+    scan.insert(scan_cloud);
+  }
+  const auto insert_time = Clock::now() - start_insert;
+  const auto start_view = Clock::now();
+  for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+    scan_view.insert(scan_cloud);
+  }
+  const auto view_time = Clock::now() - start_view;
+  ASSERT_EQ(scan.size(), scan_view.size());
+
+  const P2DNDTOptimizationConfig config{0.55};
+  P2DFrozenObjective objective{scan, map, config};
+  P2DNDTObjective<FrozenNDTMap, P2DNDTScanView> view_objective{scan_view, map, config};
+  EigenPose<Real> diff;
+  diff << 0.1, -0.1, 0.05, 0.0, 0.0, 0.01;
+  const ComputeMode mode{true, true, true};
+  // Warm up the per task buffers
+  objective.evaluate_(diff, mode);
+  view_objective.evaluate_(diff, mode);
+  const auto start_eval = Clock::now();
+  for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+    objective.evaluate_(diff, mode);
+  }
+  const auto eval_time = Clock::now() - start_eval;
+  const auto start_view_eval = Clock::now();
+  for (std::size_t idx = 0U; idx < num_evaluations; ++idx) {
+    view_objective.evaluate_(diff, mode);
+  }
+  const auto view_eval_time = Clock::now() - start_view_eval;
+  EXPECT_NEAR(objective(diff), view_objective(diff), 1e-4 * std::fabs(objective(diff)));
+
+  std::cerr << "Scan of " << num_scan_points << " points:\n";
+  std::cerr << "  P2DNDTScan insert:     " << std::chrono::duration_cast<std::chrono::microseconds>(
+    insert_time).count() / num_evaluations << " µs\n";
+  std::cerr << "  P2DNDTScanView insert: " << std::chrono::duration_cast<std::chrono::microseconds>(
+    view_time).count() / num_evaluations << " µs\n";
+  std::cerr << "  P2DNDTScan evaluate_:     " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(eval_time).count() / num_evaluations <<
+    " µs\n";
+  std::cerr << "  P2DNDTScanView evaluate_: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(view_eval_time).count() /
+    num_evaluations << " µs\n";
+}
+
+// Evaluations along line search steps with a single objective, whose voxel cache is kept
+// between the steps, against a new objective per step, which looks up every point.
+TEST(P2DNDTCellCacheBenchmark, benchmark) {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::size_t num_scan_points = 30000U;
+  constexpr std::size_t num_steps = 10U;
+
+  const StaticNDTMap map{make_parking_lot_map()};
+  const auto scan_cloud = make_pcl(make_parking_lot_scan(num_scan_points));
+  P2DNDTScan scan(scan_cloud, scan_cloud.width);
+  const P2DNDTOptimizationConfig config{0.55};
+  const ComputeMode mode{true, true, true};
+  std::vector<EigenPose<Real>> steps;
+  for (std::size_t idx = 0U; idx < num_steps; ++idx) {
+    const auto step = 0.01 * static_cast<Real>(idx);
+    steps.push_back((EigenPose<Real>{} << 0.1 + step, -0.1 - step, 0.05, 0.0, 0.0,
+      0.01 + 0.1 * step).finished());
+  }
+
+  P2DObjective cached_objective{scan, map, config};
+  const auto start_cached = Clock::now();
+  for (const auto & pose : steps) {
+    cached_objective.evaluate_(pose, mode);
+  }
+  const auto cached_time = Clock::now() - start_cached;
+  const auto start_uncached = Clock::now();
+  Real uncached_score{0.0};
+  for (const auto & pose : steps) {
+    P2DObjective objective{scan, map, config};
+    objective.evaluate_(pose, mode);
+    uncached_score = objective(pose);
+  }
+  const auto uncached_time = Clock::now() - start_uncached;
+  EXPECT_EQ(cached_objective(steps.back()), uncached_score);
+
+  std::cerr << "evaluate_ of " << num_scan_points << " points along " << num_steps <<
+    " line search steps:\n";
+  std::cerr << "  with voxel cache:    " << std::chrono::duration_cast<std::chrono::microseconds>(
+    cached_time).count() / num_steps << " µs, hit rate " <<
+    cached_objective.cell_cache_statistics().hit_rate() << "\n";
+  std::cerr << "  without voxel cache: " << std::chrono::duration_cast<std::chrono::microseconds>(
+    uncached_time).count() / num_steps << " µs\n";
+}
+
 
 ////////////////////////////////////// Test function implementations
 
@@ -224,3 +561,136 @@ pcl::PointCloud<pcl::PointXYZ> from_pointcloud2(const sensor_msgs::msg::PointClo
   }
   return res;
 }
+
+StaticNDTMap make_parking_lot_map()
+{
+  using Config = autoware::perception::filters::voxel_grid::Config;
+  using PointXYZ = autoware::perception::filters::voxel_grid::PointXYZ;
+  PointXYZ min_point, max_point, voxel_size;
+  min_point.x = 0.0F;
+  min_point.y = 0.0F;
+  min_point.z = -1.0F;
+  max_point.x = PARKING_LOT_SIZE;
+  max_point.y = PARKING_LOT_SIZE;
+  max_point.z = PARKING_LOT_HEIGHT;
+  voxel_size.x = 1.0F;
+  voxel_size.y = 1.0F;
+  voxel_size.z = 1.0F;
+  const Config grid_config{min_point, max_point, voxel_size,
+    static_cast<uint64_t>(PARKING_LOT_SIZE * PARKING_LOT_SIZE * (PARKING_LOT_HEIGHT + 1.0F))};
+
+  // Flat gaussians: thin along z on the ground, thin along x on the walls
+  std::vector<Eigen::Vector3d> centroids;
+  std::vector<Eigen::Matrix3d> inv_covariances;
+  Eigen::Matrix3d ground_inv_cov, wall_inv_cov;
+  ground_inv_cov << 12.5, 0.5, 0.0, 0.5, 12.5, 0.0, 0.0, 0.0, 500.0;
+  wall_inv_cov << 500.0, 0.0, 0.0, 0.0, 12.5, 0.5, 0.0, 0.5, 12.5;
+  for (float32_t x = 0.5F; x < PARKING_LOT_SIZE; x += 1.0F) {
+    for (float32_t y = 0.5F; y < PARKING_LOT_SIZE; y += 1.0F) {
+      centroids.emplace_back(x, y, -0.5);
+      inv_covariances.push_back(ground_inv_cov);
+    }
+  }
+  for (float32_t x = PARKING_LOT_WALL_SPACING; x < PARKING_LOT_SIZE;
+    x += PARKING_LOT_WALL_SPACING)
+  {
+    for (float32_t y = 0.5F; y < PARKING_LOT_SIZE; y += 1.0F) {
+      for (float32_t z = 0.5F; z < PARKING_LOT_WALL_HEIGHT; z += 1.0F) {
+        centroids.emplace_back(x + 0.2, y, z);
+        inv_covariances.push_back(wall_inv_cov);
+      }
+    }
+  }
+  StaticNDTMap map(grid_config);
+  map.insert(make_static_map_cloud(grid_config, centroids, inv_covariances));
+  return map;
+}
+
+std::vector<Eigen::Vector3d> make_parking_lot_scan(const std::size_t num_points)
+{
+  constexpr std::size_t num_rings = 16U;
+  constexpr float64_t pi = 3.14159265359;
+  const std::size_t ring_size = num_points / num_rings;
+  const float64_t wall_spacing = static_cast<float64_t>(PARKING_LOT_WALL_SPACING);
+  // The sensor is in the middle of the map: consecutive points are close to each other, as in
+  // real scans
+  const Eigen::Vector3d sensor{PARKING_LOT_SIZE * 0.5 + 10.0, PARKING_LOT_SIZE * 0.5, 1.5};
+  std::mt19937 gen{42U};
+  std::normal_distribution<float64_t> noise{0.0, 0.02};
+  std::vector<Eigen::Vector3d> scan_points;
+  for (std::size_t ring = 0U; ring < num_rings; ++ring) {
+    const float64_t elevation = (-15.0 + ring) * (pi / 180.0);
+    for (std::size_t step = 0U; step < ring_size; ++step) {
+      const float64_t azimuth = (2.0 * pi * step) / ring_size;
+      const Eigen::Vector3d dir{std::cos(elevation) * std::cos(azimuth),
+        std::cos(elevation) * std::sin(azimuth), std::sin(elevation)};
+      // Hit the ground, or the closest wall if it is in front of the ground hit
+      float64_t range = (-0.5 - sensor(2)) / dir(2);
+      const float64_t wall_x = (dir(0) > 0.0) ?
+        ((std::floor(sensor(0) / wall_spacing) + 1.0) * wall_spacing + 0.2) :
+        (std::floor(sensor(0) / wall_spacing) * wall_spacing + 0.2);
+      const float64_t wall_range = (wall_x - sensor(0)) / dir(0);
+      if ((wall_range > 0.0) && (wall_range < range)) {
+        range = wall_range;
+      }
+      scan_points.push_back(sensor + ((range + noise(gen)) * dir));
+    }
+  }
+  return scan_points;
+}
+
+sensor_msgs::msg::PointCloud2 make_static_map_cloud(
+  const autoware::perception::filters::voxel_grid::Config & grid_config,
+  const std::vector<Eigen::Vector3d> & centroids,
+  const std::vector<Eigen::Matrix3d> & inv_covariances)
+{
+  sensor_msgs::msg::PointCloud2 msg;
+  autoware::common::lidar_utils::init_pcl_msg(msg, "map", centroids.size(), 10U,
+    "x", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "y", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "z", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xx", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xy", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_yy", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_yz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_zz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "cell_id", 2U, sensor_msgs::msg::PointField::UINT32);
+
+  sensor_msgs::PointCloud2Iterator<Real> x_it(msg, "x");
+  sensor_msgs::PointCloud2Iterator<Real> y_it(msg, "y");
+  sensor_msgs::PointCloud2Iterator<Real> z_it(msg, "z");
+  sensor_msgs::PointCloud2Iterator<Real> icov_xx_it(msg, "icov_xx");
+  sensor_msgs::PointCloud2Iterator<Real> icov_xy_it(msg, "icov_xy");
+  sensor_msgs::PointCloud2Iterator<Real> icov_xz_it(msg, "icov_xz");
+  sensor_msgs::PointCloud2Iterator<Real> icov_yy_it(msg, "icov_yy");
+  sensor_msgs::PointCloud2Iterator<Real> icov_yz_it(msg, "icov_yz");
+  sensor_msgs::PointCloud2Iterator<Real> icov_zz_it(msg, "icov_zz");
+  sensor_msgs::PointCloud2Iterator<uint32_t> cell_id_it(msg, "cell_id");
+  for (std::size_t idx = 0U; idx < centroids.size(); ++idx) {
+    const auto & centroid = centroids[idx];
+    const auto & inv_covariance = inv_covariances[idx];
+    *(x_it) = centroid(0U);
+    *(y_it) = centroid(1U);
+    *(z_it) = centroid(2U);
+    *(icov_xx_it) = inv_covariance(0U, 0U);
+    *(icov_xy_it) = inv_covariance(0U, 1U);
+    *(icov_xz_it) = inv_covariance(0U, 2U);
+    *(icov_yy_it) = inv_covariance(1U, 1U);
+    *(icov_yz_it) = inv_covariance(1U, 2U);
+    *(icov_zz_it) = inv_covariance(2U, 2U);
+    const auto cell_id = grid_config.index(centroid);
+    std::memcpy(&cell_id_it[0U], &cell_id, sizeof(cell_id));
+    ++x_it;
+    ++y_it;
+    ++z_it;
+    ++icov_xx_it;
+    ++icov_xy_it;
+    ++icov_xz_it;
+    ++icov_yy_it;
+    ++icov_yz_it;
+    ++icov_zz_it;
+    ++cell_id_it;
+  }
+  return msg;
+}
@@ -35,6 +35,26 @@ using autoware::localization::ndt::EigenPose;
 
 pcl::PointCloud<pcl::PointXYZ> from_pointcloud2(const sensor_msgs::msg::PointCloud2 & msg);
 
+// Build a point cloud in the format expected by StaticNDTMap from the given voxels
+sensor_msgs::msg::PointCloud2 make_static_map_cloud(
+  const autoware::perception::filters::voxel_grid::Config & grid_config,
+  const std::vector<Eigen::Vector3d> & centroids,
+  const std::vector<Eigen::Matrix3d> & inv_covariances);
+
+// Dimensions of the synthetic parking lot used in the benchmarks, as no recorded map is available
+// to the tests.
+constexpr float32_t PARKING_LOT_SIZE = 200.0F;
+constexpr float32_t PARKING_LOT_HEIGHT = 20.0F;
+constexpr float32_t PARKING_LOT_WALL_SPACING = 20.0F;
+constexpr float32_t PARKING_LOT_WALL_HEIGHT = 5.0F;
+
+// Build a map of a 200m x 200m parking lot at 1m resolution, with a ground plane and parallel
+// walls
+autoware::localization::ndt::StaticNDTMap make_parking_lot_map();
+
+// Simulate a scan of a 16 beam spinning lidar in the parking lot
+std::vector<Eigen::Vector3d> make_parking_lot_scan(const std::size_t num_points);
+
 class OptimizationTestContext : public DenseNDTMapContext
 {
 public:
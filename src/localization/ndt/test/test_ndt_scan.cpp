@@ -15,6 +15,7 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include <ndt/ndt_scan.hpp>
+#include <ndt/scan_downsampler.hpp>
 #include <lidar_utils/point_cloud_utils.hpp>
 #include <gtest/gtest.h>
 #include <vector>
@@ -22,6 +23,8 @@
 #include "test_ndt_scan.hpp"
 
 using autoware::localization::ndt::P2DNDTScan;
+using autoware::localization::ndt::P2DNDTScanView;
+using autoware::localization::ndt::ScanDownsampler;
 
 TEST_F(NDTScanTest, bad_input) {
   const auto capacity = 5U;
@@ -71,3 +74,87 @@ TEST_F(NDTScanTest, basics) {
   EXPECT_TRUE(ndt_scan.empty());
   EXPECT_EQ(ndt_scan.size(), 0U);
 }
+
+TEST_F(NDTScanTest, view_bad_input) {
+  const auto capacity = 5U;
+  ASSERT_LT(capacity, m_num_points);
+  P2DNDTScanView small_scan(capacity);
+  EXPECT_THROW(small_scan.insert(m_pc), std::length_error);
+
+  P2DNDTScanView ndt_scan(m_num_points);
+  // Not float32
+  auto double_pc = m_pc;
+  double_pc.fields[1U].datatype = sensor_msgs::msg::PointField::FLOAT64;
+  EXPECT_THROW(ndt_scan.insert(double_pc), std::runtime_error);
+  // Missing field
+  auto xy_pc = m_pc;
+  xy_pc.fields[2U].name = "w";
+  EXPECT_THROW(ndt_scan.insert(xy_pc), std::runtime_error);
+  // Truncated data
+  auto truncated_pc = m_pc;
+  truncated_pc.data.resize(truncated_pc.data.size() - 1U);
+  EXPECT_THROW(ndt_scan.insert(truncated_pc), std::runtime_error);
+  EXPECT_TRUE(ndt_scan.empty());
+}
+
+TEST_F(NDTScanTest, view_basics) {
+  P2DNDTScanView ndt_scan(m_num_points);
+  EXPECT_TRUE(ndt_scan.empty());
+  EXPECT_EQ(ndt_scan.begin(), ndt_scan.end());
+  EXPECT_NO_THROW(ndt_scan.insert(m_pc));
+
+  EXPECT_EQ(ndt_scan.size(), m_num_points);
+  EXPECT_FALSE(ndt_scan.empty());
+  EXPECT_EQ(std::distance(ndt_scan.begin(), ndt_scan.end()),
+    static_cast<std::ptrdiff_t>(m_num_points));
+
+  // The view keeps the order of the points and references the message data
+  const P2DNDTScan copied_scan(m_pc, m_num_points);
+  auto copied_it = copied_scan.begin();
+  for (const auto & pt : ndt_scan) {
+    ASSERT_NE(copied_it, copied_scan.end());
+    EXPECT_EQ(pt.cast<float64_t>(), *copied_it);
+    ++copied_it;
+  }
+  const auto scan_begin = ndt_scan.begin();
+  for (auto idx = 0U; idx < m_num_points; ++idx) {
+    EXPECT_FLOAT_EQ(scan_begin[idx](0U), m_points[idx](0U));
+  }
+
+  ndt_scan.clear();
+  EXPECT_TRUE(ndt_scan.empty());
+  EXPECT_EQ(ndt_scan.size(), 0U);
+}
+
+TEST_F(NDTScanTest, downsampling) {
+  autoware::perception::filters::voxel_grid::PointXYZ min_point, max_point, voxel_size;
+  min_point.x = min_point.y = min_point.z = -1.0F;
+  max_point.x = max_point.y = max_point.z = 7.0F;
+  voxel_size.x = voxel_size.y = voxel_size.z = 2.0F;
+  const ScanDownsampler::Config config{min_point, max_point, voxel_size, 5U};
+  ASSERT_LT(max_point.x, static_cast<float32_t>(m_num_points - 1U));
+  m_pc.header.frame_id = "lidar";
+
+  ScanDownsampler downsampler{config};
+  // Twice, to check that no state is kept between scans
+  for (auto i = 0U; i < 2U; ++i) {
+    const auto & downsampled = downsampler.downsample(m_pc);
+    EXPECT_EQ(downsampled.header.frame_id, "lidar");
+    // Points 0 to 7 fall into the voxels {0}, {1, 2}, {3, 4}, {5, 6} and {7}, the points outside
+    // of the grid are dropped.
+    P2DNDTScan ndt_scan(downsampled, m_num_points);
+    std::vector<float64_t> coordinates;
+    for (const auto & pt : ndt_scan) {
+      ASSERT_FLOAT_EQ(pt(0U), pt(1U));
+      ASSERT_FLOAT_EQ(pt(0U), pt(2U));
+      coordinates.push_back(pt(0U));
+    }
+    std::sort(coordinates.begin(), coordinates.end());
+    EXPECT_EQ(coordinates, (std::vector<float64_t>{0.0, 1.5, 3.5, 5.5, 7.0}));
+  }
+
+  // More occupied voxels than the capacity
+  ScanDownsampler small_downsampler{
+    ScanDownsampler::Config{min_point, max_point, voxel_size, 4U}};
+  EXPECT_THROW(small_downsampler.downsample(m_pc), std::length_error);
+}
@@ -0,0 +1,87 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef NDT_NODES__MAP_CACHE_HPP_
+#define NDT_NODES__MAP_CACHE_HPP_
+
+#include <ndt_nodes/visibility_control.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <voxel_grid/config.hpp>
+#include <cstdint>
+#include <string>
+#include "common/types.hpp"
+
+using autoware::common::types::float32_t;
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt_nodes
+{
+
+/// Version of the map cache format. To be incremented whenever the header or the layout of the
+/// voxel records changes, older caches are then rejected and have to be regenerated.
+constexpr uint32_t MAP_CACHE_VERSION = 1U;
+
+/// Header of a map cache file. It is followed by the voxel records, which have exactly the layout
+/// of the data of the serialized ndt map PointCloud2 message. All values are in the byte order of
+/// the machine which wrote the cache.
+struct MapCacheHeader
+{
+  /// "NDTMAP" followed by two zero bytes
+  char magic[8U];
+  uint32_t version;
+  /// Fixed value to detect a cache written with another byte order
+  uint32_t byte_order;
+  uint32_t point_step;
+  uint32_t reserved;
+  uint64_t num_voxels;
+  uint64_t capacity;
+  float32_t min_point[3U];
+  float32_t max_point[3U];
+  float32_t voxel_size[3U];
+  uint32_t padding[3U];
+};
+
+/// Write a serialized ndt map into a binary map cache file. Throws if the file cannot be written.
+/// \param[in] file_name Name of the cache file.
+/// \param[in] config Voxel grid config of the map.
+/// \param[in] msg Serialized ndt map, as created by ndt_map_to_pc().
+void NDT_NODES_PUBLIC write_map_cache(
+  const std::string & file_name,
+  const perception::filters::voxel_grid::Config & config,
+  const sensor_msgs::msg::PointCloud2 & msg);
+
+/// Read a binary map cache file into a serialized ndt map message. The file is memory mapped and
+/// the voxel records are copied into the message in one go, without any per voxel processing.
+/// \param[in] file_name Name of the cache file.
+/// \param[in] config Voxel grid config the map is expected to have.
+/// \param[out] msg Message initialized with init_ndt_map_pc(). It is resized to the number of
+/// voxels in the cache.
+/// \throws std::runtime_error if the file cannot be read, has another format version or is
+/// corrupted.
+/// \throws std::domain_error if the map in the cache was created with another voxel grid config.
+void NDT_NODES_PUBLIC read_map_cache(
+  const std::string & file_name,
+  const perception::filters::voxel_grid::Config & config,
+  sensor_msgs::msg::PointCloud2 & msg);
+
+}  // namespace ndt_nodes
+}  // namespace localization
+}  // namespace autoware
+
+#endif  // NDT_NODES__MAP_CACHE_HPP_
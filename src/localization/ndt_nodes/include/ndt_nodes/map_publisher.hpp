@@ -18,10 +18,13 @@
 #define NDT_NODES__MAP_PUBLISHER_HPP_
 
 #include <ndt_nodes/visibility_control.hpp>
+#include <ndt_nodes/map_tiles.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <ndt/ndt_map.hpp>
 #include <tf2_ros/static_transform_broadcaster.h>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_centroid.hpp>
+#include <set>
 #include <string>
 #include <memory>
 #include "common/types.hpp"
@@ -63,8 +66,29 @@ void NDT_NODES_PUBLIC read_from_pcd(
   const std::string & file_name,
   sensor_msgs::msg::PointCloud2 * msg);
 
+/// Initialize a PointCloud2 message with the fields of a serialized ndt map. See the documentation
+/// for the specs and the format of the point cloud message.
+/// \param[out] msg Message to initialize.
+/// \param[in] frame_id Frame of the map.
+/// \param[in] capacity Maximum number of voxels the message is allocated for.
+void NDT_NODES_PUBLIC init_ndt_map_pc(
+  sensor_msgs::msg::PointCloud2 & msg,
+  const std::string & frame_id,
+  const std::size_t capacity);
+
+/// Iterate over the map representation and convert it into a PointCloud2 message where each voxel
+/// in the map corresponds to a single point in the PointCloud2 field. Voxels which cannot be used
+/// for matching are left out.
+/// \param[in] map Map to convert.
+/// \param[out] msg Message initialized with init_ndt_map_pc(). It is resized to the number of
+/// serialized voxels.
+void NDT_NODES_PUBLIC ndt_map_to_pc(
+  const ndt::DynamicNDTMap & map,
+  sensor_msgs::msg::PointCloud2 & msg);
+
 /// Node to read pcd files, transform to ndt maps and publish the resulting maps in PointCloud2
-/// format
+/// format. In tiled mode, the map is split into square tiles on disk and only the tiles around
+/// the vehicle are published. The published map follows the poses of the localizer.
 class NDT_NODES_PUBLIC NDTMapPublisherNode : public rclcpp::Node
 {
 public:
@@ -82,6 +106,12 @@ public:
   /// 2. Load the PCD file into a PointCloud2 message.
   /// 3. Apply the normal distribution transform loaded PointCloud2 message.
   /// 4. Convert the resulting map representation into a `PointCloud2` message and publish.
+  /// If a map cache file is configured, steps 2. and 3. are replaced by reading the cache file
+  /// created with the `ndt_map_cache_tool`.
+  /// In tiled mode, steps 2. and 3. are done only for the tiles within the configured radius of
+  /// the initial position, after splitting the PCD file into tiles if the tile directory does
+  /// not contain any yet. The map is updated and published again whenever the vehicle moves into
+  /// another tile.
   void run();
 
 private:
@@ -101,6 +131,23 @@ private:
   /// \param fn File name of the pcd file.
   void load_map();
 
+  /// Read the map info yaml file and broadcast the transform from the earth frame to the map.
+  void load_map_origin();
+
+  /// Prepare the tiles of the map and load the ones around the initial position.
+  void load_tiled_map();
+
+  /// Bring the map up to date with the tiles around a location: tiles that are out of the radius
+  /// are evicted from the map, tiles that came into the radius are loaded and inserted. Other
+  /// voxels of the map are left untouched.
+  /// \param x x coordinate in the map frame
+  /// \param y y coordinate in the map frame
+  void update_tiles(const float64_t x, const float64_t y);
+
+  /// Update the tiled map if the pose is in another tile than the previous one and publish it.
+  /// \param msg Pose of the vehicle in the map frame.
+  void on_pose(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg);
+
   void publish_earth_to_map_transform(
     float64_t x, float64_t y, float64_t z,
     float64_t roll, float64_t pitch, float64_t yaw);
@@ -112,11 +159,6 @@ private:
   /// Reset the internal point clouds and the ndt map.
   void reset();
 
-  /// Iterate over the map representation and convert it into a PointCloud2 message where each voxel
-  /// in the map corresponds to a single point in the PointCloud2 field. See the documentation for
-  /// the specs and the format of the point cloud message.
-  void map_to_pc();
-
   /// Use a Voxel Grid filter to downsample the loaded map prior to publishing.
   void downsample_pc();
 
@@ -133,12 +175,23 @@ private:
   const std::string m_pcl_file_name;
   const std::string m_yaml_file_name;
   const bool8_t m_viz_map;
+  const std::string m_map_cache_file_name;
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr m_viz_pub;
   std::unique_ptr<MapConfig> m_map_config_ptr;
   std::unique_ptr<MapConfig> m_viz_map_config_ptr;
   std::unique_ptr<VoxelGrid> m_voxelgrid_ptr;
   // Workaround. TODO(yunus.caliskan): Remove in #380
   rclcpp::TimerBase::SharedPtr m_visualization_timer{nullptr};
+  // Members for the tiled mode, m_tiles_ptr is null if it is disabled
+  std::unique_ptr<MapTiles> m_tiles_ptr;
+  std::unique_ptr<ndt::StaticNDTMap> m_tiled_map_ptr;
+  std::string m_tile_directory;
+  float64_t m_initial_x{0.0};
+  float64_t m_initial_y{0.0};
+  std::set<TileIndex> m_available_tiles;
+  std::set<TileIndex> m_loaded_tiles;
+  TileIndex m_current_tile;
+  rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr m_pose_sub;
 };
 
 }  // namespace ndt_nodes
@@ -0,0 +1,132 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef NDT_NODES__MAP_TILES_HPP_
+#define NDT_NODES__MAP_TILES_HPP_
+
+#include <ndt_nodes/visibility_control.hpp>
+#include <voxel_grid/config.hpp>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/types.hpp"
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float64_t;
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt_nodes
+{
+
+/// Index of a map tile along the x and y axes.
+using TileIndex = std::pair<int64_t, int64_t>;
+
+/// Partition of the x-y plane of an ndt map into square tiles. The tiles start at the minimum
+/// point of the map's voxel grid and their size is a multiple of the voxel size, so every voxel
+/// of the map belongs to exactly one tile. A voxel's tile is the one that contains its center.
+class NDT_NODES_PUBLIC MapTiles
+{
+public:
+  using MapConfig = perception::filters::voxel_grid::Config;
+
+  /// Constructor
+  /// \param map_config Voxel grid configuration of the ndt map.
+  /// \param tile_size Edge length of a tile in meters.
+  /// \param radius Tiles which are closer to the vehicle than this radius are kept in memory.
+  /// \throws std::domain_error if the tile size is not a positive multiple of the voxel size in
+  /// x and y or if the radius is negative.
+  MapTiles(const MapConfig & map_config, const float64_t tile_size, const float64_t radius);
+
+  /// Get the tile containing a location.
+  /// \param x x coordinate in the map frame
+  /// \param y y coordinate in the map frame
+  /// \return Index of the tile.
+  TileIndex tile(const float64_t x, const float64_t y) const;
+
+  /// Get the tile of a voxel.
+  /// \param voxel_index Index of the voxel as computed by the map's voxel grid config.
+  /// \return Index of the tile containing the voxel's center.
+  TileIndex tile(const uint64_t voxel_index) const;
+
+  /// Get all tiles which have at least one point within the radius around a location.
+  /// \param x x coordinate in the map frame
+  /// \param y y coordinate in the map frame
+  /// \return Indices of the tiles, ordered by x and then by y.
+  std::vector<TileIndex> tiles_in_radius(const float64_t x, const float64_t y) const;
+
+  /// Get the edge length of a tile.
+  /// \return Tile size in meters.
+  float64_t tile_size() const noexcept;
+
+  /// Get the radius around the vehicle in which tiles are kept.
+  /// \return Radius in meters.
+  float64_t radius() const noexcept;
+
+  /// Get the voxel grid config the tiles are aligned with.
+  /// \return Voxel grid config of the ndt map.
+  const MapConfig & map_config() const noexcept;
+
+private:
+  MapConfig m_map_config;
+  float64_t m_tile_size;
+  float64_t m_radius;
+};
+
+/// Get the name of the pcd file of a tile.
+/// \param directory Directory of the tiled map.
+/// \param tile Index of the tile.
+/// \return Path of the tile's pcd file.
+std::string NDT_NODES_PUBLIC tile_file_name(
+  const std::string & directory,
+  const TileIndex & tile);
+
+/// Split a pcd map into tiles and write every non-empty tile into its own pcd file in the
+/// given directory, which has to exist. An index file listing the tiles and the tiling
+/// parameters is written alongside. Throws if a file cannot be read or written.
+/// \param pcd_file_name Name of the pcd file of the complete map.
+/// \param directory Directory to write the tiles to.
+/// \param tiles Tiling of the map.
+/// \return Number of written tiles.
+std::size_t NDT_NODES_PUBLIC write_map_tiles(
+  const std::string & pcd_file_name,
+  const std::string & directory,
+  const MapTiles & tiles);
+
+/// Check whether a directory contains a tiled map, i.e. has a tile index file.
+/// \param directory Directory of the tiled map.
+/// \return True if the tile index file exists.
+bool8_t NDT_NODES_PUBLIC has_map_tiles(const std::string & directory);
+
+/// Read the tile index file of a tiled map.
+/// \param directory Directory of the tiled map.
+/// \param tiles Expected tiling of the map.
+/// \return Indices of all tiles present in the directory.
+/// \throws std::runtime_error if the index file cannot be read.
+/// \throws std::domain_error if the map was split with a different tile size or origin.
+std::set<TileIndex> NDT_NODES_PUBLIC read_map_tiles(
+  const std::string & directory,
+  const MapTiles & tiles);
+
+}  // namespace ndt_nodes
+}  // namespace localization
+}  // namespace autoware
+
+#endif  // NDT_NODES__MAP_TILES_HPP_
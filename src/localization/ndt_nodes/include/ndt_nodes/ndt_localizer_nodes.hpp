@@ -25,10 +25,15 @@
 #include <optimization/newtons_method_optimizer.hpp>
 #include <optimization/line_search/more_thuente_line_search.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <experimental/optional>
+#include <chrono>
 #include <utility>
 #include <string>
 #include <memory>
 #include <limits>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
 
 using autoware::common::types::float32_t;
 using autoware::common::types::float64_t;
@@ -47,6 +52,8 @@ using Optimizer_ =
 using PoseInitializer_ = localization_common::BestEffortInitializer;
 
 /// P2D NDT localizer node. Currently uses the hard coded optimizer and pose initializers.
+/// The localizer registers the incoming scans through a P2DNDTScanView, which references the
+/// points of the message instead of copying them.
 /// \tparam OptimizerT Hard coded for Newton optimizer. TODO(yunus.caliskan): Make Configurable
 /// \tparam PoseInitializerT Hard coded for Best effort. TODO(yunus.caliskan): Make Configurable
 template<typename OptimizerT = Optimizer_, typename PoseInitializerT = PoseInitializer_>
@@ -54,11 +61,11 @@ class NDT_NODES_PUBLIC P2DNDTLocalizerNode
   : public localization_nodes::RelativeLocalizerNode<
     sensor_msgs::msg::PointCloud2,
     sensor_msgs::msg::PointCloud2,
-    ndt::P2DNDTLocalizer<OptimizerT>,
+    ndt::P2DNDTLocalizer<OptimizerT, ndt::StaticNDTMap, ndt::P2DNDTScanView>,
     PoseInitializerT>
 {
 public:
-  using Localizer = ndt::P2DNDTLocalizer<OptimizerT>;
+  using Localizer = ndt::P2DNDTLocalizer<OptimizerT, ndt::StaticNDTMap, ndt::P2DNDTScanView>;
   using RegistrationSummary = typename Localizer::RegistrationSummary;
   using LocalizerBasePtr = std::unique_ptr<localization_common::RelativeLocalizerBase<
         sensor_msgs::msg::PointCloud2,
@@ -107,6 +114,12 @@ public:
     init();
   }
 
+  ~P2DNDTLocalizerNode() override
+  {
+    // The pipeline threads call the overrides below.
+    this->stop_pipeline();
+  }
+
 protected:
   bool validate_output(
     const RegistrationSummary & summary,
@@ -202,13 +215,48 @@ private:
         "localizer.map.min_point"), get_point_param("localizer.map.max_point"),
       get_point_param("localizer.map.voxel_size"), capacity};
 
+    // Optional coarse-to-fine registration, voxel size multiples of the map given from the finest
+    // coarse map up. Checked before the cast so that negative or huge values can not wrap around
+    const auto scale_params =
+      this->declare_parameter("localizer.map.pyramid_scales", std::vector<int64_t>{});
+    std::vector<uint32_t> pyramid_scales;
+    for (auto it = scale_params.rbegin(); it != scale_params.rend(); ++it) {
+      if ((*it <= 1) || (*it > static_cast<int64_t>(std::numeric_limits<uint32_t>::max()))) {
+        throw std::domain_error("localizer.map.pyramid_scales: every scale must be larger than 1");
+      }
+      if ((it != scale_params.rbegin()) && (*it >= *std::prev(it))) {
+        throw std::domain_error("localizer.map.pyramid_scales: scales must be strictly increasing");
+      }
+      // The config is ordered from coarse to fine
+      pyramid_scales.push_back(static_cast<uint32_t>(*it));
+    }
+
+    const auto scan_capacity = static_cast<uint32_t>(
+      this->declare_parameter("localizer.scan.capacity").template get<uint32_t>());
+    // Optional voxel grid downsampling of the scans, disabled by a non-positive voxel size
+    std::experimental::optional<perception::filters::voxel_grid::Config> scan_downsampling_config;
+    const auto downsampling_voxel_size = static_cast<float32_t>(this->declare_parameter(
+        "localizer.scan.downsampling.voxel_size", 0.0));
+    if (downsampling_voxel_size > 0.0F) {
+      perception::filters::voxel_grid::PointXYZ voxel_size;
+      voxel_size.x = downsampling_voxel_size;
+      voxel_size.y = downsampling_voxel_size;
+      voxel_size.z = downsampling_voxel_size;
+      scan_downsampling_config = perception::filters::voxel_grid::Config{
+        get_point_param("localizer.scan.downsampling.min_point"),
+        get_point_param("localizer.scan.downsampling.max_point"), voxel_size, scan_capacity};
+    }
+
     // Fetch localizer configuration
     ndt::P2DNDTLocalizerConfig localizer_config{
       map_config,
-      static_cast<uint32_t>(this->declare_parameter("localizer.scan.capacity").
-      template get<uint32_t>()),
+      scan_capacity,
       std::chrono::milliseconds(static_cast<uint64_t>(
-          this->declare_parameter("localizer.guess_time_tolerance_ms").template get<uint64_t>()))
+          this->declare_parameter("localizer.guess_time_tolerance_ms").template get<uint64_t>())),
+      static_cast<std::size_t>(
+        this->declare_parameter("localizer.optimization.num_threads").template get<uint64_t>()),
+      pyramid_scales,
+      scan_downsampling_config
     };
 
     const auto outlier_ratio{this->declare_parameter(
@@ -231,7 +279,7 @@ private:
         "localizer.optimizer.line_search.step_min").
       template get<float64_t>())};
     // TODO(igor): make the line search configurable.
-    LocalizerBasePtr localizer_ptr = std::make_unique<Localizer>(
+    auto localizer = std::make_unique<Localizer>(
       localizer_config,
       OptimizerT{
             common::optimization::MoreThuenteLineSearch{
@@ -240,11 +288,41 @@ private:
             optimizer_options
           },
       outlier_ratio);
+    m_localizer = localizer.get();
+    LocalizerBasePtr localizer_ptr{std::move(localizer)};
     this->set_localizer(std::move(localizer_ptr));
   }
 
+  /// Report the iterations, the time and the map voxel cache hit rate of each level of the
+  /// registration.
+  void handle_registration_summary(const RegistrationSummary & summary) override
+  {
+    for (const auto & level : summary.level_summaries()) {
+      RCLCPP_DEBUG(this->get_logger(), "Registration at voxel size scale %u: %lu iterations "
+        "in %ld µs, voxel cache hit rate %.3f.", level.scale,
+        level.optimization_summary.number_of_iterations_made(),
+        static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+          level.duration).count()), level.cell_cache_statistics.hit_rate());
+    }
+  }
+
+  /// Report how much of the map changed with the last map message and how long it took.
+  void on_map_set() override
+  {
+    const auto & summary = m_localizer->map_update_summary();
+    RCLCPP_DEBUG(this->get_logger(), "Map updated in %ld µs: %zu inserted, %zu updated, "
+      "%zu removed and %zu unchanged voxels. Coarse maps updated in %ld µs.",
+      static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        summary.duration).count()),
+      summary.num_inserted, summary.num_updated, summary.num_removed, summary.num_unchanged,
+      static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        summary.coarse_maps_duration).count()));
+  }
+
   ndt::Real m_predict_translation_threshold;
   ndt::Real m_predict_rotation_threshold;
+  // Non-owning, the localizer is owned by the parent node.
+  const Localizer * m_localizer{nullptr};
 };
 }  // namespace ndt_nodes
 }  // namespace localization
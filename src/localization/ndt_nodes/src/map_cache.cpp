@@ -0,0 +1,183 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <ndt_nodes/map_cache.hpp>
+#include <lidar_utils/point_cloud_utils.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using autoware::common::types::bool8_t;
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt_nodes
+{
+namespace
+{
+constexpr char MAGIC[8U] = {'N', 'D', 'T', 'M', 'A', 'P', '\0', '\0'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304U;
+static_assert(sizeof(MapCacheHeader) == 88U, "Map cache header layout changed, bump the version");
+
+using Config = perception::filters::voxel_grid::Config;
+
+/// Read-only memory mapping of a file, unmapped on destruction
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string & file_name)
+  {
+    const auto fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Map cache file not found.");
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+      close(fd);
+      throw std::runtime_error("Map cache file cannot be read.");
+    }
+    m_size = static_cast<std::size_t>(file_stat.st_size);
+    if (m_size > 0U) {
+      m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping stays valid after the file is closed
+    close(fd);
+    if (MAP_FAILED == m_data) {
+      throw std::runtime_error("Map cache file cannot be mapped.");
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  ~MappedFile()
+  {
+    if ((nullptr != m_data) && (MAP_FAILED != m_data)) {
+      munmap(m_data, m_size);
+    }
+  }
+
+  const uint8_t * data() const noexcept
+  {
+    return static_cast<const uint8_t *>(m_data);
+  }
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+private:
+  void * m_data{nullptr};
+  std::size_t m_size{0U};
+};
+
+void copy_point(const perception::filters::voxel_grid::PointXYZ & pt, float32_t (& out)[3U])
+{
+  out[0U] = pt.x;
+  out[1U] = pt.y;
+  out[2U] = pt.z;
+}
+
+bool8_t equal(const perception::filters::voxel_grid::PointXYZ & pt, const float32_t (& arr)[3U])
+{
+  // The cache is only valid for exactly the same grid, hence no tolerance
+  return (pt.x == arr[0U]) && (pt.y == arr[1U]) && (pt.z == arr[2U]);
+}
+}  // namespace
+
+void write_map_cache(
+  const std::string & file_name,
+  const Config & config,
+  const sensor_msgs::msg::PointCloud2 & msg)
+{
+  MapCacheHeader header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = MAP_CACHE_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.point_step = msg.point_step;
+  header.num_voxels = static_cast<uint64_t>(msg.width) * static_cast<uint64_t>(msg.height);
+  header.capacity = static_cast<uint64_t>(config.get_capacity());
+  copy_point(config.get_min_point(), header.min_point);
+  copy_point(config.get_max_point(), header.max_point);
+  copy_point(config.get_voxel_size(), header.voxel_size);
+
+  const auto data_size = static_cast<std::size_t>(header.num_voxels * header.point_step);
+  if (msg.data.size() < data_size) {
+    throw std::length_error("write_map_cache: point cloud data is smaller than its dimensions");
+  }
+
+  std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(msg.data.data()),
+    static_cast<std::streamsize>(data_size));
+  if (!file) {
+    throw std::runtime_error("Could not write map cache file.");
+  }
+}
+
+void read_map_cache(
+  const std::string & file_name,
+  const Config & config,
+  sensor_msgs::msg::PointCloud2 & msg)
+{
+  const MappedFile file{file_name};
+  if (file.size() < sizeof(MapCacheHeader)) {
+    throw std::runtime_error("Map cache file is too small.");
+  }
+  MapCacheHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("Not a map cache file.");
+  }
+  if (header.byte_order != BYTE_ORDER_MARK) {
+    throw std::runtime_error("Map cache file was written with another byte order.");
+  }
+  if (header.version != MAP_CACHE_VERSION) {
+    throw std::runtime_error("Map cache file has version " + std::to_string(header.version) +
+            ", expected " + std::to_string(MAP_CACHE_VERSION) + ". Regenerate the cache.");
+  }
+  if (header.point_step != msg.point_step) {
+    throw std::runtime_error("Map cache file has another voxel layout than the message.");
+  }
+  const auto data_size = header.num_voxels * header.point_step;
+  if ((file.size() - sizeof(MapCacheHeader)) != data_size) {
+    throw std::runtime_error("Map cache file is truncated or corrupted.");
+  }
+  if (!equal(config.get_min_point(), header.min_point) ||
+    !equal(config.get_max_point(), header.max_point) ||
+    !equal(config.get_voxel_size(), header.voxel_size) ||
+    (static_cast<uint64_t>(config.get_capacity()) != header.capacity))
+  {
+    throw std::domain_error("Map cache file was created with another voxel grid config.");
+  }
+
+  common::lidar_utils::resize_pcl_msg(msg, static_cast<std::size_t>(header.num_voxels));
+  std::memcpy(msg.data.data(), file.data() + sizeof(MapCacheHeader),
+    static_cast<std::size_t>(data_size));
+}
+
+}  // namespace ndt_nodes
+}  // namespace localization
+}  // namespace autoware
@@ -0,0 +1,107 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+// Standalone tool to transform a pcd map into an ndt map once and store the result in a binary
+// map cache file, which the map publisher can load instead of the pcd file. The voxel grid config
+// is read from the map publisher's parameter file, so that the cache matches the publisher.
+//
+// Usage: ndt_map_cache_tool <map pcd file> <map publisher parameter file> <output cache file>
+
+#include <common/types.hpp>
+#include <lidar_utils/point_cloud_utils.hpp>
+#include <ndt/ndt_map.hpp>
+#include <ndt_nodes/map_cache.hpp>
+#include <ndt_nodes/map_publisher.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using autoware::common::types::float32_t;
+using autoware::localization::ndt::DynamicNDTMap;
+using autoware::localization::ndt_nodes::init_ndt_map_pc;
+using autoware::localization::ndt_nodes::ndt_map_to_pc;
+using autoware::localization::ndt_nodes::read_from_pcd;
+using autoware::localization::ndt_nodes::write_map_cache;
+using autoware::perception::filters::voxel_grid::Config;
+using autoware::perception::filters::voxel_grid::PointXYZ;
+
+namespace
+{
+PointXYZ read_point(const YAML::Node & node)
+{
+  PointXYZ pt;
+  pt.x = node["x"].as<float32_t>();
+  pt.y = node["y"].as<float32_t>();
+  pt.z = node["z"].as<float32_t>();
+  return pt;
+}
+
+/// Read the voxel grid config from the first node in a ROS 2 parameter file that has one.
+Config read_map_config(const std::string & param_file_name)
+{
+  const YAML::Node params = YAML::LoadFile(param_file_name);
+  for (const auto & node_params : params) {
+    const auto map_config = node_params.second["ros__parameters"]["map_config"];
+    if (map_config) {
+      return Config{read_point(map_config["min_point"]), read_point(map_config["max_point"]),
+        read_point(map_config["voxel_size"]), map_config["capacity"].as<uint64_t>()};
+    }
+  }
+  throw std::runtime_error("Parameter file: map_config not found");
+}
+}  // namespace
+
+int32_t main(const int32_t argc, char ** const argv)
+{
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] <<
+      " <map pcd file> <map publisher parameter file> <output cache file>\n";
+    return 1;
+  }
+  const std::string pcd_file_name{argv[1]};
+  const std::string param_file_name{argv[2]};
+  const std::string cache_file_name{argv[3]};
+
+  try {
+    const auto start = std::chrono::steady_clock::now();
+    const auto config = read_map_config(param_file_name);
+
+    sensor_msgs::msg::PointCloud2 source_pc;
+    autoware::common::lidar_utils::init_pcl_msg(source_pc, "map");
+    read_from_pcd(pcd_file_name, &source_pc);
+
+    DynamicNDTMap ndt_map{config};
+    ndt_map.insert(source_pc);
+
+    sensor_msgs::msg::PointCloud2 map_pc;
+    init_ndt_map_pc(map_pc, "map", config.get_capacity());
+    ndt_map_to_pc(ndt_map, map_pc);
+    write_map_cache(cache_file_name, config, map_pc);
+
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+    std::cout << "Wrote " << map_pc.width << " voxels to " << cache_file_name << " in " <<
+      duration.count() << " ms\n";
+  } catch (const std::exception & e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -17,6 +17,7 @@
 #include <common/types.hpp>
 #include <GeographicLib/Geocentric.hpp>
 #include <lidar_utils/point_cloud_utils.hpp>
+#include <ndt_nodes/map_cache.hpp>
 #include <ndt_nodes/map_publisher.hpp>
 #include <pcl/io/pcd_io.h>
 #include <rclcpp_components/register_node_macro.hpp>
@@ -24,8 +25,11 @@
 #include <tf2/LinearMath/Quaternion.h>
 #include <yaml-cpp/yaml.h>
 
+#include <chrono>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 using autoware::common::types::bool8_t;
 using autoware::common::types::float32_t;
@@ -37,6 +41,106 @@ namespace localization
 {
 namespace ndt_nodes
 {
+namespace
+{
+/// Get the inverse covariance of a voxel. Returns false if the covariance is not invertible.
+bool8_t get_inverse_covariance(const ndt::DynamicNDTVoxel & vx, Eigen::Matrix3d & inv_covariance)
+{
+  const auto inv_covariance_opt = vx.inverse_covariance();
+  if (!inv_covariance_opt) {
+    return false;
+  }
+  inv_covariance = inv_covariance_opt.value();
+  return true;
+}
+
+/// Get the inverse covariance of a voxel. Static voxels are only created with an inverse.
+bool8_t get_inverse_covariance(const ndt::StaticNDTVoxel & vx, Eigen::Matrix3d & inv_covariance)
+{
+  inv_covariance = vx.inverse_covariance();
+  return true;
+}
+
+/// Serialize the usable voxels of an ndt map into a message initialized by init_ndt_map_pc().
+template<typename MapT>
+void write_ndt_map_pc(const MapT & map, sensor_msgs::msg::PointCloud2 & msg)
+{
+  auto dummy_idx = 0U;  // TODO(yunus.caliskan): Change in #102
+  common::lidar_utils::reset_pcl_msg(msg, 0U, dummy_idx);
+  common::lidar_utils::resize_pcl_msg(msg, map.size());
+
+  // TODO(yunus.caliskan): Make prettier -> #102
+  sensor_msgs::PointCloud2Iterator<ndt::Real> x_it(msg, "x");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> y_it(msg, "y");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> z_it(msg, "z");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xx_it(msg, "icov_xx");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xy_it(msg, "icov_xy");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xz_it(msg, "icov_xz");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_yy_it(msg, "icov_yy");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_yz_it(msg, "icov_yz");
+  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_zz_it(msg, "icov_zz");
+  sensor_msgs::PointCloud2Iterator<uint32_t> cell_id_it(msg, "cell_id");
+
+  auto num_used_cells = 0U;
+  Eigen::Matrix3d inv_covariance;
+  for (const auto & vx_it : map) {
+    if (!  // No `==` operator defined for PointCloud2Iterators
+      (y_it != y_it.end() &&
+      z_it != z_it.end() &&
+      icov_xx_it != icov_xx_it.end() &&
+      icov_xy_it != icov_xy_it.end() &&
+      icov_xz_it != icov_xz_it.end() &&
+      icov_yy_it != icov_yy_it.end() &&
+      icov_yz_it != icov_yz_it.end() &&
+      icov_zz_it != icov_zz_it.end() &&
+      cell_id_it != cell_id_it.end()))
+    {
+      // This should not occur as the cloud is resized to the map's size.
+      throw std::length_error("NDTMapPublisherNode: NDT map is larger than the map point cloud.");
+    }
+    const auto & vx = vx_it.second;
+    if (!vx.usable()) {
+      // Voxel doesn't have enough points to be used in NDT
+      continue;
+    }
+
+    if (!get_inverse_covariance(vx, inv_covariance)) {
+      // Voxel covariance is not invertible
+      continue;
+    }
+
+    const auto & centroid = vx.centroid();
+    *(x_it) = centroid(0U);
+    *(y_it) = centroid(1U);
+    *(z_it) = centroid(2U);
+    *(icov_xx_it) = inv_covariance(0U, 0U);
+    *(icov_xy_it) = inv_covariance(0U, 1U);
+    *(icov_xz_it) = inv_covariance(0U, 2U);
+    *(icov_yy_it) = inv_covariance(1U, 1U);
+    *(icov_yz_it) = inv_covariance(1U, 2U);
+    *(icov_zz_it) = inv_covariance(2U, 2U);
+
+    // There are cases where the centroid of a voxel does get indexed to another voxel. To prevent
+    // ID mismatches while transferring the map. The index from the voxel grid config is used.
+    const auto correct_idx = map.config().index(centroid);
+
+    std::memcpy(&cell_id_it[0U], &(correct_idx), sizeof(correct_idx));
+    ++x_it;
+    ++y_it;
+    ++z_it;
+    ++icov_xx_it;
+    ++icov_xy_it;
+    ++icov_xz_it;
+    ++icov_yy_it;
+    ++icov_yz_it;
+    ++icov_zz_it;
+    ++cell_id_it;
+    ++num_used_cells;
+  }
+  // Resize to throw out unused cells.
+  common::lidar_utils::resize_pcl_msg(msg, num_used_cells);
+}
+}  // namespace
 
 void read_from_yaml(
   const std::string & yaml_file_name,
@@ -94,13 +198,36 @@ void read_from_pcd(const std::string & file_name, sensor_msgs::msg::PointCloud2
   }
 }
 
+void init_ndt_map_pc(
+  sensor_msgs::msg::PointCloud2 & msg, const std::string & frame_id,
+  const std::size_t capacity)
+{
+  common::lidar_utils::init_pcl_msg(msg, frame_id, capacity, 10U,
+    "x", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "y", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "z", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xx", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xy", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_xz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_yy", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_yz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "icov_zz", 1U, sensor_msgs::msg::PointField::FLOAT64,
+    "cell_id", 2U, sensor_msgs::msg::PointField::UINT32);
+}
+
+void ndt_map_to_pc(const ndt::DynamicNDTMap & map, sensor_msgs::msg::PointCloud2 & msg)
+{
+  write_ndt_map_pc(map, msg);
+}
+
 NDTMapPublisherNode::NDTMapPublisherNode(
   const rclcpp::NodeOptions & node_options
 )
 : Node("ndt_map_publisher_node", node_options),
   m_pcl_file_name(declare_parameter("map_pcd_file").get<std::string>()),
   m_yaml_file_name(declare_parameter("map_yaml_file").get<std::string>()),
-  m_viz_map(declare_parameter("viz_map", false))
+  m_viz_map(declare_parameter("viz_map", false)),
+  m_map_cache_file_name(declare_parameter("map_cache_file", std::string{}))
 {
   using PointXYZ = perception::filters::voxel_grid::PointXYZ;
   PointXYZ min_point;
@@ -131,6 +258,14 @@ NDTMapPublisherNode::NDTMapPublisherNode(
   const std::string viz_map_topic = "viz_ndt_map";
 
   m_map_config_ptr = std::make_unique<MapConfig>(min_point, max_point, voxel_size, capacity);
+  if (declare_parameter("tiles.enabled", false)) {
+    m_tile_directory = declare_parameter("tiles.directory").get<std::string>();
+    const auto tile_size = declare_parameter("tiles.size").get<float64_t>();
+    const auto radius = declare_parameter("tiles.radius").get<float64_t>();
+    m_tiles_ptr = std::make_unique<MapTiles>(*m_map_config_ptr, tile_size, radius);
+    m_initial_x = declare_parameter("tiles.initial_position.x", 0.0);
+    m_initial_y = declare_parameter("tiles.initial_position.y", 0.0);
+  }
   init(map_frame, map_topic, viz_map_topic);
 }
 
@@ -140,19 +275,12 @@ void NDTMapPublisherNode::init(
   const std::string & viz_map_topic)
 {
   m_ndt_map_ptr = std::make_unique<ndt::DynamicNDTMap>(*m_map_config_ptr);
+  if (m_tiles_ptr) {
+    m_tiled_map_ptr = std::make_unique<ndt::StaticNDTMap>(*m_map_config_ptr);
+  }
 
   common::lidar_utils::init_pcl_msg(m_source_pc, map_frame);
-  common::lidar_utils::init_pcl_msg(m_map_pc, map_frame, m_map_config_ptr->get_capacity(), 10U,
-    "x", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "y", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "z", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_xx", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_xy", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_xz", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_yy", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_yz", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "icov_zz", 1U, sensor_msgs::msg::PointField::FLOAT64,
-    "cell_id", 2U, sensor_msgs::msg::PointField::UINT32);
+  init_ndt_map_pc(m_map_pc, map_frame, m_map_config_ptr->get_capacity());
 
   m_pub = create_publisher<sensor_msgs::msg::PointCloud2>(map_topic,
       rclcpp::QoS(rclcpp::KeepLast(5U)).transient_local());
@@ -195,7 +323,11 @@ void NDTMapPublisherNode::init(
 
 void NDTMapPublisherNode::run()
 {
-  load_map();
+  if (m_tiles_ptr) {
+    load_tiled_map();
+  } else {
+    load_map();
+  }
   publish();
 }
 
@@ -204,12 +336,19 @@ void NDTMapPublisherNode::load_map()
   reset_pc_msg(m_map_pc);  // TODO(yunus.caliskan): Change in #102
   reset_pc_msg(m_source_pc);  // TODO(yunus.caliskan): Change in #102
 
-  geocentric_pose_t geo_pose{0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-
-  if (!m_yaml_file_name.empty()) {
-    read_from_yaml(m_yaml_file_name, &geo_pose);
-  } else {
-    throw std::runtime_error("YAML file name empty\n");
+  load_map_origin();
+
+  if (!m_map_cache_file_name.empty()) {
+    // The cache holds the finished map, the pcd file is only needed for the visualization
+    const auto start = std::chrono::steady_clock::now();
+    read_map_cache(m_map_cache_file_name, *m_map_config_ptr, m_map_pc);
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+    RCLCPP_INFO(get_logger(), "Loaded %u voxels from the map cache in %ld ms.", m_map_pc.width,
+      static_cast<int64_t>(duration.count()));
+    if (!m_viz_map) {
+      return;
+    }
   }
 
   if (!m_pcl_file_name.empty()) {
@@ -218,6 +357,27 @@ void NDTMapPublisherNode::load_map()
     throw std::runtime_error("PCD file name empty\n");
   }
 
+  if (m_map_cache_file_name.empty()) {
+    m_ndt_map_ptr->insert(m_source_pc);
+    write_ndt_map_pc(*m_ndt_map_ptr, m_map_pc);
+  }
+
+  if (m_viz_map) {
+    reset_pc_msg(m_downsampled_pc);
+    downsample_pc();
+  }
+}
+
+void NDTMapPublisherNode::load_map_origin()
+{
+  geocentric_pose_t geo_pose{0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+  if (!m_yaml_file_name.empty()) {
+    read_from_yaml(m_yaml_file_name, &geo_pose);
+  } else {
+    throw std::runtime_error("YAML file name empty\n");
+  }
+
   float64_t x(0.0), y(0.0), z(0.0);
 
   GeographicLib::Geocentric earth(
@@ -231,13 +391,99 @@ void NDTMapPublisherNode::load_map()
     x, y, z);
   publish_earth_to_map_transform(x, y, z,
     geo_pose.roll, geo_pose.pitch, geo_pose.yaw);
+}
+
+void NDTMapPublisherNode::load_tiled_map()
+{
+  reset_pc_msg(m_map_pc);  // TODO(yunus.caliskan): Change in #102
 
-  m_ndt_map_ptr->insert(m_source_pc);
-  map_to_pc();
+  load_map_origin();
+
+  if (!has_map_tiles(m_tile_directory)) {
+    if (m_pcl_file_name.empty()) {
+      throw std::runtime_error("PCD file name empty\n");
+    }
+    const auto num_tiles = write_map_tiles(m_pcl_file_name, m_tile_directory, *m_tiles_ptr);
+    RCLCPP_INFO(get_logger(), "Split the map into %zu tiles.", num_tiles);
+  }
+  m_available_tiles = read_map_tiles(m_tile_directory, *m_tiles_ptr);
+  m_loaded_tiles.clear();
+  m_tiled_map_ptr->clear();
 
   if (m_viz_map) {
-    reset_pc_msg(m_downsampled_pc);
-    downsample_pc();
+    RCLCPP_WARN(get_logger(), "Map visualization is not supported for tiled maps.");
+  }
+
+  m_current_tile = m_tiles_ptr->tile(m_initial_x, m_initial_y);
+  update_tiles(m_initial_x, m_initial_y);
+
+  if (!m_pose_sub) {
+    m_pose_sub = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>("ndt_pose",
+        rclcpp::QoS(rclcpp::KeepLast(1U)),
+        [this](const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg) {
+          on_pose(msg);
+        });
+  }
+}
+
+void NDTMapPublisherNode::update_tiles(const float64_t x, const float64_t y)
+{
+  const auto tiles = m_tiles_ptr->tiles_in_radius(x, y);
+  const std::set<TileIndex> tiles_in_radius{tiles.begin(), tiles.end()};
+
+  std::set<TileIndex> evicted_tiles;
+  for (const auto & tile : m_loaded_tiles) {
+    if (tiles_in_radius.find(tile) == tiles_in_radius.end()) {
+      evicted_tiles.insert(tile);
+    }
+  }
+  if (!evicted_tiles.empty()) {
+    m_tiled_map_ptr->erase_if([this, &evicted_tiles](uint64_t voxel_index) {
+        return evicted_tiles.find(m_tiles_ptr->tile(voxel_index)) != evicted_tiles.end();
+      });
+    for (const auto & tile : evicted_tiles) {
+      m_loaded_tiles.erase(tile);
+    }
+  }
+
+  for (const auto & tile : tiles) {
+    if ((m_available_tiles.find(tile) == m_available_tiles.end()) ||
+      (m_loaded_tiles.find(tile) != m_loaded_tiles.end()))
+    {
+      continue;
+    }
+    // Every tile is transformed on its own. Voxels do not span tiles, so the result is the same
+    // as for the complete map.
+    reset_pc_msg(m_source_pc);  // TODO(yunus.caliskan): Change in #102
+    read_from_pcd(tile_file_name(m_tile_directory, tile), &m_source_pc);
+    m_ndt_map_ptr->clear();
+    m_ndt_map_ptr->insert(m_source_pc);
+    write_ndt_map_pc(*m_ndt_map_ptr, m_map_pc);
+    if (m_map_pc.width > 0U) {
+      m_tiled_map_ptr->insert(m_map_pc);
+    }
+    m_loaded_tiles.insert(tile);
+  }
+  m_ndt_map_ptr->clear();
+
+  write_ndt_map_pc(*m_tiled_map_ptr, m_map_pc);
+}
+
+void NDTMapPublisherNode::on_pose(
+  const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg)
+{
+  const auto x = msg->pose.pose.position.x;
+  const auto y = msg->pose.pose.position.y;
+  const auto tile = m_tiles_ptr->tile(x, y);
+  if (tile == m_current_tile) {
+    return;
+  }
+  m_current_tile = tile;
+  try {
+    update_tiles(x, y);
+    publish();
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(get_logger(), e.what());
   }
 }
 
@@ -259,84 +505,6 @@ void NDTMapPublisherNode::publish_earth_to_map_transform(
   m_earth_map_broadcaster->sendTransform(tf);
 }
 
-void NDTMapPublisherNode::map_to_pc()
-{
-  reset_pc_msg(m_map_pc);
-  common::lidar_utils::resize_pcl_msg(m_map_pc, m_ndt_map_ptr->size());
-
-  // TODO(yunus.caliskan): Make prettier -> #102
-  sensor_msgs::PointCloud2Iterator<ndt::Real> x_it(m_map_pc, "x");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> y_it(m_map_pc, "y");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> z_it(m_map_pc, "z");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xx_it(m_map_pc, "icov_xx");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xy_it(m_map_pc, "icov_xy");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_xz_it(m_map_pc, "icov_xz");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_yy_it(m_map_pc, "icov_yy");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_yz_it(m_map_pc, "icov_yz");
-  sensor_msgs::PointCloud2Iterator<ndt::Real> icov_zz_it(m_map_pc, "icov_zz");
-  sensor_msgs::PointCloud2Iterator<uint32_t> cell_id_it(m_map_pc, "cell_id");
-
-  auto num_used_cells = 0U;
-  for (const auto & vx_it : *m_ndt_map_ptr) {
-    if (!  // No `==` operator defined for PointCloud2Iterators
-      (y_it != y_it.end() &&
-      z_it != z_it.end() &&
-      icov_xx_it != icov_xx_it.end() &&
-      icov_xy_it != icov_xy_it.end() &&
-      icov_xz_it != icov_xz_it.end() &&
-      icov_yy_it != icov_yy_it.end() &&
-      icov_yz_it != icov_yz_it.end() &&
-      icov_zz_it != icov_zz_it.end() &&
-      cell_id_it != cell_id_it.end()))
-    {
-      // This should not occur as the cloud is resized to the map's size.
-      throw std::length_error("NDTMapPublisherNode: NDT map is larger than the map point cloud.");
-    }
-    const auto & vx = vx_it.second;
-    if (!vx.usable()) {
-      // Voxel doesn't have enough points to be used in NDT
-      continue;
-    }
-
-    const auto inv_covariance_opt = vx.inverse_covariance();
-    if (!inv_covariance_opt) {
-      // Voxel covariance is not invertible
-      continue;
-    }
-
-    const auto & centroid = vx.centroid();
-    const auto & inv_covariance = inv_covariance_opt.value();
-    *(x_it) = centroid(0U);
-    *(y_it) = centroid(1U);
-    *(z_it) = centroid(2U);
-    *(icov_xx_it) = inv_covariance(0U, 0U);
-    *(icov_xy_it) = inv_covariance(0U, 1U);
-    *(icov_xz_it) = inv_covariance(0U, 2U);
-    *(icov_yy_it) = inv_covariance(1U, 1U);
-    *(icov_yz_it) = inv_covariance(1U, 2U);
-    *(icov_zz_it) = inv_covariance(2U, 2U);
-
-    // There are cases where the centroid of a voxel does get indexed to another voxel. To prevent
-    // ID mismatches while transferring the map. The index from the voxel grid config is used.
-    const auto correct_idx = m_map_config_ptr->index(centroid);
-
-    std::memcpy(&cell_id_it[0U], &(correct_idx), sizeof(correct_idx));
-    ++x_it;
-    ++y_it;
-    ++z_it;
-    ++icov_xx_it;
-    ++icov_xy_it;
-    ++icov_xz_it;
-    ++icov_yy_it;
-    ++icov_yz_it;
-    ++icov_zz_it;
-    ++cell_id_it;
-    ++num_used_cells;
-  }
-  // Resize to throw out unused cells.
-  common::lidar_utils::resize_pcl_msg(m_map_pc, num_used_cells);
-}
-
 void NDTMapPublisherNode::downsample_pc()
 {
   common::lidar_utils::resize_pcl_msg(m_downsampled_pc, m_source_pc.data.size());
@@ -372,6 +540,10 @@ void NDTMapPublisherNode::reset()
   }
 
   m_ndt_map_ptr->clear();
+  if (m_tiled_map_ptr) {
+    m_tiled_map_ptr->clear();
+    m_loaded_tiles.clear();
+  }
 }
 
 void NDTMapPublisherNode::reset_pc_msg(sensor_msgs::msg::PointCloud2 & msg)
@@ -0,0 +1,211 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <ndt_nodes/map_tiles.hpp>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autoware
+{
+namespace localization
+{
+namespace ndt_nodes
+{
+namespace
+{
+constexpr auto TILE_INDEX_FILE_NAME = "tiles.yaml";
+// Tolerance when comparing lengths that are read from parameters or files, in meters
+constexpr float64_t LENGTH_TOLERANCE = 1.0e-6;
+
+bool8_t is_multiple(const float64_t length, const float64_t unit)
+{
+  const auto ratio = length / unit;
+  return (std::round(ratio) >= 1.0) && (std::fabs(ratio - std::round(ratio)) < LENGTH_TOLERANCE);
+}
+
+std::string index_file_name(const std::string & directory)
+{
+  return directory + "/" + TILE_INDEX_FILE_NAME;
+}
+}  // namespace
+
+MapTiles::MapTiles(
+  const MapConfig & map_config, const float64_t tile_size,
+  const float64_t radius)
+: m_map_config{map_config}, m_tile_size{tile_size}, m_radius{radius}
+{
+  const auto & voxel_size = m_map_config.get_voxel_size();
+  if (!is_multiple(m_tile_size, static_cast<float64_t>(voxel_size.x)) ||
+    !is_multiple(m_tile_size, static_cast<float64_t>(voxel_size.y)))
+  {
+    throw std::domain_error("MapTiles: tile size has to be a positive multiple of the voxel size");
+  }
+  if (m_radius < 0.0) {
+    throw std::domain_error("MapTiles: radius cannot be negative");
+  }
+}
+
+TileIndex MapTiles::tile(const float64_t x, const float64_t y) const
+{
+  const auto & min_point = m_map_config.get_min_point();
+  return TileIndex{
+    static_cast<int64_t>(std::floor((x - static_cast<float64_t>(min_point.x)) / m_tile_size)),
+    static_cast<int64_t>(std::floor((y - static_cast<float64_t>(min_point.y)) / m_tile_size))};
+}
+
+TileIndex MapTiles::tile(const uint64_t voxel_index) const
+{
+  // The voxel center is half a voxel away from any tile border, so there is no ambiguity
+  const auto center =
+    m_map_config.centroid<perception::filters::voxel_grid::PointXYZ>(voxel_index);
+  return tile(static_cast<float64_t>(center.x), static_cast<float64_t>(center.y));
+}
+
+std::vector<TileIndex> MapTiles::tiles_in_radius(const float64_t x, const float64_t y) const
+{
+  const auto & min_point = m_map_config.get_min_point();
+  const auto first = tile(x - m_radius, y - m_radius);
+  const auto last = tile(x + m_radius, y + m_radius);
+  // Distance from the location to an interval along one axis, 0 if the location is inside
+  const auto distance = [](const float64_t pos, const float64_t lower, const float64_t upper) {
+      return std::max(0.0, std::max(lower - pos, pos - upper));
+    };
+
+  std::vector<TileIndex> ret;
+  for (auto idx = first.first; idx <= last.first; ++idx) {
+    const auto lower_x = static_cast<float64_t>(min_point.x) + (static_cast<float64_t>(idx) *
+      m_tile_size);
+    const auto dx = distance(x, lower_x, lower_x + m_tile_size);
+    for (auto jdx = first.second; jdx <= last.second; ++jdx) {
+      const auto lower_y = static_cast<float64_t>(min_point.y) + (static_cast<float64_t>(jdx) *
+        m_tile_size);
+      const auto dy = distance(y, lower_y, lower_y + m_tile_size);
+      if (((dx * dx) + (dy * dy)) <= (m_radius * m_radius)) {
+        ret.emplace_back(idx, jdx);
+      }
+    }
+  }
+  return ret;
+}
+
+float64_t MapTiles::tile_size() const noexcept
+{
+  return m_tile_size;
+}
+
+float64_t MapTiles::radius() const noexcept
+{
+  return m_radius;
+}
+
+const MapTiles::MapConfig & MapTiles::map_config() const noexcept
+{
+  return m_map_config;
+}
+
+std::string tile_file_name(const std::string & directory, const TileIndex & tile)
+{
+  return directory + "/tile_" + std::to_string(tile.first) + "_" + std::to_string(tile.second) +
+         ".pcd";
+}
+
+std::size_t write_map_tiles(
+  const std::string & pcd_file_name,
+  const std::string & directory,
+  const MapTiles & tiles)
+{
+  pcl::PointCloud<pcl::PointXYZI> cloud{};
+  if (pcl::io::loadPCDFile<pcl::PointXYZI>(pcd_file_name, cloud) == -1) {
+    throw std::runtime_error("PCD file not found.");
+  }
+
+  // Points are assigned through their voxel, so that a voxel never gets split between tiles
+  std::map<TileIndex, pcl::PointCloud<pcl::PointXYZI>> tile_clouds;
+  for (const auto & pt : cloud) {
+    tile_clouds[tiles.tile(tiles.map_config().index(pt))].push_back(pt);
+  }
+
+  YAML::Emitter index;
+  index << YAML::BeginMap;
+  index << YAML::Key << "tile_size" << YAML::Value << tiles.tile_size();
+  index << YAML::Key << "origin" << YAML::Value << YAML::Flow << YAML::BeginSeq <<
+    static_cast<float64_t>(tiles.map_config().get_min_point().x) <<
+    static_cast<float64_t>(tiles.map_config().get_min_point().y) << YAML::EndSeq;
+  index << YAML::Key << "tiles" << YAML::Value << YAML::BeginSeq;
+  for (const auto & tile_cloud : tile_clouds) {
+    const auto & tile = tile_cloud.first;
+    if (pcl::io::savePCDFileBinary(tile_file_name(directory, tile), tile_cloud.second) < 0) {
+      throw std::runtime_error("Could not write map tile.");
+    }
+    index << YAML::Flow << YAML::BeginSeq << tile.first << tile.second << YAML::EndSeq;
+  }
+  index << YAML::EndSeq << YAML::EndMap;
+
+  // The index is written last: a directory with an index is complete
+  std::ofstream index_file{index_file_name(directory)};
+  index_file << index.c_str() << "\n";
+  if (!index_file) {
+    throw std::runtime_error("Could not write map tile index.");
+  }
+  return tile_clouds.size();
+}
+
+bool8_t has_map_tiles(const std::string & directory)
+{
+  return std::ifstream{index_file_name(directory)}.good();
+}
+
+std::set<TileIndex> read_map_tiles(const std::string & directory, const MapTiles & tiles)
+{
+  std::set<TileIndex> ret;
+  try {
+    const YAML::Node index = YAML::LoadFile(index_file_name(directory));
+    if (!index["tile_size"] || !index["origin"] || !index["tiles"]) {
+      throw std::runtime_error("Map tile index: tiling parameters not found\n");
+    }
+    const auto & min_point = tiles.map_config().get_min_point();
+    if ((std::fabs(index["tile_size"].as<float64_t>() - tiles.tile_size()) > LENGTH_TOLERANCE) ||
+      (std::fabs(index["origin"][0].as<float64_t>() - static_cast<float64_t>(min_point.x)) >
+      LENGTH_TOLERANCE) ||
+      (std::fabs(index["origin"][1].as<float64_t>() - static_cast<float64_t>(min_point.y)) >
+      LENGTH_TOLERANCE))
+    {
+      throw std::domain_error("Map tile index: map was split with a different tiling\n");
+    }
+    for (const auto & tile : index["tiles"]) {
+      ret.emplace(tile[0].as<int64_t>(), tile[1].as<int64_t>());
+    }
+  } catch (const YAML::BadFile & ex) {
+    throw std::runtime_error("Map tile index file not found\n");
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error("Map tile index syntax error\n");
+  }
+  return ret;
+}
+
+}  // namespace ndt_nodes
+}  // namespace localization
+}  // namespace autoware
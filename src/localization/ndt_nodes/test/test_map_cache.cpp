@@ -0,0 +1,222 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <gtest/gtest.h>
+#include <lidar_utils/point_cloud_utils.hpp>
+#include <ndt/ndt_map.hpp>
+#include <ndt_nodes/map_cache.hpp>
+#include <ndt_nodes/map_publisher.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+#include "common/types.hpp"
+
+using autoware::common::types::float32_t;
+using autoware::common::types::PointXYZIF;
+using autoware::localization::ndt::DynamicNDTMap;
+using autoware::localization::ndt::Real;
+using autoware::localization::ndt::StaticNDTMap;
+using autoware::localization::ndt_nodes::init_ndt_map_pc;
+using autoware::localization::ndt_nodes::ndt_map_to_pc;
+using autoware::localization::ndt_nodes::read_map_cache;
+using autoware::localization::ndt_nodes::write_map_cache;
+using autoware::localization::ndt_nodes::MapCacheHeader;
+using autoware::perception::filters::voxel_grid::Config;
+using autoware::perception::filters::voxel_grid::PointXYZ;
+
+namespace
+{
+PointXYZ make_point(float32_t x, float32_t y, float32_t z)
+{
+  PointXYZ pt;
+  pt.x = x;
+  pt.y = y;
+  pt.z = z;
+  return pt;
+}
+
+/// Config of a grid with voxels of size 1 whose centers are at the integers 1 to num_voxels
+Config make_config(uint32_t num_voxels_xy, uint32_t num_voxels_z)
+{
+  const auto max_xy = static_cast<float32_t>(num_voxels_xy) + 0.5F;
+  const auto max_z = static_cast<float32_t>(num_voxels_z) + 0.5F;
+  return Config{make_point(0.5F, 0.5F, 0.5F), make_point(max_xy, max_xy, max_z),
+    make_point(1.0F, 1.0F, 1.0F), static_cast<uint64_t>(num_voxels_xy * num_voxels_xy *
+    num_voxels_z)};
+}
+
+/// Point cloud with 7 points around the center of every voxel of the grid
+sensor_msgs::msg::PointCloud2 make_dense_pc(uint32_t num_voxels_xy, uint32_t num_voxels_z)
+{
+  constexpr float32_t DEVIATION = 0.3F;
+  sensor_msgs::msg::PointCloud2 msg;
+  autoware::common::lidar_utils::init_pcl_msg(msg, "map",
+    num_voxels_xy * num_voxels_xy * num_voxels_z * 7U);
+  auto pc_idx = 0U;
+  for (auto x = 1U; x <= num_voxels_xy; ++x) {
+    for (auto y = 1U; y <= num_voxels_xy; ++y) {
+      for (auto z = 1U; z <= num_voxels_z; ++z) {
+        const auto cx = static_cast<float32_t>(x);
+        const auto cy = static_cast<float32_t>(y);
+        const auto cz = static_cast<float32_t>(z);
+        // Skew the points a bit per voxel, so that the covariances differ
+        const auto skew = 0.01F * static_cast<float32_t>((x + y + z) % 7U);
+        for (const auto & pt : {PointXYZIF{cx, cy, cz},
+            PointXYZIF{cx + DEVIATION, cy + skew, cz}, PointXYZIF{cx - DEVIATION, cy, cz},
+            PointXYZIF{cx, cy + DEVIATION, cz + skew}, PointXYZIF{cx, cy - DEVIATION, cz},
+            PointXYZIF{cx + skew, cy, cz + DEVIATION}, PointXYZIF{cx, cy, cz - DEVIATION}})
+        {
+          autoware::common::lidar_utils::add_point_to_cloud(msg, pt, pc_idx);
+        }
+      }
+    }
+  }
+  autoware::common::lidar_utils::resize_pcl_msg(msg, pc_idx);
+  return msg;
+}
+}  // namespace
+
+TEST(MapCacheTest, round_trip) {
+  const auto config = make_config(5U, 5U);
+  const std::string cache_file_name = "MapCacheTest_test.ndtmap";
+
+  DynamicNDTMap dynamic_map{config};
+  dynamic_map.insert(make_dense_pc(5U, 5U));
+  sensor_msgs::msg::PointCloud2 map_pc;
+  init_ndt_map_pc(map_pc, "map", config.get_capacity());
+  ndt_map_to_pc(dynamic_map, map_pc);
+  ASSERT_EQ(map_pc.width, 125U);
+
+  write_map_cache(cache_file_name, config, map_pc);
+  ASSERT_TRUE(std::ifstream{cache_file_name}.good());
+
+  sensor_msgs::msg::PointCloud2 cached_pc;
+  init_ndt_map_pc(cached_pc, "map", config.get_capacity());
+  read_map_cache(cache_file_name, config, cached_pc);
+  EXPECT_EQ(cached_pc.width, map_pc.width);
+  EXPECT_EQ(cached_pc.height, map_pc.height);
+  EXPECT_EQ(cached_pc.data, map_pc.data);
+
+  // The cached map can be used directly
+  StaticNDTMap static_map{config};
+  static_map.insert(cached_pc);
+  EXPECT_EQ(static_map.size(), dynamic_map.size());
+  for (const auto & vx : dynamic_map) {
+    const auto & cells = static_map.cell(vx.second.centroid());
+    ASSERT_EQ(cells.size(), 1U);
+    EXPECT_EQ(cells[0U].centroid(), vx.second.centroid());
+    // Only the upper triangle of the inverse covariance is serialized
+    EXPECT_TRUE(cells[0U].inverse_covariance().isApprox(vx.second.inverse_covariance().value(),
+      std::numeric_limits<Real>::epsilon() * 1e2));
+  }
+  remove(cache_file_name.c_str());
+}
+
+TEST(MapCacheTest, bad_input) {
+  const auto config = make_config(5U, 5U);
+  const std::string cache_file_name = "MapCacheTest_bad_input.ndtmap";
+
+  DynamicNDTMap dynamic_map{config};
+  dynamic_map.insert(make_dense_pc(5U, 5U));
+  sensor_msgs::msg::PointCloud2 map_pc;
+  init_ndt_map_pc(map_pc, "map", config.get_capacity());
+  ndt_map_to_pc(dynamic_map, map_pc);
+
+  EXPECT_THROW(read_map_cache("NON_EXISTING_FILE_MapCacheTest.ndtmap", config, map_pc),
+    std::runtime_error);
+
+  // Another grid
+  write_map_cache(cache_file_name, config, map_pc);
+  EXPECT_THROW(read_map_cache(cache_file_name, make_config(6U, 5U), map_pc), std::domain_error);
+
+  // Another message layout
+  sensor_msgs::msg::PointCloud2 xyz_pc;
+  autoware::common::lidar_utils::init_pcl_msg(xyz_pc, "map", 10U);
+  EXPECT_THROW(read_map_cache(cache_file_name, config, xyz_pc), std::runtime_error);
+
+  // Truncated file
+  std::string content;
+  {
+    std::ifstream file{cache_file_name, std::ios::binary};
+    content.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+  }
+  {
+    std::ofstream file{cache_file_name, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size() - 1U));
+  }
+  EXPECT_THROW(read_map_cache(cache_file_name, config, map_pc), std::runtime_error);
+
+  // Other version
+  MapCacheHeader header;
+  std::memcpy(&header, content.data(), sizeof(header));
+  ++header.version;
+  std::memcpy(&content[0U], &header, sizeof(header));
+  {
+    std::ofstream file{cache_file_name, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+  EXPECT_THROW(read_map_cache(cache_file_name, config, map_pc), std::runtime_error);
+
+  // Not a cache file
+  content[0U] = 'X';
+  {
+    std::ofstream file{cache_file_name, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+  EXPECT_THROW(read_map_cache(cache_file_name, config, map_pc), std::runtime_error);
+  remove(cache_file_name.c_str());
+}
+
+// Compares building the serialized map from a point cloud with reading it from a map cache.
+// The pcd parsing, which comes on top of the former, is not included.
+TEST(MapCacheBenchmark, benchmark) {
+  constexpr uint32_t NUM_VOXELS_XY = 100U;
+  constexpr uint32_t NUM_VOXELS_Z = 5U;
+  const auto config = make_config(NUM_VOXELS_XY, NUM_VOXELS_Z);
+  const std::string cache_file_name = "MapCacheBenchmark_test.ndtmap";
+  const auto source_pc = make_dense_pc(NUM_VOXELS_XY, NUM_VOXELS_Z);
+
+  sensor_msgs::msg::PointCloud2 map_pc;
+  init_ndt_map_pc(map_pc, "map", config.get_capacity());
+  auto start = std::chrono::steady_clock::now();
+  DynamicNDTMap dynamic_map{config};
+  dynamic_map.insert(source_pc);
+  ndt_map_to_pc(dynamic_map, map_pc);
+  const auto build_duration = std::chrono::steady_clock::now() - start;
+  ASSERT_EQ(map_pc.width, NUM_VOXELS_XY * NUM_VOXELS_XY * NUM_VOXELS_Z);
+
+  write_map_cache(cache_file_name, config, map_pc);
+  sensor_msgs::msg::PointCloud2 cached_pc;
+  init_ndt_map_pc(cached_pc, "map", config.get_capacity());
+  start = std::chrono::steady_clock::now();
+  read_map_cache(cache_file_name, config, cached_pc);
+  const auto read_duration = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(cached_pc.data, map_pc.data);
+
+  std::cerr << "Serialized ndt map of " << map_pc.width << " voxels:\n";
+  std::cerr << "  built from point cloud: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(build_duration).count() << " µs\n";
+  std::cerr << "  read from map cache:    " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(read_duration).count() << " µs\n";
+  remove(cache_file_name.c_str());
+}
@@ -28,6 +28,10 @@
 #include "test_map_publisher.hpp"
 
 using autoware::localization::ndt_nodes::read_from_pcd;
+using autoware::localization::ndt_nodes::has_map_tiles;
+using autoware::localization::ndt_nodes::read_map_tiles;
+using autoware::localization::ndt_nodes::tile_file_name;
+using autoware::localization::ndt_nodes::MapTiles;
 using autoware::localization::ndt_nodes::geocentric_pose_t;
 using autoware::localization::ndt_nodes::NDTMapPublisherNode;
 using autoware::localization::ndt::DynamicNDTMap;
@@ -331,3 +335,141 @@ TEST_F(MapPublisherTest, viz_functionality)
   remove(pcl_file_name);
   remove(yaml_file_name.c_str());
 }
+
+TEST_F(MapPublisherTest, tiled_functionality)
+{
+  using Cloud = sensor_msgs::msg::PointCloud2;
+  using Pose = geometry_msgs::msg::PoseWithCovarianceStamped;
+  const auto grid_config = Config(m_min_point, m_max_point, m_voxel_size, m_capacity);
+
+  std::string yaml_file_name = "MapPublisherTest_test.yaml";
+  const auto pcl_file_name = "MapPublisherTest_test.pcd";
+  const auto tile_directory = ".";
+  const auto map_topic = "ndt_map";
+  const auto map_frame = "map";
+  auto callback_counter = 0U;
+  Cloud received_cloud_map;
+  const auto listener_node = rclcpp::Node::make_shared("MapPublisherTest_listener_node");
+  const auto sub =
+    listener_node->create_subscription<Cloud>(map_topic,
+      rclcpp::QoS(rclcpp::KeepLast(5U)).transient_local(),
+      [&received_cloud_map, &callback_counter](Cloud::ConstSharedPtr msg) {
+        ++callback_counter;
+        received_cloud_map = *msg;
+      });
+  const auto pose_pub = listener_node->create_publisher<Pose>("ndt_pose",
+      rclcpp::QoS(rclcpp::KeepLast(1U)));
+
+  std::string yaml_string = build_yaml_string();
+  std::ofstream yaml_fout(yaml_file_name);
+  yaml_fout << yaml_string << std::endl;
+  yaml_fout.close();
+
+  ASSERT_TRUE(std::ifstream{yaml_file_name}.good());
+  ASSERT_FALSE(has_map_tiles(tile_directory));
+
+  std::vector<rclcpp::Parameter> params;
+
+  params.emplace_back("map_pcd_file", pcl_file_name);
+  params.emplace_back("map_yaml_file", yaml_file_name);
+  params.emplace_back("map_frame", map_frame);
+
+  params.emplace_back("map_config.min_point.x",
+    static_cast<float32_t>(grid_config.get_min_point().x));
+  params.emplace_back("map_config.min_point.y",
+    static_cast<float32_t>(grid_config.get_min_point().y));
+  params.emplace_back("map_config.min_point.z",
+    static_cast<float32_t>(grid_config.get_min_point().z));
+  params.emplace_back("map_config.max_point.x",
+    static_cast<float32_t>(grid_config.get_max_point().x));
+  params.emplace_back("map_config.max_point.y",
+    static_cast<float32_t>(grid_config.get_max_point().y));
+  params.emplace_back("map_config.max_point.z",
+    static_cast<float32_t>(grid_config.get_max_point().z));
+  params.emplace_back("map_config.voxel_size.x",
+    static_cast<float32_t>(grid_config.get_voxel_size().x));
+  params.emplace_back("map_config.voxel_size.y",
+    static_cast<float32_t>(grid_config.get_voxel_size().y));
+  params.emplace_back("map_config.voxel_size.z",
+    static_cast<float32_t>(grid_config.get_voxel_size().z));
+  params.emplace_back("map_config.capacity", static_cast<int32_t>(grid_config.get_capacity()));
+
+  // Tiles of 2x2 voxels, only the tile of the vehicle is kept.
+  params.emplace_back("tiles.enabled", true);
+  params.emplace_back("tiles.directory", tile_directory);
+  params.emplace_back("tiles.size", 2.0);
+  params.emplace_back("tiles.radius", 0.0);
+  params.emplace_back("tiles.initial_position.x", 1.0);
+  params.emplace_back("tiles.initial_position.y", 1.0);
+
+  rclcpp::NodeOptions node_options;
+  node_options.parameter_overrides(params);
+
+  const auto map_publisher_ptr = std::make_shared<NDTMapPublisherNode>(node_options);
+
+  // Build a dense PC that can be transformed into 125 cells. See function for details.
+  build_pc(grid_config);
+  DynamicNDTMap dynamic_validation_map(grid_config);
+  dynamic_validation_map.insert(m_pc);
+
+  const auto pcl_source = from_pointcloud2(m_pc);
+  pcl::io::savePCDFile(pcl_file_name, pcl_source);
+  ASSERT_TRUE(std::ifstream{pcl_file_name}.good());
+
+  // Split the map into tiles and publish the tile at the initial position.
+  EXPECT_NO_THROW(map_publisher_ptr->run());
+  EXPECT_TRUE(has_map_tiles(tile_directory));
+
+  // Check that the received map has exactly the voxels with x and y within the given range
+  const auto check_received_map = [&](float64_t min_xy, float64_t max_xy) {
+      StaticNDTMap static_received_map(grid_config);
+      static_received_map.insert(received_cloud_map);
+      auto num_expected = 0U;
+      for (const auto & expected_centroid_it : m_voxel_centers) {
+        const auto & centroid = expected_centroid_it.second;
+        const auto & received_cells = static_received_map.cell(centroid);
+        if ((centroid(0U) < min_xy) || (centroid(0U) > max_xy) ||
+          (centroid(1U) < min_xy) || (centroid(1U) > max_xy))
+        {
+          EXPECT_TRUE(received_cells.empty());
+          continue;
+        }
+        ++num_expected;
+        ASSERT_EQ(received_cells.size(), 1U);
+        const auto & reference_cell = dynamic_validation_map.cell(centroid)[0U];
+        EXPECT_TRUE(received_cells[0U].centroid().isApprox(reference_cell.centroid(),
+          std::numeric_limits<Real>::epsilon()));
+        EXPECT_TRUE(received_cells[0U].inverse_covariance().isApprox(
+            reference_cell.inverse_covariance(),
+            std::numeric_limits<Real>::epsilon() * 1e2));
+      }
+      EXPECT_EQ(static_received_map.size(), num_expected);
+    };
+
+  while (callback_counter < 1U) {
+    rclcpp::spin_some(listener_node);
+  }
+  // Tile (0, 0) holds the voxel centers 1 and 2 along x and y.
+  check_received_map(1.0, 2.0);
+
+  // Move to tile (1, 1), its voxels replace the ones of tile (0, 0).
+  Pose pose;
+  pose.header.frame_id = map_frame;
+  pose.pose.pose.position.x = 4.0;
+  pose.pose.pose.position.y = 4.0;
+  while (callback_counter < 2U) {
+    pose_pub->publish(pose);
+    rclcpp::spin_some(map_publisher_ptr);
+    rclcpp::spin_some(listener_node);
+  }
+  check_received_map(3.0, 4.0);
+
+  const auto tiles = read_map_tiles(tile_directory, MapTiles{grid_config, 2.0, 0.0});
+  EXPECT_EQ(tiles.size(), 9U);
+  for (const auto & tile : tiles) {
+    remove(tile_file_name(tile_directory, tile).c_str());
+  }
+  remove("./tiles.yaml");
+  remove(pcl_file_name);
+  remove(yaml_file_name.c_str());
+}
@@ -0,0 +1,147 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <gtest/gtest.h>
+#include <ndt_nodes/map_tiles.hpp>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/types.hpp"
+
+using autoware::common::types::float32_t;
+using autoware::localization::ndt_nodes::MapTiles;
+using autoware::localization::ndt_nodes::TileIndex;
+using autoware::localization::ndt_nodes::has_map_tiles;
+using autoware::localization::ndt_nodes::read_map_tiles;
+using autoware::localization::ndt_nodes::tile_file_name;
+using autoware::localization::ndt_nodes::write_map_tiles;
+using autoware::perception::filters::voxel_grid::Config;
+using autoware::perception::filters::voxel_grid::PointXYZ;
+
+class MapTilesTest : public ::testing::Test
+{
+protected:
+  MapTilesTest()
+  {
+    // 5x5x5 voxels of size 1, the voxel centers are at the integers 1 to 5
+    m_min_point.x = 0.5F;
+    m_min_point.y = 0.5F;
+    m_min_point.z = 0.5F;
+    m_max_point.x = 5.5F;
+    m_max_point.y = 5.5F;
+    m_max_point.z = 5.5F;
+    m_voxel_size.x = 1.0F;
+    m_voxel_size.y = 1.0F;
+    m_voxel_size.z = 1.0F;
+  }
+
+  Config make_config() const
+  {
+    return Config{m_min_point, m_max_point, m_voxel_size, 1024U};
+  }
+
+  PointXYZ m_min_point;
+  PointXYZ m_max_point;
+  PointXYZ m_voxel_size;
+};
+
+TEST_F(MapTilesTest, bad_input) {
+  const auto config = make_config();
+  EXPECT_THROW(MapTiles(config, 0.0, 1.0), std::domain_error);
+  EXPECT_THROW(MapTiles(config, 1.5, 1.0), std::domain_error);
+  EXPECT_THROW(MapTiles(config, 2.0, -1.0), std::domain_error);
+  EXPECT_NO_THROW(MapTiles(config, 2.0, 0.0));
+}
+
+TEST_F(MapTilesTest, tiling) {
+  const auto config = make_config();
+  const MapTiles tiles{config, 2.0, 1.0};
+
+  EXPECT_EQ(tiles.tile(1.0, 1.0), TileIndex(0, 0));
+  EXPECT_EQ(tiles.tile(2.6, 0.6), TileIndex(1, 0));
+  EXPECT_EQ(tiles.tile(0.4, -2.0), TileIndex(-1, -2));
+
+  // Every voxel is in the tile of its center
+  for (auto x = 1; x <= 5; ++x) {
+    for (auto y = 1; y <= 5; ++y) {
+      PointXYZ center;
+      center.x = static_cast<float32_t>(x);
+      center.y = static_cast<float32_t>(y);
+      center.z = 1.0F;
+      EXPECT_EQ(tiles.tile(config.index(center)), tiles.tile(center.x, center.y));
+    }
+  }
+
+  // Tiles at distance 0.5 in x and/or y are in the radius, the ones at 1.5 are not.
+  const std::vector<TileIndex> expected_tiles{{-1, -1}, {-1, 0}, {0, -1}, {0, 0}};
+  EXPECT_EQ(tiles.tiles_in_radius(1.0, 1.0), expected_tiles);
+  // The corner of tile (1, 1) is at a distance of sqrt(2) * 0.6
+  EXPECT_EQ(tiles.tiles_in_radius(1.9, 1.9).size(), 4U);
+}
+
+TEST_F(MapTilesTest, write_and_read) {
+  const auto config = make_config();
+  const MapTiles tiles{config, 2.0, 1.0};
+  const std::string pcd_file_name = "MapTilesTest_test.pcd";
+  const std::string directory = ".";
+  ASSERT_FALSE(has_map_tiles(directory));
+
+  // 4 points in each of the voxels with centers (1, 1, 1), (4, 1, 1) and (5, 3, 1)
+  pcl::PointCloud<pcl::PointXYZI> cloud{};
+  for (const auto & center : std::vector<std::vector<float32_t>>{{1.0F, 1.0F}, {4.0F, 1.0F},
+      {5.0F, 3.0F}})
+  {
+    for (const auto offset : {-0.3F, -0.1F, 0.1F, 0.3F}) {
+      pcl::PointXYZI pt;
+      pt.x = center[0U] + offset;
+      pt.y = center[1U] - offset;
+      pt.z = 1.0F + offset;
+      pt.intensity = 0.0F;
+      cloud.push_back(pt);
+    }
+  }
+  pcl::io::savePCDFile(pcd_file_name, cloud);
+
+  EXPECT_THROW(write_map_tiles("NON_EXISTING_FILE_MapTilesTest.pcd", directory, tiles),
+    std::runtime_error);
+  EXPECT_THROW(read_map_tiles(directory, tiles), std::runtime_error);
+
+  EXPECT_EQ(write_map_tiles(pcd_file_name, directory, tiles), 3U);
+  EXPECT_TRUE(has_map_tiles(directory));
+
+  const std::set<TileIndex> expected_tiles{{0, 0}, {1, 0}, {2, 1}};
+  EXPECT_EQ(read_map_tiles(directory, tiles), expected_tiles);
+  EXPECT_THROW(read_map_tiles(directory, MapTiles(config, 4.0, 1.0)), std::domain_error);
+
+  for (const auto & tile : expected_tiles) {
+    pcl::PointCloud<pcl::PointXYZI> tile_cloud{};
+    ASSERT_EQ(pcl::io::loadPCDFile<pcl::PointXYZI>(tile_file_name(directory, tile), tile_cloud),
+      0);
+    EXPECT_EQ(tile_cloud.size(), 4U);
+    for (const auto & pt : tile_cloud) {
+      EXPECT_EQ(tiles.tile(config.index(pt)), tile);
+    }
+    remove(tile_file_name(directory, tile).c_str());
+  }
+  remove("./tiles.yaml");
+  remove(pcd_file_name.c_str());
+}
@@ -65,6 +65,12 @@ public:
   explicit P2DNDTVoxelMapperNode(const rclcpp::NodeOptions & options)
   : RelativeLocalizerNode{"ndt_mapper_node", options, PoseInitializer{}} {init();}
 
+  ~P2DNDTVoxelMapperNode() override
+  {
+    // The pipeline threads call the overrides below.
+    this->stop_pipeline();
+  }
+
 private:
   void init()
   {
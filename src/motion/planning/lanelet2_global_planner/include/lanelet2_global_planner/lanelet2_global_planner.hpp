@@ -30,9 +30,13 @@
 #include <lanelet2_routing/RoutingGraph.h>
 #include <lanelet2_routing/RoutingGraphContainer.h>
 #include <lanelet2_traffic_rules/TrafficRulesFactory.h>
+// boost
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
 // autoware
 #include <lanelet2_global_planner/visibility_control.hpp>
 #include <common/types.hpp>
+#include <helper_functions/worker_pool.hpp>
 // c++
 #include <chrono>
 #include <string>
@@ -40,6 +44,7 @@
 #include <vector>
 #include <cmath>
 #include <unordered_map>
+#include <utility>
 
 using autoware::common::types::float64_t;
 using autoware::common::types::bool8_t;
@@ -52,12 +57,38 @@ namespace planning
 {
 namespace lanelet2_global_planner
 {
+/// Time spent in the stages of a route request
+struct LANELET2_GLOBAL_PLANNER_PUBLIC RouteRequestLatency
+{
+  /// Finding the parking spots near the start and end, and the lanes next to them
+  std::chrono::nanoseconds lookup{std::chrono::nanoseconds::zero()};
+  /// Searching the routing graph
+  std::chrono::nanoseconds routing{std::chrono::nanoseconds::zero()};
+  /// Whole request
+  std::chrono::nanoseconds total{std::chrono::nanoseconds::zero()};
+};
+
+/// Result of a batched route query from several start positions to several end positions
+struct LANELET2_GLOBAL_PLANNER_PUBLIC RouteCostMatrix
+{
+  std::size_t num_starts{0U};
+  std::size_t num_ends{0U};
+  /// Routing cost from start i to end j at index i * num_ends + j, infinity if there is no route
+  std::vector<float64_t> costs;
+  /// Lane ids of the shortest route from start i to end j at the same index as the cost, empty
+  /// if there is no route. Only filled if requested
+  std::vector<std::vector<lanelet::Id>> routes;
+};
+
 class LANELET2_GLOBAL_PLANNER_PUBLIC Lanelet2GlobalPlannerNode : public rclcpp::Node
 {
 public:
   explicit Lanelet2GlobalPlannerNode(const rclcpp::NodeOptions & node_options);
 
+  /// Load a map and build its routing graph, replacing the previous map
   void load_osm_map(const std::string & file, float64_t lat, float64_t lon, float64_t alt);
+  /// Collect the parking spots and road lanes of the loaded map and index the parking spots by
+  /// their center, replacing the result of any previous call
   void parse_lanelet_element();
   bool8_t plan_route(
     const lanelet::Point3d & start, const lanelet::Point3d & end,
@@ -68,15 +99,53 @@ public:
   std::vector<lanelet::Id> get_lane_route(
     const lanelet::Id & from_id,
     const lanelet::Id & to) const;
+  /// Compute the routing costs from one lane to several lanes with a single search of the
+  /// routing graph, which stops once all reachable lanes are found
+  /// \param from_id Start lane id
+  /// \param to_ids End lane ids
+  /// \param routes If not null, replaced by the lane ids of the shortest route to each end lane,
+  ///               empty if there is no route
+  /// \return Routing cost to each end lane, infinity if there is no route
+  std::vector<float64_t> get_lane_route_costs(
+    const lanelet::Id & from_id,
+    const std::vector<lanelet::Id> & to_ids,
+    std::vector<std::vector<lanelet::Id>> * routes = nullptr) const;
+  /// Compute the routing costs from each start position to each end position, with the lanes
+  /// found as in plan_route(). The start positions are distributed over route_query_threads
+  /// threads, each doing one search for all end positions. Calls must not overlap
+  /// \param starts Start positions
+  /// \param ends End positions
+  /// \param with_routes Whether to also return the shortest routes
+  /// \return The cost matrix
+  RouteCostMatrix plan_route_costs(
+    const std::vector<lanelet::Point3d> & starts,
+    const std::vector<lanelet::Point3d> & ends,
+    bool8_t with_routes) const;
   bool8_t compute_parking_center(lanelet::Id & parking_id, lanelet::Point3d & parking_center) const;
   float64_t p2p_euclidean(const lanelet::Point3d & p1, const lanelet::Point3d & p2) const;
   std::vector<lanelet::Id> str2num_lanes(const std::string & str) const;
+  /// Get the time spent in the last call to plan_route()
+  RouteRequestLatency get_last_route_latency() const;
 
 private:
+  /// Find the lane next to the parking spot nearest to a position
+  lanelet::Id find_lane_from_point(const lanelet::Point3d & point) const;
+
+  using IndexPoint = boost::geometry::model::point<float64_t, 3, boost::geometry::cs::cartesian>;
+  using ParkingIndex = boost::geometry::index::rtree<std::pair<IndexPoint, lanelet::Id>,
+      boost::geometry::index::rstar<16>>;
+
   std::unique_ptr<lanelet::LaneletMap> osm_map;
+  // Built once per map, the graph refers to the lanelets of the map
+  lanelet::traffic_rules::TrafficRulesPtr traffic_rules;
+  lanelet::routing::RoutingGraphUPtr routing_graph;
   std::vector<lanelet::Id> parking_id_list;
+  // Parking spot centers, for nearest neighbor lookups
+  ParkingIndex parking_index;
   std::unordered_map<lanelet::Id, std::vector<lanelet::Id>> parking_lane_map;
   std::unordered_map<lanelet::Id, lanelet::Id> near_road_map;
+  mutable RouteRequestLatency last_route_latency;
+  std::unique_ptr<autoware::common::helper_functions::WorkerPool> route_query_pool;
 };
 }  // namespace lanelet2_global_planner
 }  // namespace planning
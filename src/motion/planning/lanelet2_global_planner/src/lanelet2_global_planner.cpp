@@ -21,6 +21,9 @@
 #include <std_msgs/msg/string.hpp>
 #include <common/types.hpp>
 
+#include <chrono>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -39,9 +42,19 @@ namespace planning
 {
 namespace lanelet2_global_planner
 {
+namespace
+{
+float64_t to_ms(const std::chrono::nanoseconds duration)
+{
+  return std::chrono::duration<float64_t, std::milli>(duration).count();
+}
+}  // namespace
+
 Lanelet2GlobalPlannerNode::Lanelet2GlobalPlannerNode(
   const rclcpp::NodeOptions & node_options)
-: Node("lanelet2_global_planner_node", node_options)
+: Node("lanelet2_global_planner_node", node_options),
+  route_query_pool{new autoware::common::helper_functions::WorkerPool{
+      static_cast<std::size_t>(std::max(declare_parameter("route_query_threads", 1), 1))}}
 {
 }
 
@@ -49,6 +62,8 @@ void Lanelet2GlobalPlannerNode::load_osm_map(
   const std::string & file,
   float64_t lat, float64_t lon, float64_t alt)
 {
+  // the routing graph refers to the lanelets of the old map
+  routing_graph.reset();
   if (osm_map) {
     osm_map.reset();
   }
@@ -59,10 +74,23 @@ void Lanelet2GlobalPlannerNode::load_osm_map(
   if (!osm_map) {
     throw std::runtime_error("Lanelet2GlobalPlannerNode: Map load fail");
   }
+
+  // build the routing graph once per map, route requests only search it
+  const auto build_start = std::chrono::steady_clock::now();
+  traffic_rules = lanelet::traffic_rules::TrafficRulesFactory::create(lanelet::Locations::Germany,
+      lanelet::Participants::Vehicle);
+  routing_graph = lanelet::routing::RoutingGraph::build(*osm_map, *traffic_rules);
+  RCLCPP_INFO(
+    this->get_logger(), "Routing graph built in %.1f ms",
+    to_ms(std::chrono::steady_clock::now() - build_start));
 }
 
 void Lanelet2GlobalPlannerNode::parse_lanelet_element()
 {
+  near_road_map.clear();
+  parking_id_list.clear();
+  parking_lane_map.clear();
+  parking_index.clear();
   if (osm_map) {
     // parsing lanelet lane
     typedef std::unordered_map<lanelet::Id, lanelet::Id>::iterator it_lane;
@@ -105,6 +133,17 @@ void Lanelet2GlobalPlannerNode::parse_lanelet_element()
         }
       }
     }
+
+    // index the parking centers, bulk loading builds a better balanced tree than insertion
+    std::vector<std::pair<IndexPoint, lanelet::Id>> parking_centers;
+    parking_centers.reserve(parking_id_list.size());
+    for (lanelet::Id parking_id : parking_id_list) {
+      lanelet::Point3d center;
+      if (compute_parking_center(parking_id, center)) {
+        parking_centers.emplace_back(IndexPoint{center.x(), center.y(), center.z()}, parking_id);
+      }
+    }
+    parking_index = ParkingIndex{parking_centers};
   }
 }
 
@@ -112,17 +151,21 @@ bool8_t Lanelet2GlobalPlannerNode::plan_route(
   const lanelet::Point3d & start,
   const lanelet::Point3d & end, std::vector<lanelet::Id> & route) const
 {
-  // find near start-end parking:return id
-  lanelet::Id near_parking_start = find_nearparking_from_point(start);
-  lanelet::Id near_parking_end = find_nearparking_from_point(end);
-  // locate near roads/lanes: return cad_id
-  lanelet::Id road_start = find_nearroute_from_parking(near_parking_start);
-  lanelet::Id road_end = find_nearroute_from_parking(near_parking_end);
-  // find lane id from near_roads id: return lane id
-  lanelet::Id lane_id_start = find_lane_id(road_start);
-  lanelet::Id lane_id_end = find_lane_id(road_end);
+  const auto request_start = std::chrono::steady_clock::now();
+  lanelet::Id lane_id_start = find_lane_from_point(start);
+  lanelet::Id lane_id_end = find_lane_from_point(end);
+  const auto lookup_end = std::chrono::steady_clock::now();
   // plan a route using lanelet2 lib: vector lane id
   route = get_lane_route(lane_id_start, lane_id_end);
+  const auto request_end = std::chrono::steady_clock::now();
+
+  last_route_latency.lookup = lookup_end - request_start;
+  last_route_latency.routing = request_end - lookup_end;
+  last_route_latency.total = request_end - request_start;
+  RCLCPP_DEBUG(
+    this->get_logger(), "Route request took %.3f ms (lookup %.3f ms, routing %.3f ms)",
+    to_ms(last_route_latency.total), to_ms(last_route_latency.lookup),
+    to_ms(last_route_latency.routing));
   if (route.size() > 0) {
     return true;
   } else {
@@ -130,34 +173,69 @@ bool8_t Lanelet2GlobalPlannerNode::plan_route(
   }
 }
 
+RouteCostMatrix Lanelet2GlobalPlannerNode::plan_route_costs(
+  const std::vector<lanelet::Point3d> & starts,
+  const std::vector<lanelet::Point3d> & ends,
+  bool8_t with_routes) const
+{
+  RouteCostMatrix result;
+  result.num_starts = starts.size();
+  result.num_ends = ends.size();
+  result.costs.resize(starts.size() * ends.size());
+  if (with_routes) {
+    result.routes.resize(starts.size() * ends.size());
+  }
+
+  // the end lanes are shared by all searches
+  std::vector<lanelet::Id> end_lane_ids;
+  end_lane_ids.reserve(ends.size());
+  for (const auto & end : ends) {
+    end_lane_ids.push_back(find_lane_from_point(end));
+  }
+
+  // one search per start, each task writes its own row
+  route_query_pool->run(starts.size(), [&](const std::size_t start_idx) {
+      const auto row = static_cast<std::ptrdiff_t>(start_idx * ends.size());
+      std::vector<std::vector<lanelet::Id>> routes;
+      const std::vector<float64_t> costs = get_lane_route_costs(
+        find_lane_from_point(starts[start_idx]), end_lane_ids, with_routes ? &routes : nullptr);
+      std::copy(costs.begin(), costs.end(), result.costs.begin() + row);
+      if (with_routes) {
+        std::move(routes.begin(), routes.end(), result.routes.begin() + row);
+      }
+    });
+  return result;
+}
+
+lanelet::Id Lanelet2GlobalPlannerNode::find_lane_from_point(const lanelet::Point3d & point) const
+{
+  // find near parking:return id
+  lanelet::Id near_parking = find_nearparking_from_point(point);
+  // locate near roads/lanes: return cad_id
+  lanelet::Id road = find_nearroute_from_parking(near_parking);
+  // find lane id from near_roads id: return lane id
+  return find_lane_id(road);
+}
+
 lanelet::Id Lanelet2GlobalPlannerNode::find_nearparking_from_point(const lanelet::Point3d & point)
 const
 {
-  // loop through parking space to find the closest distance error
-  float64_t min_dist = 1e9;
-  auto i = std::min_element(std::begin(parking_id_list),
-      std::end(parking_id_list),
-      [ =, &min_dist](lanelet::Id park_id1, lanelet::Id park_id2)
-      {
-        // compute parking center point
-        lanelet::Point3d p1;
-        lanelet::Point3d p2;
-        if (compute_parking_center(park_id1, p1) &&
-        compute_parking_center(park_id2, p2))
-        {
-          float64_t dist1 = p2p_euclidean(p1, point);
-          float64_t dist2 = p2p_euclidean(p2, point);
-          min_dist = (dist1 < dist2) ? dist1 : dist2;
-          return dist1 < dist2;
-        } else {
-          return false;
-        }
-      });
+  // query the parking center closest to the point in euclidean distance
+  std::vector<std::pair<IndexPoint, lanelet::Id>> nearest;
+  parking_index.query(
+    boost::geometry::index::nearest(IndexPoint{point.x(), point.y(), point.z()}, 1U),
+    std::back_inserter(nearest));
+  if (nearest.empty()) {
+    RCLCPP_WARN(
+      this->get_logger(),
+      "Find near parking: No parking found in the map");
+    return -1;
+  }
 
   // get parking id
   // Improvement- Check if the parking point is too far away?
-  //              Check if min_dist below the threshold
-  return parking_id_list[std::distance(std::begin(parking_id_list), i)];
+  //              Check if the distance is below the threshold
+  return nearest.front().second;
 }
 
 lanelet::Id Lanelet2GlobalPlannerNode::find_nearroute_from_parking(const lanelet::Id & park_id)
@@ -205,17 +283,18 @@ std::vector<lanelet::Id> Lanelet2GlobalPlannerNode::get_lane_route(
   const lanelet::Id & from_id, const lanelet::Id & to_id) const
 {
   std::vector<lanelet::Id> lane_ids;
-  lanelet::traffic_rules::TrafficRulesPtr trafficRules =
-    lanelet::traffic_rules::TrafficRulesFactory::create(lanelet::Locations::Germany,
-      lanelet::Participants::Vehicle);
-  lanelet::routing::RoutingGraphUPtr routingGraph =
-    lanelet::routing::RoutingGraph::build(*osm_map, *trafficRules);
+  if (!routing_graph) {
+    throw std::runtime_error("Lanelet2GlobalPlannerNode: No map loaded");
+  }
 
   // plan a shortest path without a lane change
   lanelet::ConstLanelet fromLanelet = osm_map->laneletLayer.get(from_id);
   lanelet::ConstLanelet toLanelet = osm_map->laneletLayer.get(to_id);
-  lanelet::Optional<lanelet::routing::Route> route = routingGraph->getRoute(
+  lanelet::Optional<lanelet::routing::Route> route = routing_graph->getRoute(
     fromLanelet, toLanelet, 0);
+  if (!route) {
+    throw std::runtime_error("Lanelet2GlobalPlannerNode: Finding route error");
+  }
   lanelet::routing::LaneletPath shortestPath = route->shortestPath();
   lanelet::LaneletSequence fullLane = route->fullLane(fromLanelet);
 
@@ -228,6 +307,69 @@ std::vector<lanelet::Id> Lanelet2GlobalPlannerNode::get_lane_route(
   return lane_ids;
 }
 
+std::vector<float64_t> Lanelet2GlobalPlannerNode::get_lane_route_costs(
+  const lanelet::Id & from_id, const std::vector<lanelet::Id> & to_ids,
+  std::vector<std::vector<lanelet::Id>> * routes) const
+{
+  if (!routing_graph) {
+    throw std::runtime_error("Lanelet2GlobalPlannerNode: No map loaded");
+  }
+  std::vector<float64_t> costs(to_ids.size(), std::numeric_limits<float64_t>::infinity());
+  if (routes) {
+    routes->assign(to_ids.size(), std::vector<lanelet::Id>{});
+  }
+  if (!osm_map->laneletLayer.exists(from_id)) {
+    return costs;
+  }
+
+  // indices of the end lanes which are not reached yet, several entries may share a lane
+  std::unordered_map<lanelet::Id, std::vector<std::size_t>> pending;
+  for (std::size_t idx = 0U; idx < to_ids.size(); ++idx) {
+    if (osm_map->laneletLayer.exists(to_ids[idx])) {
+      pending[to_ids[idx]].push_back(idx);
+    }
+  }
+
+  // dijkstra search visiting lanes by increasing cost, the same cost module as get_lane_route
+  std::unordered_map<lanelet::Id, lanelet::Id> predecessors;
+  routing_graph->forEachSuccessor(
+    osm_map->laneletLayer.get(from_id),
+    [&](const lanelet::routing::LaneletVisitInformation & info) {
+      // not expanding any lane ends the search once all end lanes are found
+      if (pending.empty()) {
+        return false;
+      }
+      const lanelet::Id lane_id = info.lanelet.id();
+      if (routes) {
+        predecessors.emplace(lane_id, info.predecessor.id());
+      }
+      const auto it = pending.find(lane_id);
+      if (it != pending.end()) {
+        for (const std::size_t idx : it->second) {
+          costs[idx] = info.cost;
+        }
+        pending.erase(it);
+      }
+      return true;
+    }, true, 0);
+
+  if (routes) {
+    for (std::size_t idx = 0U; idx < to_ids.size(); ++idx) {
+      if (std::isfinite(costs[idx])) {
+        std::vector<lanelet::Id> & route = (*routes)[idx];
+        for (lanelet::Id lane_id = to_ids[idx]; lane_id != from_id;
+          lane_id = predecessors.at(lane_id))
+        {
+          route.push_back(lane_id);
+        }
+        route.push_back(from_id);
+        std::reverse(route.begin(), route.end());
+      }
+    }
+  }
+  return costs;
+}
+
 bool8_t Lanelet2GlobalPlannerNode::compute_parking_center(
   lanelet::Id & parking_id, lanelet::Point3d & parking_center) const
 {
@@ -264,6 +406,11 @@ float64_t Lanelet2GlobalPlannerNode::p2p_euclidean(
   return std::sqrt(pd2.x() + pd2.y() + pd2.z());
 }
 
+RouteRequestLatency Lanelet2GlobalPlannerNode::get_last_route_latency() const
+{
+  return last_route_latency;
+}
+
 std::vector<lanelet::Id> Lanelet2GlobalPlannerNode::str2num_lanes(const std::string & str) const
 {
   // expecting e.g. str = "[u'429933', u'430462']";
@@ -20,7 +20,10 @@
 #include <gtest/gtest.h>
 #include <lanelet2_global_planner/lanelet2_global_planner.hpp>
 #include <common/types.hpp>
+#include <chrono>
+#include <cmath>
 #include <experimental/filesystem>
+#include <iostream>
 #include <string>
 #include <memory>
 #include <vector>
@@ -55,6 +58,25 @@ protected:
   std::shared_ptr<Lanelet2GlobalPlannerNode> node_ptr;
 };
 
+// Cost of a path with the cost module the planner searches, i.e. the first default one
+inline float64_t path_cost(
+  const lanelet::routing::RoutingGraph & routing_graph,
+  const lanelet::traffic_rules::TrafficRules & traffic_rules,
+  const lanelet::routing::LaneletPath & path)
+{
+  const auto cost_module = lanelet::routing::defaultRoutingCosts()[0];
+  float64_t cost = 0.0;
+  for (std::size_t idx = 1U; idx < path.size(); ++idx) {
+    const auto relation = routing_graph.routingRelation(path[idx - 1U], path[idx]);
+    if (relation && (*relation == lanelet::routing::RelationType::Successor)) {
+      cost += cost_module->getCostSucceeding(traffic_rules, path[idx - 1U], path[idx]);
+    } else {
+      cost += cost_module->getCostLaneChange(traffic_rules, {path[idx - 1U]}, {path[idx]});
+    }
+  }
+  return cost;
+}
+
 TEST(TestFunction, Point3d_copy)
 {
   auto assign_point3d = [](lanelet::Point3d & pcopy)
@@ -155,6 +177,122 @@ TEST_F(TestGlobalPlanner, test_plan_route)
   EXPECT_TRUE(ret);
 }
 
+TEST_F(TestGlobalPlanner, test_plan_route_latency)
+{
+  lanelet::Point3d start(lanelet::utils::getId(), 20.76, -10.26, 15.60);
+  lanelet::Point3d end(lanelet::utils::getId(), 29.05, 5.78, 16.90);
+  std::vector<lanelet::Id> route;
+
+  // the routing graph is built on map load, requests only search it
+  const auto start_time = std::chrono::steady_clock::now();
+  constexpr int32_t num_requests = 100;
+  for (int32_t i = 0; i < num_requests; ++i) {
+    EXPECT_TRUE(node_ptr->plan_route(start, end, route));
+  }
+  const auto end_time = std::chrono::steady_clock::now();
+  std::cerr << "Average route request: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() /
+    num_requests << " µs\n";
+
+  const auto latency = node_ptr->get_last_route_latency();
+  EXPECT_GT(latency.total.count(), 0);
+  EXPECT_EQ(latency.total, latency.lookup + latency.routing);
+}
+
+TEST_F(TestGlobalPlanner, test_reload_map)
+{
+  // loading and parsing again replaces the map, the routing graph and the parking index
+  std::string file = std::string(std::experimental::filesystem::current_path()) +
+    std::string("/test/map_data/mapping_example_pk.osm");
+  node_ptr->load_osm_map(file, 51.502091, -0.08719, 39.0144);
+  node_ptr->parse_lanelet_element();
+
+  lanelet::Point3d position(lanelet::utils::getId(), 20.7607, -10.2697, 15.6);
+  EXPECT_EQ(node_ptr->find_nearparking_from_point(position), 5830);
+
+  lanelet::Point3d start(lanelet::utils::getId(), 20.76, -10.26, 15.60);
+  lanelet::Point3d end(lanelet::utils::getId(), 29.05, 5.78, 16.90);
+  std::vector<lanelet::Id> route;
+  EXPECT_TRUE(node_ptr->plan_route(start, end, route));
+}
+
+TEST_F(TestGlobalPlanner, test_lane_route_costs)
+{
+  // id:6895 -> cad_id 445864, id:6944 -> cad_id 448826
+  lanelet::Id lane_start = node_ptr->find_lane_id(445864);
+  lanelet::Id lane_end = node_ptr->find_lane_id(448826);
+
+  // the same end lane twice, the start lane itself and a lane which does not exist
+  std::vector<std::vector<lanelet::Id>> routes;
+  std::vector<float64_t> costs = node_ptr->get_lane_route_costs(
+    lane_start, {lane_end, lane_start, lane_end, -1}, &routes);
+  ASSERT_EQ(costs.size(), 4U);
+  ASSERT_EQ(routes.size(), 4U);
+  EXPECT_GT(costs[0], 0.0);
+  EXPECT_TRUE(std::isfinite(costs[0]));
+  EXPECT_DOUBLE_EQ(costs[1], 0.0);
+  EXPECT_EQ(costs[2], costs[0]);
+  EXPECT_TRUE(std::isinf(costs[3]));
+
+  ASSERT_FALSE(routes[0].empty());
+  EXPECT_EQ(routes[0].front(), lane_start);
+  EXPECT_EQ(routes[0].back(), lane_end);
+  EXPECT_EQ(routes[1], std::vector<lanelet::Id>({lane_start}));
+  EXPECT_EQ(routes[2], routes[0]);
+  EXPECT_TRUE(routes[3].empty());
+}
+
+TEST_F(TestGlobalPlanner, test_plan_route_costs)
+{
+  // from bay 5830 and bay 6139 to both bays
+  std::vector<lanelet::Point3d> positions({
+      lanelet::Point3d(lanelet::utils::getId(), 20.76, -10.26, 15.60),
+      lanelet::Point3d(lanelet::utils::getId(), 29.05, 5.78, 16.90)});
+
+  rclcpp::NodeOptions node_options;
+  node_options.append_parameter_override("route_query_threads", 2);
+  auto parallel_node_ptr = std::make_shared<Lanelet2GlobalPlannerNode>(node_options);
+  std::string file = std::string(std::experimental::filesystem::current_path()) +
+    std::string("/test/map_data/mapping_example_pk.osm");
+  parallel_node_ptr->load_osm_map(file, 51.502091, -0.08719, 39.0144);
+  parallel_node_ptr->parse_lanelet_element();
+
+  const auto result = node_ptr->plan_route_costs(positions, positions, true);
+  const auto parallel_result = parallel_node_ptr->plan_route_costs(positions, positions, false);
+  ASSERT_EQ(result.num_starts, 2U);
+  ASSERT_EQ(result.num_ends, 2U);
+  ASSERT_EQ(result.costs.size(), 4U);
+  ASSERT_EQ(result.routes.size(), 4U);
+  EXPECT_TRUE(parallel_result.routes.empty());
+  EXPECT_EQ(result.costs, parallel_result.costs);
+
+  // the batch agrees with a single query between the same lanes
+  lanelet::Id lane_start = node_ptr->find_lane_id(
+    node_ptr->find_nearroute_from_parking(node_ptr->find_nearparking_from_point(positions[0])));
+  lanelet::Id lane_end = node_ptr->find_lane_id(
+    node_ptr->find_nearroute_from_parking(node_ptr->find_nearparking_from_point(positions[1])));
+  const std::vector<float64_t> single_costs =
+    node_ptr->get_lane_route_costs(lane_start, {lane_end});
+  EXPECT_TRUE(std::isfinite(result.costs[1]));
+  EXPECT_DOUBLE_EQ(result.costs[1], single_costs[0]);
+  EXPECT_DOUBLE_EQ(result.costs[0], 0.0);
+  EXPECT_EQ(result.routes[1].front(), lane_start);
+  EXPECT_EQ(result.routes[1].back(), lane_end);
+
+  // the search agrees with the shortest path of lanelet2 on a routing graph of the same map
+  const auto osm_map = lanelet::load(file, lanelet::projection::UtmProjector(
+        lanelet::Origin({51.502091, -0.08719, 39.0144})));
+  const auto traffic_rules = lanelet::traffic_rules::TrafficRulesFactory::create(
+    lanelet::Locations::Germany, lanelet::Participants::Vehicle);
+  const auto routing_graph = lanelet::routing::RoutingGraph::build(*osm_map, *traffic_rules);
+  const auto route = routing_graph->getRoute(
+    osm_map->laneletLayer.get(lane_start), osm_map->laneletLayer.get(lane_end), 0);
+  ASSERT_TRUE(route);
+  EXPECT_DOUBLE_EQ(result.costs[1],
+    path_cost(*routing_graph, *traffic_rules, route->shortestPath()));
+  EXPECT_EQ(result.routes[1], node_ptr->get_lane_route(lane_start, lane_end));
+}
+
 TEST_F(TestGlobalPlanner, test_p2p_distance)
 {
   lanelet::Point3d p1(lanelet::utils::getId(), 1.0, 2.0, 3.0);
@@ -15,9 +15,14 @@
 #define PARKING_PLANNER__ASTAR_PATH_PLANNER_HPP_
 
 #include <common/types.hpp>
+#include <helper_functions/worker_pool.hpp>
 #include <cmath>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "astar_search.hpp"
 #include "parking_planner_types.hpp"
 #include "visibility_control.hpp"
 
@@ -30,17 +35,31 @@ namespace planning
 namespace parking_planner
 {
 using autoware::common::types::float64_t;
-static constexpr float64_t MY_PI = 3.14159265358979323846;
-static constexpr float64_t DELTA_LONGITUDINAL = 0.25;
-static constexpr float64_t DELTA_HEADING = MY_PI / 12.0;
-static constexpr float64_t MAX_EXPLORATION_RADIUS = 20.0;
-static constexpr size_t MAX_NUM_EXPLORATION_NODES = 100000;
 
+/// \brief Result of planning towards several candidate goals
+struct PARKING_PLANNER_PUBLIC AstarMultiGoalResult
+{
+  /// Path to the selected goal, see AstarPathPlanner::plan_astar(). Only contains the starting
+  /// state if no goal was reached
+  std::vector<VehicleState<float64_t>> path;
+  /// Index of the selected goal, the number of goals if no goal was reached
+  std::size_t goal_index;
+  /// Length of the path to the selected goal, infinity if no goal was reached
+  float64_t path_length;
+};
+
+/// \brief Plans paths with an A* search. The memory of the searches is allocated once on
+///        construction, so the planner should be kept and reused. Planning calls on the same
+///        planner are serialized, so a planner can be shared between threads but only runs one
+///        call at a time.
 class PARKING_PLANNER_PUBLIC AstarPathPlanner
 {
 public:
   /// \brief Create an A* path planner
-  AstarPathPlanner() = default;
+  /// \param[in] num_threads Number of threads used by plan_astar_multi_goal(), including the
+  ///                        calling thread. Each thread gets its own search memory
+  /// \throw std::domain_error If num_threads is zero
+  explicit AstarPathPlanner(std::size_t num_threads = 1U);
 
   /// \brief Plan a collision-free but not necessarily dynamically feasible path from a given
   ///        starting state to a given ending state.
@@ -58,8 +77,39 @@ public:
     const Polytope2D<float64_t> & vehicle_bounding_box,
     const std::vector<Polytope2D<float64_t>> & obstacles) const;
 
+  /// \brief Plan paths to several candidate goals, e.g. alternative parking spots or poses, and
+  ///        select the shortest one. The searches are distributed over the threads of the
+  ///        planner. The result does not depend on the number of threads: among paths of equal
+  ///        length, the one to the goal with the lowest index is selected.
+  /// \param[in] current_state Starting vehicle state for the path planning
+  /// \param[in] goal_states Candidate final states for the path planning
+  /// \param[in] vehicle_bounding_box Bounding box of the vehicle, used for collision checking
+  /// \param[in] obstacles List of bounding boxes of the obstacles to be avoided
+  /// \return The selected goal and the path to it
+  AstarMultiGoalResult
+  plan_astar_multi_goal(
+    const VehicleState<float64_t> & current_state,
+    const std::vector<VehicleState<float64_t>> & goal_states,
+    const Polytope2D<float64_t> & vehicle_bounding_box,
+    const std::vector<Polytope2D<float64_t>> & obstacles) const;
+
 private:
-  // Currently no state
+  /// Search memory shared by the planning calls, kept behind a pointer to keep the planner movable
+  struct Workspace
+  {
+    std::unique_ptr<common::helper_functions::WorkerPool> pool;
+    std::vector<std::unique_ptr<AstarSearch>> searches;
+    // Searches not used by any thread of a planning call, guarded by the mutex
+    std::vector<AstarSearch *> free_searches;
+    std::mutex mutex;
+    // Held for the whole planning call, which mutates the searches
+    std::mutex planning_mutex;
+  };
+
+  /// Takes a search from the free ones and gives it back when destroyed, also if it throws
+  class SearchLease;
+
+  std::unique_ptr<Workspace> m_workspace;
 };
 
 }  // namespace parking_planner
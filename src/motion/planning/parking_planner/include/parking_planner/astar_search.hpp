@@ -0,0 +1,125 @@
+// Copyright 2020 Embotech AG, Zurich, Switzerland. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PARKING_PLANNER__ASTAR_SEARCH_HPP_
+#define PARKING_PLANNER__ASTAR_SEARCH_HPP_
+
+#include <common/types.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.hpp"
+#include "parking_planner_types.hpp"
+#include "visibility_control.hpp"
+
+namespace autoware
+{
+namespace motion
+{
+namespace planning
+{
+namespace parking_planner
+{
+using autoware::common::types::float64_t;
+static constexpr float64_t MY_PI = 3.14159265358979323846;
+static constexpr float64_t DELTA_LONGITUDINAL = 0.25;
+static constexpr float64_t DELTA_HEADING = MY_PI / 12.0;
+static constexpr float64_t MAX_EXPLORATION_RADIUS = 20.0;
+static constexpr size_t MAX_NUM_EXPLORATION_NODES = 100000;
+
+/// \brief The A* search behind AstarPathPlanner. All memory for a search of up to
+///        MAX_NUM_EXPLORATION_NODES expansions is allocated on construction and reused by every
+///        search, so a search does not allocate except for an open set growing beyond its
+///        initial capacity. A search object is not thread-safe, use one per thread.
+class PARKING_PLANNER_PUBLIC AstarSearch
+{
+public:
+  /// \brief Allocate the memory for a search
+  AstarSearch();
+
+  /// \brief Search a collision-free path on the lattice of straight and turning moves of length
+  ///        DELTA_LONGITUDINAL from a given starting state to a given ending state.
+  /// \param[in] current_state Starting vehicle state for the path planning
+  /// \param[in] goal_state Desired final state for the path planning
+  /// \param[in] vehicle_bounding_box Bounding box of the vehicle, used for collision checking
+  /// \param[in] obstacles List of bounding boxes of the obstacles to be avoided
+  /// \return True if the goal was reached
+  bool search(
+    const VehicleState<float64_t> & current_state,
+    const VehicleState<float64_t> & goal_state,
+    const Polytope2D<float64_t> & vehicle_bounding_box,
+    const std::vector<Polytope2D<float64_t>> & obstacles);
+
+  /// \brief Get the path found by the last search, see AstarPathPlanner::plan_astar().
+  /// \param[out] path Replaced by the path, only the starting state if the goal was not reached
+  void get_path(std::vector<VehicleState<float64_t>> & path) const;
+
+  /// \brief Get the length of the path found by the last search.
+  /// \return Length of the path, infinity if the goal was not reached
+  float64_t get_path_length() const noexcept;
+
+private:
+  /// A state whose outgoing moves were explored
+  struct ClosedNode
+  {
+    VehicleState<float64_t> state;
+    float64_t cost;  // Path length from the start
+    uint32_t parent;  // Index of the node this one was reached from
+  };
+
+  /// A move to a state which is not explored yet
+  struct OpenElement
+  {
+    float64_t priority;  // Path length plus distance to the goal
+    float64_t cost;  // Path length from the start
+    VehicleState<float64_t> state;
+    uint64_t discrete;  // Grid cell of the state
+    uint32_t parent;  // Index of the node the move starts from
+  };
+
+  /// Index of the closed node of a grid cell, or NO_NODE
+  uint32_t find_closed(uint64_t discrete) const noexcept;
+  /// Add a closed node for a grid cell which has none
+  void insert_closed(uint64_t discrete, uint32_t node) noexcept;
+  /// Check the vehicle at the state against the obstacles
+  bool collides(
+    const VehicleState<float64_t> & state,
+    const Polytope2D<float64_t> & vehicle_bounding_box,
+    const std::vector<Polytope2D<float64_t>> & obstacles);
+
+  static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+  std::vector<ClosedNode> m_nodes;
+  std::vector<OpenElement> m_open_set;
+  // Open addressing hash table from grid cell to closed node, at most half full. A slot is in
+  // use if its generation is the one of the current search, so it is not cleared between searches
+  std::vector<uint64_t> m_closed_keys;
+  std::vector<uint32_t> m_closed_nodes;
+  std::vector<uint32_t> m_closed_generations;
+  uint32_t m_generation;
+  uint32_t m_shift;
+  // Scratch memory
+  std::array<VehicleState<float64_t>, 6U> m_expanded_states;
+  Polytope2D<float64_t> m_moved_box;
+  // Result of the last search
+  VehicleState<float64_t> m_current_state;
+  uint32_t m_goal_node;
+};
+
+}  // namespace parking_planner
+}  // namespace planning
+}  // namespace motion
+}  // namespace autoware
+
+#endif  // PARKING_PLANNER__ASTAR_SEARCH_HPP_
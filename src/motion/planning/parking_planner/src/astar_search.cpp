@@ -0,0 +1,266 @@
+// Copyright 2020 Embotech AG, Zurich, Switzerland. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <common/types.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "parking_planner/astar_search.hpp"
+#include "parking_planner/parking_planner_types.hpp"
+#include "parking_planner/geometry.hpp"
+
+namespace autoware
+{
+
+namespace motion
+{
+
+namespace planning
+{
+
+namespace parking_planner
+{
+
+using autoware::common::types::float64_t;
+
+static void expand_state_longitudinal_with_heading(
+  const VehicleState<float64_t> & from_state,
+  std::array<VehicleState<float64_t>, 6U> & to_states)
+{
+  const float64_t from_x = from_state.get_x();
+  const float64_t from_y = from_state.get_y();
+  const float64_t from_heading = from_state.get_heading();
+  const float64_t delta_x = cos(from_heading) * parking_planner::DELTA_LONGITUDINAL;
+  const float64_t delta_y = sin(from_heading) * parking_planner::DELTA_LONGITUDINAL;
+  const float64_t heading_minus = remainder(from_heading - parking_planner::DELTA_HEADING,
+      MY_PI * 2.0);
+  const float64_t heading_plus = remainder(from_heading + parking_planner::DELTA_HEADING,
+      MY_PI * 2.0);
+  to_states.fill(from_state);
+  to_states[0].set_x(from_x - delta_x);
+  to_states[0].set_y(from_y - delta_y);
+  to_states[0].set_heading(heading_minus);
+  to_states[1].set_x(from_x - delta_x);
+  to_states[1].set_y(from_y - delta_y);
+  to_states[1].set_heading(from_heading);
+  to_states[2].set_x(from_x - delta_x);
+  to_states[2].set_y(from_y - delta_y);
+  to_states[2].set_heading(heading_plus);
+  to_states[3].set_x(from_x + delta_x);
+  to_states[3].set_y(from_y + delta_y);
+  to_states[3].set_heading(heading_minus);
+  to_states[4].set_x(from_x + delta_x);
+  to_states[4].set_y(from_y + delta_y);
+  to_states[4].set_heading(from_heading);
+  to_states[5].set_x(from_x + delta_x);
+  to_states[5].set_y(from_y + delta_y);
+  to_states[5].set_heading(heading_plus);
+}
+
+static uint64_t map_state_on_discretized_grid(
+  const VehicleState<float64_t> & state,
+  const VehicleState<float64_t> & reference)
+{
+  static constexpr uint64_t num_position_steps = static_cast<uint64_t>(round(
+      parking_planner::MAX_EXPLORATION_RADIUS / parking_planner::DELTA_LONGITUDINAL)) * 2 + 1;
+  uint64_t x_quant =
+    static_cast<uint64_t>(round(
+      (state.get_x() - reference.get_x() + parking_planner::MAX_EXPLORATION_RADIUS) /
+      parking_planner::DELTA_LONGITUDINAL));
+  uint64_t y_quant =
+    static_cast<uint64_t>(round(
+      (state.get_y() - reference.get_y() + parking_planner::MAX_EXPLORATION_RADIUS) /
+      parking_planner::DELTA_LONGITUDINAL));
+  uint64_t h_quant =
+    static_cast<uint64_t>(round((remainder(state.get_heading() - reference.get_heading(),
+    parking_planner::MY_PI * 2.0) + parking_planner::MY_PI) / parking_planner::DELTA_HEADING));
+  return h_quant * num_position_steps * num_position_steps + y_quant * num_position_steps + x_quant;
+}
+
+// The open set is a binary heap with the cheapest element on top, ties are broken by the lower
+// path length
+static bool compare_open_elements(
+  const float64_t priority1, const float64_t cost1,
+  const float64_t priority2, const float64_t cost2)
+{
+  return std::make_pair(priority1, cost1) > std::make_pair(priority2, cost2);
+}
+
+constexpr uint32_t AstarSearch::NO_NODE;
+
+AstarSearch::AstarSearch()
+: m_generation{0U},
+  m_shift{0U},
+  m_moved_box{std::vector<Point2D<float64_t>>{}},
+  m_goal_node{NO_NODE}
+{
+  // Every expansion closes at most one node, the table is kept at most half full
+  std::size_t capacity = 1U;
+  uint32_t bits = 0U;
+  while (capacity < 2U * MAX_NUM_EXPLORATION_NODES) {
+    capacity *= 2U;
+    ++bits;
+  }
+  m_shift = 64U - bits;
+  m_closed_keys.resize(capacity);
+  m_closed_nodes.resize(capacity);
+  m_closed_generations.resize(capacity, 0U);
+  m_nodes.reserve(MAX_NUM_EXPLORATION_NODES);
+  m_open_set.reserve(MAX_NUM_EXPLORATION_NODES);
+}
+
+uint32_t AstarSearch::find_closed(const uint64_t discrete) const noexcept
+{
+  // Fibonacci hashing, then linear probing
+  const std::size_t mask = m_closed_keys.size() - 1U;
+  for (std::size_t slot = (discrete * 11400714819323198485ULL) >> m_shift; ;
+    slot = (slot + 1U) & mask)
+  {
+    if (m_closed_generations[slot] != m_generation) {
+      return NO_NODE;
+    }
+    if (m_closed_keys[slot] == discrete) {
+      return m_closed_nodes[slot];
+    }
+  }
+}
+
+void AstarSearch::insert_closed(const uint64_t discrete, const uint32_t node) noexcept
+{
+  const std::size_t mask = m_closed_keys.size() - 1U;
+  std::size_t slot = (discrete * 11400714819323198485ULL) >> m_shift;
+  while (m_closed_generations[slot] == m_generation) {
+    slot = (slot + 1U) & mask;
+  }
+  m_closed_generations[slot] = m_generation;
+  m_closed_keys[slot] = discrete;
+  m_closed_nodes[slot] = node;
+}
+
+bool AstarSearch::collides(
+  const VehicleState<float64_t> & state,
+  const Polytope2D<float64_t> & vehicle_bounding_box,
+  const std::vector<Polytope2D<float64_t>> & obstacles)
+{
+  // Copy assignment reuses the memory of the scratch box
+  m_moved_box = vehicle_bounding_box;
+  m_moved_box.rotate_and_shift(state.get_heading(), Point2D<float64_t>(),
+    Point2D<float64_t>(state.get_x(), state.get_y()));
+  for (const auto & obst : obstacles) {
+    if (m_moved_box.intersects_with(obst)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AstarSearch::search(
+  const VehicleState<float64_t> & current_state,
+  const VehicleState<float64_t> & goal_state,
+  const Polytope2D<float64_t> & vehicle_bounding_box,
+  const std::vector<Polytope2D<float64_t>> & obstacles)
+{
+  // Reset the data structures, invalidating all slots of the closed set at once
+  m_nodes.clear();
+  m_open_set.clear();
+  ++m_generation;
+  if (0U == m_generation) {
+    std::fill(m_closed_generations.begin(), m_closed_generations.end(), 0U);
+    m_generation = 1U;
+  }
+  m_current_state = current_state;
+  m_goal_node = NO_NODE;
+
+  const auto heap_compare = [](const OpenElement & e1, const OpenElement & e2) {
+      return compare_open_elements(e1.priority, e1.cost, e2.priority, e2.cost);
+    };
+
+  // Initialize data structures for the given problem data
+  Point2D<float64_t> vect_current_to_goal = Point2D<float64_t>(current_state.get_x(),
+      current_state.get_y()) -
+    Point2D<float64_t>(goal_state.get_x(), goal_state.get_y());
+  float64_t dist_current_to_goal = vect_current_to_goal.norm2();
+  uint64_t current_discrete = map_state_on_discretized_grid(current_state, goal_state);
+  uint64_t goal_discrete = map_state_on_discretized_grid(goal_state, goal_state);
+  // The start is its own parent
+  m_open_set.push_back({dist_current_to_goal, 0.0, current_state, current_discrete, 0U});
+
+  // Run the main exploration loop
+  size_t num_nodes_left = parking_planner::MAX_NUM_EXPLORATION_NODES;
+  while (!m_open_set.empty() && (0 != num_nodes_left--)) {
+    std::pop_heap(m_open_set.begin(), m_open_set.end(), heap_compare);
+    const OpenElement top_element = m_open_set.back();
+    m_open_set.pop_back();
+    const float64_t f_cost = top_element.cost;
+    const VehicleState<float64_t> & to_state = top_element.state;
+    const uint64_t to_discrete = top_element.discrete;
+
+    if (NO_NODE == find_closed(to_discrete)) {
+      const auto to_node = static_cast<uint32_t>(m_nodes.size());
+      m_nodes.push_back({to_state, f_cost, top_element.parent});
+      insert_closed(to_discrete, to_node);
+      if (to_discrete == goal_discrete) {
+        m_goal_node = to_node;
+        break;
+      }
+
+      if (!collides(to_state, vehicle_bounding_box, obstacles)) {
+        expand_state_longitudinal_with_heading(to_state, m_expanded_states);
+        for (const VehicleState<float64_t> & next_state : m_expanded_states) {
+          uint64_t next_discrete = map_state_on_discretized_grid(next_state, goal_state);
+          if (NO_NODE == find_closed(next_discrete)) {
+            float64_t next_f_cost = f_cost + parking_planner::DELTA_LONGITUDINAL;
+            Point2D<float64_t> vect_to_goal = Point2D<float64_t>(
+              next_state.get_x(), next_state.get_y()) -
+              Point2D<float64_t>(goal_state.get_x(), goal_state.get_y());
+            float64_t dist_to_goal = vect_to_goal.norm2();
+            if (dist_to_goal < parking_planner::MAX_EXPLORATION_RADIUS) {
+              float64_t next_g_cost = f_cost + dist_to_goal;
+              m_open_set.push_back({next_g_cost, next_f_cost, next_state, next_discrete, to_node});
+              std::push_heap(m_open_set.begin(), m_open_set.end(), heap_compare);
+            }
+          }
+        }
+      }
+    }
+  }
+  return NO_NODE != m_goal_node;
+}
+
+void AstarSearch::get_path(std::vector<VehicleState<float64_t>> & path) const
+{
+  // Walk back from the goal, adding the state each move started from
+  path.clear();
+  if (NO_NODE != m_goal_node) {
+    for (uint32_t node = m_goal_node; 0U != node; node = m_nodes[node].parent) {
+      path.push_back(m_nodes[m_nodes[node].parent].state);
+    }
+  }
+  path.push_back(m_current_state);
+  std::reverse(path.begin(), path.end());
+}
+
+float64_t AstarSearch::get_path_length() const noexcept
+{
+  return (NO_NODE != m_goal_node) ? m_nodes[m_goal_node].cost :
+         std::numeric_limits<float64_t>::infinity();
+}
+
+}  // namespace parking_planner
+}  // namespace planning
+}  // namespace motion
+}  // namespace autoware
@@ -143,7 +143,6 @@ ParkingPlanner::ParkingPlanner(
 : m_nlp_planner(nlp_weights, lower_state_bounds, upper_state_bounds,
     lower_command_bounds, upper_command_bounds), m_model_parameters(parameters)
 {
-  m_astar_planner = AstarPathPlanner();
 }
 
 
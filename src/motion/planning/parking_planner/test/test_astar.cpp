@@ -16,6 +16,10 @@
 
 #include <gtest/gtest.h>
 #include <common/types.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
 #include <vector>
 #include "parking_planner/geometry.hpp"
 #include "parking_planner/parking_planner_types.hpp"
@@ -447,3 +451,190 @@ TEST(astar_path_planner, infeasible_situation_current_walled) {
   EXPECT_EQ(num_collisions, 0);
   EXPECT_EQ(vehicle_states.size(), 1);
 }
+
+TEST(astar_path_planner, repeated_planning) {
+  const VehicleState current_state(0.0, 0.0, 0.0, 0, 0.0);
+  const VehicleState goal_state(2.0, -1.5, 0.0, 0, 0.0);
+
+  // Set some parameters, then compute the bounding box from those
+  const auto parameters = BicycleModelParameters(0.8, 0.8, 1.0, 0.1, 0.1);
+  const auto model = BicycleModel(parameters);
+  const auto vehicle_bounding_box = model.compute_bounding_box(VehicleState{});
+
+  const Polytope2D back_parked_car(
+    std::vector<Point2D>({{0.5, -0.8}, {-2.0, -0.8}, {-2.0, -2.5}, {0.5, -2.5}}));
+
+  const std::vector<Polytope2D> obstacles({back_parked_car});
+
+  const auto planner = autoware::motion::planning::parking_planner::AstarPathPlanner();
+
+  // The search memory is reused, a different problem in between must not change the result
+  const std::vector<VehicleState> first_states =
+    planner.plan_astar(current_state, goal_state, vehicle_bounding_box, obstacles);
+  planner.plan_astar(current_state, VehicleState(-5.0, 3.0, 0.0, 1.0, 0.0),
+    vehicle_bounding_box, {});
+  const std::vector<VehicleState> second_states =
+    planner.plan_astar(current_state, goal_state, vehicle_bounding_box, obstacles);
+
+  ASSERT_EQ(first_states.size(), second_states.size());
+  for (std::size_t idx = 0U; idx < first_states.size(); ++idx) {
+    EXPECT_EQ(first_states[idx].get_x(), second_states[idx].get_x());
+    EXPECT_EQ(first_states[idx].get_y(), second_states[idx].get_y());
+    EXPECT_EQ(first_states[idx].get_heading(), second_states[idx].get_heading());
+  }
+}
+
+TEST(astar_path_planner, multi_goal) {
+  const VehicleState current_state(0.0, 0.0, 0.0, 0.0, 0.0);
+
+  // Set some parameters, then compute the bounding box from those
+  const auto parameters = BicycleModelParameters(0.8, 0.8, 1.0, 0.1, 0.1);
+  const auto model = BicycleModel(parameters);
+  const auto vehicle_bounding_box = model.compute_bounding_box(VehicleState{});
+
+  // The nearest goal is inside an obstacle, the second goal is the nearest reachable one
+  const Polytope2D blocked_spot(
+    std::vector<Point2D>({{1.0, 4.0}, {-1.0, 4.0}, {-1.0, 2.0}, {1.0, 2.0}}));
+  const std::vector<Polytope2D> obstacles({blocked_spot});
+  const std::vector<VehicleState> goal_states({
+      VehicleState(0.0, 3.0, 0.0, 0.0, 0.0),
+      VehicleState(5.0, 0.0, 0.0, 0.0, 0.0),
+      VehicleState(-8.0, 0.0, 0.0, 0.0, 0.0),
+      VehicleState(5.0, 0.0, 0.0, 0.0, 0.0)});
+
+  const auto sequential_planner = autoware::motion::planning::parking_planner::AstarPathPlanner();
+  const auto parallel_planner = autoware::motion::planning::parking_planner::AstarPathPlanner(3U);
+
+  const auto sequential_result = sequential_planner.plan_astar_multi_goal(
+    current_state, goal_states, vehicle_bounding_box, obstacles);
+  const auto parallel_result = parallel_planner.plan_astar_multi_goal(
+    current_state, goal_states, vehicle_bounding_box, obstacles);
+  const std::vector<VehicleState> single_goal_states =
+    sequential_planner.plan_astar(current_state, goal_states[1], vehicle_bounding_box, obstacles);
+
+  // Equal paths are tied, the lower goal index wins independent of the number of threads
+  EXPECT_EQ(sequential_result.goal_index, 1U);
+  EXPECT_EQ(parallel_result.goal_index, 1U);
+  EXPECT_EQ(sequential_result.path_length, parallel_result.path_length);
+  ASSERT_EQ(sequential_result.path.size(), single_goal_states.size());
+  ASSERT_EQ(parallel_result.path.size(), single_goal_states.size());
+  for (std::size_t idx = 0U; idx < single_goal_states.size(); ++idx) {
+    EXPECT_EQ(sequential_result.path[idx].get_x(), single_goal_states[idx].get_x());
+    EXPECT_EQ(sequential_result.path[idx].get_y(), single_goal_states[idx].get_y());
+    EXPECT_EQ(parallel_result.path[idx].get_x(), single_goal_states[idx].get_x());
+    EXPECT_EQ(parallel_result.path[idx].get_y(), single_goal_states[idx].get_y());
+  }
+}
+
+TEST(astar_path_planner, multi_goal_infeasible) {
+  const VehicleState current_state(0.0, 0.0, 0.0, 0, 0.0);
+
+  // Set some parameters, then compute the bounding box from those
+  const auto parameters = BicycleModelParameters(0.8, 0.8, 1.0, 0.1, 0.1);
+  const auto model = BicycleModel(parameters);
+  const auto vehicle_bounding_box = model.compute_bounding_box(VehicleState{});
+
+  const Polytope2D wall_box(
+    std::vector<Point2D>({{3.0, 25.0}, {2.5, 25.0}, {2.5, -25.0}, {3.0, -25.0}}));
+
+  const std::vector<Polytope2D> obstacles({wall_box});
+  const std::vector<VehicleState> goal_states({
+      VehicleState(15.0, 0.0, 0.0, 0.0, 0.0),
+      VehicleState(30.0, 0.0, 0.0, 0.0, 0.0)});
+
+  const auto planner = autoware::motion::planning::parking_planner::AstarPathPlanner(2U);
+
+  const auto result =
+    planner.plan_astar_multi_goal(current_state, goal_states, vehicle_bounding_box, obstacles);
+
+  EXPECT_EQ(result.goal_index, goal_states.size());
+  EXPECT_EQ(result.path.size(), 1U);
+  EXPECT_TRUE(std::isinf(result.path_length));
+}
+
+TEST(astar_path_planner, shared_between_threads) {
+  const VehicleState current_state(0.0, 0.0, 0.0, 0, 0.0);
+
+  // Set some parameters, then compute the bounding box from those
+  const auto parameters = BicycleModelParameters(0.8, 0.8, 1.0, 0.1, 0.1);
+  const auto model = BicycleModel(parameters);
+  const auto vehicle_bounding_box = model.compute_bounding_box(VehicleState{});
+
+  const Polytope2D obstacle(
+    std::vector<Point2D>({{1.0, 4.0}, {-1.0, 4.0}, {-1.0, 2.0}, {1.0, 2.0}}));
+  const std::vector<Polytope2D> obstacles({obstacle});
+  const VehicleState goal_state(0.0, 6.0, 0.0, 0.0, 0.0);
+  const std::vector<VehicleState> goal_states({goal_state, VehicleState(5.0, 0.0, 0.0, 0.0, 0.0)});
+
+  const auto planner = autoware::motion::planning::parking_planner::AstarPathPlanner(2U);
+  const auto expected_path =
+    planner.plan_astar(current_state, goal_state, vehicle_bounding_box, obstacles);
+  const auto expected_result =
+    planner.plan_astar_multi_goal(current_state, goal_states, vehicle_bounding_box, obstacles);
+
+  // Calls from several threads are serialized and do not share a search
+  std::vector<std::size_t> path_sizes(4U);
+  std::vector<std::size_t> goal_indices(4U);
+  std::vector<std::thread> threads;
+  for (std::size_t idx = 0U; idx < path_sizes.size(); ++idx) {
+    threads.emplace_back([&, idx]() {
+        path_sizes[idx] =
+        planner.plan_astar(current_state, goal_state, vehicle_bounding_box, obstacles).size();
+        goal_indices[idx] = planner.plan_astar_multi_goal(
+          current_state, goal_states, vehicle_bounding_box, obstacles).goal_index;
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (std::size_t idx = 0U; idx < path_sizes.size(); ++idx) {
+    EXPECT_EQ(path_sizes[idx], expected_path.size());
+    EXPECT_EQ(goal_indices[idx], expected_result.goal_index);
+  }
+}
+
+TEST(astar_path_planner, benchmark) {
+  const VehicleState current_state(0.0, 0.0, 0.0, 0, 0.0);
+
+  // Set some parameters, then compute the bounding box from those
+  const auto parameters = BicycleModelParameters(0.8, 0.8, 1.0, 0.1, 0.1);
+  const auto model = BicycleModel(parameters);
+  const auto vehicle_bounding_box = model.compute_bounding_box(VehicleState{});
+
+  const Polytope2D back_parked_car(
+    std::vector<Point2D>({{0.5, -0.8}, {-2.0, -0.8}, {-2.0, -2.5}, {0.5, -2.5}}));
+  const Polytope2D front_parked_car(
+    std::vector<Point2D>({{10.0, -0.8}, {3.5, -0.8}, {3.5, -2.5}, {10, -2.5}}));
+  const Polytope2D wall_box(
+    std::vector<Point2D>({{10.0, -2.5}, {-2.0, -2.5}, {-2.0, -4.0}, {10.0, -4.0}}));
+  const std::vector<Polytope2D> obstacles({back_parked_car, front_parked_car, wall_box});
+  const std::vector<VehicleState> goal_states({
+      VehicleState(2.0, -1.5, 0.0, 0.0, 0.0),
+      VehicleState(-5.0, -1.5, 0.0, 0.0, 0.0),
+      VehicleState(12.0, -1.5, 0.0, 0.0, 0.0),
+      VehicleState(2.0, 3.0, 0.0, 0.0, 0.0)});
+
+  const auto sequential_planner = autoware::motion::planning::parking_planner::AstarPathPlanner();
+  const auto parallel_planner =
+    autoware::motion::planning::parking_planner::AstarPathPlanner(goal_states.size());
+  // Warm up the search memory of all threads
+  parallel_planner.plan_astar_multi_goal(
+    current_state, goal_states, vehicle_bounding_box, obstacles);
+
+  auto start = std::chrono::steady_clock::now();
+  for (const auto & goal_state : goal_states) {
+    sequential_planner.plan_astar(current_state, goal_state, vehicle_bounding_box, obstacles);
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cerr << "Sequential A* to " << goal_states.size() << " goals: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " µs\n";
+
+  start = std::chrono::steady_clock::now();
+  const auto result = parallel_planner.plan_astar_multi_goal(
+    current_state, goal_states, vehicle_bounding_box, obstacles);
+  end = std::chrono::steady_clock::now();
+  std::cerr << "Parallel multi-goal A* to " << goal_states.size() << " goals: " <<
+    std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " µs\n";
+
+  EXPECT_LT(result.goal_index, goal_states.size());
+}
@@ -0,0 +1,163 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines a synchronizer grouping clouds from any number of sources under a
+///        latency budget
+
+#ifndef POINT_CLOUD_FUSION__DEADLINE_SYNCHRONIZER_HPP_
+#define POINT_CLOUD_FUSION__DEADLINE_SYNCHRONIZER_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <point_cloud_fusion/visibility_control.hpp>
+#include <common/types.hpp>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace point_cloud_fusion
+{
+/// \brief Groups clouds from multiple sources by timestamp, without waiting for slow sources
+///        longer than a fixed latency budget.
+///
+/// Each source has a bounded ring of clouds which have not been fused yet. The oldest stamp among
+/// all pending clouds is the reference of the next group, and each source contributes its pending
+/// cloud closest to it, if that is within a tolerance. The group is emitted as soon as every
+/// source either has a match or has already sent a cloud past the tolerance, or once the latency
+/// budget has passed since the reference cloud arrived, with whatever sources match at that point.
+/// Clouds stamped up to the reference of the previously emitted group plus the tolerance arrive
+/// too late to be fused and are dropped. The tolerance should thus be less than the period of the
+/// sources.
+///
+/// Time is passed in explicitly, which makes the class independent of ROS timers.
+class POINT_CLOUD_FUSION_PUBLIC DeadlineSynchronizer
+{
+public:
+  using MsgT = sensor_msgs::msg::PointCloud2;
+  using MsgPtrT = MsgT::ConstSharedPtr;
+  using Clock = std::chrono::steady_clock;
+
+  /// \brief Per source counters and timing, for diagnostics
+  struct SourceStats
+  {
+    /// \brief Number of clouds passed to add()
+    uint64_t num_received{0U};
+    /// \brief Number of clouds which were part of an emitted group
+    uint64_t num_fused{0U};
+    /// \brief Number of clouds which were never fused: overwritten in a full ring, superseded by
+    ///        a better match, or too late for the group they belong to
+    uint64_t num_dropped{0U};
+    /// \brief Number of emitted groups which did not contain a cloud from this source
+    uint64_t num_missed{0U};
+    /// \brief Arrival time of the fused cloud relative to the arrival of the reference cloud of
+    ///        the last group containing this source
+    std::chrono::nanoseconds last_lag{0};
+    /// \brief Maximum of last_lag over all groups
+    std::chrono::nanoseconds max_lag{0};
+  };  // struct SourceStats
+
+  /// \brief Constructor, all memory is allocated here
+  /// \param[in] num_sources Number of sources
+  /// \param[in] queue_size Maximum number of pending clouds per source
+  /// \param[in] latency_budget Maximum time a group waits for missing sources
+  /// \param[in] stamp_tolerance Maximum stamp difference of a cloud to the reference of a group
+  /// \throw std::domain_error If num_sources or queue_size is zero, or a duration is negative
+  DeadlineSynchronizer(
+    const std::size_t num_sources,
+    const std::size_t queue_size,
+    const std::chrono::nanoseconds latency_budget,
+    const std::chrono::nanoseconds stamp_tolerance);
+
+  /// \brief Add a cloud to the ring of a source, dropping the oldest pending cloud if it is full
+  /// \param[in] source_idx Index of the source
+  /// \param[in] msg The cloud
+  /// \param[in] now Arrival time of the cloud
+  /// \throw std::out_of_range If source_idx is not a valid source index
+  void add(const std::size_t source_idx, const MsgPtrT & msg, const Clock::time_point now);
+
+  /// \brief Emit a group of clouds if all sources are ready or the deadline has passed
+  /// \param[in] now Current time
+  /// \param[out] msgs Gets one entry per source, nullptr for sources missing from the group.
+  ///                  Only modified if a group is emitted.
+  /// \return True if a group was emitted
+  bool8_t poll(const Clock::time_point now, std::vector<MsgPtrT> & msgs);
+
+  /// \brief Get the time at which the pending group will be emitted at the latest
+  /// \param[out] deadline Gets the deadline written to it, if there is a pending group
+  /// \return False if there are no pending clouds
+  bool8_t get_deadline(Clock::time_point & deadline) const;
+
+  /// \brief Get the statistics of a source
+  /// \param[in] source_idx Index of the source
+  /// \return Counters and timing of the source
+  /// \throw std::out_of_range If source_idx is not a valid source index
+  const SourceStats & stats(const std::size_t source_idx) const;
+
+  /// \brief Get the number of sources
+  std::size_t num_sources() const;
+
+private:
+  /// \brief A pending cloud
+  struct Entry
+  {
+    MsgPtrT msg;
+    std::chrono::nanoseconds stamp;
+    Clock::time_point arrival;
+  };  // struct Entry
+
+  /// \brief Fixed capacity FIFO of pending clouds of a single source, in order of arrival
+  struct Ring
+  {
+    std::vector<Entry> entries;
+    std::size_t head;
+    std::size_t size;
+    SourceStats stats;
+
+    Entry & at(const std::size_t idx);
+    const Entry & at(const std::size_t idx) const;
+    void pop_front();
+  };  // struct Ring
+
+  /// \brief Find the pending cloud with the oldest stamp
+  /// \return Pointer to the cloud, nullptr if there is none
+  POINT_CLOUD_FUSION_LOCAL const Entry * find_reference() const;
+
+  /// \brief Find the pending cloud of a ring which best matches the reference stamp
+  /// \return Index of the cloud in the ring, or the size of the ring if none is within tolerance
+  POINT_CLOUD_FUSION_LOCAL std::size_t find_match(
+    const Ring & ring,
+    const std::chrono::nanoseconds reference) const;
+
+  std::vector<Ring> m_rings;
+  std::chrono::nanoseconds m_latency_budget;
+  std::chrono::nanoseconds m_stamp_tolerance;
+  std::chrono::nanoseconds m_last_reference;
+  bool8_t m_has_emitted;
+};  // class DeadlineSynchronizer
+}  // namespace point_cloud_fusion
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // POINT_CLOUD_FUSION__DEADLINE_SYNCHRONIZER_HPP_
@@ -0,0 +1,140 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines the core logic concatenating point clouds from multiple sources
+
+#ifndef POINT_CLOUD_FUSION__POINT_CLOUD_CONCATENATOR_HPP_
+#define POINT_CLOUD_FUSION__POINT_CLOUD_CONCATENATOR_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <point_cloud_fusion/visibility_control.hpp>
+#include <helper_functions/worker_pool.hpp>
+#include <common/types.hpp>
+#include <Eigen/Geometry>
+#include <cstddef>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace point_cloud_fusion
+{
+/// \brief Appends the points of multiple source clouds to a preallocated output cloud, moving each
+///        source into the output frame on the way.
+///
+/// If a source has the same memory layout as the output cloud, its points are block copied, and
+/// the transform (if any) is then applied in place on the copied coordinates. Otherwise, the
+/// x, y, z and intensity fields are gathered point by point. The work is split into chunks of at
+/// most CHUNK_SIZE points, which are distributed over a pool of threads. No memory is allocated
+/// after the first call with a given number of sources.
+class POINT_CLOUD_FUSION_PUBLIC PointCloudConcatenator
+{
+public:
+  using PointCloudMsgT = sensor_msgs::msg::PointCloud2;
+  using TransformT = Eigen::Transform<float32_t, 3, Eigen::Affine, Eigen::ColMajor>;
+
+  /// \brief Maximum number of points copied by a single task
+  static constexpr std::size_t CHUNK_SIZE = 16384U;
+
+  /// \brief A cloud to be fused, along with the transform from its frame to the output frame
+  struct Source
+  {
+    /// \brief The cloud, must outlive the call to concatenate()
+    const PointCloudMsgT * cloud;
+    /// \brief Transform from the frame of the cloud to the frame of the output cloud
+    TransformT tf;
+    /// \brief If true, tf is ignored and points are copied as is
+    bool8_t is_identity;
+  };  // struct Source
+
+  /// \brief Constructor
+  /// \param[in] num_threads The number of threads copying points, including the calling thread
+  /// \throw std::domain_error If num_threads is zero
+  explicit PointCloudConcatenator(const std::size_t num_threads);
+
+  /// \brief Append the sources to the output cloud, in order. If a source does not fit in the
+  ///        remaining capacity of the output cloud, it and all following sources are skipped.
+  /// \param[in] sources The clouds to be fused
+  /// \param[inout] cloud_out The output cloud. Its capacity is given by the size of its data
+  ///                         buffer, which is not resized. Fields other than x, y, z and intensity
+  ///                         are only filled for sources with a matching layout.
+  /// \param[out] num_fused_sources The number of sources which were added to the output cloud
+  /// \return The number of points in the output cloud
+  /// \throw std::runtime_error If the output cloud or a source without a matching layout does
+  ///                           not have float32 x, y, z and intensity fields
+  uint32_t concatenate(
+    const std::vector<Source> & sources,
+    PointCloudMsgT & cloud_out,
+    std::size_t & num_fused_sources);
+
+  /// \brief Get the number of threads copying points
+  /// \return The number of threads, including the calling thread
+  std::size_t num_threads() const;
+
+  /// \brief Check whether the points of a cloud can be block copied into another cloud
+  /// \param[in] cloud_in The cloud to copy from
+  /// \param[in] cloud_out The cloud to copy to
+  /// \return True if both clouds have the same fields, point step and endianness, and there is
+  ///         no padding at the end of the rows of cloud_in
+  static bool8_t is_layout_compatible(
+    const PointCloudMsgT & cloud_in,
+    const PointCloudMsgT & cloud_out);
+
+private:
+  /// \brief Byte offsets of the float32 x, y, z and intensity fields within a point
+  struct FieldOffsets
+  {
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+    uint32_t intensity;
+  };  // struct FieldOffsets
+
+  /// \brief A contiguous range of points of a single source, and where they go in the output
+  struct Chunk
+  {
+    const Source * source;
+    bool8_t is_block_copy;
+    FieldOffsets offsets_in;
+    std::size_t first_point_in;
+    std::size_t first_point_out;
+    std::size_t num_points;
+  };  // struct Chunk
+
+  /// \brief Find the x, y, z and intensity fields of a cloud
+  /// \throw std::runtime_error If a field is missing or is not a single float32
+  POINT_CLOUD_FUSION_LOCAL static FieldOffsets get_offsets(const PointCloudMsgT & cloud);
+
+  /// \brief Copy and transform the points of a chunk into the output cloud
+  POINT_CLOUD_FUSION_LOCAL void copy_chunk(const Chunk & chunk, PointCloudMsgT & cloud_out) const;
+
+  autoware::common::helper_functions::WorkerPool m_pool;
+  std::vector<Chunk> m_chunks;
+  FieldOffsets m_offsets_out;
+};  // class PointCloudConcatenator
+}  // namespace point_cloud_fusion
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // POINT_CLOUD_FUSION__POINT_CLOUD_CONCATENATOR_HPP_
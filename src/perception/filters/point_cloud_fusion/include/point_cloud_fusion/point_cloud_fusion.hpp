@@ -22,8 +22,11 @@
 #include <message_filters/synchronizer.h>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <lidar_utils/point_cloud_utils.hpp>
+#include <tf2/buffer_core.h>
 #include <tf2_ros/transform_listener.h>
 #include <rclcpp/rclcpp.hpp>
+#include <point_cloud_fusion/deadline_synchronizer.hpp>
+#include <point_cloud_fusion/point_cloud_concatenator.hpp>
 #include <point_cloud_fusion/visibility_control.hpp>
 #include <common/types.hpp>
 #include <string>
@@ -41,7 +44,11 @@ namespace filters
 namespace point_cloud_fusion
 {
 /// \brief Class that fuses multiple point clouds from different sources into one by concatanating
-/// them.
+/// them. Clouds which are not in the output frame are transformed using tf.
+///
+/// Clouds are grouped either with an ApproximateTime synchronizer from up to 8 sources, or with a
+/// DeadlineSynchronizer from any number of sources, which bounds the time spent waiting for slow
+/// sources.
 class POINT_CLOUD_FUSION_PUBLIC PointCloudFusionNode : public rclcpp::Node
 {
 public:
@@ -60,6 +67,10 @@ private:
 
   void init();
 
+  void init_approximate_time();
+
+  void init_deadline();
+
   std::chrono::nanoseconds convert_msg_time(builtin_interfaces::msg::Time stamp);
 
   void pointcloud_callback(
@@ -68,21 +79,47 @@ private:
     const PointCloudMsgT::ConstSharedPtr & msg5, const PointCloudMsgT::ConstSharedPtr & msg6,
     const PointCloudMsgT::ConstSharedPtr & msg7, const PointCloudMsgT::ConstSharedPtr & msg8);
 
-  bool8_t concatenate_pointcloud(
-    const PointCloudMsgT & pc_in, PointCloudMsgT & pc_out,
-    uint32_t & concat_idx) const;
+  /// \brief Add a cloud to the deadline synchronizer and try to fuse.
+  /// \param source_idx Index of the source the cloud comes from.
+  /// \param msg The cloud.
+  void deadline_callback(const std::size_t source_idx, const PointCloudMsgT::ConstSharedPtr & msg);
+
+  /// \brief Fuse and publish a group of clouds if the deadline synchronizer emits one, and report
+  /// the lag of each source.
+  void poll_deadline_synchronizer();
+
+  /// \brief Fuse the clouds and publish the result, stamped with the latest stamp of the clouds.
+  /// \param msgs msgs to be fused, nullptr entries are skipped.
+  void fuse_and_publish(const std::vector<PointCloudMsgT::ConstSharedPtr> & msgs);
+
+  /// \brief Get the transform from the frame of a cloud to the output frame. The latest
+  /// available transform is used, as sensor extrinsics are expected to be static.
+  /// \param frame_id Frame of the cloud.
+  /// \param source Gets the transform written to it.
+  /// \return False if the transform is not available.
+  bool8_t get_source_transform(
+    const std::string & frame_id,
+    PointCloudConcatenator::Source & source);
 
   /// \brief This function goes through all of the messages and adds them to the concatenated
   /// point cloud. If a pointcloud cannot be transformed to the output frame, it's ignored. If
   /// concatenation exceeds the maximum capacity, fusion stops and the partially concatenated cloud
   /// is still published.
-  /// \param msgs msgs to be fused.
+  /// \param msgs msgs to be fused, nullptr entries are skipped.
   /// \return Size of the concatenated pointcloud.
-  uint32_t fuse_pc_msgs(const std::array<PointCloudMsgT::ConstSharedPtr, 8> & msgs);
+  uint32_t fuse_pc_msgs(const std::vector<PointCloudMsgT::ConstSharedPtr> & msgs);
 
   PointCloudT m_cloud_concatenated;
+  PointCloudConcatenator m_concatenator;
+  std::vector<PointCloudConcatenator::Source> m_sources;
+  tf2::BufferCore m_tf_buffer;
+  tf2_ros::TransformListener m_tf_listener;
   std::unique_ptr<message_filters::Subscriber<PointCloudMsgT>> m_cloud_subscribers[8];
   std::unique_ptr<message_filters::Synchronizer<SyncPolicyT>> m_cloud_synchronizer;
+  std::vector<PointCloudMsgT::ConstSharedPtr> m_msgs;
+  std::unique_ptr<DeadlineSynchronizer> m_deadline_synchronizer;
+  std::vector<rclcpp::Subscription<PointCloudMsgT>::SharedPtr> m_deadline_subscribers;
+  rclcpp::TimerBase::SharedPtr m_deadline_timer;
   rclcpp::Publisher<PointCloudMsgT>::SharedPtr m_cloud_publisher;
 
   std::vector<std::string> m_input_topics;
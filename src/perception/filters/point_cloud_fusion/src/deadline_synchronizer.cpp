@@ -0,0 +1,222 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <point_cloud_fusion/deadline_synchronizer.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace point_cloud_fusion
+{
+namespace
+{
+std::chrono::nanoseconds to_duration(const builtin_interfaces::msg::Time & stamp)
+{
+  return std::chrono::seconds(stamp.sec) + std::chrono::nanoseconds(stamp.nanosec);
+}
+
+std::chrono::nanoseconds abs_diff(
+  const std::chrono::nanoseconds a,
+  const std::chrono::nanoseconds b)
+{
+  return (a > b) ? (a - b) : (b - a);
+}
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+DeadlineSynchronizer::Entry & DeadlineSynchronizer::Ring::at(const std::size_t idx)
+{
+  return entries[(head + idx) % entries.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const DeadlineSynchronizer::Entry & DeadlineSynchronizer::Ring::at(const std::size_t idx) const
+{
+  return entries[(head + idx) % entries.size()];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void DeadlineSynchronizer::Ring::pop_front()
+{
+  // Release the message right away rather than when the slot gets overwritten
+  entries[head].msg = nullptr;
+  head = (head + 1U) % entries.size();
+  --size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+DeadlineSynchronizer::DeadlineSynchronizer(
+  const std::size_t num_sources,
+  const std::size_t queue_size,
+  const std::chrono::nanoseconds latency_budget,
+  const std::chrono::nanoseconds stamp_tolerance)
+: m_rings(num_sources),
+  m_latency_budget(latency_budget),
+  m_stamp_tolerance(stamp_tolerance),
+  m_last_reference(0),
+  m_has_emitted(false)
+{
+  if ((0U == num_sources) || (0U == queue_size)) {
+    throw std::domain_error{"DeadlineSynchronizer: Need at least one source and queue slot"};
+  }
+  if ((latency_budget.count() < 0) || (stamp_tolerance.count() < 0)) {
+    throw std::domain_error{"DeadlineSynchronizer: Durations must not be negative"};
+  }
+  for (auto & ring : m_rings) {
+    ring.entries.resize(queue_size);
+    ring.head = 0U;
+    ring.size = 0U;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void DeadlineSynchronizer::add(
+  const std::size_t source_idx,
+  const MsgPtrT & msg,
+  const Clock::time_point now)
+{
+  Ring & ring = m_rings.at(source_idx);
+  ++ring.stats.num_received;
+  const auto stamp = to_duration(msg->header.stamp);
+  if (m_has_emitted && (stamp <= (m_last_reference + m_stamp_tolerance))) {
+    // It would have matched a group which is gone already
+    ++ring.stats.num_dropped;
+    return;
+  }
+  if (ring.size == ring.entries.size()) {
+    ring.pop_front();
+    ++ring.stats.num_dropped;
+  }
+  ring.at(ring.size) = Entry{msg, stamp, now};
+  ++ring.size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool8_t DeadlineSynchronizer::poll(const Clock::time_point now, std::vector<MsgPtrT> & msgs)
+{
+  const Entry * const reference_entry = find_reference();
+  if (nullptr == reference_entry) {
+    return false;
+  }
+  const Entry reference = *reference_entry;
+  // A source is resolved if it has a match, or if it has moved past the reference already: stamps
+  // of a single source are increasing, so no match can arrive anymore
+  bool8_t all_resolved = true;
+  for (const auto & ring : m_rings) {
+    if ((find_match(ring, reference.stamp) == ring.size) &&
+      ((0U == ring.size) ||
+      (ring.at(ring.size - 1U).stamp <= (reference.stamp + m_stamp_tolerance))))
+    {
+      all_resolved = false;
+      break;
+    }
+  }
+  if (!all_resolved && (now < (reference.arrival + m_latency_budget))) {
+    return false;
+  }
+
+  msgs.resize(m_rings.size());
+  for (std::size_t idx = 0U; idx < m_rings.size(); ++idx) {
+    Ring & ring = m_rings[idx];
+    const std::size_t match = find_match(ring, reference.stamp);
+    if (match == ring.size) {
+      msgs[idx] = nullptr;
+      ++ring.stats.num_missed;
+      continue;
+    }
+    const Entry & entry = ring.at(match);
+    msgs[idx] = entry.msg;
+    ring.stats.last_lag = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      entry.arrival - reference.arrival);
+    ring.stats.max_lag = std::max(ring.stats.max_lag, ring.stats.last_lag);
+    ++ring.stats.num_fused;
+    // Everything which arrived before the match is superseded by it
+    ring.stats.num_dropped += match;
+    for (std::size_t count = 0U; count <= match; ++count) {
+      ring.pop_front();
+    }
+  }
+  m_last_reference = reference.stamp;
+  m_has_emitted = true;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool8_t DeadlineSynchronizer::get_deadline(Clock::time_point & deadline) const
+{
+  const Entry * const reference = find_reference();
+  if (nullptr == reference) {
+    return false;
+  }
+  deadline = reference->arrival + m_latency_budget;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const DeadlineSynchronizer::SourceStats & DeadlineSynchronizer::stats(
+  const std::size_t source_idx) const
+{
+  return m_rings.at(source_idx).stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t DeadlineSynchronizer::num_sources() const
+{
+  return m_rings.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const DeadlineSynchronizer::Entry * DeadlineSynchronizer::find_reference() const
+{
+  const Entry * ret = nullptr;
+  for (const auto & ring : m_rings) {
+    for (std::size_t idx = 0U; idx < ring.size; ++idx) {
+      const Entry & entry = ring.at(idx);
+      if ((nullptr == ret) || (entry.stamp < ret->stamp)) {
+        ret = &entry;
+      }
+    }
+  }
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t DeadlineSynchronizer::find_match(
+  const Ring & ring,
+  const std::chrono::nanoseconds reference) const
+{
+  std::size_t ret = ring.size;
+  for (std::size_t idx = 0U; idx < ring.size; ++idx) {
+    const auto diff = abs_diff(ring.at(idx).stamp, reference);
+    if ((diff <= m_stamp_tolerance) &&
+      ((ret == ring.size) || (diff < abs_diff(ring.at(ret).stamp, reference))))
+    {
+      ret = idx;
+    }
+  }
+  return ret;
+}
+}  // namespace point_cloud_fusion
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
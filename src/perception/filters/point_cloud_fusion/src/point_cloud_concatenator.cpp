@@ -0,0 +1,206 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <point_cloud_fusion/point_cloud_concatenator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace point_cloud_fusion
+{
+
+constexpr std::size_t PointCloudConcatenator::CHUNK_SIZE;
+
+////////////////////////////////////////////////////////////////////////////////
+PointCloudConcatenator::PointCloudConcatenator(const std::size_t num_threads)
+: m_pool(num_threads),
+  m_chunks(),
+  m_offsets_out()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint32_t PointCloudConcatenator::concatenate(
+  const std::vector<Source> & sources,
+  PointCloudMsgT & cloud_out,
+  std::size_t & num_fused_sources)
+{
+  m_offsets_out = get_offsets(cloud_out);
+  const std::size_t capacity = cloud_out.data.size() / cloud_out.point_step;
+
+  // Plan serially, so that every chunk knows where its points go in the output
+  m_chunks.clear();
+  num_fused_sources = 0U;
+  std::size_t num_points_out = 0U;
+  for (const auto & source : sources) {
+    const PointCloudMsgT & cloud_in = *source.cloud;
+    const std::size_t num_points = static_cast<std::size_t>(cloud_in.width) * cloud_in.height;
+    if ((num_points_out + num_points) > capacity) {
+      break;
+    }
+    if ((num_points > 0U) &&
+      (cloud_in.data.size() <
+      ((static_cast<std::size_t>(cloud_in.height - 1U) * cloud_in.row_step) +
+      (static_cast<std::size_t>(cloud_in.width) * cloud_in.point_step))))
+    {
+      throw std::runtime_error{"PointCloudConcatenator: data of source cloud is too small"};
+    }
+    const bool8_t is_block_copy = is_layout_compatible(cloud_in, cloud_out);
+    const FieldOffsets offsets_in = is_block_copy ? m_offsets_out : get_offsets(cloud_in);
+    for (std::size_t first = 0U; first < num_points; first += CHUNK_SIZE) {
+      m_chunks.push_back(
+        Chunk{&source, is_block_copy, offsets_in, first, num_points_out + first,
+          std::min(CHUNK_SIZE, num_points - first)});
+    }
+    num_points_out += num_points;
+    ++num_fused_sources;
+  }
+
+  m_pool.run(m_chunks.size(), [this, &cloud_out](const std::size_t idx) {
+      copy_chunk(m_chunks[idx], cloud_out);
+    });
+
+  return static_cast<uint32_t>(num_points_out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t PointCloudConcatenator::num_threads() const
+{
+  return m_pool.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool8_t PointCloudConcatenator::is_layout_compatible(
+  const PointCloudMsgT & cloud_in,
+  const PointCloudMsgT & cloud_out)
+{
+  if ((cloud_in.point_step != cloud_out.point_step) ||
+    (cloud_in.is_bigendian != cloud_out.is_bigendian) ||
+    (cloud_in.fields.size() != cloud_out.fields.size()) ||
+    ((cloud_in.height > 1U) && (cloud_in.row_step != (cloud_in.width * cloud_in.point_step))))
+  {
+    return false;
+  }
+  for (std::size_t idx = 0U; idx < cloud_in.fields.size(); ++idx) {
+    const auto & field_in = cloud_in.fields[idx];
+    const auto & field_out = cloud_out.fields[idx];
+    if ((field_in.name != field_out.name) ||
+      (field_in.offset != field_out.offset) ||
+      (field_in.datatype != field_out.datatype) ||
+      (field_in.count != field_out.count))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PointCloudConcatenator::FieldOffsets PointCloudConcatenator::get_offsets(
+  const PointCloudMsgT & cloud)
+{
+  const auto find = [&cloud](const std::string & name) -> uint32_t {
+      for (const auto & field : cloud.fields) {
+        if (field.name == name) {
+          if (sensor_msgs::msg::PointField::FLOAT32 != field.datatype) {
+            throw std::runtime_error{"PointCloudConcatenator: field " + name + " is not float32"};
+          }
+          return field.offset;
+        }
+      }
+      throw std::runtime_error{"PointCloudConcatenator: cloud has no field " + name};
+    };
+  return FieldOffsets{find("x"), find("y"), find("z"), find("intensity")};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PointCloudConcatenator::copy_chunk(const Chunk & chunk, PointCloudMsgT & cloud_out) const
+{
+  const PointCloudMsgT & cloud_in = *chunk.source->cloud;
+  const std::size_t step_in = cloud_in.point_step;
+  const std::size_t step_out = cloud_out.point_step;
+  uint8_t * const data_out = &cloud_out.data[chunk.first_point_out * step_out];
+
+  if (chunk.is_block_copy) {
+    (void)std::memcpy(data_out, &cloud_in.data[chunk.first_point_in * step_in],
+      chunk.num_points * step_out);
+  } else {
+    const FieldOffsets & in = chunk.offsets_in;
+    for (std::size_t idx = 0U; idx < chunk.num_points; ++idx) {
+      const std::size_t pt_idx = chunk.first_point_in + idx;
+      const uint8_t * const pt_in = &cloud_in.data[
+        ((pt_idx / cloud_in.width) * cloud_in.row_step) + ((pt_idx % cloud_in.width) * step_in)];
+      uint8_t * const pt_out = &data_out[idx * step_out];
+      (void)std::memcpy(&pt_out[m_offsets_out.x], &pt_in[in.x], sizeof(float32_t));
+      (void)std::memcpy(&pt_out[m_offsets_out.y], &pt_in[in.y], sizeof(float32_t));
+      (void)std::memcpy(&pt_out[m_offsets_out.z], &pt_in[in.z], sizeof(float32_t));
+      (void)std::memcpy(
+        &pt_out[m_offsets_out.intensity], &pt_in[in.intensity], sizeof(float32_t));
+    }
+  }
+
+  if (!chunk.source->is_identity) {
+    // Transform the copied coordinates in place, with the matrix unpacked into scalars
+    const auto & mat = chunk.source->tf.matrix();
+    const float32_t r00 = mat(0, 0), r01 = mat(0, 1), r02 = mat(0, 2), t0 = mat(0, 3);
+    const float32_t r10 = mat(1, 0), r11 = mat(1, 1), r12 = mat(1, 2), t1 = mat(1, 3);
+    const float32_t r20 = mat(2, 0), r21 = mat(2, 1), r22 = mat(2, 2), t2 = mat(2, 3);
+    const auto transform = [ = ](float32_t (& xyz)[3U]) {
+        const float32_t x = xyz[0U];
+        const float32_t y = xyz[1U];
+        const float32_t z = xyz[2U];
+        xyz[0U] = (r00 * x) + (r01 * y) + (r02 * z) + t0;
+        xyz[1U] = (r10 * x) + (r11 * y) + (r12 * z) + t1;
+        xyz[2U] = (r20 * x) + (r21 * y) + (r22 * z) + t2;
+      };
+    const uint32_t x_off = m_offsets_out.x;
+    if ((m_offsets_out.y == (x_off + 4U)) && (m_offsets_out.z == (x_off + 8U))) {
+      // Common case of packed coordinates: one load and store per point
+      for (std::size_t idx = 0U; idx < chunk.num_points; ++idx) {
+        uint8_t * const pt_out = &data_out[(idx * step_out) + x_off];
+        float32_t xyz[3U];
+        (void)std::memcpy(&xyz[0U], pt_out, sizeof(xyz));
+        transform(xyz);
+        (void)std::memcpy(pt_out, &xyz[0U], sizeof(xyz));
+      }
+    } else {
+      for (std::size_t idx = 0U; idx < chunk.num_points; ++idx) {
+        uint8_t * const pt_out = &data_out[idx * step_out];
+        float32_t xyz[3U];
+        (void)std::memcpy(&xyz[0U], &pt_out[x_off], sizeof(float32_t));
+        (void)std::memcpy(&xyz[1U], &pt_out[m_offsets_out.y], sizeof(float32_t));
+        (void)std::memcpy(&xyz[2U], &pt_out[m_offsets_out.z], sizeof(float32_t));
+        transform(xyz);
+        (void)std::memcpy(&pt_out[x_off], &xyz[0U], sizeof(float32_t));
+        (void)std::memcpy(&pt_out[m_offsets_out.y], &xyz[1U], sizeof(float32_t));
+        (void)std::memcpy(&pt_out[m_offsets_out.z], &xyz[2U], sizeof(float32_t));
+      }
+    }
+  }
+}
+}  // namespace point_cloud_fusion
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -35,10 +36,23 @@ namespace filters
 {
 namespace point_cloud_fusion
 {
+namespace
+{
+std::size_t checked_num_threads(const int64_t num_threads)
+{
+  if (num_threads < 1) {
+    throw std::domain_error("num_threads for point cloud fusion must be at least 1. Found: " +
+            std::to_string(num_threads));
+  }
+  return static_cast<std::size_t>(num_threads);
+}
+}  // namespace
 
 PointCloudFusionNode::PointCloudFusionNode(
   const rclcpp::NodeOptions & node_options)
 : Node("point_cloud_fusion_node", node_options),
+  m_concatenator(checked_num_threads(declare_parameter("num_threads", 1).get<int64_t>())),
+  m_tf_listener(m_tf_buffer, std::shared_ptr<rclcpp::Node>(this, [](auto) {}), false),
   m_cloud_publisher(create_publisher<PointCloudMsgT>("output_topic", rclcpp::QoS(10))),
   m_input_topics(declare_parameter("number_of_sources").get<std::size_t>()),
   m_output_frame_id(declare_parameter("output_frame_id").get<std::string>()),
@@ -54,7 +68,22 @@ void PointCloudFusionNode::init()
 {
   common::lidar_utils::init_pcl_msg(m_cloud_concatenated, m_output_frame_id,
     m_cloud_capacity);
+  m_sources.reserve(m_input_topics.size());
+  m_msgs.reserve(m_input_topics.size());
 
+  const auto sync_mode = declare_parameter("sync_mode", "approximate_time").get<std::string>();
+  if (sync_mode == "approximate_time") {
+    init_approximate_time();
+  } else if (sync_mode == "deadline") {
+    init_deadline();
+  } else {
+    throw std::domain_error("sync_mode for point cloud fusion must be approximate_time or "
+            "deadline. Found: " + sync_mode);
+  }
+}
+
+void PointCloudFusionNode::init_approximate_time()
+{
   if (m_input_topics.size() > 8 || m_input_topics.size() < 2) {
     throw std::domain_error("Number of sources for point cloud fusion must be between 2 and 8."
             " Found: " + std::to_string(m_input_topics.size()));
@@ -80,6 +109,35 @@ void PointCloudFusionNode::init()
     std::placeholders::_6, std::placeholders::_7, std::placeholders::_8));
 }
 
+void PointCloudFusionNode::init_deadline()
+{
+  if (m_input_topics.size() < 2) {
+    throw std::domain_error("Number of sources for point cloud fusion must be at least 2."
+            " Found: " + std::to_string(m_input_topics.size()));
+  }
+  const std::chrono::milliseconds latency_budget{
+    declare_parameter("deadline.latency_budget_ms", 50).get<int64_t>()};
+  const std::chrono::milliseconds stamp_tolerance{
+    declare_parameter("deadline.stamp_tolerance_ms", 50).get<int64_t>()};
+  const auto queue_size = declare_parameter("deadline.queue_size", 4).get<int64_t>();
+  if (queue_size < 1) {
+    throw std::domain_error("deadline.queue_size for point cloud fusion must be at least 1.");
+  }
+  m_deadline_synchronizer = std::make_unique<DeadlineSynchronizer>(m_input_topics.size(),
+      static_cast<std::size_t>(queue_size), latency_budget, stamp_tolerance);
+
+  for (size_t i = 0; i < m_input_topics.size(); ++i) {
+    m_deadline_subscribers.push_back(create_subscription<PointCloudMsgT>(m_input_topics[i],
+      rclcpp::QoS(10), [this, i](const PointCloudMsgT::ConstSharedPtr msg) {
+        deadline_callback(i, msg);
+      }));
+  }
+  // Groups are mostly emitted on arrival of the last cloud; the timer only catches deadlines of
+  // groups with missing sources, so it overshoots the budget by at most one period
+  const auto period = std::max(std::chrono::milliseconds{1}, latency_budget / 4);
+  m_deadline_timer = create_wall_timer(period, [this]() {poll_deadline_synchronizer();});
+}
+
 std::chrono::nanoseconds PointCloudFusionNode::convert_msg_time(builtin_interfaces::msg::Time stamp)
 {
   return std::chrono::seconds(stamp.sec) + std::chrono::nanoseconds(stamp.nanosec);
@@ -92,24 +150,62 @@ PointCloudFusionNode::pointcloud_callback(
   const PointCloudMsgT::ConstSharedPtr & msg5, const PointCloudMsgT::ConstSharedPtr & msg6,
   const PointCloudMsgT::ConstSharedPtr & msg7, const PointCloudMsgT::ConstSharedPtr & msg8)
 {
-  std::array<PointCloudMsgT::ConstSharedPtr, 8> msgs{msg1, msg2, msg3, msg4, msg5, msg6, msg7,
-    msg8};
+  const std::array<PointCloudMsgT::ConstSharedPtr, 8> msgs{msg1, msg2, msg3, msg4, msg5, msg6,
+    msg7, msg8};
+  m_msgs.assign(msgs.begin(),
+    msgs.begin() + static_cast<std::ptrdiff_t>(m_input_topics.size()));
+  fuse_and_publish(m_msgs);
+}
 
+void PointCloudFusionNode::deadline_callback(
+  const std::size_t source_idx,
+  const PointCloudMsgT::ConstSharedPtr & msg)
+{
+  m_deadline_synchronizer->add(source_idx, msg, DeadlineSynchronizer::Clock::now());
+  poll_deadline_synchronizer();
+}
+
+void PointCloudFusionNode::poll_deadline_synchronizer()
+{
+  if (!m_deadline_synchronizer->poll(DeadlineSynchronizer::Clock::now(), m_msgs)) {
+    return;
+  }
+  for (std::size_t i = 0; i < m_msgs.size(); ++i) {
+    const auto & stats = m_deadline_synchronizer->stats(i);
+    if (m_msgs[i]) {
+      RCLCPP_DEBUG(get_logger(), "%s lag: %ld us, max lag: %ld us", m_input_topics[i].c_str(),
+        std::chrono::duration_cast<std::chrono::microseconds>(stats.last_lag).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(stats.max_lag).count());
+    } else {
+      RCLCPP_WARN(get_logger(), "%s missed the latency budget, fusing without it. "
+        "Missed: %lu, fused: %lu, dropped: %lu", m_input_topics[i].c_str(),
+        stats.num_missed, stats.num_fused, stats.num_dropped);
+    }
+  }
+  fuse_and_publish(m_msgs);
+}
+
+void PointCloudFusionNode::fuse_and_publish(
+  const std::vector<PointCloudMsgT::ConstSharedPtr> & msgs)
+{
   uint32_t pc_concat_idx = 0;
   // reset pointcloud before using
   common::lidar_utils::reset_pcl_msg(m_cloud_concatenated, m_cloud_capacity,
     pc_concat_idx);
 
-  auto latest_stamp = msgs[0]->header.stamp;
+  builtin_interfaces::msg::Time latest_stamp;
   auto total_size = 0U;
 
   // Get the latest time stamp of the point clouds and find the total size after concatenation
-  for (uint32_t msg_idx = 0; msg_idx < m_input_topics.size(); ++msg_idx) {
-    const auto & stamp = msgs[msg_idx]->header.stamp;
+  for (const auto & msg : msgs) {
+    if (!msg) {
+      continue;
+    }
+    const auto & stamp = msg->header.stamp;
     if (convert_msg_time(stamp) > convert_msg_time(latest_stamp)) {
       latest_stamp = stamp;
     }
-    total_size += msgs[msg_idx]->width;
+    total_size += msg->width;
   }
 
   if (total_size > m_cloud_capacity) {
@@ -130,66 +226,57 @@ PointCloudFusionNode::pointcloud_callback(
 }
 
 uint32_t PointCloudFusionNode::fuse_pc_msgs(
-  const std::array<PointCloudMsgT::ConstSharedPtr, 8> & msgs)
+  const std::vector<PointCloudMsgT::ConstSharedPtr> & msgs)
 {
-  uint32_t pc_concat_idx = 0;
-
-  for (size_t i = 0; i < m_input_topics.size(); ++i) {
-    bool8_t concat_success = concatenate_pointcloud(*msgs[i], m_cloud_concatenated, pc_concat_idx);
-    if (!concat_success) {
-      // Cloud could not be added to the m_cloud_concatenated since the size limit is reached.
-      // No point in trying the remaining clouds.
-      RCLCPP_WARN(get_logger(), "Reached the capacity of the fused cloud, ignoring the "
-        "remaining cloud messages and publishing.");
-      break;
+  m_sources.clear();
+  for (const auto & msg : msgs) {
+    if (!msg) {
+      continue;
     }
+    PointCloudConcatenator::Source source{msg.get(), {}, true};
+    if (get_source_transform(msg->header.frame_id, source)) {
+      m_sources.push_back(source);
+    }
+  }
+
+  std::size_t num_fused_sources = 0U;
+  const auto pc_concat_idx =
+    m_concatenator.concatenate(m_sources, m_cloud_concatenated, num_fused_sources);
+  if (num_fused_sources < m_sources.size()) {
+    // Cloud could not be added to the m_cloud_concatenated since the size limit is reached.
+    // No point in trying the remaining clouds.
+    RCLCPP_WARN(get_logger(), "Reached the capacity of the fused cloud, ignoring the "
+      "remaining cloud messages and publishing.");
   }
   return pc_concat_idx;
 }
 
-bool8_t PointCloudFusionNode::concatenate_pointcloud(
-  const sensor_msgs::msg::PointCloud2 & pc_in,
-  sensor_msgs::msg::PointCloud2 & pc_out,
-  uint32_t & concat_idx) const
-{
-  auto ret = true;
-  if ((pc_in.width + concat_idx) > m_cloud_capacity) {
-    RCLCPP_WARN(
-      this->get_logger(),
-      "Pointcloud is too large to be fused and will be ignored.");
-    ret = false;
-  } else {
-    sensor_msgs::PointCloud2ConstIterator<float32_t> x_it_in(pc_in, "x");
-    sensor_msgs::PointCloud2ConstIterator<float32_t> y_it_in(pc_in, "y");
-    sensor_msgs::PointCloud2ConstIterator<float32_t> z_it_in(pc_in, "z");
-    sensor_msgs::PointCloud2ConstIterator<float32_t> intensity_it_in(pc_in, "intensity");
-
-    while (x_it_in != x_it_in.end() &&
-      y_it_in != y_it_in.end() &&
-      z_it_in != z_it_in.end() &&
-      intensity_it_in != intensity_it_in.end())
-    {
-      common::types::PointXYZIF pt;
-      pt.x = *x_it_in;
-      pt.y = *y_it_in;
-      pt.z = *z_it_in;
-      pt.intensity = *intensity_it_in;
-
-      if (common::lidar_utils::add_point_to_cloud(pc_out, pt, concat_idx)) {
-        ++x_it_in;
-        ++y_it_in;
-        ++z_it_in;
-        ++intensity_it_in;
-      } else {
-        // Somehow the point could be inserted to the concatenated cloud. Something regarding
-        // the cloud sizes must be off.
-        RCLCPP_ERROR(this->get_logger(), "Points could not be added correctly to the fused cloud");
-        ret = false;
-        break;
-      }
-    }
+bool8_t PointCloudFusionNode::get_source_transform(
+  const std::string & frame_id,
+  PointCloudConcatenator::Source & source)
+{
+  source.is_identity = frame_id.empty() || (frame_id == m_output_frame_id);
+  if (source.is_identity) {
+    return true;
+  }
+  geometry_msgs::msg::TransformStamped tf;
+  try {
+    tf = m_tf_buffer.lookupTransform(m_output_frame_id, frame_id, tf2::TimePointZero);
+  } catch (const tf2::TransformException & ex) {
+    RCLCPP_WARN(get_logger(), "Could not transform pointcloud from frame %s to the output "
+      "frame, it will be ignored: %s", frame_id.c_str(), ex.what());
+    return false;
   }
-  return ret;
+  const auto & rotation = tf.transform.rotation;
+  const auto & translation = tf.transform.translation;
+  source.tf.setIdentity();
+  source.tf.translate(
+    Eigen::Vector3f{static_cast<float32_t>(translation.x), static_cast<float32_t>(translation.y),
+      static_cast<float32_t>(translation.z)});
+  source.tf.rotate(
+    Eigen::Quaternionf{static_cast<float32_t>(rotation.w), static_cast<float32_t>(rotation.x),
+      static_cast<float32_t>(rotation.y), static_cast<float32_t>(rotation.z)});
+  return true;
 }
 }  // namespace point_cloud_fusion
 }  // namespace filters
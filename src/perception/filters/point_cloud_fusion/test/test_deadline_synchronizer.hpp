@@ -0,0 +1,206 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef TEST_DEADLINE_SYNCHRONIZER_HPP_
+#define TEST_DEADLINE_SYNCHRONIZER_HPP_
+
+#include <gtest/gtest.h>
+#include <point_cloud_fusion/deadline_synchronizer.hpp>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using autoware::perception::filters::point_cloud_fusion::DeadlineSynchronizer;
+
+class TestDeadlineSynchronizer : public ::testing::Test
+{
+protected:
+  using ms = std::chrono::milliseconds;
+
+  TestDeadlineSynchronizer()
+  : m_sync{3U, 4U, ms{30}, ms{20}},
+    m_start{DeadlineSynchronizer::Clock::now()}
+  {
+  }
+
+  /// Cloud stamped the given number of milliseconds after the epoch
+  static DeadlineSynchronizer::MsgPtrT make_msg(const int32_t stamp_ms)
+  {
+    auto msg = std::make_shared<sensor_msgs::msg::PointCloud2>();
+    msg->header.stamp.sec = stamp_ms / 1000;
+    msg->header.stamp.nanosec = static_cast<uint32_t>((stamp_ms % 1000) * 1000000);
+    return msg;
+  }
+
+  DeadlineSynchronizer::Clock::time_point at(const int32_t time_ms) const
+  {
+    return m_start + ms{time_ms};
+  }
+
+  DeadlineSynchronizer m_sync;
+  DeadlineSynchronizer::Clock::time_point m_start;
+  std::vector<DeadlineSynchronizer::MsgPtrT> m_msgs;
+};
+
+TEST_F(TestDeadlineSynchronizer, bad_input) {
+  EXPECT_THROW(DeadlineSynchronizer(0U, 4U, ms{30}, ms{20}), std::domain_error);
+  EXPECT_THROW(DeadlineSynchronizer(2U, 0U, ms{30}, ms{20}), std::domain_error);
+  EXPECT_THROW(DeadlineSynchronizer(2U, 4U, ms{-1}, ms{20}), std::domain_error);
+  EXPECT_THROW(m_sync.add(3U, make_msg(100), at(0)), std::out_of_range);
+  EXPECT_THROW(m_sync.stats(3U), std::out_of_range);
+  EXPECT_EQ(m_sync.num_sources(), 3U);
+}
+
+TEST_F(TestDeadlineSynchronizer, all_sources) {
+  DeadlineSynchronizer::Clock::time_point deadline;
+  EXPECT_FALSE(m_sync.poll(at(0), m_msgs));
+  EXPECT_FALSE(m_sync.get_deadline(deadline));
+  const auto msg0 = make_msg(100);
+  const auto msg1 = make_msg(105);
+  const auto msg2 = make_msg(95);
+  m_sync.add(0U, msg0, at(0));
+  m_sync.add(1U, msg1, at(5));
+  EXPECT_FALSE(m_sync.poll(at(5), m_msgs));
+  ASSERT_TRUE(m_sync.get_deadline(deadline));
+  EXPECT_EQ(deadline, at(30));
+  m_sync.add(2U, msg2, at(10));
+  // The oldest stamp is the reference now, its cloud arrived last
+  ASSERT_TRUE(m_sync.get_deadline(deadline));
+  EXPECT_EQ(deadline, at(40));
+  // Emitted right away, without waiting for the deadline
+  ASSERT_TRUE(m_sync.poll(at(10), m_msgs));
+  ASSERT_EQ(m_msgs.size(), 3U);
+  EXPECT_EQ(m_msgs[0U], msg0);
+  EXPECT_EQ(m_msgs[1U], msg1);
+  EXPECT_EQ(m_msgs[2U], msg2);
+  EXPECT_EQ(m_sync.stats(0U).last_lag, ms{-10});
+  EXPECT_EQ(m_sync.stats(1U).last_lag, ms{-5});
+  EXPECT_EQ(m_sync.stats(2U).last_lag, ms{0});
+  for (std::size_t idx = 0U; idx < 3U; ++idx) {
+    EXPECT_EQ(m_sync.stats(idx).num_received, 1U);
+    EXPECT_EQ(m_sync.stats(idx).num_fused, 1U);
+    EXPECT_EQ(m_sync.stats(idx).num_missed, 0U);
+  }
+  EXPECT_FALSE(m_sync.poll(at(100), m_msgs));
+}
+
+TEST_F(TestDeadlineSynchronizer, deadline) {
+  const auto msg0 = make_msg(100);
+  const auto msg1 = make_msg(100);
+  m_sync.add(0U, msg0, at(0));
+  m_sync.add(1U, msg1, at(8));
+  EXPECT_FALSE(m_sync.poll(at(29), m_msgs));
+  ASSERT_TRUE(m_sync.poll(at(30), m_msgs));
+  EXPECT_EQ(m_msgs[0U], msg0);
+  EXPECT_EQ(m_msgs[1U], msg1);
+  EXPECT_EQ(m_msgs[2U], nullptr);
+  EXPECT_EQ(m_sync.stats(1U).last_lag, ms{8});
+  EXPECT_EQ(m_sync.stats(1U).max_lag, ms{8});
+  EXPECT_EQ(m_sync.stats(2U).num_missed, 1U);
+  // The slow source finally arrives, too late to be fused
+  m_sync.add(2U, make_msg(99), at(50));
+  EXPECT_EQ(m_sync.stats(2U).num_dropped, 1U);
+  EXPECT_FALSE(m_sync.poll(at(1000), m_msgs));
+}
+
+TEST_F(TestDeadlineSynchronizer, match_by_stamp) {
+  // Source 0 runs ahead, sources 1 and 2 catch up later
+  const auto msg0a = make_msg(100);
+  const auto msg0b = make_msg(200);
+  const auto msg1a = make_msg(102);
+  const auto msg1b = make_msg(201);
+  const auto msg2a = make_msg(99);
+  m_sync.add(0U, msg0a, at(0));
+  m_sync.add(0U, msg0b, at(1));
+  m_sync.add(1U, msg1a, at(2));
+  m_sync.add(1U, msg1b, at(3));
+  EXPECT_FALSE(m_sync.poll(at(3), m_msgs));
+  m_sync.add(2U, msg2a, at(4));
+  ASSERT_TRUE(m_sync.poll(at(4), m_msgs));
+  EXPECT_EQ(m_msgs[0U], msg0a);
+  EXPECT_EQ(m_msgs[1U], msg1a);
+  EXPECT_EQ(m_msgs[2U], msg2a);
+  // Source 2 skips a cloud: it is known to be missing as soon as it is past the tolerance
+  const auto msg2c = make_msg(300);
+  m_sync.add(2U, msg2c, at(5));
+  ASSERT_TRUE(m_sync.poll(at(5), m_msgs));
+  EXPECT_EQ(m_msgs[0U], msg0b);
+  EXPECT_EQ(m_msgs[1U], msg1b);
+  EXPECT_EQ(m_msgs[2U], nullptr);
+  EXPECT_EQ(m_sync.stats(2U).num_missed, 1U);
+  // Only source 2 is pending
+  EXPECT_FALSE(m_sync.poll(at(34), m_msgs));
+  ASSERT_TRUE(m_sync.poll(at(35), m_msgs));
+  EXPECT_EQ(m_msgs[0U], nullptr);
+  EXPECT_EQ(m_msgs[1U], nullptr);
+  EXPECT_EQ(m_msgs[2U], msg2c);
+}
+
+TEST_F(TestDeadlineSynchronizer, ring_overflow) {
+  DeadlineSynchronizer sync{2U, 2U, ms{30}, ms{20}};
+  sync.add(0U, make_msg(100), at(0));
+  sync.add(0U, make_msg(200), at(100));
+  const auto newest = make_msg(300);
+  sync.add(0U, newest, at(200));
+  EXPECT_EQ(sync.stats(0U).num_dropped, 1U);
+  // The stale group is past its deadline, the newest one is not
+  ASSERT_TRUE(sync.poll(at(200), m_msgs));
+  EXPECT_FALSE(sync.poll(at(200), m_msgs));
+  ASSERT_TRUE(sync.poll(at(230), m_msgs));
+  EXPECT_EQ(m_msgs[0U], newest);
+  EXPECT_EQ(m_msgs[1U], nullptr);
+  EXPECT_EQ(sync.stats(0U).num_fused, 2U);
+  EXPECT_EQ(sync.stats(1U).num_missed, 2U);
+}
+
+// Sources at 10 Hz, one of which is always 80 ms late: the output latency stays within the budget
+// and no groups are emitted with the fast sources split up
+TEST_F(TestDeadlineSynchronizer, bounded_latency) {
+  constexpr int32_t period_ms = 100;
+  constexpr int32_t budget_ms = 30;
+  constexpr int32_t step_ms = 5;
+  DeadlineSynchronizer sync{4U, 4U, ms{budget_ms}, ms{20}};
+  int32_t num_groups = 0;
+  for (int32_t time_ms = 0; time_ms < (100 * period_ms); time_ms += step_ms) {
+    if ((time_ms % period_ms) == 0) {
+      for (std::size_t idx = 0U; idx < 3U; ++idx) {
+        sync.add(idx, make_msg(time_ms + static_cast<int32_t>(idx)), at(time_ms));
+      }
+    }
+    if ((time_ms % period_ms) == 80) {
+      sync.add(3U, make_msg(time_ms - 80), at(time_ms));
+    }
+    DeadlineSynchronizer::Clock::time_point deadline;
+    if (sync.get_deadline(deadline)) {
+      // Polling at step_ms granularity, like the node timer
+      EXPECT_LE(at(time_ms), deadline + ms{step_ms});
+    }
+    while (sync.poll(at(time_ms), m_msgs)) {
+      ++num_groups;
+      EXPECT_NE(m_msgs[0U], nullptr);
+      EXPECT_NE(m_msgs[1U], nullptr);
+      EXPECT_NE(m_msgs[2U], nullptr);
+      EXPECT_EQ(m_msgs[3U], nullptr);
+    }
+  }
+  EXPECT_EQ(num_groups, 100);
+  EXPECT_EQ(sync.stats(0U).num_fused, 100U);
+  EXPECT_EQ(sync.stats(3U).num_missed, 100U);
+  EXPECT_EQ(sync.stats(3U).num_dropped, 100U);
+}
+
+#endif  // TEST_DEADLINE_SYNCHRONIZER_HPP_
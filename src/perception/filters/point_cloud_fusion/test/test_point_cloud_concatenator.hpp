@@ -0,0 +1,269 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#ifndef TEST_POINT_CLOUD_CONCATENATOR_HPP_
+#define TEST_POINT_CLOUD_CONCATENATOR_HPP_
+
+#include <gtest/gtest.h>
+#include <point_cloud_fusion/point_cloud_concatenator.hpp>
+#include <lidar_utils/point_cloud_utils.hpp>
+#include <common/types.hpp>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
+using autoware::common::types::PointXYZIF;
+using autoware::perception::filters::point_cloud_fusion::PointCloudConcatenator;
+
+class TestPointCloudConcatenator : public ::testing::Test
+{
+protected:
+  using PointCloud2 = sensor_msgs::msg::PointCloud2;
+
+  /// Cloud with the default x, y, z, intensity layout, with points derived from the seed
+  static PointCloud2 make_cloud(const std::size_t size, const float32_t seed)
+  {
+    PointCloud2 msg;
+    autoware::common::lidar_utils::init_pcl_msg(msg, "base_link", size);
+    uint32_t pidx = 0U;
+    for (std::size_t idx = 0U; idx < size; ++idx) {
+      autoware::common::lidar_utils::add_point_to_cloud(msg, make_point(idx, seed), pidx);
+    }
+    return msg;
+  }
+
+  /// Cloud with a different layout: an extra ring field and reversed field order
+  static PointCloud2 make_padded_cloud(const std::size_t size, const float32_t seed)
+  {
+    PointCloud2 msg;
+    msg.header.frame_id = "lidar";
+    msg.height = 1U;
+    msg.width = static_cast<uint32_t>(size);
+    msg.point_step = 20U;
+    msg.row_step = msg.width * msg.point_step;
+    const std::vector<std::string> names{"ring", "intensity", "z", "y", "x"};
+    for (std::size_t idx = 0U; idx < names.size(); ++idx) {
+      sensor_msgs::msg::PointField field;
+      field.name = names[idx];
+      field.offset = static_cast<uint32_t>(idx * 4U);
+      field.datatype = (idx == 0U) ?
+        sensor_msgs::msg::PointField::UINT32 : sensor_msgs::msg::PointField::FLOAT32;
+      field.count = 1U;
+      msg.fields.push_back(field);
+    }
+    msg.data.resize(size * msg.point_step);
+    for (std::size_t idx = 0U; idx < size; ++idx) {
+      const PointXYZIF pt = make_point(idx, seed);
+      const float32_t values[4U] = {pt.intensity, pt.z, pt.y, pt.x};
+      const uint32_t ring = static_cast<uint32_t>(idx % 16U);
+      (void)std::memcpy(&msg.data[idx * msg.point_step], &ring, sizeof(ring));
+      (void)std::memcpy(&msg.data[(idx * msg.point_step) + 4U], &values[0U], sizeof(values));
+    }
+    return msg;
+  }
+
+  static PointXYZIF make_point(const std::size_t idx, const float32_t seed)
+  {
+    PointXYZIF pt;
+    pt.x = seed + static_cast<float32_t>(idx);
+    pt.y = seed - (0.5F * static_cast<float32_t>(idx));
+    pt.z = 0.01F * static_cast<float32_t>(idx);
+    pt.intensity = seed;
+    return pt;
+  }
+
+  /// Read a point of a cloud with the default layout
+  static PointXYZIF get_point(const PointCloud2 & msg, const std::size_t idx)
+  {
+    float32_t values[4U];
+    (void)std::memcpy(&values[0U], &msg.data[idx * msg.point_step], sizeof(values));
+    PointXYZIF pt;
+    pt.x = values[0U];
+    pt.y = values[1U];
+    pt.z = values[2U];
+    pt.intensity = values[3U];
+    return pt;
+  }
+
+  static void expect_point_eq(const PointXYZIF & actual, const PointXYZIF & expected)
+  {
+    EXPECT_FLOAT_EQ(actual.x, expected.x);
+    EXPECT_FLOAT_EQ(actual.y, expected.y);
+    EXPECT_FLOAT_EQ(actual.z, expected.z);
+    EXPECT_FLOAT_EQ(actual.intensity, expected.intensity);
+  }
+
+  static PointCloud2 make_output(const std::size_t capacity)
+  {
+    PointCloud2 msg;
+    autoware::common::lidar_utils::init_pcl_msg(msg, "base_link", capacity);
+    return msg;
+  }
+
+  static PointCloudConcatenator::Source make_source(const PointCloud2 & cloud)
+  {
+    return PointCloudConcatenator::Source{&cloud, PointCloudConcatenator::TransformT::Identity(),
+      true};
+  }
+};
+
+TEST_F(TestPointCloudConcatenator, block_copy) {
+  // Larger than a chunk, so that sources get split
+  const std::size_t size = PointCloudConcatenator::CHUNK_SIZE + 123U;
+  const std::vector<PointCloud2> clouds{make_cloud(size, 1.0F), make_cloud(7U, 2.0F),
+    make_cloud(size, 3.0F)};
+  std::vector<PointCloudConcatenator::Source> sources;
+  for (const auto & cloud : clouds) {
+    EXPECT_TRUE(PointCloudConcatenator::is_layout_compatible(cloud, make_output(1U)));
+    sources.push_back(make_source(cloud));
+  }
+  for (const std::size_t num_threads : {1U, 3U}) {
+    PointCloudConcatenator concatenator{num_threads};
+    EXPECT_EQ(concatenator.num_threads(), num_threads);
+    auto output = make_output(3U * size);
+    std::size_t num_fused_sources = 0U;
+    const auto num_points = concatenator.concatenate(sources, output, num_fused_sources);
+    EXPECT_EQ(num_fused_sources, 3U);
+    ASSERT_EQ(num_points, (2U * size) + 7U);
+    std::size_t out_idx = 0U;
+    for (const auto & cloud : clouds) {
+      for (std::size_t idx = 0U; idx < cloud.width; ++idx) {
+        expect_point_eq(get_point(output, out_idx), get_point(cloud, idx));
+        ++out_idx;
+      }
+    }
+  }
+}
+
+TEST_F(TestPointCloudConcatenator, transform) {
+  const auto cloud = make_cloud(100U, 1.0F);
+  const auto padded_cloud = make_padded_cloud(100U, 1.0F);
+  EXPECT_FALSE(PointCloudConcatenator::is_layout_compatible(padded_cloud, make_output(1U)));
+  // Quarter turn around z, then shift
+  PointCloudConcatenator::TransformT tf = PointCloudConcatenator::TransformT::Identity();
+  tf.translate(Eigen::Vector3f{1.0F, 2.0F, 3.0F});
+  tf.rotate(Eigen::AngleAxisf{1.57079632679F, Eigen::Vector3f::UnitZ()});
+  const std::vector<PointCloudConcatenator::Source> sources{
+    PointCloudConcatenator::Source{&cloud, tf, false},
+    PointCloudConcatenator::Source{&padded_cloud, tf, false},
+    make_source(padded_cloud)};
+
+  PointCloudConcatenator concatenator{2U};
+  auto output = make_output(300U);
+  std::size_t num_fused_sources = 0U;
+  ASSERT_EQ(concatenator.concatenate(sources, output, num_fused_sources), 300U);
+  EXPECT_EQ(num_fused_sources, 3U);
+  for (std::size_t idx = 0U; idx < 100U; ++idx) {
+    const PointXYZIF in = make_point(idx, 1.0F);
+    PointXYZIF expected = in;
+    expected.x = 1.0F - in.y;
+    expected.y = 2.0F + in.x;
+    expected.z = 3.0F + in.z;
+    const auto check = [&expected](const PointXYZIF & actual) {
+        EXPECT_NEAR(actual.x, expected.x, 1.0E-4F);
+        EXPECT_NEAR(actual.y, expected.y, 1.0E-4F);
+        EXPECT_NEAR(actual.z, expected.z, 1.0E-4F);
+        EXPECT_FLOAT_EQ(actual.intensity, expected.intensity);
+      };
+    // Block copy, then transform
+    check(get_point(output, idx));
+    // Gather, then transform
+    check(get_point(output, 100U + idx));
+    // Gather only
+    expect_point_eq(get_point(output, 200U + idx), in);
+  }
+}
+
+TEST_F(TestPointCloudConcatenator, capacity) {
+  const auto cloud1 = make_cloud(10U, 1.0F);
+  const auto cloud2 = make_cloud(20U, 2.0F);
+  const auto cloud3 = make_cloud(1U, 3.0F);
+  const std::vector<PointCloudConcatenator::Source> sources{
+    make_source(cloud1), make_source(cloud2), make_source(cloud3)};
+  PointCloudConcatenator concatenator{2U};
+  auto output = make_output(25U);
+  std::size_t num_fused_sources = 0U;
+  // The second cloud does not fit, so it and everything after it is dropped
+  EXPECT_EQ(concatenator.concatenate(sources, output, num_fused_sources), 10U);
+  EXPECT_EQ(num_fused_sources, 1U);
+  EXPECT_EQ(output.data.size(), 25U * output.point_step);
+}
+
+TEST_F(TestPointCloudConcatenator, bad_input) {
+  EXPECT_THROW(PointCloudConcatenator{0U}, std::domain_error);
+  auto cloud = make_padded_cloud(10U, 1.0F);
+  cloud.fields.pop_back();
+  PointCloudConcatenator concatenator{1U};
+  auto output = make_output(10U);
+  std::size_t num_fused_sources = 0U;
+  EXPECT_THROW(
+    concatenator.concatenate({make_source(cloud)}, output, num_fused_sources),
+    std::runtime_error);
+  cloud = make_padded_cloud(10U, 1.0F);
+  cloud.data.resize(10U);
+  EXPECT_THROW(
+    concatenator.concatenate({make_source(cloud)}, output, num_fused_sources),
+    std::runtime_error);
+}
+
+// Fusing 2-8 VLP16 sized clouds, as block copies, block copies with a transform and gathers of
+// clouds with a different layout
+TEST_F(TestPointCloudConcatenator, benchmark) {
+  const std::size_t size = 28800U;
+  const std::size_t max_sources = 8U;
+  std::vector<PointCloud2> clouds;
+  std::vector<PointCloud2> padded_clouds;
+  for (std::size_t idx = 0U; idx < max_sources; ++idx) {
+    clouds.push_back(make_cloud(size, static_cast<float32_t>(idx)));
+    padded_clouds.push_back(make_padded_cloud(size, static_cast<float32_t>(idx)));
+  }
+  PointCloudConcatenator::TransformT tf = PointCloudConcatenator::TransformT::Identity();
+  tf.translate(Eigen::Vector3f{1.0F, 2.0F, 3.0F});
+  tf.rotate(Eigen::AngleAxisf{0.3F, Eigen::Vector3f::UnitZ()});
+
+  PointCloudConcatenator concatenator{1U};
+  auto output = make_output(size * max_sources);
+  const std::size_t iterations = 20U;
+  for (std::size_t num_sources = 2U; num_sources <= max_sources; num_sources *= 2U) {
+    const auto time = [&](const std::vector<PointCloud2> & inputs, const bool8_t is_identity) {
+        std::vector<PointCloudConcatenator::Source> sources;
+        for (std::size_t idx = 0U; idx < num_sources; ++idx) {
+          sources.push_back(PointCloudConcatenator::Source{&inputs[idx], tf, is_identity});
+        }
+        std::size_t num_fused_sources = 0U;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t iter = 0U; iter < iterations; ++iter) {
+          EXPECT_EQ(concatenator.concatenate(sources, output, num_fused_sources),
+            num_sources * size);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() /
+               static_cast<int64_t>(iterations);
+      };
+    std::cerr << num_sources << " sources, block copy: " << time(clouds, true) << " µs\n";
+    std::cerr << num_sources << " sources, block copy + transform: " << time(clouds, false) <<
+      " µs\n";
+    std::cerr << num_sources << " sources, gather + transform: " << time(padded_clouds, false) <<
+      " µs\n";
+  }
+}
+
+#endif  // TEST_POINT_CLOUD_CONCATENATOR_HPP_
@@ -15,6 +15,8 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include "gtest/gtest.h"
+#include "test_point_cloud_concatenator.hpp"
+#include "test_deadline_synchronizer.hpp"
 #include "test_point_cloud_fusion.hpp"
 
 int32_t main(int32_t argc, char ** argv)
@@ -198,4 +198,63 @@ TEST_F(TestPCF, test_basic_fusion) {
   EXPECT_TRUE(test_completed);
 }
 
+TEST_F(TestPCF, test_deadline_fusion) {
+  std::vector<rclcpp::Parameter> params;
+  params.emplace_back("number_of_sources", 3);
+  params.emplace_back("output_frame_id", "base_link");
+  params.emplace_back("cloud_size", static_cast<int64_t>(55000U));
+  params.emplace_back("sync_mode", "deadline");
+  params.emplace_back("deadline.latency_budget_ms", 20);
+
+  rclcpp::NodeOptions node_options;
+  node_options.parameter_overrides(params);
+
+  auto pcf_node =
+    std::make_shared<autoware::perception::filters::point_cloud_fusion::PointCloudFusionNode>(
+    node_options);
+
+  bool8_t test_completed = false;
+  auto time0 = std::chrono::system_clock::now();
+  auto t0 = to_msg_time(time0);
+  auto t1 = to_msg_time(time0 + std::chrono::milliseconds(1));
+
+  auto pc1 = make_pc({1, 2, 3}, t0);
+  auto pc2 = make_pc({4, 5, 6}, t1);
+  auto expected_result = make_pc({1, 2, 3, 4, 5, 6}, t1);
+
+  auto pub_ptr1 = pcf_node->create_publisher<sensor_msgs::msg::PointCloud2>("input_topic1",
+      rclcpp::QoS(10));
+  auto pub_ptr2 = pcf_node->create_publisher<sensor_msgs::msg::PointCloud2>("input_topic2",
+      rclcpp::QoS(10));
+
+  auto handle_concat =
+    [&expected_result,
+    &test_completed](const sensor_msgs::msg::PointCloud2::SharedPtr msg) -> void {
+      check_pcl_eq(*msg, expected_result);
+      test_completed = true;
+    };
+
+  auto sub_ptr = pcf_node->create_subscription<sensor_msgs::msg::PointCloud2>("output_topic",
+      rclcpp::QoS(10), handle_concat);
+
+  // The third source never publishes, no reference message is needed either
+  pub_ptr1->publish(pc1);
+  pub_ptr2->publish(pc2);
+
+  auto start_time = std::chrono::system_clock::now();
+  auto max_test_dur = std::chrono::seconds(1);
+  auto timed_out = false;
+
+  while (rclcpp::ok() && !test_completed) {
+    rclcpp::spin_some(pcf_node);
+    rclcpp::sleep_for(std::chrono::milliseconds(10));
+    if (std::chrono::system_clock::now() - start_time > max_test_dur) {
+      timed_out = true;
+      break;
+    }
+  }
+  EXPECT_FALSE(timed_out);
+  EXPECT_TRUE(test_completed);
+}
+
 #endif  // TEST_POINT_CLOUD_FUSION_HPP_
@@ -0,0 +1,112 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines a multithreaded driver for ray ground classification
+
+#ifndef RAY_GROUND_CLASSIFIER__PARALLEL_RAY_GROUND_CLASSIFIER_HPP_
+#define RAY_GROUND_CLASSIFIER__PARALLEL_RAY_GROUND_CLASSIFIER_HPP_
+
+#include <autoware_auto_algorithm/algorithm.hpp>
+#include <common/types.hpp>
+#include <helper_functions/worker_pool.hpp>
+#include <ray_ground_classifier/ray_aggregator.hpp>
+#include <ray_ground_classifier/ray_ground_classifier.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace ray_ground_classifier
+{
+
+/// \brief Partitions all ready rays of a RayAggregator into ground and nonground points, using
+///        a pool of threads. Rays are independent, so each thread sorts and classifies whole rays
+///        with its own RayGroundClassifier, appending the results to its own output buffers.
+///        The buffers are then merged in the order the rays were handed out by the aggregator, so
+///        the output is identical to partitioning the rays one by one, regardless of the number
+///        of threads or scheduling.
+class RAY_GROUND_CLASSIFIER_PUBLIC ParallelRayGroundClassifier
+{
+public:
+  /// \brief Constructor
+  /// \param[in] cfg Ray ground filter configuration parameters
+  /// \param[in] num_threads The number of threads partitioning rays, including the calling thread
+  /// \throw std::domain_error If num_threads is zero
+  ParallelRayGroundClassifier(const Config & cfg, const std::size_t num_threads);
+
+  /// \brief Drain all ready rays from the aggregator and partition them
+  /// \param[inout] aggregator The aggregator to take ready rays from
+  /// \param[out] ground_points Gets overwritten with the ground points of all rays, in ray order
+  /// \param[out] nonground_points Gets overwritten with the nonground points of all rays, in ray
+  ///                              order
+  /// \throw std::runtime_error If a ray cannot be partitioned, see RayGroundClassifier::partition
+  void partition(
+    RayAggregator & aggregator,
+    std::vector<PointXYZIF> & ground_points,
+    std::vector<PointXYZIF> & nonground_points);
+
+  /// \brief Get the number of threads partitioning rays
+  /// \return The number of threads, including the calling thread
+  std::size_t num_threads() const;
+
+private:
+  /// \brief Per thread state
+  struct Worker
+  {
+    explicit Worker(const Config & cfg);
+    RayGroundClassifier classifier;
+    autoware::common::algorithm::QuickSorter<Ray> sorter;
+    // Scratch blocks for a single ray
+    PointBlock ground_block;
+    PointBlock nonground_block;
+    // Accumulated results of all rays handled by this thread
+    std::vector<PointXYZIF> ground_points;
+    std::vector<PointXYZIF> nonground_points;
+  };  // struct Worker
+
+  /// \brief Where the results of a single ray are stored
+  struct RayResult
+  {
+    std::size_t worker;
+    std::size_t ground_begin;
+    std::size_t ground_end;
+    std::size_t nonground_begin;
+    std::size_t nonground_end;
+  };  // struct RayResult
+
+  /// \brief Sort and partition rays until none are left, called once per worker
+  RAY_GROUND_CLASSIFIER_LOCAL void work(const std::size_t worker_idx);
+
+  autoware::common::helper_functions::WorkerPool m_pool;
+  std::vector<Worker> m_workers;
+  std::vector<Ray *> m_rays;
+  std::vector<RayResult> m_results;
+  std::atomic<std::size_t> m_next_ray;
+};  // class ParallelRayGroundClassifier
+}  // namespace ray_ground_classifier
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // RAY_GROUND_CLASSIFIER__PARALLEL_RAY_GROUND_CLASSIFIER_HPP_
@@ -121,6 +121,12 @@ private:
   /// \return Const reference to next ray ready for processing
   /// \throw std::runtime_error If no ray is ready
   const Ray & get_next_ray();
+  /// \brief Get next ray that is ready for partitioning, without sorting it. Allows the caller
+  ///        to sort rays concurrently, see ParallelRayGroundClassifier. The ray must be sorted
+  ///        before it is partitioned
+  /// \return Reference to next ray ready for processing, valid until the next insertion
+  /// \throw std::runtime_error If no ray is ready
+  Ray & get_next_unsorted_ray();
 
 private:
   enum class RayState : uint8_t
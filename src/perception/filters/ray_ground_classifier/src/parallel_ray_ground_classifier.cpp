@@ -0,0 +1,128 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <stdexcept>
+#include <vector>
+
+#include "common/types.hpp"
+#include "ray_ground_classifier/parallel_ray_ground_classifier.hpp"
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace ray_ground_classifier
+{
+
+using autoware::common::types::POINT_BLOCK_CAPACITY;
+
+////////////////////////////////////////////////////////////////////////////////
+ParallelRayGroundClassifier::Worker::Worker(const Config & cfg)
+: classifier(cfg),
+  sorter(POINT_BLOCK_CAPACITY),
+  ground_block(),
+  nonground_block(),
+  ground_points(),
+  nonground_points()
+{
+  ground_block.reserve(POINT_BLOCK_CAPACITY);
+  nonground_block.reserve(POINT_BLOCK_CAPACITY);
+}
+////////////////////////////////////////////////////////////////////////////////
+ParallelRayGroundClassifier::ParallelRayGroundClassifier(
+  const Config & cfg,
+  const std::size_t num_threads)
+: m_pool(num_threads),
+  m_workers(),
+  m_rays(),
+  m_results(),
+  m_next_ray{0U}
+{
+  m_workers.reserve(num_threads);
+  for (std::size_t idx = 0U; idx < num_threads; ++idx) {
+    m_workers.emplace_back(cfg);
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+void ParallelRayGroundClassifier::partition(
+  RayAggregator & aggregator,
+  std::vector<PointXYZIF> & ground_points,
+  std::vector<PointXYZIF> & nonground_points)
+{
+  // Hand out rays serially: the aggregator is not thread safe. Rays stay valid until the next
+  // insertion into the aggregator
+  m_rays.clear();
+  while (aggregator.is_ray_ready()) {
+    m_rays.push_back(&aggregator.get_next_unsorted_ray());
+  }
+  m_results.resize(m_rays.size());
+  for (auto & worker : m_workers) {
+    worker.ground_points.clear();
+    worker.nonground_points.clear();
+  }
+  m_next_ray.store(0U);
+  m_pool.run(m_workers.size(), [this](const std::size_t worker_idx) {work(worker_idx);});
+  // Merge in ray order
+  ground_points.clear();
+  nonground_points.clear();
+  for (const RayResult & result : m_results) {
+    const Worker & worker = m_workers[result.worker];
+    (void)ground_points.insert(
+      ground_points.end(),
+      worker.ground_points.begin() + static_cast<std::ptrdiff_t>(result.ground_begin),
+      worker.ground_points.begin() + static_cast<std::ptrdiff_t>(result.ground_end));
+    (void)nonground_points.insert(
+      nonground_points.end(),
+      worker.nonground_points.begin() + static_cast<std::ptrdiff_t>(result.nonground_begin),
+      worker.nonground_points.begin() + static_cast<std::ptrdiff_t>(result.nonground_end));
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+std::size_t ParallelRayGroundClassifier::num_threads() const
+{
+  return m_pool.size();
+}
+////////////////////////////////////////////////////////////////////////////////
+void ParallelRayGroundClassifier::work(const std::size_t worker_idx)
+{
+  Worker & worker = m_workers[worker_idx];
+  for (std::size_t rdx = m_next_ray.fetch_add(1U); rdx < m_rays.size();
+    rdx = m_next_ray.fetch_add(1U))
+  {
+    Ray & ray = *m_rays[rdx];
+    worker.sorter.sort(ray.begin(), ray.end());
+    worker.ground_block.clear();
+    worker.nonground_block.clear();
+    worker.classifier.partition(ray, worker.ground_block, worker.nonground_block);
+    RayResult & result = m_results[rdx];
+    result.worker = worker_idx;
+    result.ground_begin = worker.ground_points.size();
+    result.nonground_begin = worker.nonground_points.size();
+    (void)worker.ground_points.insert(
+      worker.ground_points.end(), worker.ground_block.begin(), worker.ground_block.end());
+    (void)worker.nonground_points.insert(
+      worker.nonground_points.end(), worker.nonground_block.begin(),
+      worker.nonground_block.end());
+    result.ground_end = worker.ground_points.size();
+    result.nonground_end = worker.nonground_points.size();
+  }
+}
+}  // namespace ray_ground_classifier
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
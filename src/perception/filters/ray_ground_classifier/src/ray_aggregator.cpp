@@ -176,14 +176,20 @@ bool8_t RayAggregator::is_ray_ready() const
 }
 ////////////////////////////////////////////////////////////////////////////////
 const Ray & RayAggregator::get_next_ray()
+{
+  Ray & ret = get_next_unsorted_ray();
+  // Sort ray
+  m_ray_sorter.sort(ret.begin(), ret.end());
+  return ret;
+}
+////////////////////////////////////////////////////////////////////////////////
+Ray & RayAggregator::get_next_unsorted_ray()
 {
   if (0U == m_num_ready) {
     throw std::runtime_error("RayAggregator: no rays ready");
   }
   const std::size_t idx = m_ready_indices[m_ready_start_idx];
   Ray & ret = m_rays[idx];
-  // Sort ray
-  m_ray_sorter.sort(ret.begin(), ret.end());
   // ready to be reset on next insertion to this item
   m_ray_state[idx] = RayState::RESET;
   // "pop" from ring buffer
@@ -24,6 +24,8 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "ray_ground_classifier/parallel_ray_ground_classifier.hpp"
+#include "ray_ground_classifier/ray_aggregator.hpp"
 #include "ray_ground_classifier/ray_ground_point_classifier.hpp"
 #include "test_ray_ground_classifier_aux.hpp"
 
@@ -816,3 +818,123 @@ TEST_F(ray_ground_classifier, benchmark)
   fn(256U);
   fn(512U);
 }
+
+/////
+// Unstructured cloud: ground plane with scattered boxes, partitioned through the aggregator
+class parallel_ray_ground_classifier : public ray_ground_classifier
+{
+protected:
+  using RayAggregator = autoware::perception::filters::ray_ground_classifier::RayAggregator;
+  using ParallelRayGroundClassifier =
+    autoware::perception::filters::ray_ground_classifier::ParallelRayGroundClassifier;
+
+  parallel_ray_ground_classifier()
+  : agg_cfg{-3.14159F, 3.14159F, 0.01F, 512U}
+  {
+    std::mt19937 gen(1338U);
+    std::uniform_real_distribution<float32_t> th_samp{-3.14F, 3.14F};
+    std::uniform_real_distribution<float32_t> r_samp{1.0F, 60.0F};
+    std::normal_distribution<float32_t> noise{0.0F, 0.02F};
+    for (std::size_t idx = 0U; idx < 60000U; ++idx) {
+      PointXYZIF pt;
+      const float32_t th = th_samp(gen);
+      const float32_t r = r_samp(gen);
+      pt.x = r * cosf(th);
+      pt.y = r * sinf(th);
+      // every few meters a 1 m tall obstacle
+      const bool8_t obstacle = (static_cast<int32_t>(r) % 7) == 3;
+      pt.z = cfg.get_ground_z() + noise(gen) + (obstacle ? fabsf(noise(gen)) * 50.0F : 0.0F);
+      pt.intensity = static_cast<float32_t>(idx % 256U);
+      pt.id = static_cast<uint16_t>(idx % 1000U);
+      cloud.push_back(pt);
+    }
+    cloud.emplace_back();
+    cloud.back().id = static_cast<uint16_t>(PointXYZIF::END_OF_SCAN_ID);
+  }
+
+  /// Reference: one ray at a time with a single classifier
+  void partition_serial(std::vector<PointXYZIF> & ground, std::vector<PointXYZIF> & nonground)
+  {
+    autoware::perception::filters::ray_ground_classifier::RayGroundClassifier cls{cfg};
+    RayAggregator agg{agg_cfg};
+    agg.insert(cloud.begin(), cloud.end());
+    ground.clear();
+    nonground.clear();
+    while (agg.is_ray_ready()) {
+      PointBlock ground_blk;
+      PointBlock nonground_blk;
+      cls.partition(agg.get_next_ray(), ground_blk, nonground_blk);
+      ground.insert(ground.end(), ground_blk.begin(), ground_blk.end());
+      nonground.insert(nonground.end(), nonground_blk.begin(), nonground_blk.end());
+    }
+  }
+
+  static void expect_same(const std::vector<PointXYZIF> & a, const std::vector<PointXYZIF> & b)
+  {
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t idx = 0U; idx < a.size(); ++idx) {
+      EXPECT_EQ(a[idx].x, b[idx].x);
+      EXPECT_EQ(a[idx].y, b[idx].y);
+      EXPECT_EQ(a[idx].z, b[idx].z);
+      EXPECT_EQ(a[idx].intensity, b[idx].intensity);
+      EXPECT_EQ(a[idx].id, b[idx].id);
+    }
+  }
+
+  RayAggregator::Config agg_cfg;
+  std::vector<PointXYZIF> cloud;
+};
+
+TEST_F(parallel_ray_ground_classifier, matches_serial)
+{
+  std::vector<PointXYZIF> ref_ground, ref_nonground;
+  partition_serial(ref_ground, ref_nonground);
+  EXPECT_FALSE(ref_ground.empty());
+  EXPECT_FALSE(ref_nonground.empty());
+  // Points outside the height limits are dropped
+  EXPECT_LE(ref_ground.size() + ref_nonground.size(), cloud.size() - 1U);
+
+  EXPECT_THROW(ParallelRayGroundClassifier(cfg, 0U), std::domain_error);
+  for (const std::size_t num_threads : {1U, 2U, 4U}) {
+    ParallelRayGroundClassifier cls{cfg, num_threads};
+    EXPECT_EQ(cls.num_threads(), num_threads);
+    RayAggregator agg{agg_cfg};
+    std::vector<PointXYZIF> ground, nonground;
+    // Twice to check state is reset between scans
+    for (std::size_t iter = 0U; iter < 2U; ++iter) {
+      agg.insert(cloud.begin(), cloud.end());
+      cls.partition(agg, ground, nonground);
+      EXPECT_FALSE(agg.is_ray_ready());
+      expect_same(ground, ref_ground);
+      expect_same(nonground, ref_nonground);
+    }
+  }
+}
+
+TEST_F(parallel_ray_ground_classifier, benchmark)
+{
+  constexpr std::size_t num_iter = 20U;
+  std::vector<PointXYZIF> ground, nonground;
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t iter = 0U; iter < num_iter; ++iter) {
+      partition_serial(ground, nonground);
+    }
+    const auto dt = std::chrono::steady_clock::now() - start;
+    std::cerr << "Serial aggregate + partition, " << cloud.size() << " points: " <<
+      std::chrono::duration_cast<std::chrono::microseconds>(dt).count() / num_iter << " µs\n";
+  }
+  for (const std::size_t num_threads : {1U, 2U, 4U}) {
+    ParallelRayGroundClassifier cls{cfg, num_threads};
+    RayAggregator agg{agg_cfg};
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t iter = 0U; iter < num_iter; ++iter) {
+      agg.insert(cloud.begin(), cloud.end());
+      cls.partition(agg, ground, nonground);
+    }
+    const auto dt = std::chrono::steady_clock::now() - start;
+    std::cerr << "Parallel aggregate + partition, " << num_threads << " threads, " <<
+      cloud.size() << " points: " <<
+      std::chrono::duration_cast<std::chrono::microseconds>(dt).count() / num_iter << " µs\n";
+  }
+}
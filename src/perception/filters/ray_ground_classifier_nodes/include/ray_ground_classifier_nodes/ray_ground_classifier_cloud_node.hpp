@@ -23,6 +23,7 @@
 #include <common/types.hpp>
 #include <lidar_utils/point_cloud_utils.hpp>
 #include <ray_ground_classifier_nodes/visibility_control.hpp>
+#include <ray_ground_classifier/parallel_ray_ground_classifier.hpp>
 #include <ray_ground_classifier/ray_aggregator.hpp>
 #include <ray_ground_classifier/ray_ground_classifier.hpp>
 #include <rclcpp/rclcpp.hpp>
@@ -30,6 +31,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 using autoware::common::types::bool8_t;
 using autoware::common::types::char8_t;
@@ -59,9 +61,18 @@ public:
 private:
   /// \brief Resets state of ray aggregator and messages
   RAY_GROUND_CLASSIFIER_NODES_LOCAL void reset();
+  /// \brief Partition all ready rays one at a time on the callback thread
+  RAY_GROUND_CLASSIFIER_NODES_LOCAL void partition_serial();
+  /// \brief Partition all ready rays concurrently with the parallel classifier
+  RAY_GROUND_CLASSIFIER_NODES_LOCAL void partition_parallel();
   // Algorithmic core
+  const ray_ground_classifier::Config m_classifier_cfg;
   ray_ground_classifier::RayGroundClassifier m_classifier;
   ray_ground_classifier::RayAggregator m_aggregator;
+  // Only set if more than one thread is configured
+  std::unique_ptr<ray_ground_classifier::ParallelRayGroundClassifier> m_parallel_classifier;
+  std::vector<autoware::common::types::PointXYZIF> m_ground_points;
+  std::vector<autoware::common::types::PointXYZIF> m_nonground_points;
   // preallocated message
   PointCloud2 m_ground_msg;
   PointCloud2 m_nonground_msg;
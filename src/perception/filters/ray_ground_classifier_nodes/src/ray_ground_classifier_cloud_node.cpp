@@ -19,6 +19,7 @@
 #include <rclcpp/rclcpp.hpp>
 #include <rclcpp_components/register_node_macro.hpp>
 
+#include <memory>
 #include <string>
 
 namespace autoware
@@ -42,7 +43,7 @@ using autoware::common::lidar_utils::init_pcl_msg;
 RayGroundClassifierCloudNode::RayGroundClassifierCloudNode(
   const rclcpp::NodeOptions & node_options)
 : Node("ray_ground_classifier", node_options),
-  m_classifier(ray_ground_classifier::Config{
+  m_classifier_cfg{
           static_cast<float32_t>(declare_parameter("classifier.sensor_height_m").get<float32_t>()),
           static_cast<float32_t>(declare_parameter(
             "classifier.max_local_slope_deg").get<float32_t>()),
@@ -60,7 +61,8 @@ RayGroundClassifierCloudNode::RayGroundClassifierCloudNode(
             "classifier.max_provisional_ground_distance_m").get<float32_t>()),
           static_cast<float32_t>(declare_parameter("classifier.min_height_m").get<float32_t>()),
           static_cast<float32_t>(declare_parameter("classifier.max_height_m").get<float32_t>())
-        }),
+        },
+  m_classifier(m_classifier_cfg),
   m_aggregator(ray_ground_classifier::RayAggregator::Config{
           static_cast<float32_t>(declare_parameter(
             "aggregator.min_ray_angle_rad").get<float32_t>()),
@@ -89,6 +91,17 @@ RayGroundClassifierCloudNode::RayGroundClassifierCloudNode(
   m_ground_pc_its.reset(m_ground_msg, 0);
   init_pcl_msg(m_nonground_msg, m_frame_id.c_str(), m_pcl_size);
   m_nonground_pc_its.reset(m_nonground_msg, 0);
+  // optionally partition rays concurrently
+  const int64_t num_threads = declare_parameter("num_threads", 1);
+  if (num_threads < 1) {
+    throw std::domain_error("RayGroundClassifierCloudNode: num_threads must be positive");
+  }
+  if (num_threads > 1) {
+    m_parallel_classifier = std::make_unique<ray_ground_classifier::ParallelRayGroundClassifier>(
+      m_classifier_cfg, static_cast<std::size_t>(num_threads));
+    m_ground_points.reserve(m_pcl_size);
+    m_nonground_points.reserve(m_pcl_size);
+  }
 }
 ////////////////////////////////////////////////////////////////////////////////
 void
@@ -144,24 +157,10 @@ RayGroundClassifierCloudNode::callback(const PointCloud2::SharedPtr msg)
     // Add end of scan
     m_aggregator.insert(eos_pt);
     // Partition each ray
-    while (m_aggregator.is_ray_ready()) {
-      // Note: if an exception occurs in this loop, the aggregator can get into a bad state
-      // (e.g. overrun capacity)
-      PointBlock ground_blk;
-      PointBlock nonground_blk;
-      // partition: should never fail, guaranteed to have capacity via other checks
-      m_classifier.partition(m_aggregator.get_next_ray(), ground_blk, nonground_blk);
-      // Add ray to point clouds
-      for (auto & ground_point : ground_blk) {
-        if (!add_point_to_cloud(m_ground_pc_its, ground_point, m_ground_pc_idx)) {
-          throw std::runtime_error("RayGroundClassifierNode: Overran ground msg point capacity");
-        }
-      }
-      for (auto & nonground_point : nonground_blk) {
-        if (!add_point_to_cloud(m_nonground_pc_its, nonground_point, m_nonground_pc_idx)) {
-          throw std::runtime_error("RayGroundClassifierNode: Overran nonground msg point capacity");
-        }
-      }
+    if (m_parallel_classifier) {
+      partition_parallel();
+    } else {
+      partition_serial();
     }
     // Resize the clouds down to their actual sizes.
     autoware::common::lidar_utils::resize_pcl_msg(m_ground_msg, m_ground_pc_idx);
@@ -185,6 +184,45 @@ RayGroundClassifierCloudNode::callback(const PointCloud2::SharedPtr msg)
   }
 }
 ////////////////////////////////////////////////////////////////////////////////
+void RayGroundClassifierCloudNode::partition_serial()
+{
+  while (m_aggregator.is_ray_ready()) {
+    // Note: if an exception occurs in this loop, the aggregator can get into a bad state
+    // (e.g. overrun capacity)
+    PointBlock ground_blk;
+    PointBlock nonground_blk;
+    // partition: should never fail, guaranteed to have capacity via other checks
+    m_classifier.partition(m_aggregator.get_next_ray(), ground_blk, nonground_blk);
+    // Add ray to point clouds
+    for (auto & ground_point : ground_blk) {
+      if (!add_point_to_cloud(m_ground_pc_its, ground_point, m_ground_pc_idx)) {
+        throw std::runtime_error("RayGroundClassifierNode: Overran ground msg point capacity");
+      }
+    }
+    for (auto & nonground_point : nonground_blk) {
+      if (!add_point_to_cloud(m_nonground_pc_its, nonground_point, m_nonground_pc_idx)) {
+        throw std::runtime_error("RayGroundClassifierNode: Overran nonground msg point capacity");
+      }
+    }
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+void RayGroundClassifierCloudNode::partition_parallel()
+{
+  // rays are merged back in aggregator order, so the output matches partition_serial()
+  m_parallel_classifier->partition(m_aggregator, m_ground_points, m_nonground_points);
+  for (auto & ground_point : m_ground_points) {
+    if (!add_point_to_cloud(m_ground_pc_its, ground_point, m_ground_pc_idx)) {
+      throw std::runtime_error("RayGroundClassifierNode: Overran ground msg point capacity");
+    }
+  }
+  for (auto & nonground_point : m_nonground_points) {
+    if (!add_point_to_cloud(m_nonground_pc_its, nonground_point, m_nonground_pc_idx)) {
+      throw std::runtime_error("RayGroundClassifierNode: Overran nonground msg point capacity");
+    }
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
 void RayGroundClassifierCloudNode::reset()
 {
   // reset aggregator: Needed in case an error is thrown during partitioning of cloud
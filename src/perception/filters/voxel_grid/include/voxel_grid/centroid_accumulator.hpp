@@ -0,0 +1,134 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines a centroid voxel grid with batched insertion and SoA accumulation
+
+#ifndef VOXEL_GRID__CENTROID_ACCUMULATOR_HPP_
+#define VOXEL_GRID__CENTROID_ACCUMULATOR_HPP_
+
+#include <voxel_grid/config.hpp>
+#include <voxel_grid/visibility_control.hpp>
+#include <common/types.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+using autoware::common::types::float32_t;
+using autoware::common::types::float64_t;
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace voxel_grid
+{
+
+using autoware::common::types::PointXYZIF;
+
+/// \brief A centroid voxel grid for PointXYZIF which ingests blocks of points in structure of
+///        arrays (SoA) form. Voxel indices of a block are computed with Config's batched,
+///        runtime-dispatched SIMD kernels. Each active voxel keeps running sums of x, y, z and
+///        intensity in separate contiguous arrays plus a count; the division into a centroid only
+///        happens when a voxel is read out. All memory is allocated on construction.
+///
+/// Equivalent to VoxelGrid<CentroidVoxel<PointXYZIF>> up to floating point rounding, since the
+/// mean is computed from a sum rather than updated incrementally. The sums are kept in double
+/// precision, as single precision sums of many points far from the origin lose the digits that
+/// distinguish the points.
+class VOXEL_GRID_PUBLIC CentroidAccumulator
+{
+public:
+  /// \brief The number of points whose voxel indices are computed in one batch
+  static constexpr std::size_t BLOCK_SIZE = 256U;
+
+  /// \brief Constructor
+  /// \param[in] cfg The configuration class
+  explicit CentroidAccumulator(const Config & cfg);
+
+  /// \brief Inserts a block of points, may result in new voxels being activated
+  /// \param[in] x Array of x coordinates
+  /// \param[in] y Array of y coordinates
+  /// \param[in] z Array of z coordinates
+  /// \param[in] intensity Array of intensities, or nullptr if the points have no intensity
+  /// \param[in] count The number of points in each array
+  /// \throw std::length_error If a new voxel would be activated while at capacity. Points of the
+  ///                           block before the offending point are kept
+  void insert(
+    const float32_t * const x,
+    const float32_t * const y,
+    const float32_t * const z,
+    const float32_t * const intensity,
+    const std::size_t count);
+
+  /// \brief Gets the centroid of an active voxel
+  /// \param[in] voxel The position of the voxel in activation order, less than size()
+  /// \return The mean of all points which fell into the voxel
+  PointXYZIF get(const std::size_t voxel) const;
+  /// \brief Gets the index of an active voxel as computed by Config::index()
+  /// \param[in] voxel The position of the voxel in activation order, less than size()
+  /// \return The voxel index
+  uint64_t index(const std::size_t voxel) const;
+  /// \brief Gets the number of points in an active voxel
+  /// \param[in] voxel The position of the voxel in activation order, less than size()
+  /// \return The number of points
+  uint32_t count(const std::size_t voxel) const;
+
+  /// \brief Resets the state of the voxel grid, only touching the active voxels
+  void clear();
+  /// \brief Returns the current number of active voxels
+  std::size_t size() const;
+  /// \brief Returns the maximum number of active voxels
+  std::size_t capacity() const;
+  /// \brief Whether the voxel grid is empty
+  bool8_t empty() const;
+
+private:
+  /// \brief Get the position of the voxel with the given index, activating it if needed
+  std::size_t find_or_add(const uint64_t index);
+
+  /// \brief An entry in the open addressing table, mapping a voxel index to its position
+  struct Slot
+  {
+    uint64_t index;
+    std::size_t voxel;
+  };  // struct Slot
+  static constexpr std::size_t EMPTY = static_cast<std::size_t>(-1);
+
+  const Config m_config;
+  const std::size_t m_mask;
+  std::vector<Slot> m_table;
+  // Per active voxel, in activation order
+  std::vector<std::size_t> m_slots;
+  std::vector<uint64_t> m_indices;
+  std::vector<float64_t> m_sum_x;
+  std::vector<float64_t> m_sum_y;
+  std::vector<float64_t> m_sum_z;
+  std::vector<float64_t> m_sum_intensity;
+  std::vector<uint32_t> m_counts;
+  // Scratch space for the indices of the current block
+  std::array<uint64_t, BLOCK_SIZE> m_block_indices;
+};  // class CentroidAccumulator
+
+}  // namespace voxel_grid
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // VOXEL_GRID__CENTROID_ACCUMULATOR_HPP_
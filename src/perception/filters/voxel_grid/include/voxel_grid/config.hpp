@@ -25,7 +25,10 @@
 #include <geometry/common_2d.hpp>
 #include <common/types.hpp>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
+using autoware::common::types::bool8_t;
 using autoware::common::types::float32_t;
 
 namespace autoware
@@ -46,6 +49,18 @@ inline T clamp(const T val, const T min, const T max)
 
 using PointXYZ = geometry_msgs::msg::Point32;
 
+/// \brief Instruction sets the batched voxel index computation can dispatch to
+enum class SimdLevel : uint8_t
+{
+  SCALAR = 0U,
+  SSE2 = 1U,
+  AVX = 2U
+};
+
+/// \brief Get the most capable instruction set supported by the executing CPU. Detection happens
+///        once, on the first call
+/// \return The SimdLevel, SCALAR on non-x86 platforms
+VOXEL_GRID_PUBLIC SimdLevel detect_simd_level();
 
 /// \brief A configuration class for the VoxelGrid data structure, also includes some helper
 ///        functionality for computing indices and centroids of voxels.
@@ -75,6 +90,10 @@ public:
   /// \brief Gets the capacity of the voxel grid
   /// \return Fixed value
   uint64_t get_capacity() const;
+  /// \brief Gets the number of voxels spanning the receptive field, i.e. one more than the
+  ///        largest index a point can map to
+  /// \return Fixed value
+  uint64_t get_num_voxels() const;
   /// \brief Computes index for a given point given the voxelgrid configuration parameters
   /// \param[in] pt The point for which the voxel index will be computed
   /// \return The index of the voxel for which this point will fall into
@@ -95,6 +114,36 @@ public:
     return idx + (jdx * m_y_stride) + (kdx * m_z_stride);
   }
 
+  /// \brief Computes indices for a block of points stored as separate coordinate arrays. Gives
+  ///        the same result as index() for each point, but processes 4 (SSE2) or 8 (AVX) points
+  ///        per instruction
+  /// \param[in] x Array of x coordinates
+  /// \param[in] y Array of y coordinates
+  /// \param[in] z Array of z coordinates
+  /// \param[in] count The number of points in each array
+  /// \param[out] out Array of at least count elements to store the voxel indices in
+  /// \param[in] level The instruction set to use, must be supported by the executing CPU
+  void index(
+    const float32_t * const x,
+    const float32_t * const y,
+    const float32_t * const z,
+    const std::size_t count,
+    uint64_t * const out,
+    const SimdLevel level) const;
+  /// \brief Computes indices for a block of points stored as separate coordinate arrays, using
+  ///        the most capable instruction set of the executing CPU
+  /// \param[in] x Array of x coordinates
+  /// \param[in] y Array of y coordinates
+  /// \param[in] z Array of z coordinates
+  /// \param[in] count The number of points in each array
+  /// \param[out] out Array of at least count elements to store the voxel indices in
+  void index(
+    const float32_t * const x,
+    const float32_t * const y,
+    const float32_t * const z,
+    const std::size_t count,
+    uint64_t * const out) const;
+
   /// \brief Computes the centroid for a given voxel index
   /// \param[in] index The index for a given voxel
   /// \return A point for whom the x, y and z fields are filled out
@@ -139,6 +188,8 @@ private:
   uint64_t m_y_stride;
   uint64_t m_z_stride;
   uint64_t m_capacity;
+  // Whether the per axis indices fit into 32 bit lanes for the batched index computation
+  bool8_t m_batch_fits_32_bit;
 };  // class Config
 }  // namespace voxel_grid
 }  // namespace filters
@@ -0,0 +1,232 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines a voxel grid backed by a dense array for bounded receptive fields
+
+#ifndef VOXEL_GRID__DENSE_VOXEL_GRID_HPP_
+#define VOXEL_GRID__DENSE_VOXEL_GRID_HPP_
+
+#include <voxel_grid/config.hpp>
+#include <voxel_grid/voxels.hpp>
+#include <common/types.hpp>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using autoware::common::types::bool8_t;
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace voxel_grid
+{
+
+/// \brief A voxel grid data structure for downsampling point clouds, where every voxel of the
+///        receptive field is preallocated in a flat array indexed directly by the voxel index.
+///        Insertion is a bit test and an array access, with no hashing or node allocation.
+///        The memory footprint scales with the volume of the receptive field rather than with the
+///        capacity, see memory_size(). Intended for small, bounded regions.
+///
+/// Iteration visits the occupied voxels in activation order. Unlike VoxelGrid, there is no
+/// new_voxels() queue.
+/// \tparam VoxelT The underlying voxel type, assumed to be a child class of Voxel with the
+///                addition of the add_observation(PointT) and configure(Config, uint64_t) methods
+template<typename VoxelT>
+class VOXEL_GRID_PUBLIC DenseVoxelGrid
+{
+  using IndexVector = std::vector<uint64_t>;
+
+public:
+  using point_t = typename VoxelT::point_t;
+  using value_type = std::pair<uint64_t, const VoxelT &>;
+
+  /// \brief Forward iterator over the occupied voxels, dereferences to an index-voxel pair
+  class const_iterator
+  {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = DenseVoxelGrid::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    /// \brief Constructor
+    /// \param[in] voxels Pointer to the first element of the voxel array
+    /// \param[in] it Iterator into the list of occupied voxel indices
+    const_iterator(const VoxelT * const voxels, const IndexVector::const_iterator it)
+    : m_voxels{voxels},
+      m_it{it}
+    {
+    }
+    /// \brief Get the index and voxel this iterator points to
+    value_type operator*() const
+    {
+      return value_type{*m_it, m_voxels[*m_it]};
+    }
+    /// \brief Advance to the next occupied voxel
+    const_iterator & operator++()
+    {
+      ++m_it;
+      return *this;
+    }
+    /// \brief Advance to the next occupied voxel
+    const_iterator operator++(int)
+    {
+      const const_iterator ret{*this};
+      ++m_it;
+      return ret;
+    }
+    /// \brief Equality comparison
+    bool8_t operator==(const const_iterator & rhs) const
+    {
+      return m_it == rhs.m_it;
+    }
+    /// \brief Inequality comparison
+    bool8_t operator!=(const const_iterator & rhs) const
+    {
+      return m_it != rhs.m_it;
+    }
+
+private:
+    const VoxelT * m_voxels;
+    IndexVector::const_iterator m_it;
+  };  // class const_iterator
+
+  /// \brief Constructor, all memory is allocated here
+  /// \param[in] cfg The configuration class
+  explicit DenseVoxelGrid(const Config & cfg)
+  : m_config(cfg),
+    m_voxels(m_config.get_num_voxels()),
+    m_occupancy((m_config.get_num_voxels() + 63U) / 64U, 0U),
+    m_occupied{}
+  {
+    m_occupied.reserve(m_config.get_capacity());
+  }
+
+  /// \brief Inserts a point into the voxel grid, may result in new voxels being activated
+  /// \param[in] pt The point to insert
+  /// \throw std::length_error If a new voxel would be activated while at capacity
+  void insert(const point_t & pt)
+  {
+    const uint64_t idx = m_config.index(pt);
+    uint64_t & word = m_occupancy[idx / 64U];
+    const uint64_t bit = 1ULL << (idx % 64U);
+    VoxelT & vx = m_voxels[idx];
+    if (0U == (word & bit)) {
+      if (capacity() <= size()) {
+        throw std::length_error{"DenseVoxelGrid: insertion would overrun capacity"};
+      }
+      word |= bit;
+      m_occupied.push_back(idx);
+      // Voxels are reused across clear(), so reset any stale state first
+      vx = VoxelT{};
+      //lint -e{523} NOLINT This is to support multiple voxel implementations, see VoxelGrid
+      vx.configure(m_config, idx);
+    }
+    vx.add_observation(pt);
+  }
+  /// \brief Inserts many points into the voxel grid, dispatches to the core insert method.
+  /// \tparam IT The iterator type
+  /// \param[in] begin The starting iterator
+  /// \param[in] end An iterator pointing one past the last element to be inserted.
+  template<typename IT>
+  void insert(const IT begin, const IT end)
+  {
+    for (IT it = begin; it != end; ++it) {
+      insert(*it);
+    }
+  }
+
+  /// \brief Returns an iterator to the first occupied voxel
+  /// \return Iterator
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+  /// \brief Returns an iterator to the first occupied voxel
+  /// \return Iterator
+  const_iterator cbegin() const
+  {
+    return const_iterator{m_voxels.data(), m_occupied.cbegin()};
+  }
+  /// \brief Returns an iterator to one past the last occupied voxel
+  /// \return Iterator
+  const_iterator end() const
+  {
+    return cend();
+  }
+  /// \brief Returns an iterator to one past the last occupied voxel
+  /// \return Iterator
+  const_iterator cend() const
+  {
+    return const_iterator{m_voxels.data(), m_occupied.cend()};
+  }
+  /// \brief Resets the state of the voxel grid, only touching the occupied voxels
+  void clear()
+  {
+    for (const uint64_t idx : m_occupied) {
+      m_occupancy[idx / 64U] = 0U;
+    }
+    m_occupied.clear();
+  }
+  /// \brief Returns the current number of occupied voxels
+  std::size_t size() const
+  {
+    return m_occupied.size();
+  }
+  /// \brief Returns the maximum number of occupied voxels
+  /// \return The capacity
+  std::size_t capacity() const
+  {
+    return m_config.get_capacity();
+  }
+  /// \brief Whether the voxel grid is empty
+  /// \return True or false
+  bool8_t empty() const
+  {
+    return m_occupied.empty();
+  }
+  /// \brief Computes the number of bytes a dense voxel grid with the given configuration
+  ///        allocates on construction
+  /// \param[in] cfg The configuration class
+  /// \return The size of the preallocated buffers in bytes
+  static std::size_t memory_size(const Config & cfg)
+  {
+    const std::size_t num_voxels = static_cast<std::size_t>(cfg.get_num_voxels());
+    return (num_voxels * sizeof(VoxelT)) +
+           (((num_voxels + 63U) / 64U) * sizeof(uint64_t)) +
+           (static_cast<std::size_t>(cfg.get_capacity()) * sizeof(uint64_t));
+  }
+
+private:
+  const Config m_config;
+  std::vector<VoxelT> m_voxels;
+  IndexVector m_occupancy;
+  IndexVector m_occupied;
+};  // class DenseVoxelGrid
+
+}  // namespace voxel_grid
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // VOXEL_GRID__DENSE_VOXEL_GRID_HPP_
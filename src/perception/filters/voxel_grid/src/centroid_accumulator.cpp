@@ -0,0 +1,180 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+#include <algorithm>
+#include <stdexcept>
+#include "voxel_grid/centroid_accumulator.hpp"
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace voxel_grid
+{
+namespace
+{
+/// Smallest power of two that is at least twice the capacity, for a load factor <= 0.5
+std::size_t table_size(const std::size_t capacity)
+{
+  std::size_t ret = 1U;
+  while (ret < (capacity * 2U)) {
+    ret <<= 1U;
+  }
+  return ret;
+}
+}  // namespace
+
+constexpr std::size_t CentroidAccumulator::BLOCK_SIZE;
+constexpr std::size_t CentroidAccumulator::EMPTY;
+
+////////////////////////////////////////////////////////////////////////////////
+CentroidAccumulator::CentroidAccumulator(const Config & cfg)
+: m_config(cfg),
+  m_mask{table_size(static_cast<std::size_t>(cfg.get_capacity())) - 1U},
+  m_table(m_mask + 1U, Slot{0U, EMPTY}),
+  m_block_indices{}
+{
+  const std::size_t capacity = static_cast<std::size_t>(cfg.get_capacity());
+  m_slots.reserve(capacity);
+  m_indices.reserve(capacity);
+  m_sum_x.reserve(capacity);
+  m_sum_y.reserve(capacity);
+  m_sum_z.reserve(capacity);
+  m_sum_intensity.reserve(capacity);
+  m_counts.reserve(capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CentroidAccumulator::insert(
+  const float32_t * const x,
+  const float32_t * const y,
+  const float32_t * const z,
+  const float32_t * const intensity,
+  const std::size_t count)
+{
+  for (std::size_t first = 0U; first < count; first += BLOCK_SIZE) {
+    const std::size_t num = std::min(BLOCK_SIZE, count - first);
+    m_config.index(&x[first], &y[first], &z[first], num, m_block_indices.data());
+    // Consecutive points of a scan often fall into the same voxel, skip the lookup for those
+    uint64_t last_index = m_block_indices[0U];
+    std::size_t voxel = find_or_add(last_index);
+    for (std::size_t idx = 0U; idx < num; ++idx) {
+      const uint64_t index = m_block_indices[idx];
+      if (index != last_index) {
+        voxel = find_or_add(index);
+        last_index = index;
+      }
+      const std::size_t pdx = first + idx;
+      m_sum_x[voxel] += static_cast<float64_t>(x[pdx]);
+      m_sum_y[voxel] += static_cast<float64_t>(y[pdx]);
+      m_sum_z[voxel] += static_cast<float64_t>(z[pdx]);
+      if (nullptr != intensity) {
+        m_sum_intensity[voxel] += static_cast<float64_t>(intensity[pdx]);
+      }
+      ++m_counts[voxel];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+PointXYZIF CentroidAccumulator::get(const std::size_t voxel) const
+{
+  const float64_t count = static_cast<float64_t>(m_counts[voxel]);
+  PointXYZIF ret;
+  ret.x = static_cast<float32_t>(m_sum_x[voxel] / count);
+  ret.y = static_cast<float32_t>(m_sum_y[voxel] / count);
+  ret.z = static_cast<float32_t>(m_sum_z[voxel] / count);
+  ret.intensity = static_cast<float32_t>(m_sum_intensity[voxel] / count);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint64_t CentroidAccumulator::index(const std::size_t voxel) const
+{
+  return m_indices[voxel];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+uint32_t CentroidAccumulator::count(const std::size_t voxel) const
+{
+  return m_counts[voxel];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void CentroidAccumulator::clear()
+{
+  for (const std::size_t sdx : m_slots) {
+    m_table[sdx].voxel = EMPTY;
+  }
+  m_slots.clear();
+  m_indices.clear();
+  m_sum_x.clear();
+  m_sum_y.clear();
+  m_sum_z.clear();
+  m_sum_intensity.clear();
+  m_counts.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CentroidAccumulator::size() const
+{
+  return m_counts.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CentroidAccumulator::capacity() const
+{
+  return static_cast<std::size_t>(m_config.get_capacity());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool8_t CentroidAccumulator::empty() const
+{
+  return m_counts.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t CentroidAccumulator::find_or_add(const uint64_t index)
+{
+  // Fibonacci hashing to spread out the (mostly sequential) voxel indices
+  constexpr uint64_t MULTIPLIER = 11400714819323198485ULL;
+  std::size_t sdx = static_cast<std::size_t>(index * MULTIPLIER) & m_mask;
+  while (EMPTY != m_table[sdx].voxel) {
+    if (index == m_table[sdx].index) {
+      return m_table[sdx].voxel;
+    }
+    sdx = (sdx + 1U) & m_mask;
+  }
+  if (capacity() <= size()) {
+    throw std::length_error{"CentroidAccumulator: insertion would overrun capacity"};
+  }
+  const std::size_t voxel = size();
+  m_table[sdx] = Slot{index, voxel};
+  m_slots.push_back(sdx);
+  m_indices.push_back(index);
+  m_sum_x.push_back(0.0);
+  m_sum_y.push_back(0.0);
+  m_sum_z.push_back(0.0);
+  m_sum_intensity.push_back(0.0);
+  m_counts.push_back(0U);
+  return voxel;
+}
+}  // namespace voxel_grid
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
@@ -15,6 +15,10 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include <common/types.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
 #include <limits>
 #include "voxel_grid/voxel_grid.hpp"
 
@@ -30,6 +34,116 @@ namespace filters
 {
 namespace voxel_grid
 {
+namespace
+{
+/// Number of points whose per axis indices are buffered on the stack in the batched index
+constexpr std::size_t INDEX_BLOCK_SIZE = 256U;
+
+/// Per axis voxel index, same operations as Config::index(). After clamping, the offset from the
+/// minimum is never negative, so truncation is equivalent to floor
+void axis_index_scalar(
+  const float32_t * const v,
+  const std::size_t count,
+  const float32_t min,
+  const float32_t max,
+  const float32_t inv,
+  uint32_t * const out)
+{
+  for (std::size_t idx = 0U; idx < count; ++idx) {
+    out[idx] = static_cast<uint32_t>((clamp(v[idx], min, max) - min) * inv);
+  }
+}
+
+#if defined(__SSE2__)
+/// Per axis voxel index, 4 points at a time
+void axis_index_sse2(
+  const float32_t * const v,
+  const std::size_t count,
+  const float32_t min,
+  const float32_t max,
+  const float32_t inv,
+  uint32_t * const out)
+{
+  const __m128 vmin = _mm_set1_ps(min);
+  const __m128 vmax = _mm_set1_ps(max);
+  const __m128 vinv = _mm_set1_ps(inv);
+  std::size_t idx = 0U;
+  for (; (idx + 4U) <= count; idx += 4U) {
+    // max(v, min) picks min for NaN, so garbage input still lands in a valid voxel
+    const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&v[idx]), vmin), vmax);
+    const __m128 scaled = _mm_mul_ps(_mm_sub_ps(clamped, vmin), vinv);
+    //lint -e{9176} NOLINT unaligned store of integer lanes
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[idx]), _mm_cvttps_epi32(scaled));
+  }
+  axis_index_scalar(&v[idx], count - idx, min, max, inv, &out[idx]);
+}
+#endif  // __SSE2__
+
+#if defined(__x86_64__) || defined(__i386__)
+/// Per axis voxel index, 8 points at a time. Compiled for AVX regardless of the baseline flags,
+/// only called after runtime detection
+__attribute__((target("avx")))
+void axis_index_avx(
+  const float32_t * const v,
+  const std::size_t count,
+  const float32_t min,
+  const float32_t max,
+  const float32_t inv,
+  uint32_t * const out)
+{
+  const __m256 vmin = _mm256_set1_ps(min);
+  const __m256 vmax = _mm256_set1_ps(max);
+  const __m256 vinv = _mm256_set1_ps(inv);
+  std::size_t idx = 0U;
+  for (; (idx + 8U) <= count; idx += 8U) {
+    const __m256 clamped = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&v[idx]), vmin), vmax);
+    const __m256 scaled = _mm256_mul_ps(_mm256_sub_ps(clamped, vmin), vinv);
+    //lint -e{9176} NOLINT unaligned store of integer lanes
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(&out[idx]), _mm256_cvttps_epi32(scaled));
+  }
+  axis_index_scalar(&v[idx], count - idx, min, max, inv, &out[idx]);
+}
+#endif  // x86
+
+using AxisIndexFn = void (*)(
+  const float32_t *, std::size_t, float32_t, float32_t, float32_t, uint32_t *);
+
+AxisIndexFn select_kernel(const SimdLevel level)
+{
+  switch (level) {
+#if defined(__x86_64__) || defined(__i386__)
+    case SimdLevel::AVX:
+      return &axis_index_avx;
+#endif
+#if defined(__SSE2__)
+    case SimdLevel::SSE2:
+      return &axis_index_sse2;
+#endif
+    default:
+      return &axis_index_scalar;
+  }
+}
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+SimdLevel detect_simd_level()
+{
+  static const SimdLevel level = []() {
+      SimdLevel ret = SimdLevel::SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx")) {
+        ret = SimdLevel::AVX;
+      } else if (__builtin_cpu_supports("sse2")) {
+#if defined(__SSE2__)
+        ret = SimdLevel::SSE2;
+#endif
+      }
+#endif
+      return ret;
+    } ();
+  return level;
+}
 ////////////////////////////////////////////////////////////////////////////////
 uint64_t Config::check_basis_direction(
   const float32_t min,
@@ -67,7 +181,8 @@ Config::Config(
   m_max_point(max_point),
   m_voxel_size(voxel_size),
   m_y_stride{check_basis_direction(min_point.x, max_point.x, voxel_size.x)},
-  m_capacity(capacity)
+  m_capacity(capacity),
+  m_batch_fits_32_bit{false}
 {
   // tiny function to check if the multiplication of unsigned longs will overflow
   auto mul_will_overflow_u64 = [](const uint64_t x, const uint64_t y)
@@ -94,6 +209,9 @@ Config::Config(
   if (mul_will_overflow_u64(m_z_stride, z_width)) {
     throw std::domain_error("voxel_grid::Config: voxel index may overflow!");
   }
+  // Clamping can yield an index of one past the width, leave some headroom
+  constexpr uint64_t max_width = static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) - 1U;
+  m_batch_fits_32_bit = (m_y_stride < max_width) && (y_width < max_width) && (z_width < max_width);
   // small fudging to prevent weird boundary effects
   // (e.g (x=xmax, y) rolls index over to (x=0, y+1)
   //lint -e{1938} read only access is fine NOLINT
@@ -121,6 +239,57 @@ uint64_t Config::get_capacity() const
 {
   return m_capacity;
 }
+////////////////////////////////////////////////////////////////////////////////
+void Config::index(
+  const float32_t * const x,
+  const float32_t * const y,
+  const float32_t * const z,
+  const std::size_t count,
+  uint64_t * const out,
+  const SimdLevel level) const
+{
+  if (!m_batch_fits_32_bit) {
+    for (std::size_t idx = 0U; idx < count; ++idx) {
+      PointXYZ pt;
+      pt.x = x[idx];
+      pt.y = y[idx];
+      pt.z = z[idx];
+      out[idx] = index(pt);
+    }
+    return;
+  }
+  const AxisIndexFn kernel = select_kernel(level);
+  uint32_t xdx[INDEX_BLOCK_SIZE];
+  uint32_t ydx[INDEX_BLOCK_SIZE];
+  uint32_t zdx[INDEX_BLOCK_SIZE];
+  for (std::size_t first = 0U; first < count; first += INDEX_BLOCK_SIZE) {
+    const std::size_t num = std::min(INDEX_BLOCK_SIZE, count - first);
+    kernel(&x[first], num, m_min_point.x, m_max_point.x, m_voxel_size_inv.x, &xdx[0U]);
+    kernel(&y[first], num, m_min_point.y, m_max_point.y, m_voxel_size_inv.y, &ydx[0U]);
+    kernel(&z[first], num, m_min_point.z, m_max_point.z, m_voxel_size_inv.z, &zdx[0U]);
+    for (std::size_t idx = 0U; idx < num; ++idx) {
+      out[first + idx] = static_cast<uint64_t>(xdx[idx]) +
+        (static_cast<uint64_t>(ydx[idx]) * m_y_stride) +
+        (static_cast<uint64_t>(zdx[idx]) * m_z_stride);
+    }
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+void Config::index(
+  const float32_t * const x,
+  const float32_t * const y,
+  const float32_t * const z,
+  const std::size_t count,
+  uint64_t * const out) const
+{
+  index(x, y, z, count, out, detect_simd_level());
+}
+////////////////////////////////////////////////////////////////////////////////
+uint64_t Config::get_num_voxels() const
+{
+  // Index is monotonic in each coordinate, so the max corner has the largest index
+  return index(m_max_point) + 1U;
+}
 
 }  // namespace voxel_grid
 }  // namespace filters
@@ -15,6 +15,7 @@
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
 #include "common/types.hpp"
+#include "voxel_grid/dense_voxel_grid.hpp"
 #include "voxel_grid/voxel_grid.hpp"
 
 namespace autoware
@@ -31,6 +32,10 @@ template class VoxelGrid<ApproximateVoxel<PointXYZ>>;
 template class VoxelGrid<ApproximateVoxel<autoware::common::types::PointXYZIF>>;
 template class VoxelGrid<CentroidVoxel<PointXYZ>>;
 template class VoxelGrid<CentroidVoxel<autoware::common::types::PointXYZIF>>;
+template class DenseVoxelGrid<ApproximateVoxel<PointXYZ>>;
+template class DenseVoxelGrid<ApproximateVoxel<autoware::common::types::PointXYZIF>>;
+template class DenseVoxelGrid<CentroidVoxel<PointXYZ>>;
+template class DenseVoxelGrid<CentroidVoxel<autoware::common::types::PointXYZIF>>;
 }  // namespace voxel_grid
 }  // namespace filters
 }  // namespace perception
@@ -18,8 +18,14 @@
 #define TEST_VOXEL_GRID_HPP_
 
 #include <common/types.hpp>
+#include <chrono>
+#include <iostream>
+#include <map>
 #include <memory>
 #include <limits>
+#include <vector>
+#include "voxel_grid/centroid_accumulator.hpp"
+#include "voxel_grid/dense_voxel_grid.hpp"
 #include "voxel_grid/voxel_grid.hpp"
 
 using autoware::perception::filters::voxel_grid::PointXYZ;
@@ -28,6 +34,10 @@ using autoware::perception::filters::voxel_grid::Voxel;
 using autoware::perception::filters::voxel_grid::ApproximateVoxel;
 using autoware::perception::filters::voxel_grid::CentroidVoxel;
 using autoware::perception::filters::voxel_grid::VoxelGrid;
+using autoware::perception::filters::voxel_grid::DenseVoxelGrid;
+using autoware::perception::filters::voxel_grid::CentroidAccumulator;
+using autoware::perception::filters::voxel_grid::SimdLevel;
+using autoware::perception::filters::voxel_grid::detect_simd_level;
 using autoware::perception::filters::voxel_grid::PointXYZIF;
 using autoware::common::types::bool8_t;
 using autoware::common::types::float32_t;
@@ -756,4 +766,330 @@ TYPED_TEST(TypedVoxelGridTest, approximate_voxel_grid)
   EXPECT_THROW(grid.insert(*(this->obs_points1.end() - 1)), std::length_error);
   EXPECT_THROW(grid.insert(*(this->obs_points1.end() - 2)), std::length_error);
 }
+/// Generate a deterministic, spread out cloud in [-10, 10)^2 x [-2, 2)
+inline std::vector<PointXYZ> make_dense_test_cloud(const std::size_t num_points)
+{
+  std::vector<PointXYZ> ret;
+  ret.reserve(num_points);
+  for (std::size_t idx = 0U; idx < num_points; ++idx) {
+    PointXYZ pt;
+    pt.x = static_cast<float32_t>((idx * 7919U) % 2000U) * 0.01F - 10.0F;
+    pt.y = static_cast<float32_t>((idx * 104729U) % 2000U) * 0.01F - 10.0F;
+    pt.z = static_cast<float32_t>((idx * 31U) % 400U) * 0.01F - 2.0F;
+    ret.push_back(pt);
+  }
+  return ret;
+}
+
+/// Dense and hashed backends must produce the same voxels
+template<typename VoxelT>
+void check_dense_matches_hashed(const Config & cfg, const std::vector<PointXYZ> & cloud)
+{
+  VoxelGrid<VoxelT> hashed{cfg};
+  DenseVoxelGrid<VoxelT> dense{cfg};
+  // Two rounds to make sure clear() resets reused voxels
+  for (std::size_t round = 0U; round < 2U; ++round) {
+    hashed.clear();
+    dense.clear();
+    EXPECT_TRUE(dense.empty());
+    const auto last = cloud.begin() + static_cast<std::ptrdiff_t>(cloud.size() / (round + 1U));
+    hashed.insert(cloud.begin(), last);
+    dense.insert(cloud.begin(), last);
+    ASSERT_EQ(hashed.size(), dense.size());
+    std::map<uint64_t, PointXYZ> ref;
+    for (const auto it : hashed) {
+      ref[it.first] = it.second.get();
+    }
+    for (const auto it : dense) {
+      const auto ref_it = ref.find(it.first);
+      ASSERT_NE(ref_it, ref.end());
+      EXPECT_FLOAT_EQ(ref_it->second.x, it.second.get().x);
+      EXPECT_FLOAT_EQ(ref_it->second.y, it.second.get().y);
+      EXPECT_FLOAT_EQ(ref_it->second.z, it.second.get().z);
+    }
+  }
+}
+
+TEST(DenseVoxelGrid, matches_hashed)
+{
+  PointXYZ min_point, max_point, voxel_size;
+  min_point.x = -10.0F;
+  min_point.y = -10.0F;
+  min_point.z = -2.0F;
+  max_point.x = 10.0F;
+  max_point.y = 10.0F;
+  max_point.z = 2.0F;
+  voxel_size.x = 0.5F;
+  voxel_size.y = 0.5F;
+  voxel_size.z = 0.5F;
+  const Config cfg{min_point, max_point, voxel_size, 20000U};
+  EXPECT_GE(cfg.get_num_voxels(), 40U * 40U * 8U);
+  const auto cloud = make_dense_test_cloud(10000U);
+  check_dense_matches_hashed<CentroidVoxel<PointXYZ>>(cfg, cloud);
+  check_dense_matches_hashed<ApproximateVoxel<PointXYZ>>(cfg, cloud);
+}
+
+TEST_F(VoxelTest, dense_capacity)
+{
+  DenseVoxelGrid<CentroidVoxel<PointXYZ>> grid{*cfg_ptr};
+  EXPECT_EQ(cfg_ptr->get_num_voxels(), 8U);
+  EXPECT_EQ(grid.capacity(), capacity);
+  PointXYZ pt;
+  for (std::size_t idx = 0U; idx < 8U; ++idx) {
+    pt.x = ((idx & 1U) == 0U) ? -0.5F : 0.5F;
+    pt.y = ((idx & 2U) == 0U) ? -0.5F : 0.5F;
+    pt.z = ((idx & 4U) == 0U) ? -0.5F : 0.5F;
+    if (idx < capacity) {
+      grid.insert(pt);
+      // Repeated observations of an active voxel never throw
+      grid.insert(pt);
+    } else {
+      EXPECT_THROW(grid.insert(pt), std::length_error);
+    }
+  }
+  EXPECT_EQ(grid.size(), capacity);
+  grid.clear();
+  EXPECT_TRUE(grid.empty());
+  EXPECT_NO_THROW(grid.insert(pt));
+  EXPECT_EQ((*grid.begin()).second.count(), 1U);
+}
+
+/// Compare insertion throughput of the hashed and dense backends
+TEST(DenseVoxelGrid, benchmark)
+{
+  PointXYZ min_point, max_point, voxel_size;
+  min_point.x = -10.0F;
+  min_point.y = -10.0F;
+  min_point.z = -2.0F;
+  max_point.x = 10.0F;
+  max_point.y = 10.0F;
+  max_point.z = 2.0F;
+  voxel_size.x = 0.1F;
+  voxel_size.y = 0.1F;
+  voxel_size.z = 0.1F;
+  const Config cfg{min_point, max_point, voxel_size, 100000U};
+  const auto cloud = make_dense_test_cloud(100000U);
+  constexpr std::size_t ITERS = 10U;
+  using VoxelT = CentroidVoxel<PointXYZ>;
+
+  VoxelGrid<VoxelT> hashed{cfg};
+  DenseVoxelGrid<VoxelT> dense{cfg};
+  std::size_t hashed_size = 0U;
+  std::size_t dense_size = 0U;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t idx = 0U; idx < ITERS; ++idx) {
+    hashed.clear();
+    hashed.insert(cloud.begin(), cloud.end());
+    hashed_size = hashed.size();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  for (std::size_t idx = 0U; idx < ITERS; ++idx) {
+    dense.clear();
+    dense.insert(cloud.begin(), cloud.end());
+    dense_size = dense.size();
+  }
+  const auto t2 = std::chrono::steady_clock::now();
+  EXPECT_EQ(hashed_size, dense_size);
+  const auto us = [](const std::chrono::steady_clock::duration & dt) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(dt).count() /
+             static_cast<decltype(dt.count())>(ITERS);
+    };
+  std::cerr << "VoxelGrid insert " << cloud.size() << " points: " << us(t1 - t0) << " µs\n";
+  std::cerr << "DenseVoxelGrid insert " << cloud.size() << " points: " << us(t2 - t1) <<
+    " µs (" << DenseVoxelGrid<VoxelT>::memory_size(cfg) << " bytes)\n";
+}
+/// Structure of arrays point block for the batched APIs
+struct SoaCloud
+{
+  explicit SoaCloud(const std::vector<PointXYZ> & cloud)
+  {
+    for (const auto & pt : cloud) {
+      x.push_back(pt.x);
+      y.push_back(pt.y);
+      z.push_back(pt.z);
+      intensity.push_back(pt.x + pt.y);
+    }
+  }
+  std::vector<float32_t> x;
+  std::vector<float32_t> y;
+  std::vector<float32_t> z;
+  std::vector<float32_t> intensity;
+};
+
+inline Config make_batch_test_config(const float32_t voxel_size, const uint64_t capacity)
+{
+  PointXYZ min_point, max_point, size;
+  min_point.x = -8.0F;
+  min_point.y = -8.0F;
+  min_point.z = -1.5F;
+  max_point.x = 8.0F;
+  max_point.y = 8.0F;
+  max_point.z = 1.5F;
+  size.x = voxel_size;
+  size.y = voxel_size;
+  size.z = voxel_size;
+  return Config{min_point, max_point, size, capacity};
+}
+
+/// Every kernel the CPU supports must agree bit for bit with the scalar per point index
+TEST(BatchIndex, matches_scalar)
+{
+  const Config cfg = make_batch_test_config(0.3F, 1000U);
+  // Odd count to exercise the remainder loops; the cloud exceeds the field to test clamping
+  auto cloud = make_dense_test_cloud(1003U);
+  PointXYZ pt;
+  pt.x = 8.0F;
+  pt.y = -8.0F;
+  pt.z = 1.5F;
+  cloud.push_back(pt);
+  pt.x = -100.0F;
+  pt.y = 100.0F;
+  pt.z = 0.0F;
+  cloud.push_back(pt);
+  const SoaCloud soa{cloud};
+  std::vector<uint64_t> ref;
+  for (const auto & p : cloud) {
+    ref.push_back(cfg.index(p));
+  }
+  const auto max_level = static_cast<uint8_t>(detect_simd_level());
+  for (uint8_t level = 0U; level <= max_level; ++level) {
+    std::vector<uint64_t> out(cloud.size(), 0U);
+    cfg.index(
+      soa.x.data(), soa.y.data(), soa.z.data(), cloud.size(), out.data(),
+      static_cast<SimdLevel>(level));
+    EXPECT_EQ(out, ref) << "SimdLevel " << static_cast<uint32_t>(level);
+  }
+}
+
+TEST(CentroidAccumulator, matches_centroid_voxel_grid)
+{
+  const Config cfg = make_batch_test_config(0.5F, 5000U);
+  const auto cloud = make_dense_test_cloud(20000U);
+  const SoaCloud soa{cloud};
+  VoxelGrid<CentroidVoxel<PointXYZIF>> grid{cfg};
+  CentroidAccumulator acc{cfg};
+  for (std::size_t idx = 0U; idx < cloud.size(); ++idx) {
+    PointXYZIF pt;
+    pt.x = soa.x[idx];
+    pt.y = soa.y[idx];
+    pt.z = soa.z[idx];
+    pt.intensity = soa.intensity[idx];
+    grid.insert(pt);
+  }
+  // Two rounds to make sure clear() fully resets the state
+  for (std::size_t round = 0U; round < 2U; ++round) {
+    acc.clear();
+    EXPECT_TRUE(acc.empty());
+    acc.insert(soa.x.data(), soa.y.data(), soa.z.data(), soa.intensity.data(), cloud.size());
+    ASSERT_EQ(acc.size(), grid.size());
+    std::map<uint64_t, PointXYZIF> ref;
+    for (const auto it : grid) {
+      ref[it.first] = it.second.get();
+    }
+    constexpr float32_t TOL = 1.0E-4F;
+    for (std::size_t vdx = 0U; vdx < acc.size(); ++vdx) {
+      const auto ref_it = ref.find(acc.index(vdx));
+      ASSERT_NE(ref_it, ref.end());
+      const PointXYZIF pt = acc.get(vdx);
+      EXPECT_NEAR(ref_it->second.x, pt.x, TOL);
+      EXPECT_NEAR(ref_it->second.y, pt.y, TOL);
+      EXPECT_NEAR(ref_it->second.z, pt.z, TOL);
+      EXPECT_NEAR(ref_it->second.intensity, pt.intensity, TOL);
+    }
+  }
+  // Bad case: insert too many
+  CentroidAccumulator small{make_batch_test_config(0.5F, 10U)};
+  EXPECT_THROW(
+    small.insert(soa.x.data(), soa.y.data(), soa.z.data(), nullptr, cloud.size()),
+    std::length_error);
+  EXPECT_EQ(small.size(), small.capacity());
+}
+
+/// Many points in one voxel far from the origin, as in a cloud in map frame
+TEST(CentroidAccumulator, far_from_origin)
+{
+  PointXYZ min_point;
+  min_point.x = 9990.0F;
+  min_point.y = -10.0F;
+  min_point.z = -10.0F;
+  PointXYZ max_point;
+  max_point.x = 10010.0F;
+  max_point.y = 10.0F;
+  max_point.z = 10.0F;
+  PointXYZ voxel_size;
+  voxel_size.x = 20.0F;
+  voxel_size.y = 20.0F;
+  voxel_size.z = 20.0F;
+  CentroidAccumulator acc{Config{min_point, max_point, voxel_size, 1U}};
+  constexpr std::size_t NUM_POINTS = 100000U;
+  std::vector<float32_t> x(NUM_POINTS);
+  std::vector<float32_t> y(NUM_POINTS);
+  std::vector<float32_t> z(NUM_POINTS);
+  double sum_x = 0.0;
+  for (std::size_t idx = 0U; idx < NUM_POINTS; ++idx) {
+    x[idx] = 10000.0F + (static_cast<float32_t>(idx % 1000U) * 0.001F);
+    y[idx] = 1.0F;
+    z[idx] = 1.0F;
+    sum_x += static_cast<double>(x[idx]);
+  }
+  acc.insert(x.data(), y.data(), z.data(), nullptr, NUM_POINTS);
+  ASSERT_EQ(acc.size(), 1U);
+  EXPECT_EQ(acc.count(0U), NUM_POINTS);
+  // A single precision sum would be off by meters
+  EXPECT_FLOAT_EQ(acc.get(0U).x, static_cast<float32_t>(sum_x / NUM_POINTS));
+  EXPECT_FLOAT_EQ(acc.get(0U).y, 1.0F);
+}
+
+/// Downsampling a fused cloud: per point insertion vs batched SoA insertion
+TEST(CentroidAccumulator, benchmark)
+{
+  const Config cfg = make_batch_test_config(0.1F, 300000U);
+  const auto cloud = make_dense_test_cloud(300000U);
+  const SoaCloud soa{cloud};
+  constexpr std::size_t ITERS = 5U;
+  const auto us = [](const std::chrono::steady_clock::duration & dt) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(dt).count() /
+             static_cast<decltype(dt.count())>(ITERS);
+    };
+
+  std::vector<uint64_t> out(cloud.size(), 0U);
+  const auto max_level = static_cast<uint8_t>(detect_simd_level());
+  for (uint8_t level = 0U; level <= max_level; ++level) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t iter = 0U; iter < ITERS; ++iter) {
+      cfg.index(
+        soa.x.data(), soa.y.data(), soa.z.data(), cloud.size(), out.data(),
+        static_cast<SimdLevel>(level));
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    std::cerr << "Batched index, SimdLevel " << static_cast<uint32_t>(level) << ", " <<
+      cloud.size() << " points: " << us(t1 - t0) << " µs\n";
+  }
+
+  VoxelGrid<CentroidVoxel<PointXYZIF>> grid{cfg};
+  CentroidAccumulator acc{cfg};
+  const auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t iter = 0U; iter < ITERS; ++iter) {
+    grid.clear();
+    for (std::size_t idx = 0U; idx < cloud.size(); ++idx) {
+      PointXYZIF pt;
+      pt.x = soa.x[idx];
+      pt.y = soa.y[idx];
+      pt.z = soa.z[idx];
+      pt.intensity = soa.intensity[idx];
+      grid.insert(pt);
+    }
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  for (std::size_t iter = 0U; iter < ITERS; ++iter) {
+    acc.clear();
+    acc.insert(soa.x.data(), soa.y.data(), soa.z.data(), soa.intensity.data(), cloud.size());
+  }
+  const auto t2 = std::chrono::steady_clock::now();
+  EXPECT_EQ(grid.size(), acc.size());
+  std::cerr << "VoxelGrid<CentroidVoxel> insert " << cloud.size() << " points: " <<
+    us(t1 - t0) << " µs\n";
+  std::cerr << "CentroidAccumulator insert " << cloud.size() << " points: " <<
+    us(t2 - t1) << " µs\n";
+}
 #endif  // TEST_VOXEL_GRID_HPP_
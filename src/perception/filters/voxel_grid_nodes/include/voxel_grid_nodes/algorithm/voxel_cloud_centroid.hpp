@@ -19,6 +19,7 @@
 #ifndef VOXEL_GRID_NODES__ALGORITHM__VOXEL_CLOUD_CENTROID_HPP_
 #define VOXEL_GRID_NODES__ALGORITHM__VOXEL_CLOUD_CENTROID_HPP_
 
+#include <voxel_grid/centroid_accumulator.hpp>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_base.hpp>
 
 namespace autoware
@@ -31,7 +32,9 @@ namespace voxel_grid_nodes
 {
 namespace algorithm
 {
-/// \brief An instantiation of VoxelCloudBase for CentroidVoxels.
+/// \brief An instantiation of VoxelCloudBase for centroid voxels. Points are deinterleaved from
+///        the PointCloud2 buffer into blocks of coordinate arrays and inserted with the batched
+///        CentroidAccumulator.
 class VOXEL_GRID_NODES_PUBLIC VoxelCloudCentroid : public VoxelCloudBase
 {
 public:
@@ -50,7 +53,7 @@ public:
 
 private:
   sensor_msgs::msg::PointCloud2 m_cloud;
-  voxel_grid::VoxelGrid<voxel_grid::CentroidVoxel<PointXYZIF>> m_grid;
+  voxel_grid::CentroidAccumulator m_grid;
 };  // VoxelCloudCentroid
 }  // namespace algorithm
 }  // namespace voxel_grid_nodes
@@ -0,0 +1,75 @@
+// Copyright 2020 Apex.AI, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Co-developed by Tier IV, Inc. and Apex.AI, Inc.
+
+/// \file
+/// \brief This file defines instances of the VoxelCloudBase interface backed by a dense voxel grid
+#ifndef VOXEL_GRID_NODES__ALGORITHM__VOXEL_CLOUD_DENSE_HPP_
+#define VOXEL_GRID_NODES__ALGORITHM__VOXEL_CLOUD_DENSE_HPP_
+
+#include <voxel_grid/dense_voxel_grid.hpp>
+#include <voxel_grid_nodes/algorithm/voxel_cloud_base.hpp>
+
+namespace autoware
+{
+namespace perception
+{
+namespace filters
+{
+namespace voxel_grid_nodes
+{
+namespace algorithm
+{
+/// \brief An instantiation of VoxelCloudBase using a DenseVoxelGrid, which preallocates every voxel
+///        of the receptive field. Faster than the hashed grid for small, bounded regions, at the
+///        cost of memory proportional to the volume of the region.
+/// \tparam VoxelT The voxel type, e.g. CentroidVoxel or ApproximateVoxel over PointXYZIF
+template<typename VoxelT>
+class VOXEL_GRID_NODES_PUBLIC VoxelCloudDense : public VoxelCloudBase
+{
+public:
+  /// \brief Constructor
+  /// \param[in] cfg Configuration struct for the voxel grid
+  explicit VoxelCloudDense(const voxel_grid::Config & cfg);
+
+  /// \brief Inserts points into the voxel grid data structure, overwrites internal header
+  /// \param[in] msg A point cloud to insert into the voxel grid. Assumed to have the structure XYZI
+  void insert(const sensor_msgs::msg::PointCloud2 & msg) override;
+
+  /// \brief Get accumulated downsampled points. Internally resets the internal grid. Header is
+  ///        taken from last insert
+  /// \return The downsampled point cloud
+  const sensor_msgs::msg::PointCloud2 & get() override;
+
+  /// \brief Get the number of bytes preallocated for the voxel grid with a given configuration
+  /// \param[in] cfg Configuration struct for the voxel grid
+  /// \return The size in bytes
+  static std::size_t memory_size(const voxel_grid::Config & cfg);
+
+private:
+  sensor_msgs::msg::PointCloud2 m_cloud;
+  voxel_grid::DenseVoxelGrid<VoxelT> m_grid;
+};  // VoxelCloudDense
+
+using VoxelCloudDenseCentroid = VoxelCloudDense<voxel_grid::CentroidVoxel<voxel_grid::PointXYZIF>>;
+using VoxelCloudDenseApproximate =
+  VoxelCloudDense<voxel_grid::ApproximateVoxel<voxel_grid::PointXYZIF>>;
+}  // namespace algorithm
+}  // namespace voxel_grid_nodes
+}  // namespace filters
+}  // namespace perception
+}  // namespace autoware
+
+#endif  // VOXEL_GRID_NODES__ALGORITHM__VOXEL_CLOUD_DENSE_HPP_
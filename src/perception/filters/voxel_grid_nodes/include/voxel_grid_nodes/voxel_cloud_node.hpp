@@ -56,7 +56,11 @@ private:
   /// \brief Initialize state transition callbacks and voxel grid
   /// \param[in] cfg Configuration object for voxel grid
   /// \param[in] is_approximate whether to instantiate an approximate or centroid voxel grid
-  void VOXEL_GRID_NODES_LOCAL init(const voxel_grid::Config & cfg, const bool8_t is_approximate);
+  /// \param[in] is_dense whether to back the voxel grid with a dense array instead of a hash map
+  void VOXEL_GRID_NODES_LOCAL init(
+    const voxel_grid::Config & cfg,
+    const bool8_t is_approximate,
+    const bool8_t is_dense);
 
   using Message = sensor_msgs::msg::PointCloud2;
 
@@ -14,6 +14,8 @@
 //
 // Co-developed by Tier IV, Inc. and Apex.AI, Inc.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 
 #include "lidar_utils/point_cloud_utils.hpp"
@@ -60,20 +62,35 @@ void VoxelCloudCentroid::insert(
     point_step = 3U * field_size;
   }
 
-  // Iterate through the data, but skip intensity in case the point cloud does not have it.
+  const bool8_t has_intensity = (4U * field_size) == point_step;
+
+  // Deinterleave blocks of points into coordinate arrays, skipping any fields after xyz(i).
   // For example:
   //
   // point_step = 4
   // x y z i a b c x y z i a b c
   // ^------       ^------
-  for (std::size_t idx = 0U; idx < msg.data.size(); idx += msg.point_step) {
-    PointXYZIF pt;
-    //lint -e{925, 9110} Need to convert pointers and use bit for external API NOLINT
-    (void)memmove(
-      static_cast<void *>(&pt.x),
-      static_cast<const void *>(&msg.data[idx]),
-      point_step);
-    m_grid.insert(pt);
+  constexpr std::size_t block_size = voxel_grid::CentroidAccumulator::BLOCK_SIZE;
+  std::array<float32_t, block_size> x;
+  std::array<float32_t, block_size> y;
+  std::array<float32_t, block_size> z;
+  std::array<float32_t, block_size> intensity;
+  const std::size_t num_points = msg.data.size() / msg.point_step;
+  for (std::size_t first = 0U; first < num_points; first += block_size) {
+    const std::size_t count = std::min(block_size, num_points - first);
+    for (std::size_t idx = 0U; idx < count; ++idx) {
+      float32_t pt[4U] = {0.0F, 0.0F, 0.0F, 0.0F};
+      //lint -e{925, 9110} Need to convert pointers and use bit for external API NOLINT
+      (void)memmove(
+        static_cast<void *>(&pt[0U]),
+        static_cast<const void *>(&msg.data[(first + idx) * msg.point_step]),
+        point_step);
+      x[idx] = pt[0U];
+      y[idx] = pt[1U];
+      z[idx] = pt[2U];
+      intensity[idx] = pt[3U];
+    }
+    m_grid.insert(x.data(), y.data(), z.data(), has_intensity ? intensity.data() : nullptr, count);
   }
   // TODO(c.ho) overlay?
 }
@@ -84,9 +101,8 @@ const sensor_msgs::msg::PointCloud2 & VoxelCloudCentroid::get()
   // resetting the index for the pointcloud iterators
   autoware::common::lidar_utils::reset_pcl_msg(m_cloud, m_grid.capacity(), m_point_cloud_idx);
 
-  for (const auto & it : m_grid) {
-    const auto & pt = it.second.get();
-    (void)add_point_to_cloud(m_cloud, pt, m_point_cloud_idx);
+  for (std::size_t idx = 0U; idx < m_grid.size(); ++idx) {
+    (void)add_point_to_cloud(m_cloud, m_grid.get(idx), m_point_cloud_idx);
     // Don't need to check if cloud can't fit since it has the same capacity as the grid
     // insert will throw if the grid is at capacity
   }
@@ -20,6 +20,7 @@
 #include <voxel_grid_nodes/voxel_cloud_node.hpp>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_approximate.hpp>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_centroid.hpp>
+#include <voxel_grid_nodes/algorithm/voxel_cloud_dense.hpp>
 #include <common/types.hpp>
 #include <rclcpp_components/register_node_macro.hpp>
 
@@ -82,7 +83,10 @@ VoxelCloudNode::VoxelCloudNode(
     static_cast<std::size_t>(declare_parameter("config.capacity").get<std::size_t>());
   const voxel_grid::Config cfg{min_point, max_point, voxel_size, capacity};
   // Init
-  init(cfg, declare_parameter("is_approximate").get<bool8_t>());
+  init(
+    cfg,
+    declare_parameter("is_approximate").get<bool8_t>(),
+    declare_parameter("is_dense", false));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -104,10 +108,25 @@ void VoxelCloudNode::callback(const sensor_msgs::msg::PointCloud2::SharedPtr msg
   }
 }
 ////////////////////////////////////////////////////////////////////////////////
-void VoxelCloudNode::init(const voxel_grid::Config & cfg, const bool8_t is_approximate)
+void VoxelCloudNode::init(
+  const voxel_grid::Config & cfg,
+  const bool8_t is_approximate,
+  const bool8_t is_dense)
 {
   // construct voxel grid
-  if (is_approximate) {
+  if (is_dense) {
+    std::size_t memory_size = 0U;
+    if (is_approximate) {
+      memory_size = algorithm::VoxelCloudDenseApproximate::memory_size(cfg);
+      m_voxelgrid_ptr = std::make_unique<algorithm::VoxelCloudDenseApproximate>(cfg);
+    } else {
+      memory_size = algorithm::VoxelCloudDenseCentroid::memory_size(cfg);
+      m_voxelgrid_ptr = std::make_unique<algorithm::VoxelCloudDenseCentroid>(cfg);
+    }
+    RCLCPP_INFO(
+      get_logger(), "Dense voxel grid with %lu voxels uses %lu bytes",
+      cfg.get_num_voxels(), memory_size);
+  } else if (is_approximate) {
     m_voxelgrid_ptr = std::make_unique<algorithm::VoxelCloudApproximate>(cfg);
   } else {
     m_voxelgrid_ptr = std::make_unique<algorithm::VoxelCloudCentroid>(cfg);
@@ -22,6 +22,7 @@
 #include <sensor_msgs/point_cloud2_iterator.hpp>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_approximate.hpp>
 #include <voxel_grid_nodes/algorithm/voxel_cloud_centroid.hpp>
+#include <voxel_grid_nodes/algorithm/voxel_cloud_dense.hpp>
 #include <voxel_grid_nodes/voxel_cloud_node.hpp>
 
 #include <memory>
@@ -33,6 +34,8 @@ using autoware::perception::filters::voxel_grid::Config;
 using autoware::perception::filters::voxel_grid_nodes::algorithm::VoxelCloudBase;
 using autoware::perception::filters::voxel_grid_nodes::algorithm::VoxelCloudApproximate;
 using autoware::perception::filters::voxel_grid_nodes::algorithm::VoxelCloudCentroid;
+using autoware::perception::filters::voxel_grid_nodes::algorithm::VoxelCloudDenseApproximate;
+using autoware::perception::filters::voxel_grid_nodes::algorithm::VoxelCloudDenseCentroid;
 using autoware::perception::filters::voxel_grid::PointXYZIF;
 
 using autoware::common::types::bool8_t;
@@ -221,6 +224,44 @@ TEST_F(CloudAlgorithm, centroid)
   EXPECT_EQ(alg_ptr->get().width, 0U);
 }
 
+TEST_F(CloudAlgorithm, dense)
+{
+  this->ref_points1[0U] = this->make(-0.75F, -0.75F, -0.75F);
+  this->ref_points1[1U] = this->make(0.75F, -0.75F, -0.75F);
+  this->ref_points1[2U] = this->make(-0.75F, 0.75F, -0.75F);
+  this->ref_points1[3U] = this->make(0.75F, 0.75F, -0.75F);
+  this->ref_points1[4U] = this->make(-0.75F, -0.75F, 0.75F);
+  this->ref_points1[5U] = this->make(0.75F, -0.75F, 0.75F);
+  this->ref_points1[6U] = this->make(-0.75F, 0.75F, 0.75F);
+  this->ref_points1[7U] = this->make(0.75F, 0.75F, 0.75F);
+  // Same behavior as the hashed centroid grid
+  alg_ptr = std::make_unique<VoxelCloudDenseCentroid>(*cfg_ptr);
+  EXPECT_EQ(alg_ptr->get().width, 0U);
+  alg_ptr->insert(cloud1);
+  EXPECT_TRUE(check(alg_ptr->get(), 4U));
+  EXPECT_EQ(alg_ptr->get().width, 0U);
+  alg_ptr->insert(cloud1);
+  alg_ptr->insert(cloud2);
+  EXPECT_TRUE(check(alg_ptr->get(), ref_points1.size()));
+  EXPECT_EQ(alg_ptr->get().width, 0U);
+  EXPECT_GT(VoxelCloudDenseCentroid::memory_size(*cfg_ptr), 0U);
+
+  // Same behavior as the hashed approximate grid
+  this->ref_points1[0U] = this->make(-0.5F, -0.5F, -0.5F);
+  this->ref_points1[1U] = this->make(0.5F, -0.5F, -0.5F);
+  this->ref_points1[2U] = this->make(-0.5F, 0.5F, -0.5F);
+  this->ref_points1[3U] = this->make(0.5F, 0.5F, -0.5F);
+  this->ref_points1[4U] = this->make(-0.5F, -0.5F, 0.5F);
+  this->ref_points1[5U] = this->make(0.5F, -0.5F, 0.5F);
+  this->ref_points1[6U] = this->make(-0.5F, 0.5F, 0.5F);
+  this->ref_points1[7U] = this->make(0.5F, 0.5F, 0.5F);
+  alg_ptr = std::make_unique<VoxelCloudDenseApproximate>(*cfg_ptr);
+  alg_ptr->insert(cloud1);
+  alg_ptr->insert(cloud2);
+  EXPECT_TRUE(check(alg_ptr->get(), ref_points1.size()));
+  EXPECT_EQ(alg_ptr->get().width, 0U);
+}
+
 TEST(voxel_grid_nodes, instantiate)
 {
   // Basic test to ensure that VoxelCloudNode can be instantiated
@@ -278,6 +319,10 @@ TEST(voxel_grid_nodes, instantiate)
   params.emplace_back("config.voxel_size.z", 1.0);
   node_options.parameter_overrides(params);
   ASSERT_NO_THROW(VoxelCloudNode{node_options});
+
+  params.emplace_back("is_dense", true);
+  node_options.parameter_overrides(params);
+  ASSERT_NO_THROW(VoxelCloudNode{node_options});
 }
 
 #endif  // TEST_VOXEL_GRID_NODES_HPP_
@@ -23,6 +23,9 @@
 #include <geometry/spatial_hash.hpp>
 #include <euclidean_cluster/visibility_control.hpp>
 #include <common/types.hpp>
+#include <helper_functions/worker_pool.hpp>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <utility>
@@ -83,7 +86,7 @@ private:
 };  // class PointXYZII
 
 using HashConfig = autoware::common::geometry::spatial_hash::Config2d;
-using Hash = autoware::common::geometry::spatial_hash::SpatialHash2d<PointXYZII>;
+using Hash = autoware::common::geometry::spatial_hash::FlatSpatialHash2d<PointXYZII>;
 using Clusters = autoware_auto_msgs::msg::PointClusters;
 using Cluster = decltype(Clusters::clusters)::value_type;
 
@@ -99,10 +102,13 @@ public:
   /// \param[in] min_cluster_size The number of points that must be in a cluster before it is not
   ///                             considered noise
   /// \param[in] max_num_clusters The maximum preallocated number of clusters in a scene
+  /// \param[in] num_threads The number of threads used for clustering. If more than one, the
+  ///                        parallel union-find algorithm is used
   Config(
     const std::string & frame_id,
     const std::size_t min_cluster_size,
-    const std::size_t max_num_clusters);
+    const std::size_t max_num_clusters,
+    const std::size_t num_threads = 1U);
   /// \brief Gets minimum number of points needed for a cluster to not be considered noise
   /// \return Minimum cluster size
   std::size_t min_cluster_size() const;
@@ -112,11 +118,15 @@ public:
   /// \brief Get frame id
   /// \return The frame id
   const std::string & frame_id() const;
+  /// \brief Get number of threads used for clustering
+  /// \return Number of threads
+  std::size_t num_threads() const;
 
 private:
   const std::string m_frame_id;
   const std::size_t m_min_cluster_size;
   const std::size_t m_max_num_clusters;
+  const std::size_t m_num_threads;
 };  // class Config
 
 /// \brief implementation of euclidean clustering for point cloud segmentation
@@ -124,6 +134,12 @@ private:
 /// according to euclidean distance. This can be thought of as a graph-based
 /// approach where points are vertices and edges are defined by euclidean distance
 /// The input to this should be nonground points pased through a voxel grid.
+///
+/// If configured with more than one thread, the connected components are instead computed by
+/// partitioning the occupied bins of the spatial hash across a pool of worker threads, and merging
+/// neighboring points with a lock-free union-find. The resulting clusters and their order are
+/// identical to the serial algorithm, but points within a cluster are in insertion order rather
+/// than in breadth first search order.
 class EUCLIDEAN_CLUSTER_PUBLIC EuclideanCluster
 {
 public:
@@ -149,7 +165,7 @@ public:
     m_seen.push_back(false);
   }
 
-  /// \brief Multi-insert
+  /// \brief Multi-insert, bulk builds the underlying spatial hash
   /// \param[in] begin Iterator pointing to to the first point to insert
   /// \param[in] end Iterator pointing to one past the last point to insert
   /// \throw std::length_error If the underlying spatial hash is full
@@ -157,12 +173,16 @@ public:
   template<typename IT>
   void insert(const IT begin, const IT end)
   {
-    if ((static_cast<std::size_t>(std::distance(begin, end)) + m_hash.size()) > m_hash.capacity()) {
+    const auto count = static_cast<std::size_t>(std::distance(begin, end));
+    if ((count + m_hash.size()) > m_hash.capacity()) {
       throw std::length_error{"EuclideanCluster: Multi insert would overrun capacity"};
     }
-    for (auto it = begin; it != end; ++it) {
-      insert(*it);
-    }
+    // Ids are assigned in order, matching the single point insert
+    auto id = static_cast<uint32_t>(m_seen.size());
+    m_hash.insert(begin, end, [&id](const auto & pt) {
+        return PointXYZII{pt, id++};
+      });
+    m_seen.resize(m_seen.size() + count, false);
   }
 
   /// \brief Compute the clusters from the inserted points
@@ -205,6 +225,14 @@ private:
   };  // struct PointXYZ
   /// \brief Do the clustering process, with no error checking
   EUCLIDEAN_CLUSTER_LOCAL void cluster_impl(Clusters & clusters);
+  /// \brief Do the clustering process using the worker pool, with no error checking
+  EUCLIDEAN_CLUSTER_LOCAL void cluster_parallel(Clusters & clusters);
+  /// \brief Find the root of a point's component in the union-find forest, with path halving
+  EUCLIDEAN_CLUSTER_LOCAL uint32_t find_root(uint32_t idx);
+  /// \brief Merge the components of two points in the union-find forest. The root of a component
+  ///        is always its smallest index, and hence the point which seeds the cluster in the
+  ///        serial algorithm
+  EUCLIDEAN_CLUSTER_LOCAL void unite(uint32_t idx, uint32_t jdx);
   /// \brief Compute the next cluster, seeded by the given point, and grown using the remaining
   ///         unseen points
   EUCLIDEAN_CLUSTER_LOCAL void cluster(Clusters & clusters, const PointXYZII & pt);
@@ -225,6 +253,12 @@ private:
   decltype(Clusters::clusters) m_cluster_pool;
   Error m_last_error;
   std::vector<bool8_t> m_seen;
+  // Parallel clustering state, only allocated if more than one thread is configured
+  std::unique_ptr<common::helper_functions::WorkerPool> m_pool;
+  std::vector<Hash::OutputVector> m_task_neighbors;
+  std::vector<std::atomic<uint32_t>> m_parents;
+  std::vector<uint32_t> m_component_sizes;
+  std::vector<uint32_t> m_component_clusters;
 };  // class EuclideanCluster
 }  // namespace euclidean_cluster
 }  // namespace segmentation
@@ -17,6 +17,7 @@
 #include <cstring>
 //lint -e537 NOLINT Repeated include file: pclint vs cpplint
 #include <algorithm>
+#include <limits>
 #include <string>
 //lint -e537 NOLINT Repeated include file: pclint vs cpplint
 #include <utility>
@@ -62,12 +63,17 @@ const PointXYZI & PointXYZII::get_point() const
 Config::Config(
   const std::string & frame_id,
   const std::size_t min_cluster_size,
-  const std::size_t max_num_clusters)
+  const std::size_t max_num_clusters,
+  const std::size_t num_threads)
 : m_frame_id(frame_id),
   m_min_cluster_size(min_cluster_size),
-  m_max_num_clusters(max_num_clusters)
+  m_max_num_clusters(max_num_clusters),
+  m_num_threads(num_threads)
 {
   // TODO(c.ho) sanity checking
+  if (0U == m_num_threads) {
+    throw std::domain_error{"EuclideanCluster: Need at least one thread"};
+  }
 }
 ////////////////////////////////////////////////////////////////////////////////
 std::size_t Config::min_cluster_size() const
@@ -85,6 +91,11 @@ const std::string & Config::frame_id() const
   return m_frame_id;
 }
 ////////////////////////////////////////////////////////////////////////////////
+std::size_t Config::num_threads() const
+{
+  return m_num_threads;
+}
+////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 EuclideanCluster::EuclideanCluster(const Config & cfg, const HashConfig & hash_cfg)
 : m_config(cfg),
@@ -92,7 +103,12 @@ EuclideanCluster::EuclideanCluster(const Config & cfg, const HashConfig & hash_c
   m_clusters(),
   m_cluster_pool(),
   m_last_error(Error::NONE),
-  m_seen{}
+  m_seen{},
+  m_pool{nullptr},
+  m_task_neighbors{},
+  m_parents{},
+  m_component_sizes{},
+  m_component_clusters{}
 {
   // Reservation
   m_clusters.clusters.reserve(m_config.max_num_clusters());
@@ -110,6 +126,17 @@ EuclideanCluster::EuclideanCluster(const Config & cfg, const HashConfig & hash_c
       throw std::domain_error{"Cluster initialized with point size != PointXYZI"};
     }
   }
+  if (m_config.num_threads() > 1U) {
+    if (hash_cfg.get_capacity() > std::numeric_limits<uint32_t>::max()) {
+      throw std::domain_error{"EuclideanCluster: Capacity too large for parallel clustering"};
+    }
+    m_pool = std::make_unique<common::helper_functions::WorkerPool>(m_config.num_threads());
+    // A few tasks per thread for load balancing; each task has its own neighbor scratch space
+    m_task_neighbors.resize(4U * m_config.num_threads());
+    m_parents = std::vector<std::atomic<uint32_t>>(hash_cfg.get_capacity());
+    m_component_sizes.resize(hash_cfg.get_capacity());
+    m_component_clusters.resize(hash_cfg.get_capacity());
+  }
 }
 ////////////////////////////////////////////////////////////////////////////////
 void EuclideanCluster::cluster(Clusters & clusters)
@@ -170,6 +197,11 @@ const Config & EuclideanCluster::get_config() const
 void EuclideanCluster::cluster_impl(Clusters & clusters)
 {
   m_last_error = Error::NONE;
+  if (m_pool) {
+    cluster_parallel(clusters);
+    m_hash.clear();
+    return;
+  }
   for (const auto & kv : m_hash) {
     const auto & pt = kv.second;
     if (!m_seen[pt.get_id()]) {
@@ -179,6 +211,112 @@ void EuclideanCluster::cluster_impl(Clusters & clusters)
   m_hash.clear();
 }
 ////////////////////////////////////////////////////////////////////////////////
+void EuclideanCluster::cluster_parallel(Clusters & clusters)
+{
+  if (m_hash.empty()) {
+    return;
+  }
+  // Sorts the points by bin so that the hash can be queried concurrently
+  const auto & bins = m_hash.bins();
+  // Ids are contiguous within the hash, but may not start at zero
+  const uint32_t first_id = m_hash.begin()->second.get_id();
+  const auto num_points = static_cast<uint32_t>(m_hash.size());
+  for (uint32_t idx = 0U; idx < num_points; ++idx) {
+    m_parents[idx].store(idx, std::memory_order_relaxed);
+    m_component_sizes[idx] = 0U;
+  }
+  // Link each point to its neighbors, bins are split into contiguous chunks per task
+  const std::size_t num_tasks = std::min(bins.size(), m_task_neighbors.size());
+  m_pool->run(num_tasks, [this, &bins, num_tasks, first_id](const std::size_t task) {
+      auto & nbrs = m_task_neighbors[task];
+      const std::size_t first_bin = (task * bins.size()) / num_tasks;
+      const std::size_t last_bin = ((task + 1U) * bins.size()) / num_tasks;
+      for (std::size_t bdx = first_bin; bdx < last_bin; ++bdx) {
+        for (auto it = bins[bdx].first; it != bins[bdx].second; ++it) {
+          const auto & pt = it->second.get_point();
+          const uint32_t idx = it->second.get_id() - first_id;
+          m_hash.near(pt.x, pt.y, nbrs);
+          for (const auto & itd : nbrs) {
+            const uint32_t jdx = itd.get_point().get_id() - first_id;
+            // Each edge is found from both ends, only handle it once
+            if (jdx > idx) {
+              unite(idx, jdx);
+            }
+          }
+        }
+      }
+    });
+  // Flatten the forest and count component sizes
+  for (uint32_t idx = 0U; idx < num_points; ++idx) {
+    const uint32_t root = find_root(idx);
+    m_parents[idx].store(root, std::memory_order_relaxed);
+    ++m_component_sizes[root];
+  }
+  // Emit clusters in order of their smallest point id, which is the order the serial algorithm
+  // seeds them in, including the error behavior once the maximum number of clusters is reached
+  constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+  uint32_t idx = 0U;
+  for (const auto & kv : m_hash) {
+    const uint32_t root = m_parents[idx].load(std::memory_order_relaxed);
+    if (root == idx) {
+      const auto num_clusters = clusters.clusters.size();
+      m_component_clusters[idx] = INVALID;
+      if (num_clusters >= m_config.max_num_clusters()) {
+        m_last_error = Error::TOO_MANY_CLUSTERS;
+      } else if (m_component_sizes[idx] >= m_config.min_cluster_size()) {
+        clusters.clusters.emplace_back(std::move(m_cluster_pool[num_clusters]));
+        m_component_clusters[idx] = static_cast<uint32_t>(num_clusters);
+      } else {
+        // noise
+      }
+    }
+    const uint32_t cdx = m_component_clusters[root];
+    if (INVALID != cdx) {
+      add_point(clusters.clusters[cdx], kv.second);
+    }
+    ++idx;
+  }
+  // finalize clusters
+  for (auto & cluster : clusters.clusters) {
+    cluster.row_step = cluster.point_step * cluster.width;
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
+uint32_t EuclideanCluster::find_root(uint32_t idx)
+{
+  // Parents only ever point to smaller indices, so concurrent path halving can't form cycles
+  uint32_t parent = m_parents[idx].load(std::memory_order_relaxed);
+  while (parent != idx) {
+    const uint32_t grandparent = m_parents[parent].load(std::memory_order_relaxed);
+    if (grandparent != parent) {
+      (void)m_parents[idx].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+    }
+    idx = grandparent;
+    parent = m_parents[idx].load(std::memory_order_relaxed);
+  }
+  return idx;
+}
+////////////////////////////////////////////////////////////////////////////////
+void EuclideanCluster::unite(uint32_t idx, uint32_t jdx)
+{
+  while (true) {
+    idx = find_root(idx);
+    jdx = find_root(jdx);
+    if (idx == jdx) {
+      break;
+    }
+    // Always link the larger root below the smaller one
+    if (idx > jdx) {
+      std::swap(idx, jdx);
+    }
+    uint32_t expected = jdx;
+    // Fails if jdx stopped being a root in the meantime, in which case retry
+    if (m_parents[jdx].compare_exchange_strong(expected, idx, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+}
+////////////////////////////////////////////////////////////////////////////////
 void EuclideanCluster::cluster(Clusters & clusters, const PointXYZII & pt)
 {
   // init new cluster
@@ -19,6 +19,9 @@
 
 #include <common/types.hpp>
 
+#include <chrono>
+#include <iostream>
+#include <random>
 #include <vector>
 #include <utility>
 
@@ -153,4 +156,127 @@ TEST(euclidean_cluster, no_cluster)
   EXPECT_EQ(res.clusters.size(), static_cast<size_t>(0));
   EXPECT_EQ(cls.get_error(), EuclideanCluster::Error::NONE);
 }
+
+/// multi-insert goes through the bulk build of the spatial hash
+TEST(euclidean_cluster, multi_insert)
+{
+  // setup
+  builtin_interfaces::msg::Time t;
+  Config cfg{"bar", 10U, 100U};
+  HashConfig hcfg{-130.0F, 130.0F, -130.0F, 130.0F, 1.0F, 10000U};
+  EuclideanCluster cls{cfg, hcfg};
+  std::vector<PointXYZI> pts;
+  std::vector<std::pair<float32_t, float32_t>> output1;
+  std::vector<std::pair<float32_t, float32_t>> output2;
+  for (uint32_t idx = 0U; idx < 20U; ++idx) {
+    const float32_t x = -10.0F + (0.9F * static_cast<float32_t>(idx));
+    pts.push_back(PointXYZI{x, 0.0F, 0.0F, 0.0F});
+    output1.push_back({x, 0.0F});
+    pts.push_back(PointXYZI{x, 20.0F, 0.0F, 0.0F});
+    output2.push_back({x, 20.0F});
+  }
+  // Mix with single point insertion
+  insert_point(cls, 50.0F, 50.0F);
+  cls.insert(pts.begin(), pts.end());
+
+  // cluster and check
+  const auto & res = cls.cluster(t);
+  EXPECT_EQ(res.clusters.size(), static_cast<size_t>(2));
+  std::vector<std::vector<std::pair<float32_t, float32_t>> *> outputs = {&output1, &output2};
+  check_clusters(res, outputs, "bar");
+  EXPECT_EQ(res.clusters[0].width + res.clusters[1].width, pts.size());
+  EXPECT_EQ(cls.get_error(), EuclideanCluster::Error::NONE);
+
+  // Capacity is still respected
+  std::vector<PointXYZI> too_many{10001U};
+  EXPECT_THROW(cls.insert(too_many.begin(), too_many.end()), std::length_error);
+}
+
+/// Points of each cluster, sorted, so that serial and parallel results can be compared
+std::vector<std::vector<std::pair<float32_t, float32_t>>> sorted_clusters(const Clusters & res)
+{
+  std::vector<std::vector<std::pair<float32_t, float32_t>>> ret;
+  for (const auto & cls : res.clusters) {
+    ret.emplace_back();
+    for (uint32_t idx = 0U; idx < cls.width; ++idx) {
+      PointXYZI pt;
+      (void)memcpy(&pt, &cls.data[cls.point_step * idx], sizeof(pt));
+      ret.back().push_back({pt.x, pt.y});
+    }
+    std::sort(ret.back().begin(), ret.back().end());
+  }
+  return ret;
+}
+
+/// Random blobs of points plus uniform noise
+std::vector<PointXYZI> random_scene(const std::size_t num_points)
+{
+  std::mt19937 gen(1338U);
+  std::uniform_real_distribution<float32_t> pos{-100.0F, 100.0F};
+  std::normal_distribution<float32_t> blob{0.0F, 1.5F};
+  std::vector<PointXYZI> ret;
+  ret.reserve(num_points);
+  while (ret.size() < num_points) {
+    const float32_t cx = pos(gen);
+    const float32_t cy = pos(gen);
+    for (uint32_t idx = 0U; (idx < 50U) && (ret.size() < num_points); ++idx) {
+      ret.push_back(PointXYZI{cx + blob(gen), cy + blob(gen), 0.0F, 0.0F});
+    }
+    ret.push_back(PointXYZI{pos(gen), pos(gen), 0.0F, 0.0F});
+  }
+  return ret;
+}
+
+/// parallel clustering gives the same clusters in the same order as the serial one
+TEST(euclidean_cluster, parallel_matches_serial)
+{
+  builtin_interfaces::msg::Time t;
+  const auto pts = random_scene(5000U);
+  HashConfig hcfg{-130.0F, 130.0F, -130.0F, 130.0F, 0.7F, 10000U};
+  EXPECT_THROW(Config("bar", 5U, 100U, 0U), std::domain_error);
+  // Also check behavior when running out of clusters
+  for (const std::size_t max_num_clusters : {std::size_t{500U}, std::size_t{20U}}) {
+    EuclideanCluster serial{Config{"bar", 5U, max_num_clusters}, hcfg};
+    serial.insert(pts.begin(), pts.end());
+    const auto expected = sorted_clusters(serial.cluster(t));
+    ASSERT_GT(expected.size(), 1U);
+    for (std::size_t num_threads = 2U; num_threads <= 4U; ++num_threads) {
+      EuclideanCluster parallel{Config{"bar", 5U, max_num_clusters, num_threads}, hcfg};
+      // Twice, to check reuse
+      for (uint32_t run = 0U; run < 2U; ++run) {
+        parallel.insert(pts.begin(), pts.end());
+        const auto & res = parallel.cluster(t);
+        EXPECT_EQ(sorted_clusters(res), expected);
+        EXPECT_EQ(parallel.get_error(), serial.get_error());
+        for (const auto & cls : res.clusters) {
+          EXPECT_EQ(cls.row_step, cls.width * cls.point_step);
+          EXPECT_EQ(cls.header.frame_id, "bar");
+        }
+      }
+    }
+  }
+}
+
+/// figure out the runtime of cluster() depending on the number of threads, locally
+TEST(euclidean_cluster, benchmark)
+{
+  builtin_interfaces::msg::Time t;
+  const auto pts = random_scene(30000U);
+  HashConfig hcfg{-130.0F, 130.0F, -130.0F, 130.0F, 0.7F, pts.size()};
+  const std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 2U);
+  for (std::size_t num_threads = 1U; num_threads <= max_threads; ++num_threads) {
+    EuclideanCluster cls{Config{"bar", 5U, 1000U, num_threads}, hcfg};
+    const uint32_t num_runs = 10U;
+    std::chrono::nanoseconds duration{0};
+    for (uint32_t idx = 0U; idx < num_runs; ++idx) {
+      cls.insert(pts.begin(), pts.end());
+      const auto time_begin = std::chrono::steady_clock::now();
+      (void)cls.cluster(t);
+      duration += std::chrono::steady_clock::now() - time_begin;
+    }
+    std::cerr << num_threads << " thread(s): cluster() average runtime: " <<
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / num_runs <<
+      " µs\n";
+  }
+}
 #endif  // TEST_EUCLIDEAN_CLUSTER_HPP_
@@ -24,6 +24,7 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 using autoware::common::types::bool8_t;
@@ -37,6 +38,18 @@ namespace segmentation
 {
 namespace euclidean_cluster_nodes
 {
+namespace
+{
+// Negative values would wrap around to a huge pool size
+std::size_t validate_num_threads(const int64_t num_threads)
+{
+  if (num_threads < 1) {
+    throw std::domain_error{"EuclideanClusterNode: cluster.num_threads must be at least 1"};
+  }
+  return static_cast<std::size_t>(num_threads);
+}
+}  // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 EuclideanClusterNode::EuclideanClusterNode(
   const rclcpp::NodeOptions & node_options)
@@ -57,7 +70,8 @@ m_cluster_alg{
   euclidean_cluster::Config{
     declare_parameter("cluster.frame_id").get<std::string>().c_str(),
     static_cast<std::size_t>(declare_parameter("cluster.min_cluster_size").get<std::size_t>()),
-    static_cast<std::size_t>(declare_parameter("cluster.max_num_clusters").get<std::size_t>())
+    static_cast<std::size_t>(declare_parameter("cluster.max_num_clusters").get<std::size_t>()),
+    validate_num_threads(declare_parameter("cluster.num_threads", 1))
   },
   euclidean_cluster::HashConfig{
     static_cast<float32_t>(declare_parameter("hash.min_x").get<float32_t>()),